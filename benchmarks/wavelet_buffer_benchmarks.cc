@@ -2,12 +2,22 @@
 
 #include <wavelet_buffer/denoise_algorithms.h>
 #include <wavelet_buffer/primitives.h>
+#include <wavelet_buffer/sliding_wavelet_buffer.h>
 #include <wavelet_buffer/wavelet.h>
+#include <wavelet_buffer/wavelet_batch.h>
 #include <wavelet_buffer/wavelet_buffer.h>
 #include <wavelet_buffer/wavelet_parameters.h>
+#include <wavelet_buffer/wavelet_plan.h>
+#include <wavelet_buffer/wavelet_stream.h>
 #include <wavelet_buffer/wavelet_utils.h>
 
+#include <algorithm>
 #include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <tuple>
+#include <vector>
 
 #include <catch2/benchmark/catch_benchmark_all.hpp>
 #include <catch2/catch_test_macros.hpp>
@@ -20,6 +30,7 @@ using drift::Signal1D;
 using drift::SignalN2D;
 using drift::WaveletBuffer;
 using drift::utils::GetRandomSignal;
+using drift::wavelet::DaubechiesFilters;
 using drift::wavelet::DaubechiesMat;
 using drift::wavelet::dbwavf;
 using drift::wavelet::Orthfilt;
@@ -50,6 +61,422 @@ TEST_CASE("Wavelet algorithms benchmark 1D") {
   };
 }
 
+TEST_CASE("Short 1D windows with a plan") {
+  using drift::NullDenoiseAlgorithm;
+
+  /* The setup of the transform is comparable with the math for short
+   * windows, the plan does it once */
+  const size_t length = GENERATE(256, 1024, 4096);
+
+  drift::WaveletParameters parameters = {
+      .signal_shape = {length},
+      .signal_number = 1,
+      .decomposition_steps = 4,
+      .wavelet_type = drift::WaveletTypes::kDB3};
+
+  const auto data_src = GetRandomSignal(length, 1);
+  drift::NWaveletDecomposition decomposition(
+      1, drift::WaveletDecomposition(drift::DecompositionSize(parameters)));
+  const auto plan = std::make_shared<const drift::WaveletPlan>(parameters);
+
+  BENCHMARK("Setup per call " + std::to_string(length)) {
+    return drift::internal::DecomposeImpl(parameters, &decomposition, data_src,
+                                          NullDenoiseAlgorithm<DataType>(), 0,
+                                          1);
+  };
+
+  BENCHMARK("Plan " + std::to_string(length)) {
+    return plan->Decompose(data_src, NullDenoiseAlgorithm<DataType>(),
+                           &decomposition, 0, 1);
+  };
+
+  BENCHMARK("New buffer per window " + std::to_string(length)) {
+    WaveletBuffer buffer(parameters);
+    return buffer.Decompose(data_src, NullDenoiseAlgorithm<DataType>());
+  };
+
+  BENCHMARK("New buffer with shared plan " + std::to_string(length)) {
+    WaveletBuffer buffer(plan);
+    return buffer.Decompose(data_src, NullDenoiseAlgorithm<DataType>());
+  };
+}
+
+TEST_CASE("1D signal from caller memory") {
+  using drift::NullDenoiseAlgorithm;
+
+  /* The samples come from a ring buffer of floats, the overloads differ in
+   * the copies around the transform */
+  const size_t length = GENERATE(1024, 48000);
+
+  drift::WaveletParameters parameters = {
+      .signal_shape = {length},
+      .signal_number = 1,
+      .decomposition_steps = 6,
+      .wavelet_type = drift::WaveletTypes::kDB3};
+
+  const auto signal = GetRandomSignal(length);
+  std::vector<DataType> samples(signal.begin(), signal.end());
+  WaveletBuffer buffer(parameters);
+
+  BENCHMARK("Decompose SignalN2D column " + std::to_string(length)) {
+    SignalN2D data = {drift::Signal2D(samples.size(), 1)};
+    std::copy(samples.begin(), samples.end(),
+              blaze::column(data[0], 0).begin());
+    return buffer.Decompose(data, NullDenoiseAlgorithm<DataType>());
+  };
+
+  BENCHMARK("Decompose Signal1D " + std::to_string(length)) {
+    Signal1D data(samples.size());
+    std::copy(samples.begin(), samples.end(), data.begin());
+    return buffer.Decompose(data, NullDenoiseAlgorithm<DataType>());
+  };
+
+  BENCHMARK("Decompose span " + std::to_string(length)) {
+    return buffer.Decompose(std::span<const DataType>(samples),
+                            NullDenoiseAlgorithm<DataType>());
+  };
+
+  BENCHMARK("Compose SignalN2D column " + std::to_string(length)) {
+    SignalN2D data;
+    buffer.Compose(&data);
+    std::copy(blaze::column(data[0], 0).begin(),
+              blaze::column(data[0], 0).end(), samples.begin());
+  };
+
+  BENCHMARK("Compose Signal1D " + std::to_string(length)) {
+    Signal1D data;
+    buffer.Compose(&data);
+    std::copy(data.begin(), data.end(), samples.begin());
+  };
+
+  BENCHMARK("Compose span " + std::to_string(length)) {
+    return buffer.Compose(std::span<DataType>(samples));
+  };
+}
+
+TEST_CASE("Channels on a thread pool") {
+  using drift::NullDenoiseAlgorithm;
+
+  /* 3-channel HSL images and 16-channel sensor buffers */
+  const auto [shape, channels] =
+      GENERATE(std::make_tuple(drift::SignalShape{1920, 1080}, size_t{3}),
+               std::make_tuple(drift::SignalShape{48000}, size_t{16}));
+  const size_t threads = GENERATE(1, 2, 4, 8, 16);
+
+  drift::WaveletParameters parameters = {
+      .signal_shape = shape,
+      .signal_number = channels,
+      .decomposition_steps = 5,
+      .wavelet_type = drift::WaveletTypes::kDB3};
+
+  SignalN2D data(channels);
+  for (auto &signal : data) {
+    signal = GetRandomSignal(shape.back(), shape.size() > 1 ? shape[0] : 1)[0];
+  }
+
+  WaveletBuffer buffer(parameters);
+  buffer.SetThreadCount(threads);
+  const auto name = std::to_string(channels) + "x" +
+                    std::to_string(shape.back()) + " " +
+                    std::to_string(threads) + " threads";
+
+  BENCHMARK("Decompose " + name) {
+    return buffer.Decompose(data, NullDenoiseAlgorithm<DataType>());
+  };
+
+  BENCHMARK("Compose " + name) {
+    SignalN2D data_dst;
+    return buffer.Compose(&data_dst);
+  };
+}
+
+TEST_CASE("Single big image on a thread pool") {
+  using drift::NullDenoiseAlgorithm;
+
+  /* One 8K frame, the rows and the columns are split between the threads */
+  const size_t threads = GENERATE(1, 2, 4, 8, 16);
+
+  drift::WaveletParameters parameters = {
+      .signal_shape = {7680, 4320},
+      .signal_number = 1,
+      .decomposition_steps = 5,
+      .wavelet_type = drift::WaveletTypes::kDB3};
+
+  const SignalN2D data = {GetRandomSignal(4320, 7680)[0]};
+
+  WaveletBuffer buffer(parameters);
+  buffer.SetThreadCount(threads);
+  const auto name = "8K " + std::to_string(threads) + " threads";
+
+  BENCHMARK("Decompose " + name) {
+    return buffer.Decompose(data, NullDenoiseAlgorithm<DataType>());
+  };
+
+  BENCHMARK("Compose " + name) {
+    SignalN2D data_dst;
+    return buffer.Compose(&data_dst);
+  };
+}
+
+TEST_CASE("Scratch memory of a padded image") {
+  using drift::BoundaryMode;
+  using drift::NullDenoiseAlgorithm;
+
+  /* A Full HD frame is padded to 1088 rows, the kernels pad and crop it on
+   * the fly, the workspace holds only the levels */
+  const auto mode =
+      GENERATE(BoundaryMode::kPadding, BoundaryMode::kZeroPadding);
+  const drift::WaveletParameters parameters = {
+      .signal_shape = {1920, 1080},
+      .signal_number = 1,
+      .decomposition_steps = 5,
+      .wavelet_type = drift::WaveletTypes::kDB3,
+      .boundary_mode = mode};
+  const SignalN2D data = {GetRandomSignal(1080, 1920)[0]};
+  const auto name =
+      std::string(mode == BoundaryMode::kPadding ? "edge" : "zero") +
+      " padding of 1920x1080";
+
+  drift::Workspace workspace;
+  WaveletBuffer buffer(parameters);
+  buffer.AttachWorkspace(&workspace);
+
+  BENCHMARK("Decompose " + name) {
+    return buffer.Decompose(data, NullDenoiseAlgorithm<DataType>());
+  };
+  WARN("Decompose " << name << ": workspace of " << workspace.capacity()
+                    << " bytes");
+
+  SignalN2D composed;
+  BENCHMARK("Compose " + name) { return buffer.Compose(&composed); };
+  /* The capacity only grows, it is the peak of both */
+  WARN("Compose " << name << ": workspace of " << workspace.capacity()
+                  << " bytes");
+}
+
+TEST_CASE("Batch of small buffers") {
+  using drift::NullDenoiseAlgorithm;
+
+  /* 1000 sensor buffers of different length */
+  const size_t threads = GENERATE(1, 4, 16);
+
+  std::vector<WaveletBuffer> buffers;
+  std::vector<SignalN2D> data;
+  for (size_t i = 0; i < 1000; ++i) {
+    const size_t length = 500 * (1 + i % 8);
+    buffers.emplace_back(drift::WaveletParameters{
+        .signal_shape = {length},
+        .signal_number = 1,
+        .decomposition_steps = 5,
+        .wavelet_type = drift::WaveletTypes::kDB3});
+    data.push_back(GetRandomSignal(length, 1));
+  }
+
+  drift::ThreadPool pool(threads);
+  std::vector<std::string> blobs(buffers.size());
+  const auto name = std::to_string(threads) + " threads";
+
+  BENCHMARK("Decompose 1000 buffers " + name) {
+    return drift::BatchDecompose(buffers, data,
+                                 NullDenoiseAlgorithm<DataType>(), &pool);
+  };
+
+  BENCHMARK("Serialize 1000 buffers " + name) {
+    return drift::BatchSerialize(buffers, blobs, 0, &pool);
+  };
+
+  BENCHMARK("Parse 1000 buffers " + name) {
+    std::vector<std::unique_ptr<WaveletBuffer>> parsed;
+    return drift::BatchParse(blobs, &parsed, &pool);
+  };
+}
+
+TEST_CASE("Frames of a 32-axis accelerometer") {
+  using drift::NullDenoiseAlgorithm;
+
+  /* One second at 4 kHz, the rows are the frames of all axes */
+  const size_t samples = 4096;
+  const size_t channels = 32;
+  const drift::WaveletParameters parameters = {
+      .signal_shape = {samples},
+      .signal_number = channels,
+      .decomposition_steps = 5,
+      .wavelet_type = drift::WaveletTypes::kDB3};
+
+  const drift::Signal2D frames = GetRandomSignal(samples, channels)[0];
+  SignalN2D columns(channels);
+  for (size_t ch = 0; ch < channels; ++ch) {
+    columns[ch] = drift::Signal2D(samples, 1);
+    blaze::column(columns[ch], 0) = blaze::column(frames, ch);
+  }
+
+  drift::Workspace workspace;
+  WaveletBuffer buffer(parameters);
+  buffer.AttachWorkspace(&workspace);
+
+  BENCHMARK("Decompose the channels one by one") {
+    return buffer.Decompose(columns, NullDenoiseAlgorithm<DataType>());
+  };
+
+  BENCHMARK("Decompose interleaved channels") {
+    return buffer.DecomposeInterleaved(frames,
+                                       NullDenoiseAlgorithm<DataType>());
+  };
+
+  BENCHMARK("Compose the channels one by one") {
+    return buffer.Compose(&columns);
+  };
+
+  drift::Signal2D composed;
+  BENCHMARK("Compose interleaved channels") {
+    return buffer.ComposeInterleaved(&composed);
+  };
+}
+
+TEST_CASE("Matrix plans on many threads") {
+  /* Every thread makes the same number of plans, with hits that don't
+   * contend the time stays the same for more threads */
+  const size_t threads = GENERATE(1, 2, 4, 8, 16, 32);
+  const size_t plans_per_thread = 1000;
+
+  const drift::WaveletParameters parameters = {
+      .signal_shape = {1920, 1080},
+      .signal_number = 3,
+      .decomposition_steps = 5,
+      .wavelet_type = drift::WaveletTypes::kDB3};
+  drift::PrewarmMatrixCache(parameters);
+
+  drift::ThreadPool pool(threads);
+  BENCHMARK("Plans of a warm matrix cache " + std::to_string(threads) +
+            " threads") {
+    pool.ParallelFor(threads * plans_per_thread,
+                     [&](size_t, drift::Workspace *) {
+                       const drift::WaveletPlan plan(
+                           parameters, drift::wavelet::Engine::kMatrix);
+                     });
+  };
+}
+
+TEST_CASE("Stream of 48 kHz signal") {
+  /* One second pushed in chunks of 10 ms */
+  const auto signal = GetRandomSignal(48000);
+  constexpr size_t kChunk = 480;
+
+  BENCHMARK("Decompose and compose in chunks") {
+    drift::StreamDecomposer decomposer(drift::WaveletTypes::kDB3, 5);
+    drift::StreamComposer composer(drift::WaveletTypes::kDB3, 5);
+    drift::StreamSubbands subbands;
+    std::vector<DataType> samples;
+    for (size_t pos = 0; pos < signal.size(); pos += kChunk) {
+      for (auto &subband : subbands) {
+        subband.clear();
+      }
+      decomposer.Push({signal.data() + pos, kChunk}, &subbands);
+      composer.Push(subbands, &samples);
+    }
+    return samples.size();
+  };
+}
+
+TEST_CASE("Frame of a line-scan camera") {
+  /* 4096 pixels per row, the subbands are consumed row by row */
+  const drift::WaveletParameters params = {
+      .signal_shape = {4096, 1024},
+      .signal_number = 1,
+      .decomposition_steps = 4,
+      .wavelet_type = drift::WaveletTypes::kDB3};
+  const SignalN2D frame = {blaze::generate<blaze::rowMajor>(
+      1024, 4096, [](size_t i, size_t j) { return (i * j) % 256 / 256.f; })};
+
+  WaveletBuffer buffer(params);
+  BENCHMARK("Decompose the frame") {
+    return buffer.Decompose(frame, drift::NullDenoiseAlgorithm<float>());
+  };
+
+  size_t rows = 0;
+  drift::RowStreamDecomposer decomposer(
+      params, [&](size_t, size_t, std::span<const DataType>) { ++rows; });
+  BENCHMARK("Push the rows") {
+    for (size_t i = 0; i < frame[0].rows(); ++i) {
+      decomposer.Push({frame[0].data(i), frame[0].columns()});
+    }
+    return rows;
+  };
+}
+
+TEST_CASE("Zoom into a big image") {
+  const drift::WaveletParameters params = {
+      .signal_shape = {2048, 2048},
+      .signal_number = 1,
+      .decomposition_steps = 5,
+      .wavelet_type = drift::WaveletTypes::kDB3};
+  WaveletBuffer buffer(params);
+  buffer.Decompose(GetRandomSignal(2048, 2048),
+                   drift::NullDenoiseAlgorithm<float>());
+
+  SignalN2D composed;
+  BENCHMARK("Compose the image and crop it") {
+    buffer.Compose(&composed);
+    return drift::Signal2D(blaze::submatrix(composed[0], 900, 1000, 256, 256));
+  };
+
+  const auto size = GENERATE(size_t{16}, size_t{256});
+  BENCHMARK("Compose a region of " + std::to_string(size) + "x" +
+            std::to_string(size)) {
+    return buffer.Compose({.offset = {1000, 900}, .size = {size, size}},
+                          &composed);
+  };
+}
+
+TEST_CASE("Zoom levels of an image") {
+  const drift::WaveletParameters params = {
+      .signal_shape = {2048, 2048},
+      .signal_number = 1,
+      .decomposition_steps = 5,
+      .wavelet_type = drift::WaveletTypes::kDB3};
+  WaveletBuffer buffer(params);
+  buffer.Decompose(GetRandomSignal(2048, 2048),
+                   drift::NullDenoiseAlgorithm<float>());
+
+  /* A user zooms in from the coarsest level */
+  const size_t budget = GENERATE(size_t{0}, size_t{64} << 20);
+  SignalN2D composed;
+  BENCHMARK("Scale factors 4..0 with a cache of " +
+            std::to_string(budget >> 20) + " MB") {
+    buffer.SetResolutionCache(budget);
+    for (int scale = 4; scale >= 0; --scale) {
+      buffer.Compose(&composed, scale);
+    }
+    buffer.SetResolutionCache(0);
+    return composed[0](0, 0);
+  };
+}
+
+TEST_CASE("Sliding window of 48 kHz signal") {
+  /* A window of one second moved by 10 ms */
+  const auto signal = GetRandomSignal(48000);
+  constexpr size_t kChunk = 480;
+  const drift::WaveletParameters params = {
+      .signal_shape = {48000},
+      .signal_number = 1,
+      .decomposition_steps = 5,
+      .wavelet_type = drift::WaveletTypes::kDB3};
+
+  drift::WaveletBuffer buffer(params);
+  BENCHMARK("Decompose the window") {
+    return buffer.Decompose(signal, drift::NullDenoiseAlgorithm<float>());
+  };
+
+  drift::SlidingWaveletBuffer sliding(params);
+  sliding.Push({signal.data(), signal.size()});
+  size_t pos = 0;
+  BENCHMARK("Push 10 ms") {
+    sliding.Push({signal.data() + pos, kChunk});
+    pos = (pos + kChunk) % signal.size();
+    return pos;
+  };
+}
+
 TEST_CASE("Convolution of long 1D signal") {
   auto k = GENERATE(0.1, 1, 60);
   const size_t length = k * 48000;
@@ -64,6 +491,16 @@ TEST_CASE("Convolution of long 1D signal") {
     return result;
   };
 
+  blaze::DynamicVector<DataType> low;
+  blaze::DynamicVector<DataType> high;
+  std::tie(low, high) = drift::wavelet::dwt(signal, dmat);
+  blaze::CompressedMatrix<DataType> rmat(2, lo_d.size());
+  blaze::row(rmat, 0) = blaze::trans(lo_d);
+  blaze::row(rmat, 1) = blaze::trans(hi_d);
+  BENCHMARK("Raw deconvolve") {
+    return drift::wavelet::idwt(low, high, rmat);
+  };
+
   const blaze::CompressedMatrix<DataType> filter = DaubechiesMat(length, 6);
 
   BENCHMARK("Predefined matrix convolve") {
@@ -72,6 +509,93 @@ TEST_CASE("Convolution of long 1D signal") {
   };
 }
 
+TEST_CASE("Matrix, filter bank and lifting engines 2D") {
+  using drift::NullDenoiseAlgorithm;
+  using drift::wavelet::Engine;
+
+  drift::WaveletParameters parameters = {
+      .signal_shape = {1920, 1080},
+      .signal_number = 1,
+      .decomposition_steps = 5,
+      .wavelet_type = drift::WaveletTypes::kDB3};
+
+  /* Single transform of padded image */
+  const auto padded = GetRandomSignal(1088, 1920);
+  const auto dmat_w = DaubechiesMat(1920, 6);
+  const auto dmat_h = DaubechiesMat(1088, 6);
+  const auto filters = DaubechiesFilters(6);
+  const auto scheme = drift::wavelet::DaubechiesLifting(6);
+
+  BENCHMARK("Matrix dwt2s 1920x1088") {
+    return drift::wavelet::dwt2s(padded[0], dmat_w, dmat_h);
+  };
+
+  BENCHMARK("Filter bank dwt2s 1920x1088") {
+    return drift::wavelet::dwt2s(padded[0], filters);
+  };
+
+  BENCHMARK_ADVANCED("Lifting dwt2s 1920x1088")
+  (Catch::Benchmark::Chronometer meter) {
+    std::vector<drift::Signal2D> images(meter.runs(), padded[0]);
+    meter.measure([&](int i) { drift::wavelet::dwt2s(&images[i], scheme); });
+  };
+
+  /* Whole decomposition */
+  const auto data_src = GetRandomSignal(1080, 1920);
+  drift::NWaveletDecomposition decomposition(
+      1, drift::WaveletDecomposition(drift::DecompositionSize(parameters)));
+
+  const auto engine =
+      GENERATE(Engine::kMatrix, Engine::kFilterBank, Engine::kLifting);
+  const std::string name = engine == Engine::kMatrix       ? "Matrix"
+                           : engine == Engine::kFilterBank ? "Filter bank"
+                                                           : "Lifting";
+
+  BENCHMARK(name + " Decompose 1920x1080") {
+    return drift::internal::DecomposeImpl(parameters, &decomposition, data_src,
+                                          NullDenoiseAlgorithm<DataType>(), 0,
+                                          1, engine);
+  };
+
+  BENCHMARK(name + " Compose 1920x1080") {
+    SignalN2D data_dst;
+    return drift::internal::ComposeImpl(parameters, &data_dst, decomposition,
+                                        0, 0, 1, engine);
+  };
+}
+
+TEST_CASE("Column pass width sweep") {
+  /* Both passes are linear in the image size, the time per element should
+   * stay flat when the columns are processed in cache-line tiles */
+  const size_t width = GENERATE(256, 512, 1024, 2048, 4096, 8192);
+  const size_t height = 512;
+
+  const auto image = GetRandomSignal(height, width)[0];
+  const auto dmat_w = DaubechiesMat(width, 6);
+  const auto dmat_h = DaubechiesMat(height, 6);
+  const auto filters = DaubechiesFilters(6);
+  const auto scheme = drift::wavelet::DaubechiesLifting(6);
+  const std::string size = std::to_string(width) + "x" + std::to_string(height);
+
+  BENCHMARK("Matrix dwt2s " + size) {
+    return drift::wavelet::dwt2s(image, dmat_w, dmat_h);
+  };
+
+  BENCHMARK("Filter bank dwt2s " + size) {
+    return drift::wavelet::dwt2s(image, filters);
+  };
+
+  BENCHMARK("Filter bank idwt2s " + size) {
+    return drift::wavelet::idwt2s(image, filters);
+  };
+
+  BENCHMARK_ADVANCED("Lifting dwt2s " + size)
+  (Catch::Benchmark::Chronometer meter) {
+    std::vector<drift::Signal2D> images(meter.runs(), image);
+    meter.measure([&](int i) { drift::wavelet::dwt2s(&images[i], scheme); });
+  };
+}
+
 TEST_CASE("Wavelet algorithms benchmark 2D") {
   using drift::NullDenoiseAlgorithm;
   using drift::SimpleDenoiseAlgorithm;
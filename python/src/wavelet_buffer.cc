@@ -169,7 +169,9 @@ void WrapWaveletBuffer(py::module *m) {
       py::arg("signal_shape"), py::arg("signal_number"),
       py::arg("decomposition_steps"), py::arg("wavelet_type"));
 
-  cls.def_static("parse", &Class::Parse, py::arg("blob"));
+  cls.def_static(
+      "parse", [](const std::string &blob) { return Class::Parse(blob); },
+      py::arg("blob"));
 
   cls.def(
       "decompose",
@@ -0,0 +1,45 @@
+// Copyright 2023 PANDA GmbH
+
+#include <immintrin.h>
+
+#include "internal/dwt_simd.h"
+#include "internal/dwt_simd_impl.h"
+
+/* Compiled with -mavx2 -mfma */
+
+namespace drift::wavelet::internal {
+
+struct Avx2 {
+  using Vec = __m256;
+  static constexpr size_t kWidth = 8;
+
+  static Vec Load(const float* p) { return _mm256_loadu_ps(p); }
+  static void Store(float* p, Vec v) { _mm256_storeu_ps(p, v); }
+  static Vec Set1(float x) { return _mm256_set1_ps(x); }
+  static Vec Zero() { return _mm256_setzero_ps(); }
+  static Vec MulAdd(Vec a, Vec b, Vec c) { return _mm256_fmadd_ps(a, b, c); }
+
+  static void Deinterleave(const float* p, Vec* even, Vec* odd) {
+    const Vec a = _mm256_loadu_ps(p);
+    const Vec b = _mm256_loadu_ps(p + 8);
+    /* Shuffles work within 128-bit lanes, fix the order of 64-bit pairs */
+    const Vec e = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    const Vec o = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    *even = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(e),
+                                                   _MM_SHUFFLE(3, 1, 2, 0)));
+    *odd = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(o),
+                                                  _MM_SHUFFLE(3, 1, 2, 0)));
+  }
+
+  static void Interleave(Vec even, Vec odd, float* p) {
+    const Vec lo = _mm256_unpacklo_ps(even, odd);
+    const Vec hi = _mm256_unpackhi_ps(even, odd);
+    _mm256_storeu_ps(p, _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps(p + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+  }
+};
+
+const SimdKernels kAvx2Kernels = {SimdLevel::kAvx2, AnalyzeInterior<Avx2>,
+                                  SynthesizeInterior<Avx2>};
+
+}  // namespace drift::wavelet::internal
@@ -0,0 +1,49 @@
+// Copyright 2023 PANDA GmbH
+
+#include <immintrin.h>
+
+#include "internal/dwt_simd.h"
+#include "internal/dwt_simd_impl.h"
+
+/* Compiled with -mavx512f */
+
+namespace drift::wavelet::internal {
+
+struct Avx512 {
+  using Vec = __m512;
+  static constexpr size_t kWidth = 16;
+
+  static Vec Load(const float* p) { return _mm512_loadu_ps(p); }
+  static void Store(float* p, Vec v) { _mm512_storeu_ps(p, v); }
+  static Vec Set1(float x) { return _mm512_set1_ps(x); }
+  static Vec Zero() { return _mm512_setzero_ps(); }
+  static Vec MulAdd(Vec a, Vec b, Vec c) { return _mm512_fmadd_ps(a, b, c); }
+
+  static void Deinterleave(const float* p, Vec* even, Vec* odd) {
+    const Vec a = _mm512_loadu_ps(p);
+    const Vec b = _mm512_loadu_ps(p + 16);
+    const __m512i even_index =
+        _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26,
+                          28, 30);
+    const __m512i odd_index =
+        _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27,
+                          29, 31);
+    *even = _mm512_permutex2var_ps(a, even_index, b);
+    *odd = _mm512_permutex2var_ps(a, odd_index, b);
+  }
+
+  static void Interleave(Vec even, Vec odd, float* p) {
+    const __m512i lo_index = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4,
+                                               20, 5, 21, 6, 22, 7, 23);
+    const __m512i hi_index = _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27,
+                                               12, 28, 13, 29, 14, 30, 15, 31);
+    _mm512_storeu_ps(p, _mm512_permutex2var_ps(even, lo_index, odd));
+    _mm512_storeu_ps(p + 16, _mm512_permutex2var_ps(even, hi_index, odd));
+  }
+};
+
+const SimdKernels kAvx512Kernels = {SimdLevel::kAvx512,
+                                    AnalyzeInterior<Avx512>,
+                                    SynthesizeInterior<Avx512>};
+
+}  // namespace drift::wavelet::internal
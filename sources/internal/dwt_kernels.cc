@@ -0,0 +1,588 @@
+// Copyright 2023 PANDA GmbH
+
+#include "internal/dwt_kernels.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <type_traits>
+
+#include "internal/dwt_simd.h"
+
+namespace drift::wavelet::internal {
+
+static_assert(std::is_same_v<DataType, float>,
+              "vectorized kernels are implemented for float");
+
+/**
+ * Vectorized kernels if the lines are contiguous and the filters are short
+ * enough
+ */
+static const SimdKernels* SelectSimdKernels(
+    size_t length, std::initializer_list<size_t> strides) {
+  if (length > kMaxSimdTaps) {
+    return nullptr;
+  }
+  for (auto stride : strides) {
+    if (stride != 1) {
+      return nullptr;
+    }
+  }
+  return ActiveSimdKernels();
+}
+
+/**
+ * Sample of the periodic extension of a padded line
+ * @return nullptr for a zero of the padding
+ */
+static const DataType* PaddedSample(StridedLine<const DataType> src,
+                                    const LinePadding& padding,
+                                    size_t index) {
+  const size_t j = index % padding.padded;
+  if (j >= padding.offset && j - padding.offset < padding.size) {
+    return &src[j - padding.offset];
+  }
+  if (padding.extension == Extension::kZero) {
+    return nullptr;
+  }
+  return &src[j < padding.offset ? 0 : padding.size - 1];
+}
+
+static DataType PaddedValue(StridedLine<const DataType> src,
+                            const LinePadding& padding, size_t index) {
+  const DataType* x = PaddedSample(src, padding, index);
+  return x ? *x : DataType(0);
+}
+
+template <typename Taps>
+void AnalyzeLine(StridedLine<const DataType> src, size_t size,
+                 const Taps& taps, StridedLine<DataType> low,
+                 StridedLine<DataType> high) {
+  AnalyzePaddedLine(src, EvenPadding(size), taps, low, high);
+}
+
+template <typename Taps>
+void AnalyzePaddedLine(StridedLine<const DataType> src,
+                       const LinePadding& padding, const Taps& taps,
+                       StridedLine<DataType> low, StridedLine<DataType> high) {
+  const size_t padded = padding.padded;
+  const size_t half = padded / 2;
+
+  /* Interior: the support of the filters doesn't cross the end of the
+   * padded line */
+  const size_t interior = padded >= taps.length
+                              ? std::min(half, (padded - taps.length) / 2 + 1)
+                              : 0;
+
+  /* Samples [begin, end) of the padded line lie in the line */
+  auto inside = [&padding](size_t begin, size_t end) {
+    return begin >= padding.offset && end <= padding.offset + padding.size;
+  };
+
+  if (const auto* simd = SelectSimdKernels(
+          taps.length, {src.stride, low.stride, high.stride})) {
+    /* The blocks of the vectorized kernels read the line in place, only
+     * those reaching the padding are gathered. The sums don't depend on
+     * where the samples are */
+    DataType samples[2 * kSimdBlock + kMaxSimdTaps];
+    for (size_t first = 0; first < interior; first += kSimdBlock) {
+      const size_t count = std::min(kSimdBlock, interior - first);
+      const size_t begin = 2 * first;
+      const size_t end = 2 * (first + count) + taps.length - 2;
+      const DataType* x = samples;
+      if (inside(begin, end)) {
+        x = &src[begin - padding.offset];
+      } else {
+        for (size_t j = begin; j < end; ++j) {
+          samples[j - begin] = PaddedValue(src, padding, j);
+        }
+      }
+      simd->analyze(x, count, taps.low, taps.high, taps.length, &low[first],
+                    &high[first]);
+    }
+  } else {
+    for (size_t i = 0; i < interior; ++i) {
+      DataType l = 0;
+      DataType h = 0;
+      if (inside(2 * i, 2 * i + taps.length)) {
+        const StridedLine<const DataType> x{&src[2 * i - padding.offset],
+                                            src.stride};
+        for (size_t k = 0; k < taps.length; ++k) {
+          l += taps.low[k] * x[k];
+          h += taps.high[k] * x[k];
+        }
+      } else {
+        for (size_t k = 0; k < taps.length; ++k) {
+          const DataType x = PaddedValue(src, padding, 2 * i + k);
+          l += taps.low[k] * x;
+          h += taps.high[k] * x;
+        }
+      }
+      low[i] = l;
+      high[i] = h;
+    }
+  }
+
+  /* Boundary: periodic padding */
+  for (size_t i = interior; i < half; ++i) {
+    DataType l = 0;
+    DataType h = 0;
+    for (size_t k = 0; k < taps.length; ++k) {
+      const DataType x = PaddedValue(src, padding, 2 * i + k);
+      l += taps.low[k] * x;
+      h += taps.high[k] * x;
+    }
+    low[i] = l;
+    high[i] = h;
+  }
+}
+
+template <typename Taps>
+void AnalyzeSegment(const DataType* src, size_t size, size_t first,
+                    size_t count, const Taps& taps, DataType* low,
+                    DataType* high) {
+  const size_t half = size / 2;
+
+  /* The interior of the line in the segment, the vectorized blocks start
+   * at the same coefficients as for the whole line */
+  const size_t end =
+      size >= taps.length ? std::min(half, (size - taps.length) / 2 + 1) : 0;
+  const size_t interior = end > first ? std::min(count, end - first) : 0;
+  if (const auto* simd = SelectSimdKernels(taps.length, {})) {
+    simd->analyze(src, interior, taps.low, taps.high, taps.length, low, high);
+  } else {
+    for (size_t i = 0; i < interior; ++i) {
+      const DataType* x = src + 2 * i;
+      DataType l = 0;
+      DataType h = 0;
+      for (size_t k = 0; k < taps.length; ++k) {
+        l += taps.low[k] * x[k];
+        h += taps.high[k] * x[k];
+      }
+      low[i] = l;
+      high[i] = h;
+    }
+  }
+
+  /* Boundary: the samples are wrapped by the caller, the sums are those of
+   * the periodic padding of AnalyzeLine */
+  for (size_t i = interior; i < count; ++i) {
+    DataType l = 0;
+    DataType h = 0;
+    for (size_t k = 0; k < taps.length; ++k) {
+      const DataType x = src[2 * i + k];
+      l += taps.low[k] * x;
+      h += taps.high[k] * x;
+    }
+    low[i] = l;
+    high[i] = h;
+  }
+}
+
+template <typename Taps>
+void SynthesizeLine(StridedLine<const DataType> low,
+                    StridedLine<const DataType> high, size_t size,
+                    const Taps& taps, StridedLine<DataType> dst) {
+  const size_t half = (size + 1) / 2;
+  const size_t phase_taps = taps.length / 2;
+
+  /* Even output samples gather even taps, odd ones gather odd taps:
+   *   dst[2p + r] = sum_m taps[2m + r] * subband[(p - m) mod half] */
+  auto gather = [&](size_t p, auto wrap) {
+    DataType even = 0;
+    DataType odd = 0;
+    for (size_t m = 0; m < phase_taps; ++m) {
+      const size_t j = wrap(p, m);
+      even += taps.low[2 * m] * low[j] + taps.high[2 * m] * high[j];
+      odd += taps.low[2 * m + 1] * low[j] + taps.high[2 * m + 1] * high[j];
+    }
+    dst[2 * p] = even;
+    /* The extension of an odd line isn't written */
+    if (2 * p + 1 < size) {
+      dst[2 * p + 1] = odd;
+    }
+  };
+
+  /* Boundary: periodic padding */
+  const size_t boundary = std::min(half, phase_taps - 1);
+  for (size_t p = 0; p < boundary; ++p) {
+    gather(p, [half, phase_taps](size_t i, size_t m) {
+      return (i + half * phase_taps - m) % half;
+    });
+  }
+
+  /* Interior: the support of the filters doesn't cross the start of the
+   * subbands, the vectorized kernels write whole pairs */
+  size_t p = boundary;
+  if (const auto* simd = SelectSimdKernels(
+          taps.length, {low.stride, high.stride, dst.stride})) {
+    const size_t pairs = std::max(boundary, size / 2);
+    simd->synthesize(low.data, high.data, boundary, pairs, taps.low,
+                     taps.high, taps.length, dst.data);
+    p = pairs;
+  }
+  for (; p < half; ++p) {
+    gather(p, [](size_t i, size_t m) { return i - m; });
+  }
+}
+
+/**
+ * Periodic index of a line
+ */
+static size_t Wrap(std::ptrdiff_t index, size_t size) {
+  const auto n = static_cast<std::ptrdiff_t>(size);
+  return static_cast<size_t>(((index % n) + n) % n);
+}
+
+void SplitLine(StridedLine<const DataType> src, size_t size, size_t low_parity,
+               int low_shift, int high_shift, StridedLine<DataType> low,
+               StridedLine<DataType> high, size_t width) {
+  const size_t half = size / 2;
+  const size_t high_parity = 1 - low_parity;
+  for (size_t i = 0; i < half; ++i) {
+    const auto k = static_cast<std::ptrdiff_t>(i);
+    const DataType* even = &src[Wrap(2 * (k + low_shift) + low_parity, size)];
+    const DataType* odd = &src[Wrap(2 * (k + high_shift) + high_parity, size)];
+    std::copy_n(even, width, &low[i]);
+    std::copy_n(odd, width, &high[i]);
+  }
+}
+
+/**
+ * Reverse the order of the elements [begin, end) of a line in place
+ */
+static void ReverseLine(StridedLine<DataType> line, size_t begin, size_t end,
+                        size_t width) {
+  for (; begin + 1 < end; ++begin, --end) {
+    std::swap_ranges(&line[begin], &line[begin] + width, &line[end - 1]);
+  }
+}
+
+/**
+ * Rotate a line in place, line[i] = line[(i + shift) mod size]
+ */
+static void RotateLine(StridedLine<DataType> line, size_t size, size_t shift,
+                       size_t width) {
+  if (size == 0 || shift % size == 0) {
+    return;
+  }
+
+  shift %= size;
+  ReverseLine(line, 0, shift, width);
+  ReverseLine(line, shift, size, width);
+  ReverseLine(line, 0, size, width);
+}
+
+void DeinterleaveLine(StridedLine<DataType> line, size_t size,
+                      size_t low_parity, int low_shift, int high_shift,
+                      StridedLine<DataType> scratch, size_t width) {
+  const size_t half = size / 2;
+  if (half == 0) {
+    return;
+  }
+
+  const size_t high_parity = 1 - low_parity;
+  for (size_t i = 0; i < half; ++i) {
+    const size_t k = Wrap(static_cast<std::ptrdiff_t>(i) + high_shift, half);
+    std::copy_n(&line[2 * k + high_parity], width, &scratch[i]);
+  }
+
+  /* Element i is overwritten after it has been moved, 2 * i + low_parity
+   * isn't less than i: the low phase moves to the front in place */
+  for (size_t i = low_parity == 0 ? 1 : 0; i < half; ++i) {
+    std::copy_n(&line[2 * i + low_parity], width, &line[i]);
+  }
+  RotateLine(line, half, Wrap(low_shift, half), width);
+
+  for (size_t i = 0; i < half; ++i) {
+    std::copy_n(&scratch[i], width, &line[half + i]);
+  }
+}
+
+void InterleaveLine(StridedLine<DataType> line, size_t size,
+                    size_t low_parity, int low_shift, int high_shift,
+                    StridedLine<DataType> scratch, size_t width) {
+  const size_t half = size / 2;
+  if (half == 0) {
+    return;
+  }
+
+  const size_t high_parity = 1 - low_parity;
+  for (size_t i = 0; i < half; ++i) {
+    std::copy_n(&line[half + i], width, &scratch[i]);
+  }
+
+  /* The low phase moves back from the end, where it doesn't overwrite the
+   * elements it still has to move */
+  RotateLine(line, half, Wrap(-low_shift, half), width);
+  for (size_t i = half; i-- > (low_parity == 0 ? 1 : 0);) {
+    std::copy_n(&line[i], width, &line[2 * i + low_parity]);
+  }
+
+  for (size_t i = 0; i < half; ++i) {
+    const size_t k = Wrap(static_cast<std::ptrdiff_t>(i) + high_shift, half);
+    std::copy_n(&scratch[i], width, &line[2 * k + high_parity]);
+  }
+}
+
+void LiftStep(StridedLine<const DataType> source, size_t size, int offset,
+              const DataType* coefficients, size_t length, DataType sign,
+              StridedLine<DataType> target, size_t width) {
+  if (size == 0) {
+    return;
+  }
+
+  /* Interior: 0 <= i + offset and i + offset + length - 1 < size */
+  const auto n = static_cast<std::ptrdiff_t>(size);
+  const auto last = offset + static_cast<std::ptrdiff_t>(length) - 1;
+  const auto begin = std::clamp<std::ptrdiff_t>(-offset, 0, n);
+  const auto end = std::clamp<std::ptrdiff_t>(
+      n - std::max<std::ptrdiff_t>(last, 0), begin, n);
+
+  auto update = [&](std::ptrdiff_t i, auto index) {
+    DataType* t = &target[i];
+    for (size_t j = 0; j < length; ++j) {
+      const auto k = i + offset + static_cast<std::ptrdiff_t>(j);
+      const DataType* x = &source[index(k)];
+      const DataType factor = sign * coefficients[j];
+      for (size_t c = 0; c < width; ++c) {
+        t[c] += factor * x[c];
+      }
+    }
+  };
+
+  /* Boundary: periodic padding */
+  for (std::ptrdiff_t i = 0; i < begin; ++i) {
+    update(i, [size](std::ptrdiff_t k) { return Wrap(k, size); });
+  }
+  for (std::ptrdiff_t i = end; i < n; ++i) {
+    update(i, [size](std::ptrdiff_t k) { return Wrap(k, size); });
+  }
+
+  /* Interior */
+  for (std::ptrdiff_t i = begin; i < end; ++i) {
+    update(i, [](std::ptrdiff_t k) { return static_cast<size_t>(k); });
+  }
+}
+
+void ScaleLine(StridedLine<DataType> line, size_t size, DataType factor,
+               size_t width) {
+  for (size_t i = 0; i < size; ++i) {
+    DataType* x = &line[i];
+    for (size_t c = 0; c < width; ++c) {
+      x[c] *= factor;
+    }
+  }
+}
+
+/**
+ * Analysis of `count` rows of adjacent columns, the input row of each tap is
+ * given by a function, so the periodic and the segment kernels share the sums
+ * @param row function of the output row and the tap returning the input row,
+ * nullptr for a row of zeros
+ */
+template <typename Taps, typename Row>
+static void AnalyzeColumnTiles(size_t count, size_t width, const Taps& taps,
+                               StridedLine<DataType> low,
+                               StridedLine<DataType> high, Row row) {
+  /* A tile of columns is convolved row by row, every loaded cache line is
+   * reused by all columns of the tile */
+  auto analyze_tile = [&](size_t first, auto tile_width) {
+    const size_t w = tile_width;
+    for (size_t i = 0; i < count; ++i) {
+      DataType l[kColumnTile] = {};
+      DataType h[kColumnTile] = {};
+      for (size_t k = 0; k < taps.length; ++k) {
+        const DataType* x = row(i, k);
+        if (!x) {
+          continue;
+        }
+        x += first;
+        for (size_t c = 0; c < w; ++c) {
+          l[c] += taps.low[k] * x[c];
+          h[c] += taps.high[k] * x[c];
+        }
+      }
+      std::copy_n(l, w, &low[i] + first);
+      std::copy_n(h, w, &high[i] + first);
+    }
+  };
+
+  size_t first = 0;
+  for (; first + kColumnTile <= width; first += kColumnTile) {
+    analyze_tile(first, std::integral_constant<size_t, kColumnTile>{});
+  }
+  if (first < width) {
+    analyze_tile(first, width - first);
+  }
+}
+
+template <typename Taps>
+void AnalyzeColumns(StridedLine<const DataType> src, size_t size,
+                    size_t width, const Taps& taps, StridedLine<DataType> low,
+                    StridedLine<DataType> high) {
+  AnalyzePaddedColumns(src, EvenPadding(size), width, taps, low, high);
+}
+
+template <typename Taps>
+void AnalyzePaddedColumns(StridedLine<const DataType> src,
+                          const LinePadding& padding, size_t width,
+                          const Taps& taps, StridedLine<DataType> low,
+                          StridedLine<DataType> high) {
+  AnalyzeColumnTiles(padding.padded / 2, width, taps, low, high,
+                     [src, &padding](size_t i, size_t k) {
+                       return PaddedSample(src, padding, 2 * i + k);
+                     });
+}
+
+template <typename Taps>
+void AnalyzeColumnSegment(StridedLine<const DataType> src, size_t count,
+                          size_t width, const Taps& taps,
+                          StridedLine<DataType> low,
+                          StridedLine<DataType> high) {
+  AnalyzeColumnTiles(count, width, taps, low, high,
+                     [src](size_t i, size_t k) { return &src[2 * i + k]; });
+}
+
+template <typename Taps>
+void SynthesizeColumns(StridedLine<const DataType> low,
+                       StridedLine<const DataType> high, size_t size,
+                       size_t width, const Taps& taps,
+                       StridedLine<DataType> dst) {
+  SynthesizeCroppedColumns(low, high, EvenPadding(size), width, taps, dst);
+}
+
+template <typename Taps>
+void SynthesizeCroppedColumns(StridedLine<const DataType> low,
+                              StridedLine<const DataType> high,
+                              const LinePadding& padding, size_t width,
+                              const Taps& taps, StridedLine<DataType> dst) {
+  const size_t half = padding.padded / 2;
+  const size_t phase_taps = taps.length / 2;
+
+  /* Only the pairs of the samples of the line */
+  const size_t begin = padding.offset / 2;
+  const size_t end = (padding.offset + padding.size + 1) / 2;
+  auto write = [&](size_t index, const DataType* values, size_t w,
+                   size_t first) {
+    if (index >= padding.offset && index - padding.offset < padding.size) {
+      std::copy_n(values, w, &dst[index - padding.offset] + first);
+    }
+  };
+
+  auto synthesize_tile = [&](size_t first, auto tile_width) {
+    const size_t w = tile_width;
+    for (size_t p = begin; p < end; ++p) {
+      DataType even[kColumnTile] = {};
+      DataType odd[kColumnTile] = {};
+      for (size_t m = 0; m < phase_taps; ++m) {
+        const size_t j = (p + half * phase_taps - m) % half;
+        const DataType* l = &low[j] + first;
+        const DataType* h = &high[j] + first;
+        for (size_t c = 0; c < w; ++c) {
+          even[c] += taps.low[2 * m] * l[c] + taps.high[2 * m] * h[c];
+          odd[c] += taps.low[2 * m + 1] * l[c] + taps.high[2 * m + 1] * h[c];
+        }
+      }
+      write(2 * p, even, w, first);
+      write(2 * p + 1, odd, w, first);
+    }
+  };
+
+  size_t first = 0;
+  for (; first + kColumnTile <= width; first += kColumnTile) {
+    synthesize_tile(first, std::integral_constant<size_t, kColumnTile>{});
+  }
+  if (first < width) {
+    synthesize_tile(first, width - first);
+  }
+}
+
+template <typename Taps>
+void SynthesizeSegment(StridedLine<const DataType> low,
+                       StridedLine<const DataType> high, std::ptrdiff_t first,
+                       size_t count, size_t width, const Taps& taps,
+                       StridedLine<DataType> dst) {
+  const size_t phase_taps = taps.length / 2;
+  const std::ptrdiff_t first_pair = FloorHalf(first);
+
+  /* Sample q of pair p gathers the taps of its phase:
+   *   dst[q] = sum_m taps[2m + q - 2p] * subband[p - m] */
+  auto synthesize_tile = [&](size_t begin, auto tile_width) {
+    const size_t w = tile_width;
+    for (size_t j = 0; j < count; ++j) {
+      const std::ptrdiff_t q = first + static_cast<std::ptrdiff_t>(j);
+      const std::ptrdiff_t p = FloorHalf(q);
+      const auto r = static_cast<size_t>(q - 2 * p);
+      const size_t last = static_cast<size_t>(p - first_pair) + phase_taps - 1;
+      DataType sum[kColumnTile] = {};
+      for (size_t m = 0; m < phase_taps; ++m) {
+        const DataType* l = &low[last - m] + begin;
+        const DataType* h = &high[last - m] + begin;
+        for (size_t c = 0; c < w; ++c) {
+          sum[c] += taps.low[2 * m + r] * l[c] + taps.high[2 * m + r] * h[c];
+        }
+      }
+      std::copy_n(sum, w, &dst[j] + begin);
+    }
+  };
+
+  size_t begin = 0;
+  for (; begin + kColumnTile <= width; begin += kColumnTile) {
+    synthesize_tile(begin, std::integral_constant<size_t, kColumnTile>{});
+  }
+  if (begin < width) {
+    synthesize_tile(begin, width - begin);
+  }
+}
+
+/* The kernels are instantiated for the runtime filters and for the
+ * compile-time filters of every wavelet type */
+#define INSTANTIATE_DWT_KERNELS(Taps)                                        \
+  template void AnalyzeLine(StridedLine<const DataType>, size_t,            \
+                            const Taps&, StridedLine<DataType>,             \
+                            StridedLine<DataType>);                         \
+  template void AnalyzePaddedLine(StridedLine<const DataType>,              \
+                                  const LinePadding&, const Taps&,          \
+                                  StridedLine<DataType>,                    \
+                                  StridedLine<DataType>);                   \
+  template void SynthesizeLine(StridedLine<const DataType>,                 \
+                               StridedLine<const DataType>, size_t,         \
+                               const Taps&, StridedLine<DataType>);         \
+  template void AnalyzeSegment(const DataType*, size_t, size_t, size_t,     \
+                               const Taps&, DataType*, DataType*);          \
+  template void AnalyzeColumns(StridedLine<const DataType>, size_t, size_t, \
+                               const Taps&, StridedLine<DataType>,          \
+                               StridedLine<DataType>);                      \
+  template void AnalyzePaddedColumns(StridedLine<const DataType>,           \
+                                     const LinePadding&, size_t,            \
+                                     const Taps&, StridedLine<DataType>,    \
+                                     StridedLine<DataType>);                \
+  template void AnalyzeColumnSegment(StridedLine<const DataType>, size_t,   \
+                                     size_t, const Taps&,                   \
+                                     StridedLine<DataType>,                 \
+                                     StridedLine<DataType>);                \
+  template void SynthesizeColumns(StridedLine<const DataType>,              \
+                                  StridedLine<const DataType>, size_t,      \
+                                  size_t, const Taps&,                      \
+                                  StridedLine<DataType>);                   \
+  template void SynthesizeCroppedColumns(StridedLine<const DataType>,       \
+                                         StridedLine<const DataType>,       \
+                                         const LinePadding&, size_t,        \
+                                         const Taps&,                       \
+                                         StridedLine<DataType>);            \
+  template void SynthesizeSegment(StridedLine<const DataType>,              \
+                                  StridedLine<const DataType>,              \
+                                  std::ptrdiff_t, size_t, size_t,           \
+                                  const Taps&, StridedLine<DataType>);
+
+INSTANTIATE_DWT_KERNELS(FilterTaps)
+INSTANTIATE_DWT_KERNELS(StaticTaps<kDB1>)
+INSTANTIATE_DWT_KERNELS(StaticTaps<kDB2>)
+INSTANTIATE_DWT_KERNELS(StaticTaps<kDB3>)
+INSTANTIATE_DWT_KERNELS(StaticTaps<kDB4>)
+INSTANTIATE_DWT_KERNELS(StaticTaps<kDB5>)
+
+#undef INSTANTIATE_DWT_KERNELS
+
+}  // namespace drift::wavelet::internal
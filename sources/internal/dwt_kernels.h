@@ -0,0 +1,415 @@
+// Copyright 2023 PANDA GmbH
+#ifndef SOURCES_INTERNAL_DWT_KERNELS_H_
+#define SOURCES_INTERNAL_DWT_KERNELS_H_
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "internal/daubechies_tables.h"
+#include "wavelet_buffer/primitives.h"
+#include "wavelet_buffer/wavelet_parameters.h"
+
+namespace drift::wavelet::internal {
+
+/**
+ * Non-owning view of a pair of analysis filters
+ */
+struct FilterTaps {
+  const DataType* low;  /**< low-pass filter in convolution order */
+  const DataType* high; /**< high-pass filter in convolution order */
+  size_t length;        /**< number of taps in each filter (even) */
+};
+
+/**
+ * Low-pass filter in convolution order from a scaling filter, rounded the
+ * same way as Orthfilt() does
+ */
+template <size_t N>
+constexpr std::array<DataType, N> LowPassTaps(
+    const std::array<double, N>& scaling) {
+  constexpr double kSqrt2 = 1.4142135623730951;
+  std::array<DataType, N> taps{};
+  for (size_t i = 0; i < N; ++i) {
+    taps[i] = static_cast<DataType>(kSqrt2 * static_cast<DataType>(scaling[i]));
+  }
+  return taps;
+}
+
+/**
+ * High-pass filter in convolution order, the quadrature mirror of the
+ * low-pass one
+ */
+template <size_t N>
+constexpr std::array<DataType, N> HighPassTaps(
+    const std::array<DataType, N>& low) {
+  std::array<DataType, N> taps{};
+  for (size_t i = 0; i < N; ++i) {
+    taps[i] = i % 2 == 0 ? low[N - 1 - i] : -low[N - 1 - i];
+  }
+  return taps;
+}
+
+/**
+ * Filters of a Daubechies wavelet known at compile time, the same as
+ * DaubechiesFilters(). The members mirror FilterTaps, so the kernels unroll
+ * the loops over the taps and keep the coefficients as constants
+ */
+template <WaveletTypes W>
+struct StaticTaps {
+  static constexpr size_t length = 2 * W;
+  static constexpr std::array<DataType, length> kLowPass =
+      LowPassTaps(kDaubechiesScaling<W>);
+  static constexpr std::array<DataType, length> kHighPass =
+      HighPassTaps(kLowPass);
+  static constexpr const DataType* low = kLowPass.data();
+  static constexpr const DataType* high = kHighPass.data();
+};
+
+/**
+ * Non-owning view of a line of a signal with a constant distance between
+ * its elements (1 for rows, spacing of the matrix for columns)
+ */
+template <typename T>
+struct StridedLine {
+  T* data;
+  size_t stride;
+
+  T& operator[](size_t i) const { return data[i * stride]; }
+
+  operator StridedLine<const T>() const requires(!std::is_const_v<T>) {
+    return {data, stride};
+  }
+};
+
+/**
+ * Non-owning view of a row-major matrix
+ */
+template <typename T>
+struct MatrixView {
+  T* data;
+  size_t rows;
+  size_t columns;
+  size_t spacing; /**< distance between the rows */
+
+  T* row(size_t i) const { return data + i * spacing; }
+
+  operator MatrixView<const T>() const requires(!std::is_const_v<T>) {
+    return {data, rows, columns, spacing};
+  }
+};
+
+/**
+ * View of a Blaze matrix or another row-major matrix with the same accessors
+ */
+template <typename Matrix>
+auto ViewOf(Matrix& matrix) {
+  return MatrixView<std::remove_pointer_t<decltype(matrix.data())>>{
+      matrix.data(), matrix.rows(), matrix.columns(), matrix.spacing()};
+}
+
+/**
+ * Values of a padded line out of its samples, see PaddingAlgorithm
+ */
+enum class Extension {
+  kEdge, /**< the edge samples are repeated (zero derivative) */
+  kZero,
+};
+
+/**
+ * Padding of a line done by the kernels when they read it: the `size`
+ * samples of the line lie at `offset` in the periodic padded line of
+ * `padded` samples, which is never stored
+ */
+struct LinePadding {
+  size_t size;
+  size_t padded; /**< even, not less than offset + size */
+  size_t offset;
+  Extension extension = Extension::kEdge;
+};
+
+/**
+ * Padding of a line to the even length, an odd line is extended by its last
+ * sample
+ */
+constexpr LinePadding EvenPadding(size_t size) {
+  return {size, size + size % 2, 0};
+}
+
+/**
+ * Periodic analysis of one line: convolution with both filters and
+ * downsampling by two
+ *
+ *   low[i]  = sum_k taps.low[k]  * src[(2i + k) mod size]
+ *   high[i] = sum_k taps.high[k] * src[(2i + k) mod size]
+ *
+ * An odd line is extended by its last sample to the even length, so it
+ * needs no padded copy and the last coefficients cover the extension
+ * @param src input line of `size` elements
+ * @param size length of the input
+ * @param taps filters
+ * @param low output line of `(size + 1) / 2` approximation coefficients
+ * @param high output line of `(size + 1) / 2` detail coefficients
+ * @tparam Taps FilterTaps or StaticTaps
+ */
+template <typename Taps>
+void AnalyzeLine(StridedLine<const DataType> src, size_t size,
+                 const Taps& taps, StridedLine<DataType> low,
+                 StridedLine<DataType> high);
+
+/**
+ * Periodic analysis of a line padded on the fly, the results are the same as
+ * of AnalyzeLine of the padded line
+ * @param src input line of `padding.size` elements
+ * @param padding
+ * @param taps filters
+ * @param low output line of `padding.padded / 2` approximation coefficients
+ * @param high output line of `padding.padded / 2` detail coefficients
+ */
+template <typename Taps>
+void AnalyzePaddedLine(StridedLine<const DataType> src,
+                       const LinePadding& padding, const Taps& taps,
+                       StridedLine<DataType> low, StridedLine<DataType> high);
+
+/**
+ * Periodic synthesis of one line, the inverse (adjoint) of AnalyzeLine
+ *
+ *   dst[(2i + k) mod size] += taps.low[k] * low[i] + taps.high[k] * high[i]
+ *
+ * @param low input line of `(size + 1) / 2` approximation coefficients
+ * @param high input line of `(size + 1) / 2` detail coefficients
+ * @param size length of the output, the extension of an odd line isn't
+ * written
+ * @param taps filters used for the analysis
+ * @param dst output line of `size` elements, it is overwritten
+ */
+template <typename Taps>
+void SynthesizeLine(StridedLine<const DataType> low,
+                    StridedLine<const DataType> high, size_t size,
+                    const Taps& taps, StridedLine<DataType> dst);
+
+/**
+ * Coefficients [first, first + count) of the periodic analysis of a line
+ * without the rest of the line in memory
+ *
+ *   src[j] = line[(2 * first + j) mod size], 0 <= j < 2 * count + length - 2
+ *
+ * The results are the same as of AnalyzeLine if first is a multiple of
+ * kSimdBlock and the segment ends at a multiple of it or at the end of the
+ * line
+ * @param src contiguous samples under the filters of the segment
+ * @param size length of the whole line, must be even
+ * @param first the first coefficient
+ * @param count the number of the coefficients, up to size / 2 - first
+ * @param taps filters
+ * @param low output of `count` approximation coefficients
+ * @param high output of `count` detail coefficients
+ */
+template <typename Taps>
+void AnalyzeSegment(const DataType* src, size_t size, size_t first,
+                    size_t count, const Taps& taps, DataType* low,
+                    DataType* high);
+
+/**
+ * Number of adjacent columns processed together by the column kernels, it is
+ * a cache line of floats
+ */
+constexpr size_t kColumnTile = 16;
+
+/**
+ * Periodic analysis of `width` adjacent columns of a row-major matrix, the
+ * same as AnalyzeLine for each column
+ * @param src first column of the input, the stride is a row of the matrix
+ * @param size number of rows of the input, odd columns are extended
+ * @param width number of columns
+ * @param taps filters
+ * @param low first column of `(size + 1) / 2` approximation rows
+ * @param high first column of `(size + 1) / 2` detail rows
+ */
+template <typename Taps>
+void AnalyzeColumns(StridedLine<const DataType> src, size_t size,
+                    size_t width, const Taps& taps, StridedLine<DataType> low,
+                    StridedLine<DataType> high);
+
+/**
+ * Analysis of `width` adjacent columns padded on the fly, the same as
+ * AnalyzePaddedLine for each column
+ * @param src first column of `padding.size` rows
+ * @param padding
+ * @param width number of columns
+ * @param taps filters
+ * @param low first column of `padding.padded / 2` approximation rows
+ * @param high first column of `padding.padded / 2` detail rows
+ */
+template <typename Taps>
+void AnalyzePaddedColumns(StridedLine<const DataType> src,
+                          const LinePadding& padding, size_t width,
+                          const Taps& taps, StridedLine<DataType> low,
+                          StridedLine<DataType> high);
+
+/**
+ * Rows [first, first + count) of AnalyzeColumns without the rest of the
+ * columns in memory, the results are the same for any rows
+ *
+ *   src[j] = columns[(2 * first + j) mod size], 0 <= j < 2 * count + length - 2
+ *
+ * @param src first column of the rows under the filters of the segment
+ * @param count number of rows of the outputs
+ * @param width number of columns
+ * @param taps filters
+ * @param low first column of `count` approximation rows
+ * @param high first column of `count` detail rows
+ */
+template <typename Taps>
+void AnalyzeColumnSegment(StridedLine<const DataType> src, size_t count,
+                          size_t width, const Taps& taps,
+                          StridedLine<DataType> low,
+                          StridedLine<DataType> high);
+
+/**
+ * Periodic synthesis of `width` adjacent columns of a row-major matrix, the
+ * same as SynthesizeLine for each column
+ */
+template <typename Taps>
+void SynthesizeColumns(StridedLine<const DataType> low,
+                       StridedLine<const DataType> high, size_t size,
+                       size_t width, const Taps& taps,
+                       StridedLine<DataType> dst);
+
+/**
+ * Synthesis of `width` adjacent columns of a padded line cropped on the fly,
+ * only the rows of the samples of the line are computed
+ * @param low first column of `padding.padded / 2` approximation rows
+ * @param high first column of `padding.padded / 2` detail rows
+ * @param padding
+ * @param width number of columns
+ * @param taps filters used for the analysis
+ * @param dst first column of `padding.size` rows
+ */
+template <typename Taps>
+void SynthesizeCroppedColumns(StridedLine<const DataType> low,
+                              StridedLine<const DataType> high,
+                              const LinePadding& padding, size_t width,
+                              const Taps& taps, StridedLine<DataType> dst);
+
+/**
+ * Floor of a half, the samples of a pair start at an even index also for the
+ * negative indexes of the segments
+ */
+constexpr std::ptrdiff_t FloorHalf(std::ptrdiff_t index) {
+  return index >= 0 ? index / 2 : -((1 - index) / 2);
+}
+
+/**
+ * Coefficients under the synthesis filters of the samples
+ * [first, first + count) of a line, see SynthesizeSegment
+ * @param first the first sample, it may be negative
+ * @param count the number of the samples
+ * @param length number of taps in each filter
+ * @return the first coefficient, it may be negative, and the number of the
+ * coefficients
+ */
+constexpr std::pair<std::ptrdiff_t, size_t> SynthesisSupport(
+    std::ptrdiff_t first, size_t count, size_t length) {
+  const std::ptrdiff_t begin =
+      FloorHalf(first) - static_cast<std::ptrdiff_t>(length / 2) + 1;
+  const std::ptrdiff_t end =
+      FloorHalf(first + static_cast<std::ptrdiff_t>(count) - 1) + 1;
+  return {begin, static_cast<size_t>(end - begin)};
+}
+
+/**
+ * Samples [first, first + count) of the periodic synthesis of `width`
+ * adjacent lines without the rest of the lines in memory, the sample indexes
+ * are taken modulo the size of the lines
+ *
+ *   low[j] = coefficients[(begin + j) mod (size / 2)], 0 <= j < support
+ *
+ * where begin and support are given by SynthesisSupport, the same for high
+ * @param low first line of the approximation coefficients under the filters
+ * @param high first line of the detail coefficients under the filters
+ * @param first the first sample, it may be negative
+ * @param count the number of the samples
+ * @param width number of adjacent lines, element c of line is &line[i] + c
+ * @param taps filters used for the analysis
+ * @param dst first line of `count` samples
+ */
+template <typename Taps>
+void SynthesizeSegment(StridedLine<const DataType> low,
+                       StridedLine<const DataType> high, std::ptrdiff_t first,
+                       size_t count, size_t width, const Taps& taps,
+                       StridedLine<DataType> dst);
+
+/**
+ * Lazy wavelet transform: split a line into two phases with periodic shifts
+ *
+ *   low[i]  = src[(2 * (i + low_shift) + low_parity) mod size]
+ *   high[i] = src[(2 * (i + high_shift) + 1 - low_parity) mod size]
+ *
+ * The lifting functions take `width` adjacent lines with the same stride at
+ * once, element i of line c is &line[i] + c
+ * @param src input line of `size` elements, must not overlap the outputs
+ * @param size length of the input, must be even
+ * @param low_parity 0 if the low phase starts with an even sample, 1 if odd
+ * @param low_shift
+ * @param high_shift
+ * @param low output line of `size / 2` elements
+ * @param high output line of `size / 2` elements
+ * @param width number of adjacent lines
+ */
+void SplitLine(StridedLine<const DataType> src, size_t size, size_t low_parity,
+               int low_shift, int high_shift, StridedLine<DataType> low,
+               StridedLine<DataType> high, size_t width = 1);
+
+/**
+ * Lazy wavelet transform in place: the phases of SplitLine are moved from
+ * the samples of a line to its first and its second half
+ * @param line `size` elements, the low and the high phase on return
+ * @param size length of the line, must be even
+ * @param low_parity
+ * @param low_shift
+ * @param high_shift
+ * @param scratch memory of `size / 2` elements, it keeps the high phase
+ * @param width number of adjacent lines
+ */
+void DeinterleaveLine(StridedLine<DataType> line, size_t size,
+                      size_t low_parity, int low_shift, int high_shift,
+                      StridedLine<DataType> scratch, size_t width = 1);
+
+/**
+ * Inverse of DeinterleaveLine
+ */
+void InterleaveLine(StridedLine<DataType> line, size_t size,
+                    size_t low_parity, int low_shift, int high_shift,
+                    StridedLine<DataType> scratch, size_t width = 1);
+
+/**
+ * Lifting step, updates one phase by the other one in place
+ *
+ *   target[i] += sign * sum_j coefficients[j] * source[(i + offset + j)]
+ *
+ * where the index of the source is taken modulo `size`
+ *
+ * @param source phase of `size` elements, must not overlap the target
+ * @param size length of both phases
+ * @param offset index offset of the first coefficient
+ * @param coefficients
+ * @param length number of the coefficients
+ * @param sign 1 for the forward transform, -1 for the inverse one
+ * @param target phase of `size` elements to update
+ * @param width number of adjacent lines
+ */
+void LiftStep(StridedLine<const DataType> source, size_t size, int offset,
+              const DataType* coefficients, size_t length, DataType sign,
+              StridedLine<DataType> target, size_t width = 1);
+
+/**
+ * Multiply a line by a factor in place
+ */
+void ScaleLine(StridedLine<DataType> line, size_t size, DataType factor,
+               size_t width = 1);
+
+}  // namespace drift::wavelet::internal
+
+#endif  // SOURCES_INTERNAL_DWT_KERNELS_H_
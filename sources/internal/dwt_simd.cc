@@ -0,0 +1,94 @@
+// Copyright 2023 PANDA GmbH
+
+#include "internal/dwt_simd.h"
+
+#if defined(WB_SIMD_KERNELS) && defined(_MSC_VER) && !defined(__clang__)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace drift::wavelet::internal {
+
+#if defined(WB_SIMD_KERNELS) && defined(_MSC_VER) && !defined(__clang__)
+/**
+ * CPU features from CPUID, AVX state must be enabled by the OS as well
+ */
+static SimdLevel DetectWithCpuid() {
+  int info[4];
+  __cpuid(info, 0);
+  const int max_leaf = info[0];
+
+  __cpuid(info, 1);
+  const bool sse41 = info[2] & (1 << 19);
+  const bool fma = info[2] & (1 << 12);
+  const bool osxsave = info[2] & (1 << 27);
+  const bool avx = info[2] & (1 << 28);
+
+  bool avx2 = false;
+  bool avx512f = false;
+  if (max_leaf >= 7) {
+    __cpuidex(info, 7, 0);
+    avx2 = info[1] & (1 << 5);
+    avx512f = info[1] & (1 << 16);
+  }
+
+  const auto xcr0 = osxsave ? _xgetbv(0) : 0;
+  const bool ymm_state = (xcr0 & 0x6) == 0x6;
+  const bool zmm_state = (xcr0 & 0xe6) == 0xe6;
+
+  if (avx512f && zmm_state) {
+    return SimdLevel::kAvx512;
+  }
+  if (avx && avx2 && fma && ymm_state) {
+    return SimdLevel::kAvx2;
+  }
+  if (sse41) {
+    return SimdLevel::kSse41;
+  }
+  return SimdLevel::kScalar;
+}
+#endif
+
+SimdLevel DetectSimdLevel() {
+#if defined(WB_SIMD_KERNELS) && (defined(__GNUC__) || defined(__clang__))
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return SimdLevel::kAvx512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return SimdLevel::kAvx2;
+  }
+  if (__builtin_cpu_supports("sse4.1")) {
+    return SimdLevel::kSse41;
+  }
+  return SimdLevel::kScalar;
+#elif defined(WB_SIMD_KERNELS) && defined(_MSC_VER)
+  return DetectWithCpuid();
+#else
+  return SimdLevel::kScalar;
+#endif
+}
+
+const SimdKernels* GetSimdKernels([[maybe_unused]] SimdLevel level) {
+#if defined(WB_SIMD_KERNELS)
+  switch (level) {
+    case SimdLevel::kSse41:
+      return &kSse41Kernels;
+    case SimdLevel::kAvx2:
+      return &kAvx2Kernels;
+    case SimdLevel::kAvx512:
+      return &kAvx512Kernels;
+    default:
+      return nullptr;
+  }
+#else
+  return nullptr;
+#endif
+}
+
+const SimdKernels* ActiveSimdKernels() {
+  static const SimdKernels* kernels = GetSimdKernels(DetectSimdLevel());
+  return kernels;
+}
+
+}  // namespace drift::wavelet::internal
@@ -0,0 +1,88 @@
+// Copyright 2023 PANDA GmbH
+#ifndef SOURCES_INTERNAL_DWT_SIMD_H_
+#define SOURCES_INTERNAL_DWT_SIMD_H_
+
+#include <cstddef>
+
+/* The header is included by the translation units compiled with special
+ * instruction set flags, so it mustn't include Blaze or other heavy headers
+ * whose inline functions could be emitted with these instructions */
+
+namespace drift::wavelet::internal {
+
+/**
+ * Instruction set of the vectorized kernels
+ */
+enum class SimdLevel { kScalar, kSse41, kAvx2, kAvx512 };
+
+/**
+ * The longest filter supported by the vectorized kernels (DB1-DB16)
+ */
+constexpr size_t kMaxSimdTaps = 32;
+
+/**
+ * Outputs per block of the vectorized analysis, a line analyzed in segments
+ * starting at multiples of it has the same results as the whole line
+ */
+constexpr size_t kSimdBlock = 256;
+
+/**
+ * Interior of the periodic analysis of a contiguous line, no wraparound
+ *
+ *   low[i]  = sum_k low_taps[k]  * src[2i + k]
+ *   high[i] = sum_k high_taps[k] * src[2i + k], 0 <= i < count
+ */
+using AnalyzeInteriorFunc = void (*)(const float* src, size_t count,
+                                     const float* low_taps,
+                                     const float* high_taps, size_t length,
+                                     float* low, float* high);
+
+/**
+ * Interior of the periodic synthesis of a contiguous line, no wraparound
+ *
+ *   dst[2p + r] = sum_m low_taps[2m + r]  * low[p - m]
+ *               + sum_m high_taps[2m + r] * high[p - m], begin <= p < end
+ *
+ * `begin` must be at least length / 2 - 1
+ */
+using SynthesizeInteriorFunc = void (*)(const float* low, const float* high,
+                                        size_t begin, size_t end,
+                                        const float* low_taps,
+                                        const float* high_taps, size_t length,
+                                        float* dst);
+
+/**
+ * Vectorized kernels for one instruction set
+ */
+struct SimdKernels {
+  SimdLevel level;
+  AnalyzeInteriorFunc analyze;
+  SynthesizeInteriorFunc synthesize;
+};
+
+/**
+ * The best instruction set supported by the CPU and the build
+ */
+SimdLevel DetectSimdLevel();
+
+/**
+ * Kernels for an instruction set
+ * @param level
+ * @return nullptr for kScalar or if the kernels aren't built
+ */
+const SimdKernels* GetSimdKernels(SimdLevel level);
+
+/**
+ * Kernels used by the transform, selected once on the first call
+ * @return nullptr if no vectorized kernels are available
+ */
+const SimdKernels* ActiveSimdKernels();
+
+/* Implementations for the instruction sets, built only on x86 */
+extern const SimdKernels kSse41Kernels;
+extern const SimdKernels kAvx2Kernels;
+extern const SimdKernels kAvx512Kernels;
+
+}  // namespace drift::wavelet::internal
+
+#endif  // SOURCES_INTERNAL_DWT_SIMD_H_
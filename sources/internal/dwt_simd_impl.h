@@ -0,0 +1,151 @@
+// Copyright 2023 PANDA GmbH
+#ifndef SOURCES_INTERNAL_DWT_SIMD_IMPL_H_
+#define SOURCES_INTERNAL_DWT_SIMD_IMPL_H_
+
+#include <cstddef>
+
+#include "internal/dwt_simd.h"
+
+/* Polyphase kernels written once for a vector type V, every instruction set
+ * translation unit instantiates them with its own V:
+ *
+ *   V::Vec, V::kWidth
+ *   V::Load(p), V::Store(p, v), V::Set1(x), V::Zero()
+ *   V::MulAdd(a, b, c) = a * b + c
+ *   V::Deinterleave(p, &even, &odd) loads 2 * kWidth elements
+ *   V::Interleave(even, odd, p) stores 2 * kWidth elements
+ *
+ * The functions have internal linkage to keep the code compiled with
+ * different flags apart */
+
+namespace drift::wavelet::internal {
+
+template <typename V>
+static void AnalyzeInterior(const float* src, size_t count,
+                            const float* low_taps, const float* high_taps,
+                            size_t length, float* low, float* high) {
+  using Vec = typename V::Vec;
+  constexpr size_t kWidth = V::kWidth;
+  constexpr size_t kMaxPhaseTaps = kMaxSimdTaps / 2;
+  /* Outputs per block, the phases of a block stay in L1 */
+  constexpr size_t kBlock = kSimdBlock;
+
+  const size_t phase_taps = length / 2;
+
+  /* Split the filters into phases: low[i] = sum_m even_taps[m] * even[i + m]
+   * + odd_taps[m] * odd[i + m] */
+  Vec low_even[kMaxPhaseTaps];
+  Vec low_odd[kMaxPhaseTaps];
+  Vec high_even[kMaxPhaseTaps];
+  Vec high_odd[kMaxPhaseTaps];
+  for (size_t m = 0; m < phase_taps; ++m) {
+    low_even[m] = V::Set1(low_taps[2 * m]);
+    low_odd[m] = V::Set1(low_taps[2 * m + 1]);
+    high_even[m] = V::Set1(high_taps[2 * m]);
+    high_odd[m] = V::Set1(high_taps[2 * m + 1]);
+  }
+
+  alignas(64) float even[kBlock + kMaxPhaseTaps];
+  alignas(64) float odd[kBlock + kMaxPhaseTaps];
+
+  for (size_t begin = 0; begin < count; begin += kBlock) {
+    const size_t n = count - begin < kBlock ? count - begin : kBlock;
+    const float* x = src + 2 * begin;
+
+    /* Deinterleave the samples of the block once for all taps */
+    const size_t samples = n + phase_taps - 1;
+    size_t j = 0;
+    for (; j + kWidth <= samples; j += kWidth) {
+      Vec e;
+      Vec o;
+      V::Deinterleave(x + 2 * j, &e, &o);
+      V::Store(even + j, e);
+      V::Store(odd + j, o);
+    }
+    for (; j < samples; ++j) {
+      even[j] = x[2 * j];
+      odd[j] = x[2 * j + 1];
+    }
+
+    size_t i = 0;
+    for (; i + kWidth <= n; i += kWidth) {
+      Vec l = V::Zero();
+      Vec h = V::Zero();
+      for (size_t m = 0; m < phase_taps; ++m) {
+        const Vec e = V::Load(even + i + m);
+        const Vec o = V::Load(odd + i + m);
+        l = V::MulAdd(low_even[m], e, l);
+        l = V::MulAdd(low_odd[m], o, l);
+        h = V::MulAdd(high_even[m], e, h);
+        h = V::MulAdd(high_odd[m], o, h);
+      }
+      V::Store(low + begin + i, l);
+      V::Store(high + begin + i, h);
+    }
+
+    for (; i < n; ++i) {
+      float l = 0;
+      float h = 0;
+      for (size_t m = 0; m < phase_taps; ++m) {
+        l += low_taps[2 * m] * even[i + m] + low_taps[2 * m + 1] * odd[i + m];
+        h += high_taps[2 * m] * even[i + m] + high_taps[2 * m + 1] * odd[i + m];
+      }
+      low[begin + i] = l;
+      high[begin + i] = h;
+    }
+  }
+}
+
+template <typename V>
+static void SynthesizeInterior(const float* low, const float* high,
+                               size_t begin, size_t end, const float* low_taps,
+                               const float* high_taps, size_t length,
+                               float* dst) {
+  using Vec = typename V::Vec;
+  constexpr size_t kWidth = V::kWidth;
+  constexpr size_t kMaxPhaseTaps = kMaxSimdTaps / 2;
+
+  const size_t phase_taps = length / 2;
+
+  Vec low_even[kMaxPhaseTaps];
+  Vec low_odd[kMaxPhaseTaps];
+  Vec high_even[kMaxPhaseTaps];
+  Vec high_odd[kMaxPhaseTaps];
+  for (size_t m = 0; m < phase_taps; ++m) {
+    low_even[m] = V::Set1(low_taps[2 * m]);
+    low_odd[m] = V::Set1(low_taps[2 * m + 1]);
+    high_even[m] = V::Set1(high_taps[2 * m]);
+    high_odd[m] = V::Set1(high_taps[2 * m + 1]);
+  }
+
+  size_t p = begin;
+  for (; p + kWidth <= end; p += kWidth) {
+    Vec e = V::Zero();
+    Vec o = V::Zero();
+    for (size_t m = 0; m < phase_taps; ++m) {
+      const Vec l = V::Load(low + p - m);
+      const Vec h = V::Load(high + p - m);
+      e = V::MulAdd(low_even[m], l, e);
+      e = V::MulAdd(high_even[m], h, e);
+      o = V::MulAdd(low_odd[m], l, o);
+      o = V::MulAdd(high_odd[m], h, o);
+    }
+    V::Interleave(e, o, dst + 2 * p);
+  }
+
+  for (; p < end; ++p) {
+    float e = 0;
+    float o = 0;
+    for (size_t m = 0; m < phase_taps; ++m) {
+      e += low_taps[2 * m] * low[p - m] + high_taps[2 * m] * high[p - m];
+      o += low_taps[2 * m + 1] * low[p - m] +
+           high_taps[2 * m + 1] * high[p - m];
+    }
+    dst[2 * p] = e;
+    dst[2 * p + 1] = o;
+  }
+}
+
+}  // namespace drift::wavelet::internal
+
+#endif  // SOURCES_INTERNAL_DWT_SIMD_IMPL_H_
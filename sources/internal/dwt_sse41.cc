@@ -0,0 +1,40 @@
+// Copyright 2023 PANDA GmbH
+
+#include <smmintrin.h>
+
+#include "internal/dwt_simd.h"
+#include "internal/dwt_simd_impl.h"
+
+/* Compiled with -msse4.1 */
+
+namespace drift::wavelet::internal {
+
+struct Sse41 {
+  using Vec = __m128;
+  static constexpr size_t kWidth = 4;
+
+  static Vec Load(const float* p) { return _mm_loadu_ps(p); }
+  static void Store(float* p, Vec v) { _mm_storeu_ps(p, v); }
+  static Vec Set1(float x) { return _mm_set1_ps(x); }
+  static Vec Zero() { return _mm_setzero_ps(); }
+  static Vec MulAdd(Vec a, Vec b, Vec c) {
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+  }
+
+  static void Deinterleave(const float* p, Vec* even, Vec* odd) {
+    const Vec a = _mm_loadu_ps(p);
+    const Vec b = _mm_loadu_ps(p + 4);
+    *even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    *odd = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+  }
+
+  static void Interleave(Vec even, Vec odd, float* p) {
+    _mm_storeu_ps(p, _mm_unpacklo_ps(even, odd));
+    _mm_storeu_ps(p + 4, _mm_unpackhi_ps(even, odd));
+  }
+};
+
+const SimdKernels kSse41Kernels = {SimdLevel::kSse41, AnalyzeInterior<Sse41>,
+                                   SynthesizeInterior<Sse41>};
+
+}  // namespace drift::wavelet::internal
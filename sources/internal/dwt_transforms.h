@@ -0,0 +1,231 @@
+// Copyright 2023 PANDA GmbH
+#ifndef SOURCES_INTERNAL_DWT_TRANSFORMS_H_
+#define SOURCES_INTERNAL_DWT_TRANSFORMS_H_
+
+#include <algorithm>
+
+#include "internal/dwt_kernels.h"
+#include "wavelet_buffer/primitives.h"
+#include "wavelet_buffer/thread_pool.h"
+#include "wavelet_buffer/wavelet.h"
+
+/* Filter bank transforms of wavelet.h for both kinds of taps. They are
+ * instantiated in wavelet.cc for FilterTaps and StaticTaps<kDB1>..<kDB5>.
+ * The lifting transforms work in place on the memory of the caller */
+
+namespace drift::wavelet::internal {
+
+/**
+ * Images with fewer pixels are transformed in one thread, the tasks would
+ * cost more than they save
+ */
+constexpr size_t kMinParallelPixels = 512 * 512;
+
+/**
+ * Split [0, count) into blocks and call a function for each of them,
+ * concurrently on the pool if the work is big enough. The function is
+ * called directly in the calling thread, nothing is allocated for it
+ * @param pool the threads, nullptr to run in the calling thread
+ * @param pixels size of the work, compared with kMinParallelPixels
+ * @param count the number of the items, e.g. rows or columns
+ * @param grain the blocks start at multiples of it, e.g. a tile of columns
+ * @param workspace scratch memory of the calling thread, nullptr to use a
+ * workspace of the call
+ * @param func function of the block [begin, end) and the scratch memory of
+ * the thread running it
+ */
+template <typename Func>
+void ForEachBlock(ThreadPool *pool, size_t pixels, size_t count, size_t grain,
+                  Workspace *workspace, Func &&func) {
+  if (count == 0) {
+    return;
+  }
+
+  if (!pool || pool->size() == 1 || pixels < kMinParallelPixels ||
+      count <= grain) {
+    Workspace local;
+    func(0, count, workspace ? workspace : &local);
+    return;
+  }
+
+  /* A few blocks per thread balance out the threads started late. The task
+   * captures one reference to fit into the storage of std::function */
+  const size_t grains = (count + grain - 1) / grain;
+  const size_t blocks = std::min(grains, pool->size() * 4);
+  struct {
+    size_t block;
+    size_t count;
+    Func &func;
+  } task{(grains + blocks - 1) / blocks * grain, count, func};
+  pool->ParallelFor((count + task.block - 1) / task.block,
+                    [&task](size_t index, Workspace *scratch) {
+                      const size_t begin = index * task.block;
+                      task.func(begin, std::min(begin + task.block, task.count),
+                                scratch);
+                      scratch->Reset();
+                    });
+}
+
+/**
+ * Single level 2D transform of a matrix view, nothing is allocated. An odd
+ * side is extended by its last sample, see AnalyzeLine
+ * @param x image
+ * @param taps
+ * @param scratch matrix of the rows of the image and the even number of
+ * columns not less than the image for the row pass
+ * @param ll, lh, hl, hh output subbands of the half size of the image
+ * rounded up
+ * @param pool threads to split the rows and the columns of a big image
+ */
+template <typename Taps>
+void AnalyzeImage(MatrixView<const DataType> x, const Taps &taps,
+                  MatrixView<DataType> scratch, MatrixView<DataType> ll,
+                  MatrixView<DataType> lh, MatrixView<DataType> hl,
+                  MatrixView<DataType> hh, ThreadPool *pool = nullptr);
+
+/**
+ * Single level 2D transform of an image padded on the fly, the subbands are
+ * the same as of AnalyzeImage of the padded image
+ * @param x image
+ * @param row_padding padding of the columns of the image to the rows of the
+ * padded one
+ * @param column_padding padding of the rows of the image to the columns of
+ * the padded one
+ * @param taps
+ * @param scratch matrix of the rows of the image and the padded columns for
+ * the row pass
+ * @param ll, lh, hl, hh output subbands of the half size of the padded image
+ * @param pool threads to split the rows and the columns of a big image
+ */
+template <typename Taps>
+void AnalyzePaddedImage(MatrixView<const DataType> x,
+                        const LinePadding &row_padding,
+                        const LinePadding &column_padding, const Taps &taps,
+                        MatrixView<DataType> scratch, MatrixView<DataType> ll,
+                        MatrixView<DataType> lh, MatrixView<DataType> hl,
+                        MatrixView<DataType> hh, ThreadPool *pool = nullptr);
+
+/**
+ * Single level inverse 2D transform of matrix views, nothing is allocated
+ * @param ll, lh, hl, hh input subbands
+ * @param taps
+ * @param scratch matrix of the rows of the output and the double columns of
+ * the subbands for the column pass
+ * @param out output image of the double size of the subbands, a side one
+ * less for the subbands of an odd side
+ * @param pool threads to split the columns and the rows of a big image
+ */
+template <typename Taps>
+void SynthesizeImage(MatrixView<const DataType> ll,
+                     MatrixView<const DataType> lh,
+                     MatrixView<const DataType> hl,
+                     MatrixView<const DataType> hh, const Taps &taps,
+                     MatrixView<DataType> scratch, MatrixView<DataType> out,
+                     ThreadPool *pool = nullptr);
+
+/**
+ * Single level inverse 2D transform cropped on the fly, the output is the
+ * same as the crop of SynthesizeImage of the padded image
+ * @param ll, lh, hl, hh input subbands of the half size of the padded image
+ * @param row_padding padding of the columns of the output
+ * @param column_padding padding of the rows of the output
+ * @param taps
+ * @param scratch matrix of the rows of the output and the double columns of
+ * the subbands for the column pass
+ * @param out output image of the cropped size
+ * @param workspace scratch memory for the rows of a cropped width, nullptr to
+ * use a workspace of the call
+ * @param pool threads to split the columns and the rows of a big image
+ */
+template <typename Taps>
+void SynthesizeCroppedImage(MatrixView<const DataType> ll,
+                            MatrixView<const DataType> lh,
+                            MatrixView<const DataType> hl,
+                            MatrixView<const DataType> hh,
+                            const LinePadding &row_padding,
+                            const LinePadding &column_padding,
+                            const Taps &taps, MatrixView<DataType> scratch,
+                            MatrixView<DataType> out, Workspace *workspace,
+                            ThreadPool *pool = nullptr);
+
+/**
+ * Single level 2D transform, the same as dwt2() with a filter bank
+ * @param x image with even sides
+ * @param taps
+ * @param ll, lh, hl, hh output subbands, resized to the half of the image
+ * @param pool threads to split a big image
+ */
+template <typename Taps>
+void Dwt2(const Signal2D &x, const Taps &taps, Signal2D *ll, Signal2D *lh,
+          Signal2D *hl, Signal2D *hh, ThreadPool *pool = nullptr);
+
+/**
+ * Single level inverse 2D transform, the same as idwt2() with a filter bank
+ */
+template <typename Taps>
+Signal2D Idwt2(const Signal2D &ll, const Signal2D &lh, const Signal2D &hl,
+               const Signal2D &hh, const Taps &taps,
+               ThreadPool *pool = nullptr);
+
+/**
+ * Single level 1D transform, the same as dwt() with a filter bank
+ * @param signal line of even length
+ * @param taps
+ * @param low, high output subbands, resized to the half of the signal
+ */
+template <typename Taps>
+void Dwt(const Signal1D &signal, const Taps &taps, Signal1D *low,
+         Signal1D *high);
+
+/**
+ * Single level inverse 1D transform, the same as idwt() with a filter bank
+ */
+template <typename Taps>
+Signal1D Idwt(const Signal1D &low, const Signal1D &high, const Taps &taps);
+
+/**
+ * Forward lifting of one line or several adjacent lines in place: the steps
+ * update the phases where they lie, then the phases are moved to the halves
+ * of the line, see DeinterleaveLine
+ * @param line `size` elements, the approximation and the detail coefficients
+ * on return
+ * @param size length of the line, must be even
+ * @param scheme
+ * @param scratch memory of `size / 2` elements
+ * @param width number of adjacent lines
+ */
+void LiftLine(StridedLine<DataType> line, size_t size,
+              const LiftingScheme &scheme, StridedLine<DataType> scratch,
+              size_t width = 1);
+
+/**
+ * Inverse of LiftLine in place
+ */
+void UnliftLine(StridedLine<DataType> line, size_t size,
+                const LiftingScheme &scheme, StridedLine<DataType> scratch,
+                size_t width = 1);
+
+/**
+ * Single level 2D lifting, the same as dwt2s() with a lifting scheme
+ * @param x image with even sides
+ * @param scheme
+ * @param out image of the same shape, it may be x for the transform in
+ * place, otherwise the rows are split out of x
+ * @param workspace scratch memory of the calling thread, a line or a tile
+ * of columns
+ * @param pool threads to split a big image
+ */
+void LiftImage(MatrixView<const DataType> x, const LiftingScheme &scheme,
+               MatrixView<DataType> out, Workspace *workspace,
+               ThreadPool *pool = nullptr);
+
+/**
+ * Single level inverse 2D lifting in place, the same as idwt2s() with a
+ * lifting scheme
+ */
+void UnliftImage(MatrixView<DataType> x, const LiftingScheme &scheme,
+                 Workspace *workspace, ThreadPool *pool = nullptr);
+
+}  // namespace drift::wavelet::internal
+
+#endif  // SOURCES_INTERNAL_DWT_TRANSFORMS_H_
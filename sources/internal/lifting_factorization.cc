@@ -0,0 +1,273 @@
+// Copyright 2023 PANDA GmbH
+
+#include "internal/lifting_factorization.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <optional>
+#include <vector>
+
+namespace drift::wavelet::internal {
+
+/**
+ * Coefficients below it are the rounding error of the scaling filters
+ */
+constexpr double kZeroTolerance = 1e-9;
+
+/**
+ * Laurent polynomial acting on a phase of a line as
+ *   (p * x)[i] = sum_k coefficients[k] * x[i + low + k]
+ * the product of two of them is the composition
+ */
+struct LaurentPolynomial {
+  int low = 0; /**< power of the first coefficient */
+  std::vector<double> coefficients;
+
+  bool empty() const { return coefficients.empty(); }
+  size_t size() const { return coefficients.size(); }
+};
+
+/**
+ * Polyphase matrix, row-major: the rows are the low and the high subbands,
+ * the columns are the even and the odd samples
+ */
+using PolyphaseMatrix = std::array<LaurentPolynomial, 4>;
+
+/**
+ * Row operation of the reduction: row -= factor * other row
+ */
+struct RowOperation {
+  size_t row;
+  LaurentPolynomial factor;
+};
+
+static LaurentPolynomial Trim(LaurentPolynomial p) {
+  auto is_zero = [](double c) { return std::abs(c) < kZeroTolerance; };
+  auto &c = p.coefficients;
+  const auto end = std::find_if_not(c.rbegin(), c.rend(), is_zero).base();
+  const auto begin = std::find_if_not(c.begin(), end, is_zero);
+  p.low += static_cast<int>(begin - c.begin());
+  c = std::vector<double>(begin, end);
+  return p;
+}
+
+static LaurentPolynomial Multiply(const LaurentPolynomial &a,
+                                  const LaurentPolynomial &b) {
+  if (a.empty() || b.empty()) {
+    return {};
+  }
+
+  LaurentPolynomial out{a.low + b.low,
+                        std::vector<double>(a.size() + b.size() - 1)};
+  for (size_t i = 0; i < a.size(); ++i) {
+    for (size_t j = 0; j < b.size(); ++j) {
+      out.coefficients[i + j] += a.coefficients[i] * b.coefficients[j];
+    }
+  }
+  return out;
+}
+
+static LaurentPolynomial Subtract(const LaurentPolynomial &a,
+                                  const LaurentPolynomial &b) {
+  if (b.empty()) {
+    return a;
+  }
+
+  const int low = a.empty() ? b.low : std::min(a.low, b.low);
+  const int high = std::max(a.low + static_cast<int>(a.size()),
+                            b.low + static_cast<int>(b.size()));
+  LaurentPolynomial out{low, std::vector<double>(high - low)};
+  for (size_t i = 0; i < a.size(); ++i) {
+    out.coefficients[a.low - low + i] += a.coefficients[i];
+  }
+  for (size_t i = 0; i < b.size(); ++i) {
+    out.coefficients[b.low - low + i] -= b.coefficients[i];
+  }
+  return Trim(std::move(out));
+}
+
+/**
+ * Quotient of a Laurent division, the remainder is shorter than the divisor
+ * @param dividend not shorter than the divisor
+ * @param divisor
+ * @param low_terms the number of the lowest terms of the dividend cancelled
+ * by the quotient, the rest of them are the highest terms
+ */
+static LaurentPolynomial Quotient(const LaurentPolynomial &dividend,
+                                  const LaurentPolynomial &divisor,
+                                  size_t low_terms) {
+  const size_t length = dividend.size() - divisor.size() + 1;
+  LaurentPolynomial quotient{dividend.low - divisor.low,
+                             std::vector<double>(length)};
+  auto remainder = dividend.coefficients;
+  auto cancel = [&](size_t k, size_t term, double divisor_term) {
+    quotient.coefficients[k] = remainder[term] / divisor_term;
+    for (size_t j = 0; j < divisor.size(); ++j) {
+      remainder[k + j] -= quotient.coefficients[k] * divisor.coefficients[j];
+    }
+  };
+
+  for (size_t k = 0; k < low_terms; ++k) {
+    cancel(k, k, divisor.coefficients.front());
+  }
+  for (size_t k = length; k-- > low_terms;) {
+    cancel(k, k + divisor.size() - 1, divisor.coefficients.back());
+  }
+  return quotient;
+}
+
+static void ApplyRowOperation(const RowOperation &operation,
+                              PolyphaseMatrix *matrix) {
+  const size_t other = 1 - operation.row;
+  for (size_t column = 0; column < 2; ++column) {
+    auto &target = (*matrix)[operation.row * 2 + column];
+    target = Subtract(target,
+                      Multiply(operation.factor, (*matrix)[other * 2 + column]));
+  }
+}
+
+/**
+ * Scheme of a finished reduction
+ * @param operations the row operations in the order of the reduction
+ * @param monomials diagonal (even low phase) or antidiagonal (odd low phase)
+ */
+static LiftingScheme MakeScheme(const std::vector<RowOperation> &operations,
+                                const PolyphaseMatrix &monomials) {
+  const size_t low_parity = monomials[0].empty() ? 1 : 0;
+  const auto &low = monomials[low_parity];
+  const auto &high = monomials[2 + 1 - low_parity];
+  const double low_scale = low.coefficients.front();
+  const double high_scale = high.coefficients.front();
+
+  /* The steps undo the operations, the last one of the reduction is the
+   * first step. The scales of the monomials end the scheme, so a step
+   * updating the low phase by the high one is scaled by
+   * high_scale / low_scale and vice versa */
+  LiftingScheme scheme{{},
+                       low_parity,
+                       low.low,
+                       high.low,
+                       static_cast<DataType>(low_scale),
+                       static_cast<DataType>(high_scale)};
+  for (auto it = operations.rbegin(); it != operations.rend(); ++it) {
+    const bool update_low = it->row == 0;
+    const double factor =
+        update_low ? high_scale / low_scale : low_scale / high_scale;
+    Signal1D coefficients(it->factor.size());
+    for (size_t j = 0; j < it->factor.size(); ++j) {
+      coefficients[j] =
+          static_cast<DataType>(it->factor.coefficients[j] * factor);
+    }
+    scheme.steps.push_back({update_low, it->factor.low, coefficients});
+  }
+  return scheme;
+}
+
+static double MaxCoefficient(const LiftingScheme &scheme) {
+  double max = 0;
+  for (const auto &step : scheme.steps) {
+    for (const auto c : step.coefficients) {
+      max = std::max(max, static_cast<double>(std::abs(c)));
+    }
+  }
+  return max;
+}
+
+/**
+ * Reduce a column of the matrix by all divisions, keeping the scheme with
+ * the smallest coefficients
+ */
+static void Reduce(const PolyphaseMatrix &matrix, size_t column,
+                   std::vector<RowOperation> *operations,
+                   std::optional<LiftingScheme> *best) {
+  const auto &top = matrix[column];
+  const auto &bottom = matrix[2 + column];
+  if (top.empty() || bottom.empty()) {
+    /* The matrix is triangular and its determinant is a monomial, so are
+     * its diagonal entries. One more operation clears the other column */
+    const size_t pivot = top.empty() ? 1 : 0;
+    const size_t other = 1 - pivot;
+    const auto &monomial = matrix[other * 2 + 1 - column];
+    if (monomial.size() != 1 || matrix[pivot * 2 + column].size() != 1) {
+      return;
+    }
+
+    auto reduced = matrix;
+    const auto &entry = matrix[pivot * 2 + 1 - column];
+    const size_t count = operations->size();
+    if (!entry.empty()) {
+      RowOperation operation{pivot, entry};
+      operation.factor.low -= monomial.low;
+      for (auto &c : operation.factor.coefficients) {
+        c /= monomial.coefficients.front();
+      }
+      ApplyRowOperation(operation, &reduced);
+      operations->push_back(std::move(operation));
+    }
+
+    auto scheme = MakeScheme(*operations, reduced);
+    if (!*best || MaxCoefficient(scheme) < MaxCoefficient(**best)) {
+      *best = std::move(scheme);
+    }
+    operations->resize(count);
+    return;
+  }
+
+  for (size_t row = 0; row < 2; ++row) {
+    const auto &dividend = matrix[row * 2 + column];
+    const auto &divisor = matrix[(1 - row) * 2 + column];
+    if (dividend.size() < divisor.size()) {
+      continue;
+    }
+
+    const size_t length = dividend.size() - divisor.size() + 1;
+    for (size_t low_terms = 0; low_terms <= length; ++low_terms) {
+      RowOperation operation{row, Quotient(dividend, divisor, low_terms)};
+      auto reduced = matrix;
+      ApplyRowOperation(operation, &reduced);
+      if (reduced[row * 2 + column].size() >= dividend.size()) {
+        continue;
+      }
+
+      operations->push_back(std::move(operation));
+      Reduce(reduced, column, operations, best);
+      operations->pop_back();
+    }
+  }
+}
+
+LiftingScheme FactorizeScalingFilter(std::span<const double> scaling) {
+  /* The analysis filters in convolution order, as in StaticTaps */
+  const size_t length = scaling.size();
+  std::vector<double> low(length);
+  std::vector<double> high(length);
+  for (size_t i = 0; i < length; ++i) {
+    low[i] = std::sqrt(2.0) * scaling[i];
+  }
+  for (size_t i = 0; i < length; ++i) {
+    high[i] = i % 2 == 0 ? low[length - 1 - i] : -low[length - 1 - i];
+  }
+
+  /* Tap j of a filter reads the sample 2 * i + j for output i, which is
+   * sample i + j / 2 of the phase j % 2 */
+  PolyphaseMatrix matrix;
+  for (size_t j = 0; j < length; ++j) {
+    matrix[j % 2].coefficients.push_back(low[j]);
+    matrix[2 + j % 2].coefficients.push_back(high[j]);
+  }
+  for (auto &entry : matrix) {
+    entry = Trim(std::move(entry));
+  }
+
+  std::optional<LiftingScheme> best;
+  std::vector<RowOperation> operations;
+  for (size_t column = 0; column < 2; ++column) {
+    Reduce(matrix, column, &operations, &best);
+  }
+  assert(best && "the polyphase matrix must have a monomial determinant");
+  return best.value_or(LiftingScheme{});
+}
+
+}  // namespace drift::wavelet::internal
@@ -0,0 +1,29 @@
+// Copyright 2023 PANDA GmbH
+
+#ifndef SOURCES_INTERNAL_LIFTING_FACTORIZATION_H_
+#define SOURCES_INTERNAL_LIFTING_FACTORIZATION_H_
+
+#include <span>
+
+#include "wavelet_buffer/wavelet.h"
+
+namespace drift::wavelet::internal {
+
+/**
+ * Factorize the orthogonal filter bank of a scaling filter into lifting steps
+ * with the Euclidean algorithm for Laurent polynomials (Daubechies &
+ * Sweldens, "Factoring wavelet transforms into lifting steps", 1998).
+ *
+ * The polyphase matrix of the analysis filters in convolution order is
+ * reduced by row operations to a diagonal or antidiagonal matrix of
+ * monomials, the operations are the steps and the monomials are the split
+ * and the scales. The divisions aren't unique, all of them are tried and
+ * the factorization with the smallest coefficients is taken
+ * @param scaling scaling filter, the same as dbwavf()
+ * @return scheme giving the same subbands as the filter bank
+ */
+LiftingScheme FactorizeScalingFilter(std::span<const double> scaling);
+
+}  // namespace drift::wavelet::internal
+
+#endif  // SOURCES_INTERNAL_LIFTING_FACTORIZATION_H_
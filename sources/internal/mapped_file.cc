@@ -0,0 +1,110 @@
+// Copyright 2023 PANDA GmbH
+
+#include "internal/mapped_file.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <iostream>
+
+namespace drift::internal {
+
+#ifdef _WIN32
+
+std::unique_ptr<MappedFile> MappedFile::Open(const std::string& path) {
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    std::cerr << "Failed to open " << path << std::endl;
+    return nullptr;
+  }
+
+  std::unique_ptr<MappedFile> mapped(new MappedFile());
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    std::cerr << "Failed to get the size of " << path << std::endl;
+    CloseHandle(file);
+    return nullptr;
+  }
+  mapped->size_ = static_cast<size_t>(size.QuadPart);
+
+  /* The mapping keeps the file open */
+  if (mapped->size_ > 0) {
+    mapped->mapping_ =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapped->mapping_) {
+      mapped->data_ = static_cast<const char*>(
+          MapViewOfFile(mapped->mapping_, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (!mapped->data_) {
+      std::cerr << "Failed to map " << path << std::endl;
+      CloseHandle(file);
+      return nullptr;
+    }
+  }
+  CloseHandle(file);
+  return mapped;
+}
+
+MappedFile::~MappedFile() {
+  if (data_) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_) {
+    CloseHandle(mapping_);
+  }
+}
+
+#else
+
+std::unique_ptr<MappedFile> MappedFile::Open(const std::string& path) {
+  const int file = open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    std::cerr << "Failed to open " << path << std::endl;
+    return nullptr;
+  }
+
+  std::unique_ptr<MappedFile> mapped(new MappedFile());
+  struct stat status {};
+  if (fstat(file, &status) != 0) {
+    std::cerr << "Failed to get the size of " << path << std::endl;
+    close(file);
+    return nullptr;
+  }
+  mapped->size_ = static_cast<size_t>(status.st_size);
+
+  /* The mapping keeps the file open */
+  if (mapped->size_ > 0) {
+    void* data = mmap(nullptr, mapped->size_, PROT_READ, MAP_PRIVATE, file, 0);
+    if (data == MAP_FAILED) {
+      std::cerr << "Failed to map " << path << std::endl;
+      close(file);
+      return nullptr;
+    }
+    mapped->data_ = static_cast<const char*>(data);
+  }
+  close(file);
+  return mapped;
+}
+
+MappedFile::~MappedFile() {
+  if (data_) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+#endif
+
+const char* MappedFile::data() const { return data_; }
+
+size_t MappedFile::size() const { return size_; }
+
+}  // namespace drift::internal
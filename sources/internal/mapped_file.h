@@ -0,0 +1,52 @@
+// Copyright 2023 PANDA GmbH
+
+#ifndef SOURCES_INTERNAL_MAPPED_FILE_H_
+#define SOURCES_INTERNAL_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace drift::internal {
+
+/**
+ * Read-only memory mapping of a whole file, the pages are loaded by the OS
+ * when they are read and can be dropped under memory pressure
+ */
+class MappedFile {
+ public:
+  /**
+   * Map a file
+   * @param path
+   * @return nullptr if the file can't be mapped
+   */
+  static std::unique_ptr<MappedFile> Open(const std::string& path);
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  ~MappedFile();
+
+  /**
+   * The content of the file, nullptr if it is empty
+   */
+  [[nodiscard]] const char* data() const;
+
+  /**
+   * The size of the file in bytes
+   */
+  [[nodiscard]] size_t size() const;
+
+ private:
+  MappedFile() = default;
+
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+#ifdef _WIN32
+  void* mapping_ = nullptr; /**< handle of the mapping object */
+#endif
+};
+
+}  // namespace drift::internal
+
+#endif  // SOURCES_INTERNAL_MAPPED_FILE_H_
@@ -0,0 +1,217 @@
+// Copyright 2023 PANDA GmbH
+
+#include "internal/matrix_cache.h"
+
+#include <algorithm>
+
+#include "wavelet_buffer/wavelet.h"
+
+namespace drift::internal {
+
+static size_t GetThreadIndex() {
+  static std::atomic<size_t> next_index = 0;
+  thread_local const size_t index = next_index++;
+  return index;
+}
+
+static uint64_t NextCacheId() {
+  static std::atomic<uint64_t> next_id = 1;
+  return next_id++;
+}
+
+MatrixCache::MatrixCache(size_t max_bytes)
+    : id_(NextCacheId()), max_bytes_(max_bytes) {}
+
+MatrixCache::~MatrixCache() {
+  std::lock_guard lock(mutex_);
+  for (const auto& table : tables_) {
+    std::lock_guard table_lock(table->mutex);
+    table->matrices.clear();
+    table->detached = true;
+  }
+}
+
+MatrixCache::ThreadTable& MatrixCache::GetThreadTable() {
+  /**
+   * Tables of a thread in all caches, they are emptied when the thread
+   * finishes
+   */
+  struct ThreadTables {
+    std::vector<std::pair<uint64_t, std::shared_ptr<ThreadTable>>> tables;
+
+    ~ThreadTables() {
+      for (const auto& [id, table] : tables) {
+        std::lock_guard lock(table->mutex);
+        table->matrices.clear();
+      }
+    }
+  };
+  thread_local ThreadTables thread_tables;
+
+  auto& tables = thread_tables.tables;
+  for (const auto& [id, table] : tables) {
+    if (id == id_) {
+      return *table;
+    }
+  }
+
+  /* The tables of the destroyed caches are forgotten */
+  std::erase_if(tables, [](const auto& item) {
+    std::lock_guard lock(item.second->mutex);
+    return item.second->detached;
+  });
+
+  auto table = std::make_shared<ThreadTable>();
+  {
+    std::lock_guard lock(mutex_);
+    tables_.push_back(table);
+  }
+  tables.emplace_back(id_, table);
+  return *table;
+}
+
+MatrixCache::Handle MatrixCache::Get(size_t size, WaveletTypes wavelet_type,
+                                     bool transposed) {
+  const Key key = {size, wavelet_type, transposed};
+  auto& table = GetThreadTable();
+  {
+    std::lock_guard lock(table.mutex);
+    auto it = table.matrices.find(key);
+    if (it != table.matrices.end()) {
+      thread_hits_[GetThreadIndex() % kHitCounters].value.fetch_add(
+          1, std::memory_order_relaxed);
+
+      /* The clock ticks only when another matrix has been used since the
+       * last hit, so repeated hits only read it. The lock of the table
+       * keeps the entry from being evicted meanwhile */
+      auto* last_use = it->second.last_use;
+      if (last_use->load(std::memory_order_relaxed) <
+          clock_.load(std::memory_order_relaxed)) {
+        last_use->store(++clock_, std::memory_order_relaxed);
+      }
+      return it->second.matrix;
+    }
+  }
+
+  return GetShared(key, &table);
+}
+
+MatrixCache::Handle MatrixCache::GetShared(const Key& key,
+                                           ThreadTable* table) {
+  /* A kept matrix goes into the table of the thread under the lock of the
+   * cache, so an eviction can't miss it */
+  auto keep = [this, &key, table](Entry* entry) {
+    entry->last_use.store(++clock_, std::memory_order_relaxed);
+    const Handle matrix = entry->matrix;
+    Handle handle(matrix.get(), [matrix](const Matrix*) {});
+    std::lock_guard lock(table->mutex);
+    table->matrices.insert_or_assign(key,
+                                     ThreadEntry{handle, &entry->last_use});
+    return handle;
+  };
+
+  const auto [size, wavelet_type, transposed] = key;
+  {
+    std::lock_guard lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      ++stats_.hits;
+      return keep(&it->second);
+    }
+    ++stats_.misses;
+  }
+
+  /* The matrix is built without the lock, the transposed one from the
+   * shared forward matrix */
+  Handle matrix;
+  if (transposed) {
+    matrix = std::make_shared<const Matrix>(
+        blaze::trans(*Get(size, wavelet_type, false)));
+  } else {
+    matrix = std::make_shared<const Matrix>(
+        wavelet::DaubechiesMat(size, wavelet_type * 2));
+  }
+
+  const size_t bytes = MatrixBytes(*matrix);
+  std::lock_guard lock(mutex_);
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    /* Another thread has built it meanwhile */
+    return keep(&it->second);
+  }
+  if (bytes > max_bytes_) {
+    return matrix;
+  }
+
+  Evict(max_bytes_ - bytes);
+  auto& entry = entries_[key];
+  entry.matrix = std::move(matrix);
+  entry.bytes = bytes;
+  stats_.bytes += bytes;
+  stats_.entries = entries_.size();
+  return keep(&entry);
+}
+
+void MatrixCache::SetLimit(size_t max_bytes) {
+  std::lock_guard lock(mutex_);
+  max_bytes_ = max_bytes;
+  Evict(max_bytes_);
+}
+
+MatrixCache::Stats MatrixCache::stats() const {
+  std::lock_guard lock(mutex_);
+  auto stats = stats_;
+  for (const auto& counter : thread_hits_) {
+    stats.hits += counter.value.load(std::memory_order_relaxed);
+  }
+  for (const auto& table : tables_) {
+    std::lock_guard table_lock(table->mutex);
+    stats.thread_handles += table->matrices.size();
+  }
+  return stats;
+}
+
+void MatrixCache::Clear() {
+  std::lock_guard lock(mutex_);
+  for (const auto& table : tables_) {
+    std::lock_guard table_lock(table->mutex);
+    table->matrices.clear();
+  }
+  entries_.clear();
+  stats_ = {};
+  for (auto& counter : thread_hits_) {
+    counter.value.store(0, std::memory_order_relaxed);
+  }
+}
+
+size_t MatrixCache::MatrixBytes(const Matrix& matrix) {
+  return matrix.nonZeros() * (sizeof(DataType) + sizeof(size_t)) +
+         matrix.rows() * sizeof(size_t);
+}
+
+void MatrixCache::Evict(size_t max_bytes) {
+  while (stats_.bytes > max_bytes && !entries_.empty()) {
+    auto it = std::min_element(
+        entries_.begin(), entries_.end(), [](const auto& a, const auto& b) {
+          return a.second.last_use.load(std::memory_order_relaxed) <
+                 b.second.last_use.load(std::memory_order_relaxed);
+        });
+    DropFromThreads(it->first);
+    stats_.bytes -= it->second.bytes;
+    entries_.erase(it);
+    ++stats_.evictions;
+  }
+  stats_.entries = entries_.size();
+}
+
+void MatrixCache::DropFromThreads(const Key& key) {
+  std::erase_if(tables_, [](const auto& table) {
+    return table.use_count() == 1;
+  });
+  for (const auto& table : tables_) {
+    std::lock_guard lock(table->mutex);
+    table->matrices.erase(key);
+  }
+}
+
+}  // namespace drift::internal
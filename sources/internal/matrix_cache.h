@@ -0,0 +1,177 @@
+// Copyright 2023 PANDA GmbH
+
+#ifndef SOURCES_INTERNAL_MATRIX_CACHE_H_
+#define SOURCES_INTERNAL_MATRIX_CACHE_H_
+
+#include <blaze/Blaze.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "wavelet_buffer/primitives.h"
+#include "wavelet_buffer/wavelet_parameters.h"
+
+namespace drift::internal {
+
+/**
+ * Default memory bound of the matrix cache
+ */
+constexpr size_t kDefaultMatrixCacheBytes = size_t{256} << 20;
+
+/**
+ * Daubechies matrices of the matrix engine keyed by the size of the input of
+ * a step and the wavelet type, so plans with different channel numbers or
+ * signal shapes share the matrices of the same sizes. The matrices are
+ * immutable and handed out as shared handles without copies. The memory is
+ * bounded, the least recently used matrices are dropped first and stay
+ * alive while a plan holds them.
+ *
+ * A hit takes no shared lock: every thread keeps a table of the handles it
+ * has taken from the shared cache and finds them again under a lock of its
+ * own. A hit refreshes the recency of the matrix only when the clock of the
+ * cache has moved since its last use, so the hot matrices don't write shared
+ * memory on every hit. The evicting thread drops the evicted matrices from
+ * the tables of all threads, idle threads don't keep them alive
+ */
+class MatrixCache {
+ public:
+  using Matrix = blaze::CompressedMatrix<DataType>;
+  using Handle = std::shared_ptr<const Matrix>;
+
+  /**
+   * Counters of the cache
+   */
+  struct Stats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+    size_t thread_handles = 0; /**< handles in the tables of the threads */
+  };
+
+  /**
+   * @param max_bytes memory bound of the matrices
+   */
+  explicit MatrixCache(size_t max_bytes = kDefaultMatrixCacheBytes);
+
+  MatrixCache(const MatrixCache&) = delete;
+  MatrixCache& operator=(const MatrixCache&) = delete;
+
+  /**
+   * Drop the handles of the threads, the handles given out stay valid
+   */
+  ~MatrixCache();
+
+  /**
+   * Matrix of a step, it is built on a miss
+   * @param size the size of the input of the step in a dimension
+   * @param wavelet_type
+   * @param transposed true for the composition
+   * @return the matrix shared with the cache
+   */
+  Handle Get(size_t size, WaveletTypes wavelet_type, bool transposed);
+
+  /**
+   * Change the memory bound, the matrices over it are dropped
+   */
+  void SetLimit(size_t max_bytes);
+
+  [[nodiscard]] Stats stats() const;
+
+  /**
+   * Drop all matrices and reset the counters
+   */
+  void Clear();
+
+  /**
+   * Memory of a sparse matrix: the elements with their indexes and the
+   * beginnings of the rows
+   */
+  static size_t MatrixBytes(const Matrix& matrix);
+
+ private:
+  using Key = std::tuple<size_t, WaveletTypes, bool>;
+
+  struct Entry {
+    Handle matrix;
+    size_t bytes = 0;
+    std::atomic<uint64_t> last_use = 0; /**< the clock of the last use */
+  };
+
+  /**
+   * Handle of a thread with its own reference counter, the copies on the
+   * thread don't write the counter of the shared handle
+   */
+  struct ThreadEntry {
+    Handle matrix;
+    std::atomic<uint64_t>* last_use; /**< of the entry of the cache */
+  };
+
+  /**
+   * Handles a thread has taken from the cache. The lock is taken by the
+   * thread and by the evictions only, so it isn't contended
+   */
+  struct ThreadTable {
+    std::mutex mutex;
+    std::map<Key, ThreadEntry> matrices;
+    bool detached = false; /**< the cache is destroyed */
+  };
+
+  /**
+   * Hits of the threads, the counters are in different cache lines
+   */
+  struct alignas(64) HitCounter {
+    std::atomic<size_t> value = 0;
+  };
+
+  static constexpr size_t kHitCounters = 64;
+
+  /**
+   * Table of the calling thread, it is registered in the cache on the first
+   * call of the thread
+   */
+  ThreadTable& GetThreadTable();
+
+  /**
+   * Look up the shared cache, insert the matrix on a miss. A kept matrix is
+   * put into the table of the thread
+   * @return the handle of the thread, or the matrix if the cache doesn't
+   * keep it
+   */
+  Handle GetShared(const Key& key, ThreadTable* table);
+
+  /**
+   * Drop the least recently used matrices from the cache and from the tables
+   * of the threads
+   */
+  void Evict(size_t max_bytes);
+
+  /**
+   * Drop a matrix from the tables of the threads, the tables of the finished
+   * threads are forgotten
+   */
+  void DropFromThreads(const Key& key);
+
+  const uint64_t id_; /**< tells the tables of other caches */
+  std::atomic<uint64_t> clock_ = 0; /**< ticks on the uses of the cache */
+  std::array<HitCounter, kHitCounters> thread_hits_;
+
+  size_t max_bytes_;
+  Stats stats_; /**< hits of the shared cache */
+  std::map<Key, Entry> entries_;
+  std::vector<std::shared_ptr<ThreadTable>> tables_;
+  mutable std::mutex mutex_; /**< taken before the locks of the tables */
+};
+
+}  // namespace drift::internal
+
+#endif  // SOURCES_INTERNAL_MATRIX_CACHE_H_
@@ -0,0 +1,86 @@
+// Copyright 2023 PANDA GmbH
+
+#include "internal/resolution_cache.h"
+
+#include <algorithm>
+
+namespace drift::internal {
+
+ResolutionCache::ResolutionCache(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+ResolutionCache::ResolutionCache(const ResolutionCache& cache)
+    : max_bytes_(cache.budget()) {}
+
+ResolutionCache& ResolutionCache::operator=(const ResolutionCache& cache) {
+  if (this != &cache) {
+    const size_t max_bytes = cache.budget();
+    std::lock_guard lock(mutex_);
+    max_bytes_ = max_bytes;
+    entries_.clear();
+    bytes_ = 0;
+  }
+  return *this;
+}
+
+void ResolutionCache::SetBudget(size_t max_bytes) {
+  std::lock_guard lock(mutex_);
+  max_bytes_ = max_bytes;
+  Evict(max_bytes_);
+}
+
+size_t ResolutionCache::budget() const {
+  std::lock_guard lock(mutex_);
+  return max_bytes_;
+}
+
+size_t ResolutionCache::bytes() const {
+  std::lock_guard lock(mutex_);
+  return bytes_;
+}
+
+std::pair<size_t, ResolutionCache::Approximation> ResolutionCache::Find(
+    size_t channel, size_t level) const {
+  std::lock_guard lock(mutex_);
+  /* The levels of a channel are ordered, the first one from the level is the
+   * finest one the composition can resume from */
+  auto it = entries_.lower_bound({channel, level});
+  if (it == entries_.end() || it->first.first != channel) {
+    return {level, nullptr};
+  }
+  it->second.last_use = ++tick_;
+  return {it->first.second, it->second.approximation};
+}
+
+void ResolutionCache::Insert(size_t channel, size_t level,
+                             const Signal2D& approximation) {
+  const size_t bytes =
+      approximation.rows() * approximation.columns() * sizeof(DataType);
+  std::lock_guard lock(mutex_);
+  if (bytes > max_bytes_ || entries_.count({channel, level}) != 0) {
+    return;
+  }
+
+  Evict(max_bytes_ - bytes);
+  entries_[{channel, level}] = {std::make_shared<const Signal2D>(approximation),
+                                bytes, ++tick_};
+  bytes_ += bytes;
+}
+
+void ResolutionCache::Clear() {
+  std::lock_guard lock(mutex_);
+  entries_.clear();
+  bytes_ = 0;
+}
+
+void ResolutionCache::Evict(size_t max_bytes) {
+  while (bytes_ > max_bytes) {
+    auto oldest = std::min_element(
+        entries_.begin(), entries_.end(), [](const auto& a, const auto& b) {
+          return a.second.last_use < b.second.last_use;
+        });
+    bytes_ -= oldest->second.bytes;
+    entries_.erase(oldest);
+  }
+}
+
+}  // namespace drift::internal
@@ -0,0 +1,94 @@
+// Copyright 2023 PANDA GmbH
+
+#ifndef SOURCES_INTERNAL_RESOLUTION_CACHE_H_
+#define SOURCES_INTERNAL_RESOLUTION_CACHE_H_
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "wavelet_buffer/primitives.h"
+
+namespace drift::internal {
+
+/**
+ * Approximations with padding of the channels of a buffer at the levels of
+ * the composition, a finer composition resumes from the nearest cached
+ * level. The memory is bounded, the least recently used levels are dropped
+ * first. The calls are thread-safe, the approximations are immutable
+ */
+class ResolutionCache {
+ public:
+  using Approximation = std::shared_ptr<const Signal2D>;
+
+  /**
+   * @param max_bytes memory budget of the approximations, 0 to cache nothing
+   */
+  explicit ResolutionCache(size_t max_bytes = 0);
+
+  /**
+   * A copy has the budget but not the approximations, they belong to the
+   * subbands of the original
+   */
+  ResolutionCache(const ResolutionCache& cache);
+
+  ResolutionCache& operator=(const ResolutionCache& cache);
+
+  /**
+   * Change the budget, the approximations over it are dropped
+   */
+  void SetBudget(size_t max_bytes);
+
+  /**
+   * Memory budget of the approximations in bytes
+   */
+  [[nodiscard]] size_t budget() const;
+
+  /**
+   * Memory of the cached approximations in bytes
+   */
+  [[nodiscard]] size_t bytes() const;
+
+  /**
+   * Find the finest cached approximation of a channel not finer than a level
+   * @param channel
+   * @param level the level to compose
+   * @return the level and the approximation, nullptr if there is none
+   */
+  [[nodiscard]] std::pair<size_t, Approximation> Find(size_t channel,
+                                                      size_t level) const;
+
+  /**
+   * Keep a copy of an approximation if it fits into the budget
+   * @param channel
+   * @param level
+   * @param approximation the approximation with padding at the level
+   */
+  void Insert(size_t channel, size_t level, const Signal2D& approximation);
+
+  /**
+   * Drop all approximations, e.g. the subbands have changed
+   */
+  void Clear();
+
+ private:
+  struct Entry {
+    Approximation approximation;
+    size_t bytes;
+    size_t last_use; /**< tick of the last Find or Insert */
+  };
+
+  void Evict(size_t max_bytes);
+
+  size_t max_bytes_;
+  size_t bytes_ = 0;
+  mutable size_t tick_ = 0;
+  mutable std::map<std::pair<size_t, size_t>, Entry> entries_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace drift::internal
+
+#endif  // SOURCES_INTERNAL_RESOLUTION_CACHE_H_
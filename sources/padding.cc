@@ -2,6 +2,8 @@
 
 #include "wavelet_buffer/padding.h"
 
+#include <utility>
+
 namespace drift {
 
 PaddingAlgorithm::PaddingAlgorithm(size_t rows, size_t columns,
@@ -33,34 +35,84 @@ blaze::DynamicMatrix<DataType> PaddingAlgorithm::Crop(
   return result;
 }
 
-blaze::DynamicMatrix<DataType> ZeroPaddingAlgorithm::Extend(
-    const blaze::DynamicMatrix<DataType> &source) const {
-  assert(columns_ >= source.columns() && rows_ >= source.rows() &&
-         "Padding can only be done if the source is smaller then the new "
+/**
+ * Offset of the signal in the padded one
+ */
+static std::pair<size_t, size_t> CropOffset(size_t padded_rows,
+                                            size_t padded_columns, size_t rows,
+                                            size_t columns,
+                                            PaddingLocation location) {
+  if (location == PaddingLocation::kBoth) {
+    return {(padded_rows - rows) / 2, (padded_columns - columns) / 2};
+  }
+  return {0, 0};
+}
+
+void PaddingAlgorithm::Crop(const ConstSignal2DView &padded,
+                            blaze::DynamicMatrix<DataType> *result) const {
+  assert(columns_ <= padded.columns() && rows_ <= padded.rows() &&
+         "Crop can only be done if the source is bigger then the new "
          "size");
 
   if (rows_ * columns_ == 0) {
-    // empty matrix is valid input fpr kNone wavelet type, bypass
-    return source;
+    *result = padded;
+    return;
   }
 
-  blaze::DynamicMatrix<DataType> result =
-      blaze::zero<DataType>(rows_, columns_);
+  const auto [row_0, column_0] = CropOffset(
+      padded.rows(), padded.columns(), rows_, columns_, location_);
+  *result = submatrix(padded, row_0, column_0, rows_, columns_);
+}
+
+void PaddingAlgorithm::Crop(const ConstSignal2DView &padded,
+                            Signal2DView *result) const {
+  assert(columns_ <= padded.columns() && rows_ <= padded.rows() &&
+         "Crop can only be done if the source is bigger then the new "
+         "size");
+  assert(result->rows() == rows_ && result->columns() == columns_);
+
+  if (rows_ * columns_ == 0) {
+    return;
+  }
+
+  const auto [row_0, column_0] = CropOffset(
+      padded.rows(), padded.columns(), rows_, columns_, location_);
+  *result = submatrix(padded, row_0, column_0, rows_, columns_);
+}
+
+void PaddingAlgorithm::Extend(const blaze::DynamicMatrix<DataType> &source,
+                              Signal2DView *result) const {
+  *result = Extend(source);
+}
+
+void PaddingAlgorithm::Extend(const Signal2DView &source,
+                              Signal2DView *result) const {
+  *result = Extend(blaze::DynamicMatrix<DataType>(source));
+}
+
+/**
+ * Zero padding into a matrix of the padded size
+ */
+template <typename Source, typename Matrix>
+static void ExtendWithZeros(const Source &source, PaddingLocation location,
+                            Matrix *result) {
+  const size_t rows = result->rows();
+  const size_t columns = result->columns();
+  *result = 0;
 
   size_t row_0 = 0;
   size_t column_0 = 0;
 
-  if (location_ == PaddingLocation::kBoth) {
-    row_0 = (rows_ - source.rows()) / 2;
-    column_0 = (columns_ - source.columns()) / 2;
+  if (location == PaddingLocation::kBoth) {
+    row_0 = (rows - source.rows()) / 2;
+    column_0 = (columns - source.columns()) / 2;
   }
 
-  submatrix(result, row_0, column_0, source.rows(), source.columns()) = source;
-
-  return result;
+  submatrix(*result, row_0, column_0, source.rows(), source.columns()) =
+      source;
 }
 
-blaze::DynamicMatrix<DataType> ZeroDerivativePaddingAlgorithm::Extend(
+blaze::DynamicMatrix<DataType> ZeroPaddingAlgorithm::Extend(
     const blaze::DynamicMatrix<DataType> &source) const {
   assert(columns_ >= source.columns() && rows_ >= source.rows() &&
          "Padding can only be done if the source is smaller then the new "
@@ -71,28 +123,64 @@ blaze::DynamicMatrix<DataType> ZeroDerivativePaddingAlgorithm::Extend(
     return source;
   }
 
+  blaze::DynamicMatrix<DataType> result(rows_, columns_);
+  ExtendWithZeros(source, location_, &result);
+  return result;
+}
+
+void ZeroPaddingAlgorithm::Extend(const blaze::DynamicMatrix<DataType> &source,
+                                  Signal2DView *result) const {
+  assert(result->rows() == rows_ && result->columns() == columns_);
+
+  if (rows_ * columns_ == 0) {
+    *result = source;
+    return;
+  }
+
+  ExtendWithZeros(source, location_, result);
+}
+
+void ZeroPaddingAlgorithm::Extend(const Signal2DView &source,
+                                  Signal2DView *result) const {
+  assert(result->rows() == rows_ && result->columns() == columns_);
+
+  if (rows_ * columns_ == 0) {
+    *result = source;
+    return;
+  }
+
+  ExtendWithZeros(source, location_, result);
+}
+
+/**
+ * Zero derivative padding into a matrix of the padded size
+ */
+template <typename Source, typename Matrix>
+static void ExtendWithEdges(const Source &source, PaddingLocation location,
+                            Matrix *output) {
+  Matrix &result = *output;
+
   /* Calculate deltas */
-  const size_t dc = columns_ - source.columns();
-  const size_t dr = rows_ - source.rows();
+  const size_t dc = result.columns() - source.columns();
+  const size_t dr = result.rows() - source.rows();
 
   /* Calculate padding sizes */
   size_t left_padding, right_padding, top_padding, bottom_padding;
-  if (location_ == PaddingLocation::kRight) {
+  if (location == PaddingLocation::kRight) {
     left_padding = 0;
     top_padding = 0;
     right_padding = dc;
     bottom_padding = dr;
-  } else if (location_ == PaddingLocation::kBoth) {
+  } else if (location == PaddingLocation::kBoth) {
     left_padding = dc / 2;
     top_padding = dr / 2;
     right_padding = dc / 2 + dc % 2;
     bottom_padding = dr / 2 + dr % 2;
   } else {
-    return {};
+    return;
   }
 
   /* Fill original part */
-  blaze::DynamicMatrix<DataType> result(rows_, columns_);
   submatrix(result, top_padding, left_padding, source.rows(),
             source.columns()) = source;
 
@@ -155,8 +243,51 @@ blaze::DynamicMatrix<DataType> ZeroDerivativePaddingAlgorithm::Extend(
     submatrix(result, 0, left_padding + source.columns(), top_padding,
               right_padding) = top_righ_corner;
   }
+}
+
+blaze::DynamicMatrix<DataType> ZeroDerivativePaddingAlgorithm::Extend(
+    const blaze::DynamicMatrix<DataType> &source) const {
+  assert(columns_ >= source.columns() && rows_ >= source.rows() &&
+         "Padding can only be done if the source is smaller then the new "
+         "size");
 
+  if (rows_ * columns_ == 0) {
+    // empty matrix is valid input fpr kNone wavelet type, bypass
+    return source;
+  }
+
+  if (location_ != PaddingLocation::kRight &&
+      location_ != PaddingLocation::kBoth) {
+    return {};
+  }
+
+  blaze::DynamicMatrix<DataType> result(rows_, columns_);
+  ExtendWithEdges(source, location_, &result);
   return result;
 }
 
+void ZeroDerivativePaddingAlgorithm::Extend(
+    const blaze::DynamicMatrix<DataType> &source, Signal2DView *result) const {
+  assert(result->rows() == rows_ && result->columns() == columns_);
+
+  if (rows_ * columns_ == 0) {
+    *result = source;
+    return;
+  }
+
+  ExtendWithEdges(source, location_, result);
+}
+
+void ZeroDerivativePaddingAlgorithm::Extend(const Signal2DView &source,
+                                            Signal2DView *result) const {
+  assert(result->rows() == rows_ && result->columns() == columns_);
+
+  if (rows_ * columns_ == 0) {
+    *result = source;
+    return;
+  }
+
+  ExtendWithEdges(source, location_, result);
+}
+
 }  // namespace drift
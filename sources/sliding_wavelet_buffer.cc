@@ -0,0 +1,158 @@
+// Copyright 2023 PANDA GmbH
+
+#include "wavelet_buffer/sliding_wavelet_buffer.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace drift {
+
+/**
+ * Periodic analysis of the coefficients of a level from the first one to
+ * its end, the same sums as the scalar interior of AnalyzeLine
+ * @param src the approximation of the previous step
+ * @param src_offset the physical index of the first element of the source
+ * @param filters
+ * @param first the logical index of the first coefficient to compute
+ * @param low the approximation, the half of the source
+ * @param high the details, the half of the source
+ * @param dst_offset the physical index of the first coefficient
+ */
+static void AnalyzeWindow(const std::vector<DataType> &src, size_t src_offset,
+                          const wavelet::FilterBank &filters, size_t first,
+                          std::vector<DataType> *low,
+                          std::vector<DataType> *high, size_t dst_offset) {
+  const size_t size = src.size();
+  const size_t half = low->size();
+  const size_t length = filters.low_pass.size();
+  for (size_t i = first; i < half; ++i) {
+    size_t pos = (src_offset + 2 * i) % size;
+    DataType l = 0;
+    DataType h = 0;
+    for (size_t k = 0; k < length; ++k) {
+      l += filters.low_pass[k] * src[pos];
+      h += filters.high_pass[k] * src[pos];
+      if (++pos == size) {
+        pos = 0;
+      }
+    }
+    const size_t index = (dst_offset + i) % half;
+    (*low)[index] = l;
+    (*high)[index] = h;
+  }
+}
+
+/**
+ * Copy a periodic line into a subband in the logical order
+ */
+static void CopyToSubband(const std::vector<DataType> &line, size_t offset,
+                          Signal2D *subband) {
+  const size_t size = line.size();
+  subband->resize(size, 1, false);
+  for (size_t i = 0; i < size; ++i) {
+    (*subband)(i, 0) = line[(offset + i) % size];
+  }
+}
+
+SlidingWaveletBuffer::SlidingWaveletBuffer(const WaveletParameters &parameters)
+    : buffer_(parameters) {
+  const auto &params = buffer_.parameters();
+  if (params.dimension() != 1 || params.signal_number != 1) {
+    throw std::runtime_error("Sliding window supports only one 1D signal");
+  }
+
+  const size_t window = params.signal_shape[0];
+  const size_t steps = params.decomposition_steps;
+  if (window % (size_t{1} << steps) != 0) {
+    throw std::runtime_error("Sliding window must be divisible by " +
+                             std::to_string(size_t{1} << steps));
+  }
+
+  if (steps > 0) {
+    filters_ = wavelet::DaubechiesFilters(params.wavelet_type * 2);
+  }
+
+  levels_.resize(steps + 1);
+  levels_[0].low.assign(window, 0);
+  for (size_t step = 1; step <= steps; ++step) {
+    levels_[step].low.assign(window >> step, 0);
+    levels_[step].high.assign(window >> step, 0);
+  }
+  synced_ = false;
+}
+
+void SlidingWaveletBuffer::Push(std::span<const DataType> samples) {
+  if (samples.empty()) {
+    return;
+  }
+
+  auto &window = levels_[0];
+  const size_t size = window.low.size();
+  if (samples.size() > size) {
+    samples = samples.last(size);
+  }
+
+  /* The new samples take the place of the oldest ones at the end */
+  const size_t count = samples.size();
+  window.offset = (window.offset + count) % size;
+  for (size_t i = 0; i < count; ++i) {
+    window.low[(window.offset + size - count + i) % size] = samples[i];
+  }
+
+  /* The coefficients shift with the window only if the shift is a whole
+   * number of coefficients at every step */
+  const size_t steps = levels_.size() - 1;
+  const bool shifted = count % (size_t{1} << steps) == 0;
+  size_t changed = shifted ? count : size;
+
+  const size_t length = filters_.low_pass.size();
+  for (size_t step = 0; step < steps; ++step) {
+    const auto &src = levels_[step];
+    auto &dst = levels_[step + 1];
+    const size_t src_size = src.low.size();
+    const size_t half = dst.low.size();
+    if (shifted) {
+      dst.offset = (dst.offset + (count >> (step + 1))) % half;
+    }
+
+    /* A coefficient is kept if its filter ends before the changed
+     * approximations and doesn't wrap around */
+    const size_t first = changed + length > src_size
+                             ? 0
+                             : (src_size - changed - length) / 2 + 1;
+    AnalyzeWindow(src.low, src.offset, filters_, first, &dst.low, &dst.high,
+                  dst.offset);
+    changed = half - first;
+  }
+  synced_ = false;
+}
+
+const WaveletBuffer &SlidingWaveletBuffer::buffer() {
+  if (!synced_) {
+    const size_t steps = levels_.size() - 1;
+    auto &decomposition = buffer_[0];
+    for (size_t step = 1; step <= steps; ++step) {
+      CopyToSubband(levels_[step].high, levels_[step].offset,
+                    &decomposition[step - 1]);
+    }
+    CopyToSubband(levels_[steps].low, levels_[steps].offset,
+                  &decomposition[steps]);
+    synced_ = true;
+  }
+  return buffer_;
+}
+
+bool SlidingWaveletBuffer::Compose(Signal1D *data, int scale_factor) {
+  return buffer().Compose(data, scale_factor);
+}
+
+bool SlidingWaveletBuffer::Serialize(std::string *blob,
+                                     uint8_t sf_compression) {
+  return buffer().Serialize(blob, sf_compression);
+}
+
+const WaveletParameters &SlidingWaveletBuffer::parameters() const {
+  return buffer_.parameters();
+}
+
+}  // namespace drift
@@ -0,0 +1,201 @@
+// Copyright 2023 PANDA GmbH
+
+#include "wavelet_buffer/thread_pool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <utility>
+
+namespace drift {
+
+/* Set in the threads running tasks, nested calls don't wait for the pool */
+static thread_local bool in_task = false;
+
+/**
+ * Pack the range [begin, end) into one word
+ */
+static uint64_t PackRange(uint64_t begin, uint64_t end) {
+  return begin << 32 | end;
+}
+
+/**
+ * Mark the thread as running tasks for the lifetime of the object
+ */
+struct TaskScope {
+  TaskScope() { in_task = true; }
+  ~TaskScope() { in_task = false; }
+};
+
+ThreadPool::ThreadPool(size_t threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  for (size_t i = 0; i < threads; ++i) {
+    workspaces_.push_back(std::make_unique<Workspace>());
+  }
+  ranges_ = std::make_unique<TaskRange[]>(threads);
+
+  /* Thread 0 is the caller */
+  workers_.reserve(threads - 1);
+  for (size_t i = 1; i < threads; ++i) {
+    workers_.emplace_back([this, i] { WorkerLoop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(mutex_);
+    stop_ = true;
+  }
+  start_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::ParallelFor(
+    size_t count, const std::function<void(size_t, Workspace*)>& func) {
+  if (count == 0) {
+    return;
+  }
+
+  if (in_task) {
+    /* The workspace of the thread is used by the outer task */
+    Workspace workspace;
+    for (size_t i = 0; i < count; ++i) {
+      func(i, &workspace);
+    }
+    return;
+  }
+
+  if (workers_.empty() || count == 1) {
+    std::lock_guard call_lock(call_mutex_);
+    const TaskScope scope;
+    for (size_t i = 0; i < count; ++i) {
+      func(i, workspaces_[0].get());
+    }
+    return;
+  }
+
+  assert(count <= std::numeric_limits<uint32_t>::max());
+
+  std::lock_guard call_lock(call_mutex_);
+  {
+    std::lock_guard lock(mutex_);
+    func_ = &func;
+    failed_ = false;
+    error_ = nullptr;
+    const size_t threads = size();
+    for (size_t i = 0; i < threads; ++i) {
+      ranges_[i].range = PackRange(count * i / threads,
+                                   count * (i + 1) / threads);
+    }
+    running_ = workers_.size();
+    ++generation_;
+  }
+  start_.notify_all();
+
+  RunTasks(0);
+
+  std::exception_ptr error;
+  {
+    std::unique_lock lock(mutex_);
+    finish_.wait(lock, [this] { return running_ == 0; });
+    func_ = nullptr;
+    error = std::exchange(error_, nullptr);
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+size_t ThreadPool::size() const { return workspaces_.size(); }
+
+void ThreadPool::WorkerLoop(size_t thread) {
+  size_t generation = 0;
+  while (true) {
+    {
+      std::unique_lock lock(mutex_);
+      start_.wait(lock,
+                  [&] { return stop_ || generation_ != generation; });
+      if (stop_) {
+        return;
+      }
+      generation = generation_;
+    }
+
+    RunTasks(thread);
+
+    bool last = false;
+    {
+      std::lock_guard lock(mutex_);
+      last = --running_ == 0;
+    }
+    if (last) {
+      finish_.notify_one();
+    }
+  }
+}
+
+void ThreadPool::RunTasks(size_t thread) {
+  const TaskScope scope;
+  size_t index;
+  while (!failed_ &&
+         (TakeTask(thread, &index) || StealTask(thread, &index))) {
+    try {
+      (*func_)(index, workspaces_[thread].get());
+    } catch (...) {
+      std::lock_guard lock(mutex_);
+      if (!error_) {
+        error_ = std::current_exception();
+      }
+      failed_ = true;
+    }
+  }
+}
+
+bool ThreadPool::TakeTask(size_t thread, size_t* index) {
+  auto& range = ranges_[thread].range;
+  uint64_t current = range.load();
+  while (true) {
+    const uint64_t begin = current >> 32;
+    const uint64_t end = current & 0xFFFFFFFF;
+    if (begin >= end) {
+      return false;
+    }
+    if (range.compare_exchange_weak(current, PackRange(begin + 1, end))) {
+      *index = begin;
+      return true;
+    }
+  }
+}
+
+bool ThreadPool::StealTask(size_t thread, size_t* index) {
+  const size_t threads = size();
+  for (size_t i = 1; i < threads; ++i) {
+    auto& victim = ranges_[(thread + i) % threads].range;
+    uint64_t current = victim.load();
+    while (true) {
+      const uint64_t begin = current >> 32;
+      const uint64_t end = current & 0xFFFFFFFF;
+      if (begin >= end) {
+        break;
+      }
+
+      /* The victim keeps the front half, it is the next to run there */
+      const uint64_t middle = begin + (end - begin) / 2;
+      if (victim.compare_exchange_weak(current, PackRange(begin, middle))) {
+        /* Only the owner refills an empty range, the thieves skip it */
+        ranges_[thread].range = PackRange(middle + 1, end);
+        *index = middle;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace drift
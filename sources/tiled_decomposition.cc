@@ -0,0 +1,425 @@
+// Copyright 2023 PANDA GmbH
+
+#include "wavelet_buffer/tiled_decomposition.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "internal/dwt_kernels.h"
+#include "internal/dwt_simd.h"
+#include "internal/mapped_file.h"
+#include "wavelet_buffer/wavelet_utils.h"
+
+namespace drift {
+
+/**
+ * Image of a step in a mapped file, the coordinates of the padded image wrap
+ * around periodically and the padding repeats the edges as
+ * ZeroDerivativePaddingAlgorithm does
+ */
+struct TilePlane {
+  const DataType *data;
+  size_t rows;
+  size_t columns;
+  size_t padded_rows;
+  size_t padded_columns;
+  size_t top;  /**< rows of the padding before the image */
+  size_t left; /**< columns of the padding before the image */
+};
+
+/**
+ * Subband in a file with rows of a fixed number of columns
+ */
+struct SubbandWriter {
+  std::fstream *file;
+  size_t offset; /**< the first element */
+  size_t columns;
+};
+
+/**
+ * Copy a tile of the padded image, the tile can cross the end of the image
+ * @param plane
+ * @param row the first row in the padded image
+ * @param rows
+ * @param column the first column in the padded image
+ * @param columns
+ * @param tile the tile, its rows follow each other
+ */
+static void ReadTile(const TilePlane &plane, size_t row, size_t rows,
+                     size_t column, size_t columns, DataType *tile) {
+  for (size_t r = 0; r < rows; ++r) {
+    const size_t padded_row = (row + r) % plane.padded_rows;
+    const size_t source_row =
+        padded_row < plane.top
+            ? 0
+            : std::min(padded_row - plane.top, plane.rows - 1);
+    const DataType *src = plane.data + source_row * plane.columns;
+    DataType *dst = tile + r * columns;
+
+    for (size_t c = 0; c < columns;) {
+      const size_t padded_column = (column + c) % plane.padded_columns;
+      if (padded_column < plane.left) {
+        dst[c++] = src[0];
+      } else if (padded_column - plane.left >= plane.columns) {
+        dst[c++] = src[plane.columns - 1];
+      } else {
+        /* Copy the samples of the image up to its edge at once */
+        const size_t first = padded_column - plane.left;
+        const size_t count = std::min(columns - c, plane.columns - first);
+        std::copy_n(src + first, count, dst + c);
+        c += count;
+      }
+    }
+  }
+}
+
+/**
+ * Write a tile into a subband
+ * @return false if the file can't be written
+ */
+static bool WriteTile(const SubbandWriter &writer, size_t row, size_t column,
+                      size_t rows, size_t columns, const DataType *tile) {
+  for (size_t r = 0; r < rows; ++r) {
+    const size_t position =
+        writer.offset + (row + r) * writer.columns + column;
+    writer.file->seekp(
+        static_cast<std::streamoff>(position * sizeof(DataType)));
+    writer.file->write(
+        reinterpret_cast<const char *>(tile + r * columns),
+        static_cast<std::streamsize>(columns * sizeof(DataType)));
+  }
+  return writer.file->good();
+}
+
+/**
+ * Create a file of zeros and open it for writing at any position
+ * @param path
+ * @param size the number of elements
+ * @param file the opened file
+ * @return false if the file can't be created
+ */
+static bool CreateRawFile(const std::string &path, size_t size,
+                          std::fstream *file) {
+  {
+    std::ofstream create(path, std::ios::binary | std::ios::trunc);
+    if (!create) {
+      std::cerr << "Failed to create " << path << std::endl;
+      return false;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::resize_file(path, size * sizeof(DataType), error);
+  if (error) {
+    std::cerr << "Failed to resize " << path << ": " << error.message()
+              << std::endl;
+    return false;
+  }
+
+  file->open(path, std::ios::binary | std::ios::in | std::ios::out);
+  if (!*file) {
+    std::cerr << "Failed to open " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * One step of the decomposition tile by tile. The column tiles start at
+ * multiples of the vectorized blocks, so the rows have the same sums as
+ * AnalyzeLine, and the columns have the same sums for any tiles
+ * @param x the image of the step
+ * @param taps filters
+ * @param options
+ * @param subbands writers of LL, LH, HL and HH
+ * @return false if a subband can't be written
+ */
+template <typename Taps>
+static bool AnalyzeTiles(const TilePlane &x, const Taps &taps,
+                         const TileOptions &options,
+                         const SubbandWriter (&subbands)[4]) {
+  constexpr size_t kBlock = wavelet::internal::kSimdBlock;
+  const size_t half_rows = x.padded_rows / 2;
+  const size_t half_columns = x.padded_columns / 2;
+  const size_t tile_rows = std::clamp<size_t>(options.rows, 1, half_rows);
+  const size_t tile_columns = std::min(
+      std::max<size_t>((options.columns + kBlock - 1) / kBlock, 1) * kBlock,
+      half_columns);
+  const size_t overlap = taps.length - 2;
+
+  std::vector<DataType> input((2 * tile_rows + overlap) *
+                              (2 * tile_columns + overlap));
+  std::vector<DataType> low((2 * tile_rows + overlap) * tile_columns);
+  std::vector<DataType> high(low.size());
+  std::vector<DataType> output[4];
+  for (auto &tile : output) {
+    tile.resize(tile_rows * tile_columns);
+  }
+
+  for (size_t row = 0; row < half_rows; row += tile_rows) {
+    const size_t rows = std::min(tile_rows, half_rows - row);
+    const size_t input_rows = 2 * rows + overlap;
+    for (size_t column = 0; column < half_columns; column += tile_columns) {
+      const size_t columns = std::min(tile_columns, half_columns - column);
+      const size_t input_columns = 2 * columns + overlap;
+      ReadTile(x, 2 * row, input_rows, 2 * column, input_columns,
+               input.data());
+
+      /* The rows of the tile and of the overlap below it */
+      for (size_t r = 0; r < input_rows; ++r) {
+        wavelet::internal::AnalyzeSegment(
+            input.data() + r * input_columns, x.padded_columns, column,
+            columns, taps, low.data() + r * columns,
+            high.data() + r * columns);
+      }
+
+      wavelet::internal::AnalyzeColumnSegment(
+          {low.data(), columns}, rows, columns, taps,
+          {output[0].data(), columns}, {output[1].data(), columns});
+      wavelet::internal::AnalyzeColumnSegment(
+          {high.data(), columns}, rows, columns, taps,
+          {output[2].data(), columns}, {output[3].data(), columns});
+
+      for (int i = 0; i < 4; ++i) {
+        if (!WriteTile(subbands[i], row, column, rows, columns,
+                       output[i].data())) {
+          std::cerr << "Failed to write subband" << std::endl;
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Decompose one channel step by step, the approximations of the steps but
+ * the last one are written into the temporary files in turns and mapped as
+ * the input of the next step
+ * @param signal the padded image
+ * @param taps filters
+ * @param steps the number of the steps, at least 1
+ * @param options
+ * @param subbands the layout of the channel
+ * @param output the file of the subbands
+ * @param temporary the paths of the temporary files
+ * @return true if it has no errors
+ */
+template <typename Taps>
+static bool DecomposeChannel(const TilePlane &signal, const Taps &taps,
+                             size_t steps, const TileOptions &options,
+                             const TiledSubband *subbands,
+                             std::fstream *output,
+                             const std::string (&temporary)[2]) {
+  std::unique_ptr<internal::MappedFile> approximation;
+  TilePlane plane = signal;
+  for (size_t step = 0; step < steps; ++step) {
+    const size_t rows = plane.padded_rows / 2;
+    const size_t columns = plane.padded_columns / 2;
+    const auto *details = subbands + step * 3;
+    const bool last = step + 1 == steps;
+
+    std::fstream next;
+    SubbandWriter ll{output, subbands[steps * 3].offset, columns};
+    if (!last) {
+      if (!CreateRawFile(temporary[step % 2], rows * columns, &next)) {
+        return false;
+      }
+      ll = {&next, 0, columns};
+    }
+
+    if (!AnalyzeTiles(plane, taps, options,
+                      {ll,
+                       {output, details[0].offset, columns},
+                       {output, details[1].offset, columns},
+                       {output, details[2].offset, columns}})) {
+      return false;
+    }
+
+    if (!last) {
+      next.close();
+      approximation = internal::MappedFile::Open(temporary[step % 2]);
+      if (!approximation) {
+        return false;
+      }
+      plane = {reinterpret_cast<const DataType *>(approximation->data()),
+               rows,
+               columns,
+               rows,
+               columns,
+               0,
+               0};
+    }
+  }
+  return true;
+}
+
+/**
+ * Copy one channel without steps into its subband
+ */
+static bool CopyChannel(const TilePlane &signal, const TiledSubband &subband,
+                        std::fstream *output) {
+  std::vector<DataType> row(signal.padded_columns);
+  const SubbandWriter writer{output, subband.offset, subband.columns};
+  for (size_t r = 0; r < signal.padded_rows; ++r) {
+    ReadTile(signal, r, 1, 0, signal.padded_columns, row.data());
+    if (!WriteTile(writer, r, 0, 1, signal.padded_columns, row.data())) {
+      std::cerr << "Failed to write subband" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<TiledSubband> TiledLayout(const WaveletParameters &parameters) {
+  if (parameters.dimension() != 2 ||
+      parameters.boundary_mode != BoundaryMode::kPadding) {
+    return {};
+  }
+
+  const size_t steps = parameters.wavelet_type != kNone
+                           ? parameters.decomposition_steps
+                           : 0;
+  const auto padded = internal::CalcPaddedSize(
+      parameters.wavelet_type, parameters.signal_shape, steps);
+
+  std::vector<TiledSubband> layout;
+  size_t offset = 0;
+  auto add = [&](size_t rows, size_t columns) {
+    layout.push_back({offset, rows, columns});
+    offset += rows * columns;
+  };
+  for (size_t channel = 0; channel < parameters.signal_number; ++channel) {
+    size_t rows = padded[1];
+    size_t columns = padded[0];
+    for (size_t step = 0; step < steps; ++step) {
+      rows /= 2;
+      columns /= 2;
+      for (int i = 0; i < 3; ++i) {
+        add(rows, columns);
+      }
+    }
+    add(rows, columns);
+  }
+  return layout;
+}
+
+bool DecomposeTiled(const WaveletParameters &parameters,
+                    const std::string &input, const std::string &output,
+                    const TileOptions &options) {
+  if (parameters.dimension() != 2 || parameters.signal_number == 0) {
+    std::cerr << "Tiled decomposition supports only 2D signals" << std::endl;
+    return false;
+  }
+
+  const size_t steps = parameters.wavelet_type != kNone
+                           ? parameters.decomposition_steps
+                           : 0;
+  if (static_cast<int>(steps) >
+      internal::CalculateMaxDecompositionSteps(parameters.wavelet_type,
+                                               parameters.signal_shape)) {
+    std::cerr << "Too many decomposition steps for this signal size"
+              << std::endl;
+    return false;
+  }
+  if (parameters.boundary_mode != BoundaryMode::kPadding) {
+    std::cerr << "Tiled decomposition needs the padding boundary mode"
+              << std::endl;
+    return false;
+  }
+
+  const auto source = internal::MappedFile::Open(input);
+  if (!source) {
+    return false;
+  }
+
+  const size_t columns = parameters.signal_shape[0];
+  const size_t rows = parameters.signal_shape[1];
+  if (source->size() !=
+      parameters.signal_number * rows * columns * sizeof(DataType)) {
+    std::cerr << "Wrong size of " << input << ". Expected "
+              << parameters.signal_number * rows * columns * sizeof(DataType)
+              << " bytes but got " << source->size() << std::endl;
+    return false;
+  }
+
+  const auto layout = TiledLayout(parameters);
+  std::fstream file;
+  if (!CreateRawFile(output, layout.back().offset +
+                                 layout.back().rows * layout.back().columns,
+                     &file)) {
+    return false;
+  }
+
+  const auto padded = internal::CalcPaddedSize(
+      parameters.wavelet_type, parameters.signal_shape, steps);
+  const size_t subbands = layout.size() / parameters.signal_number;
+  const std::string temporary[2] = {output + ".step0", output + ".step1"};
+
+  bool decomposed = true;
+  auto decompose = [&](const auto &taps) {
+    for (size_t channel = 0;
+         channel < parameters.signal_number && decomposed; ++channel) {
+      const TilePlane signal{
+          reinterpret_cast<const DataType *>(source->data()) +
+              channel * rows * columns,
+          rows,
+          columns,
+          padded[1],
+          padded[0],
+          (padded[1] - rows) / 2,
+          (padded[0] - columns) / 2};
+      const auto *channel_layout = layout.data() + channel * subbands;
+      if constexpr (std::is_same_v<std::decay_t<decltype(taps)>,
+                                   std::nullptr_t>) {
+        decomposed = CopyChannel(signal, *channel_layout, &file);
+      } else {
+        decomposed = DecomposeChannel(signal, taps, steps, options,
+                                      channel_layout, &file, temporary);
+      }
+    }
+  };
+
+  /* The same compile-time filters as the filter bank engine */
+  using wavelet::internal::StaticTaps;
+  switch (steps > 0 ? parameters.wavelet_type : kNone) {
+    case kNone:
+      decompose(nullptr);
+      break;
+    case kDB1:
+      decompose(StaticTaps<kDB1>{});
+      break;
+    case kDB2:
+      decompose(StaticTaps<kDB2>{});
+      break;
+    case kDB3:
+      decompose(StaticTaps<kDB3>{});
+      break;
+    case kDB4:
+      decompose(StaticTaps<kDB4>{});
+      break;
+    case kDB5:
+      decompose(StaticTaps<kDB5>{});
+      break;
+  }
+
+  for (const auto &path : temporary) {
+    std::error_code error;
+    std::filesystem::remove(path, error);
+  }
+
+  file.close();
+  if (decomposed && file.fail()) {
+    std::cerr << "Failed to write " << output << std::endl;
+    return false;
+  }
+  return decomposed;
+}
+
+}  // namespace drift
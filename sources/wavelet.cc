@@ -2,8 +2,485 @@
 
 #include "wavelet_buffer/wavelet.h"
 
+#include <algorithm>
+#include <array>
+#include <utility>
+
+#include "internal/daubechies_tables.h"
+#include "internal/dwt_kernels.h"
+#include "internal/dwt_simd.h"
+#include "internal/dwt_transforms.h"
+#include "internal/lifting_factorization.h"
+
 namespace drift::wavelet {
 
+/**
+ * View of the filter bank for the convolution kernels
+ * @param filters
+ * @return
+ */
+static internal::FilterTaps MakeTaps(const FilterBank &filters) {
+  assert(filters.low_pass.size() == filters.high_pass.size());
+  return {filters.low_pass.data(), filters.high_pass.data(),
+          filters.low_pass.size()};
+}
+
+/**
+ * Copy the raw-convolution rows of a matrix into memory of the caller for
+ * the vectorized kernels, the sparse rows have no contiguous storage
+ * @param dmat the rows are the filters
+ * @param reverse reverse the filters for the synthesis
+ * @param low memory of kMaxSimdTaps elements
+ * @param high memory of kMaxSimdTaps elements
+ * @return false if no vectorized kernels can take the filters, the scalar
+ * loops do it
+ */
+static bool RawConvolutionTaps(const Signal2DCompressed &dmat, bool reverse,
+                               DataType *low, DataType *high) {
+  if (!internal::ActiveSimdKernels() ||
+      dmat.columns() > internal::kMaxSimdTaps) {
+    return false;
+  }
+
+  const size_t length = dmat.columns();
+  for (size_t j = 0; j < length; ++j) {
+    const size_t k = reverse ? length - 1 - j : j;
+    low[k] = dmat(0, j);
+    high[k] = dmat(1, j);
+  }
+  return true;
+}
+
+/**
+ * Divide a whole image transform by subbands
+ * @param r result of dwt2s
+ * @return LL, LH, HL, HH subbands
+ */
+static std::tuple<Signal2D, Signal2D, Signal2D, Signal2D> SplitSubbands(
+    const Signal2D &r) {
+  size_t split_sz_w = r.columns() / 2;
+  size_t split_sz_h = r.rows() / 2;
+
+  Signal2D ll(split_sz_h, split_sz_w);
+  Signal2D lh(split_sz_h, split_sz_w);
+  Signal2D hl(split_sz_h, split_sz_w);
+  Signal2D hh(split_sz_h, split_sz_w);
+  ll = blaze::submatrix(r, 0, 0, split_sz_h, split_sz_w);
+  lh = blaze::submatrix(r, split_sz_h, 0, split_sz_h, split_sz_w);
+  hl = blaze::submatrix(r, 0, split_sz_w, split_sz_h, split_sz_w);
+  hh = blaze::submatrix(r, split_sz_h, split_sz_w, split_sz_h, split_sz_w);
+
+  return std::make_tuple(ll, lh, hl, hh);
+}
+
+/**
+ * Assemble subbands into one image for the inverse whole image transform
+ * @return image with LL, HL (top) and LH, HH (bottom) parts
+ */
+static Signal2D AssembleSubbands(const Signal2D &ll, const Signal2D &lh,
+                                 const Signal2D &hl, const Signal2D &hh) {
+  assert(ll.rows() == lh.rows());
+  assert(ll.rows() == hl.rows());
+  assert(ll.rows() == hh.rows());
+  assert(ll.columns() == lh.columns());
+  assert(ll.columns() == hl.columns());
+  assert(ll.columns() == hh.columns());
+
+  Signal2D out(ll.rows() * 2, ll.columns() * 2);
+  blaze::submatrix(out, 0, 0, ll.rows(), ll.columns()) = ll;
+  blaze::submatrix(out, ll.rows(), 0, lh.rows(), lh.columns()) = lh;
+  blaze::submatrix(out, 0, ll.columns(), hl.rows(), hl.columns()) = hl;
+  blaze::submatrix(out, ll.rows(), ll.columns(), hh.rows(), hh.columns()) = hh;
+
+  return out;
+}
+
+/**
+ * Lifting steps and scales of one line or several adjacent lines, the
+ * phases are updated wherever they lie
+ * @param low phase of `half` elements
+ * @param high phase of `half` elements
+ * @param half
+ * @param scheme
+ * @param shift index of the high phase relative to the low one, 0 if they
+ * are split with the shifts of the scheme
+ * @param width number of adjacent lines
+ */
+static void LiftPhases(internal::StridedLine<DataType> low,
+                       internal::StridedLine<DataType> high, size_t half,
+                       const LiftingScheme &scheme, int shift,
+                       size_t width = 1) {
+  for (const auto &step : scheme.steps) {
+    const auto &c = step.coefficients;
+    if (step.update_low) {
+      internal::LiftStep(high, half, step.offset + shift, c.data(), c.size(),
+                         1, low, width);
+    } else {
+      internal::LiftStep(low, half, step.offset - shift, c.data(), c.size(),
+                         1, high, width);
+    }
+  }
+  internal::ScaleLine(low, half, scheme.low_scale, width);
+  internal::ScaleLine(high, half, scheme.high_scale, width);
+}
+
+/**
+ * Inverse of LiftPhases
+ */
+static void UnliftPhases(internal::StridedLine<DataType> low,
+                         internal::StridedLine<DataType> high, size_t half,
+                         const LiftingScheme &scheme, int shift,
+                         size_t width = 1) {
+  internal::ScaleLine(low, half, 1 / scheme.low_scale, width);
+  internal::ScaleLine(high, half, 1 / scheme.high_scale, width);
+  for (auto it = scheme.steps.rbegin(); it != scheme.steps.rend(); ++it) {
+    const auto &c = it->coefficients;
+    if (it->update_low) {
+      internal::LiftStep(high, half, it->offset + shift, c.data(), c.size(),
+                         -1, low, width);
+    } else {
+      internal::LiftStep(low, half, it->offset - shift, c.data(), c.size(),
+                         -1, high, width);
+    }
+  }
+}
+
+/**
+ * Phase of a line with the samples of a parity, in place
+ */
+static internal::StridedLine<DataType> PhaseOf(
+    internal::StridedLine<DataType> line, size_t parity) {
+  return {&line[parity], 2 * line.stride};
+}
+
+/**
+ * Row pass of the filter bank transform
+ * @param x image with even number of columns
+ * @param taps FilterTaps or StaticTaps
+ * @param pool threads to split the rows of a big image
+ * @return rows with the low (left) and high (right) halves
+ */
+template <typename Taps>
+static Signal2D AnalyzeRows(const Signal2D &x, const Taps &taps,
+                            ThreadPool *pool) {
+  const size_t split_sz_w = x.columns() / 2;
+  Signal2D out(x.rows(), x.columns());
+  internal::ForEachBlock(
+      pool, x.rows() * x.columns(), x.rows(), 1, nullptr,
+      [&](size_t begin, size_t end, Workspace *) {
+        for (size_t row_idx = begin; row_idx < end; ++row_idx) {
+          internal::AnalyzeLine({x.data(row_idx), 1}, x.columns(), taps,
+                                {out.data(row_idx), 1},
+                                {out.data(row_idx) + split_sz_w, 1});
+        }
+      });
+  return out;
+}
+
+namespace internal {
+
+template <typename Taps>
+void AnalyzeImage(MatrixView<const DataType> x, const Taps &taps,
+                  MatrixView<DataType> scratch, MatrixView<DataType> ll,
+                  MatrixView<DataType> lh, MatrixView<DataType> hl,
+                  MatrixView<DataType> hh, ThreadPool *pool) {
+  AnalyzePaddedImage(x, EvenPadding(x.rows), EvenPadding(x.columns), taps,
+                     scratch, ll, lh, hl, hh, pool);
+}
+
+template <typename Taps>
+void AnalyzePaddedImage(MatrixView<const DataType> x,
+                        const LinePadding &row_padding,
+                        const LinePadding &column_padding, const Taps &taps,
+                        MatrixView<DataType> scratch, MatrixView<DataType> ll,
+                        MatrixView<DataType> lh, MatrixView<DataType> hl,
+                        MatrixView<DataType> hh, ThreadPool *pool) {
+  const size_t split_sz_w = column_padding.padded / 2;
+  const size_t pixels = row_padding.padded * column_padding.padded;
+
+  /* The padding rows would be analyzed the same as the edge rows or to
+   * zeros, the column pass reads them from the rows of the image */
+  ForEachBlock(pool, pixels, x.rows, 1, nullptr,
+               [&](size_t begin, size_t end, Workspace *) {
+                 for (size_t row_idx = begin; row_idx < end;
+                      ++row_idx) {  // split by rows
+                   AnalyzePaddedLine({x.row(row_idx), 1}, column_padding,
+                                     taps, {scratch.row(row_idx), 1},
+                                     {scratch.row(row_idx) + split_sz_w, 1});
+                 }
+               });
+
+  /* Split the columns of the low and high halves straight into subbands,
+   * the blocks are tiles of columns */
+  ForEachBlock(
+      pool, pixels, split_sz_w, kColumnTile, nullptr,
+      [&](size_t begin, size_t end, Workspace *) {
+        AnalyzePaddedColumns({scratch.data + begin, scratch.spacing},
+                             row_padding, end - begin, taps,
+                             {ll.data + begin, ll.spacing},
+                             {lh.data + begin, lh.spacing});
+        AnalyzePaddedColumns(
+            {scratch.data + split_sz_w + begin, scratch.spacing},
+            row_padding, end - begin, taps, {hl.data + begin, hl.spacing},
+            {hh.data + begin, hh.spacing});
+      });
+}
+
+template <typename Taps>
+void SynthesizeImage(MatrixView<const DataType> ll,
+                     MatrixView<const DataType> lh,
+                     MatrixView<const DataType> hl,
+                     MatrixView<const DataType> hh, const Taps &taps,
+                     MatrixView<DataType> scratch, MatrixView<DataType> out,
+                     ThreadPool *pool) {
+  SynthesizeCroppedImage(ll, lh, hl, hh, EvenPadding(out.rows),
+                         EvenPadding(out.columns), taps, scratch, out,
+                         nullptr, pool);
+}
+
+template <typename Taps>
+void SynthesizeCroppedImage(MatrixView<const DataType> ll,
+                            MatrixView<const DataType> lh,
+                            MatrixView<const DataType> hl,
+                            MatrixView<const DataType> hh,
+                            const LinePadding &row_padding,
+                            const LinePadding &column_padding,
+                            const Taps &taps, MatrixView<DataType> scratch,
+                            MatrixView<DataType> out, Workspace *workspace,
+                            ThreadPool *pool) {
+  const size_t split_sz_w = ll.columns;
+  const size_t rows = out.rows;
+  const size_t columns = column_padding.padded;
+  const size_t pixels = rows * columns;
+
+  /* Merge columns reading the subbands in place, the transform is separable
+   * so the order of the passes doesn't matter. Only the rows of the output
+   * are merged */
+  ForEachBlock(
+      pool, pixels, split_sz_w, kColumnTile, nullptr,
+      [&](size_t begin, size_t end, Workspace *) {
+        SynthesizeCroppedColumns({ll.data + begin, ll.spacing},
+                                 {lh.data + begin, lh.spacing}, row_padding,
+                                 end - begin, taps,
+                                 {scratch.data + begin, scratch.spacing});
+        SynthesizeCroppedColumns(
+            {hl.data + begin, hl.spacing}, {hh.data + begin, hh.spacing},
+            row_padding, end - begin, taps,
+            {scratch.data + split_sz_w + begin, scratch.spacing});
+      });
+
+  /* A row of the padded width is merged into a line and cropped, so the
+   * vectorized kernels merge the same pairs as for the whole row */
+  const bool cropped = column_padding.offset > 0 ||
+                       column_padding.size + 1 < column_padding.padded;
+  ForEachBlock(pool, pixels, rows, 1, workspace,
+               [&](size_t begin, size_t end, Workspace *scratch_memory) {
+                 DataType *line =
+                     cropped ? scratch_memory->Allocate<DataType>(columns)
+                             : nullptr;
+                 for (size_t row_idx = begin; row_idx < end;
+                      ++row_idx) {  // merge rows
+                   if (!cropped) {
+                     SynthesizeLine({scratch.row(row_idx), 1},
+                                    {scratch.row(row_idx) + split_sz_w, 1},
+                                    column_padding.size, taps,
+                                    {out.row(row_idx), 1});
+                     continue;
+                   }
+                   SynthesizeLine({scratch.row(row_idx), 1},
+                                  {scratch.row(row_idx) + split_sz_w, 1},
+                                  columns, taps, {line, 1});
+                   std::copy_n(line + column_padding.offset,
+                               column_padding.size, out.row(row_idx));
+                 }
+               });
+}
+
+template <typename Taps>
+void Dwt2(const Signal2D &x, const Taps &taps, Signal2D *ll, Signal2D *lh,
+          Signal2D *hl, Signal2D *hh, ThreadPool *pool) {
+  for (auto *subband : {ll, lh, hl, hh}) {
+    subband->resize(x.rows() / 2, x.columns() / 2, false);
+  }
+
+  Signal2D intermediate(x.rows(), x.columns());
+  AnalyzeImage(ViewOf(x), taps, ViewOf(intermediate), ViewOf(*ll),
+               ViewOf(*lh), ViewOf(*hl), ViewOf(*hh), pool);
+}
+
+template <typename Taps>
+Signal2D Idwt2(const Signal2D &ll, const Signal2D &lh, const Signal2D &hl,
+               const Signal2D &hh, const Taps &taps, ThreadPool *pool) {
+  assert(ll.rows() == lh.rows() && ll.rows() == hl.rows() &&
+         ll.rows() == hh.rows());
+  assert(ll.columns() == lh.columns() && ll.columns() == hl.columns() &&
+         ll.columns() == hh.columns());
+
+  Signal2D intermediate(ll.rows() * 2, ll.columns() * 2);
+  Signal2D out(ll.rows() * 2, ll.columns() * 2);
+  SynthesizeImage(ViewOf(ll), ViewOf(lh), ViewOf(hl), ViewOf(hh), taps,
+                  ViewOf(intermediate), ViewOf(out), pool);
+
+  return out;
+}
+
+template <typename Taps>
+void Dwt(const Signal1D &signal, const Taps &taps, Signal1D *low,
+         Signal1D *high) {
+  assert(signal.size() % 2 == 0);
+
+  low->resize(signal.size() / 2, false);
+  high->resize(signal.size() / 2, false);
+  AnalyzeLine({signal.data(), 1}, signal.size(), taps, {low->data(), 1},
+              {high->data(), 1});
+}
+
+template <typename Taps>
+Signal1D Idwt(const Signal1D &low, const Signal1D &high, const Taps &taps) {
+  assert(low.size() == high.size());
+
+  Signal1D decoded(low.size() * 2);
+  SynthesizeLine({low.data(), 1}, {high.data(), 1}, decoded.size(), taps,
+                 {decoded.data(), 1});
+  return decoded;
+}
+
+void LiftLine(StridedLine<DataType> line, size_t size,
+              const LiftingScheme &scheme, StridedLine<DataType> scratch,
+              size_t width) {
+  LiftPhases(PhaseOf(line, scheme.low_parity),
+             PhaseOf(line, 1 - scheme.low_parity), size / 2, scheme,
+             scheme.high_shift - scheme.low_shift, width);
+  DeinterleaveLine(line, size, scheme.low_parity, scheme.low_shift,
+                   scheme.high_shift, scratch, width);
+}
+
+void UnliftLine(StridedLine<DataType> line, size_t size,
+                const LiftingScheme &scheme, StridedLine<DataType> scratch,
+                size_t width) {
+  InterleaveLine(line, size, scheme.low_parity, scheme.low_shift,
+                 scheme.high_shift, scratch, width);
+  UnliftPhases(PhaseOf(line, scheme.low_parity),
+               PhaseOf(line, 1 - scheme.low_parity), size / 2, scheme,
+               scheme.high_shift - scheme.low_shift, width);
+}
+
+void LiftImage(MatrixView<const DataType> x, const LiftingScheme &scheme,
+               MatrixView<DataType> out, Workspace *workspace,
+               ThreadPool *pool) {
+  assert(x.rows % 2 == 0);
+  assert(x.columns % 2 == 0);
+
+  const size_t split_sz_w = x.columns / 2;
+  const size_t split_sz_h = x.rows / 2;
+  const size_t pixels = x.rows * x.columns;
+
+  ForEachBlock(
+      pool, pixels, x.rows, 1, workspace,
+      [&](size_t begin, size_t end, Workspace *scratch_memory) {
+        auto *scratch = scratch_memory->Allocate<DataType>(split_sz_w);
+        for (size_t row_idx = begin; row_idx < end;
+             ++row_idx) {  // split by rows
+          const StridedLine<DataType> row{out.row(row_idx), 1};
+          if (x.data == out.data) {
+            LiftLine(row, x.columns, scheme, {scratch, 1});
+            continue;
+          }
+
+          /* The phases are split out of the input with the shifts */
+          const StridedLine<DataType> high{out.row(row_idx) + split_sz_w, 1};
+          SplitLine({x.row(row_idx), 1}, x.columns, scheme.low_parity,
+                    scheme.low_shift, scheme.high_shift, row, high);
+          LiftPhases(row, high, split_sz_w, scheme, 0);
+        }
+      });
+
+  ForEachBlock(
+      pool, pixels, x.columns, kColumnTile, workspace,
+      [&](size_t begin, size_t end, Workspace *scratch_memory) {
+        auto *scratch =
+            scratch_memory->Allocate<DataType>(split_sz_h * kColumnTile);
+        for (size_t col_idx = begin; col_idx < end;
+             col_idx += kColumnTile) {  // split by columns in tiles
+          LiftLine({out.data + col_idx, out.spacing}, x.rows, scheme,
+                   {scratch, kColumnTile},
+                   std::min(kColumnTile, end - col_idx));
+        }
+      });
+}
+
+void UnliftImage(MatrixView<DataType> x, const LiftingScheme &scheme,
+                 Workspace *workspace, ThreadPool *pool) {
+  assert(x.rows % 2 == 0);
+  assert(x.columns % 2 == 0);
+
+  const size_t split_sz_w = x.columns / 2;
+  const size_t split_sz_h = x.rows / 2;
+  const size_t pixels = x.rows * x.columns;
+
+  ForEachBlock(
+      pool, pixels, x.rows, 1, workspace,
+      [&](size_t begin, size_t end, Workspace *scratch_memory) {
+        auto *scratch = scratch_memory->Allocate<DataType>(split_sz_w);
+        for (size_t row_idx = begin; row_idx < end;
+             ++row_idx) {  // merge rows
+          UnliftLine({x.row(row_idx), 1}, x.columns, scheme, {scratch, 1});
+        }
+      });
+
+  ForEachBlock(
+      pool, pixels, x.columns, kColumnTile, workspace,
+      [&](size_t begin, size_t end, Workspace *scratch_memory) {
+        auto *scratch =
+            scratch_memory->Allocate<DataType>(split_sz_h * kColumnTile);
+        for (size_t col_idx = begin; col_idx < end;
+             col_idx += kColumnTile) {  // merge columns in tiles
+          UnliftLine({x.data + col_idx, x.spacing}, x.rows, scheme,
+                     {scratch, kColumnTile},
+                     std::min(kColumnTile, end - col_idx));
+        }
+      });
+}
+
+#define INSTANTIATE_DWT_TRANSFORMS(Taps)                                      \
+  template void AnalyzeImage(MatrixView<const DataType>, const Taps &,       \
+                             MatrixView<DataType>, MatrixView<DataType>,     \
+                             MatrixView<DataType>, MatrixView<DataType>,     \
+                             MatrixView<DataType>, ThreadPool *);            \
+  template void AnalyzePaddedImage(                                          \
+      MatrixView<const DataType>, const LinePadding &, const LinePadding &,  \
+      const Taps &, MatrixView<DataType>, MatrixView<DataType>,              \
+      MatrixView<DataType>, MatrixView<DataType>, MatrixView<DataType>,      \
+      ThreadPool *);                                                         \
+  template void SynthesizeImage(                                             \
+      MatrixView<const DataType>, MatrixView<const DataType>,                \
+      MatrixView<const DataType>, MatrixView<const DataType>, const Taps &,  \
+      MatrixView<DataType>, MatrixView<DataType>, ThreadPool *);             \
+  template void SynthesizeCroppedImage(                                      \
+      MatrixView<const DataType>, MatrixView<const DataType>,                \
+      MatrixView<const DataType>, MatrixView<const DataType>,                \
+      const LinePadding &, const LinePadding &, const Taps &,                \
+      MatrixView<DataType>, MatrixView<DataType>, Workspace *,               \
+      ThreadPool *);                                                         \
+  template void Dwt2(const Signal2D &, const Taps &, Signal2D *, Signal2D *, \
+                     Signal2D *, Signal2D *, ThreadPool *);                  \
+  template Signal2D Idwt2(const Signal2D &, const Signal2D &,                \
+                          const Signal2D &, const Signal2D &, const Taps &,  \
+                          ThreadPool *);                                     \
+  template void Dwt(const Signal1D &, const Taps &, Signal1D *, Signal1D *); \
+  template Signal1D Idwt(const Signal1D &, const Signal1D &, const Taps &);
+
+INSTANTIATE_DWT_TRANSFORMS(FilterTaps)
+INSTANTIATE_DWT_TRANSFORMS(StaticTaps<kDB1>)
+INSTANTIATE_DWT_TRANSFORMS(StaticTaps<kDB2>)
+INSTANTIATE_DWT_TRANSFORMS(StaticTaps<kDB3>)
+INSTANTIATE_DWT_TRANSFORMS(StaticTaps<kDB4>)
+INSTANTIATE_DWT_TRANSFORMS(StaticTaps<kDB5>)
+
+#undef INSTANTIATE_DWT_TRANSFORMS
+
+}  // namespace internal
+
 blaze::CompressedMatrix<DataType> DaubechiesMat(size_t size, int order,
                                                 Padding padding) {
   assert(order % 2 == 0);
@@ -138,21 +615,52 @@ std::tuple<Signal2D, Signal2D, Signal2D, Signal2D> dwt2(
     const Signal2D &x, const Signal2DCompressed &dmat_w,
     const Signal2DCompressed &dmat_h) {  // wrapper for dividing by subbands
 
-  Signal2D r = dwt2s(x, dmat_w, dmat_h);
+  return SplitSubbands(dwt2s(x, dmat_w, dmat_h));
+}
+
+std::tuple<Signal2D, Signal2D, Signal2D, Signal2D> dwt2(
+    const Signal2D &x, const FilterBank &filters) {
+  Signal2D ll;
+  Signal2D lh;
+  Signal2D hl;
+  Signal2D hh;
+  dwt2(x, filters, &ll, &lh, &hl, &hh);
+  return {std::move(ll), std::move(lh), std::move(hl), std::move(hh)};
+}
 
-  size_t split_sz_w = dmat_w.columns() / 2;
-  size_t split_sz_h = dmat_h.columns() / 2;
+void dwt2(const Signal2D &x, const FilterBank &filters, Signal2D *ll,
+          Signal2D *lh, Signal2D *hl, Signal2D *hh, ThreadPool *pool) {
+  internal::Dwt2(x, MakeTaps(filters), ll, lh, hl, hh, pool);
+}
 
-  Signal2D ll(split_sz_h, split_sz_w);
-  Signal2D lh(split_sz_h, split_sz_w);
-  Signal2D hl(split_sz_h, split_sz_w);
-  Signal2D hh(split_sz_h, split_sz_w);
-  ll = blaze::submatrix(r, 0, 0, split_sz_h, split_sz_w);
-  lh = blaze::submatrix(r, split_sz_h, 0, split_sz_h, split_sz_w);
-  hl = blaze::submatrix(r, 0, split_sz_w, split_sz_h, split_sz_w);
-  hh = blaze::submatrix(r, split_sz_h, split_sz_w, split_sz_h, split_sz_w);
+std::tuple<Signal2D, Signal2D, Signal2D, Signal2D> dwt2(
+    const Signal2D &x, const LiftingScheme &scheme) {
+  /* The rows are split into the image of the subbands, LL stays in it */
+  Signal2D ll(x.rows(), x.columns());
+  Workspace workspace;
+  internal::LiftImage(internal::ViewOf(x), scheme, internal::ViewOf(ll),
+                      &workspace);
 
-  return std::make_tuple(ll, lh, hl, hh);
+  const size_t split_sz_w = x.columns() / 2;
+  const size_t split_sz_h = x.rows() / 2;
+  Signal2D lh = blaze::submatrix(ll, split_sz_h, 0, split_sz_h, split_sz_w);
+  Signal2D hl = blaze::submatrix(ll, 0, split_sz_w, split_sz_h, split_sz_w);
+  Signal2D hh =
+      blaze::submatrix(ll, split_sz_h, split_sz_w, split_sz_h, split_sz_w);
+  ll.resize(split_sz_h, split_sz_w, true);
+  return {std::move(ll), std::move(lh), std::move(hl), std::move(hh)};
+}
+
+/**
+ * Copy a table of coefficients to a signal
+ */
+template <size_t N>
+static Signal1D ToSignal(const std::array<double, N> &table) {
+  Signal1D out(N);
+  for (size_t i = 0; i < N; ++i) {
+    out[i] = static_cast<DataType>(table[i]);
+  }
+  return out;
 }
 
 Signal1D dbwavf(const int wnum) {
@@ -161,56 +669,25 @@ Signal1D dbwavf(const int wnum) {
 
   switch (wnum) {
     case 1:
-      return {0.50000000000000, 0.50000000000000};
+      return ToSignal(internal::kDaubechiesScaling<1>);
     case 2:
-      return {0.34150635094622, 0.59150635094587, 0.15849364905378,
-              -0.09150635094587};
+      return ToSignal(internal::kDaubechiesScaling<2>);
     case 3:
-      return {0.23523360389270,  0.57055845791731,  0.32518250026371,
-              -0.09546720778426, -0.06041610415535, 0.02490874986589};
+      return ToSignal(internal::kDaubechiesScaling<3>);
     case 4:
-      return {0.16290171402562,  0.50547285754565,  0.44610006912319,
-              -0.01978751311791, -0.13225358368437, 0.02180815023739,
-              0.02325180053556,  -0.00749349466513};
+      return ToSignal(internal::kDaubechiesScaling<4>);
     case 5:
-      return {0.11320949129173, 0.42697177135271,  0.51216347213016,
-              0.09788348067375, -0.17132835769133, -0.02280056594205,
-              0.05485132932108, -0.00441340005433, -0.00889593505093,
-              0.00235871396920};
+      return ToSignal(internal::kDaubechiesScaling<5>);
     case 6:
-      return {
-          0.07887121600145072,   0.3497519070376178,   0.5311318799408691,
-          0.22291566146501776,   -0.15999329944606142, -0.09175903203014758,
-          0.0689440464873723,    0.019461604854164663, -0.022331874165094537,
-          0.0003916255761485779, 0.003378031181463938, -0.0007617669028012533};
+      return ToSignal(internal::kDaubechiesScaling<6>);
     case 7:
-      return {0.05504971537285,  0.28039564181304,  0.51557424581833,
-              0.33218624110566,  -0.10175691123173, -0.15841750564054,
-              0.05042323250485,  0.05700172257986,  -0.02689122629486,
-              -0.01171997078235, 0.00887489618962,  0.00030375749776,
-              -0.00127395235906, 0.00025011342658};
+      return ToSignal(internal::kDaubechiesScaling<7>);
     case 8:
-      return {0.03847781105406,  0.22123362357624,  0.47774307521438,
-              0.41390826621166,  -0.01119286766665, -0.20082931639111,
-              0.00033409704628,  0.09103817842345,  -0.01228195052300,
-              -0.03117510332533, 0.00988607964808,  0.00618442240954,
-              -0.00344385962813, -0.00027700227421, 0.00047761485533,
-              -0.00008306863060};
+      return ToSignal(internal::kDaubechiesScaling<8>);
     case 9:
-      return {0.02692517479416,  0.17241715192471,  0.42767453217028,
-              0.46477285717278,  0.09418477475112,  -0.20737588089628,
-              -0.06847677451090, 0.10503417113714,  0.02172633772990,
-              -0.04782363205882, 0.00017744640673,  0.01581208292614,
-              -0.00333981011324, -0.00302748028715, 0.00130648364018,
-              0.00016290733601,  -0.00017816487955, 0.00002782275679};
+      return ToSignal(internal::kDaubechiesScaling<9>);
     case 10:
-      return {0.01885857879640,  0.13306109139687,  0.37278753574266,
-              0.48681405536610,  0.19881887088440,  -0.17666810089647,
-              -0.13855493935993, 0.09006372426666,  0.06580149355070,
-              -0.05048328559801, -0.02082962404385, 0.02348490704841,
-              0.00255021848393,  -0.00758950116768, 0.00098666268244,
-              0.00140884329496,  -0.00048497391996, -0.00008235450295,
-              0.00006617718320,  -0.00000937920789};
+      return ToSignal(internal::kDaubechiesScaling<10>);
     default:
       return {};
   }
@@ -268,6 +745,35 @@ std::tuple<Signal1D, Signal1D, Signal1D, Signal1D> Orthfilt(
 
   return {Lo_D, Hi_D, Lo_R, Hi_R};
 }
+
+FilterBank DaubechiesFilters(int order) {
+  assert(order % 2 == 0);
+
+  auto [Lo_D, Hi_D, Lo_R, Hi_R] = Orthfilt(dbwavf(order / 2));
+
+  /* Reverse filters for convolution */
+  std::reverse(Lo_D.begin(), Lo_D.end());
+  std::reverse(Hi_D.begin(), Hi_D.end());
+
+  return {Lo_D, Hi_D};
+}
+
+LiftingScheme DaubechiesLifting(int order) {
+  assert(order % 2 == 0);
+
+  static const std::array<LiftingScheme, 5> kSchemes = {
+      internal::FactorizeScalingFilter(internal::kDaubechiesScaling<1>),
+      internal::FactorizeScalingFilter(internal::kDaubechiesScaling<2>),
+      internal::FactorizeScalingFilter(internal::kDaubechiesScaling<3>),
+      internal::FactorizeScalingFilter(internal::kDaubechiesScaling<4>),
+      internal::FactorizeScalingFilter(internal::kDaubechiesScaling<5>)};
+  if (order < 2 || order / 2 > static_cast<int>(kSchemes.size())) {
+    assert(false && "lifting scheme is available for DB1-DB5 only");
+    return {};
+  }
+  return kSchemes[order / 2 - 1];
+}
+
 Signal2D dwt2s(const Signal2D &x, const Signal2DCompressed &dmat_w,
                const Signal2DCompressed
                    &dmat_h) {  // whole image transform, no dividing by subbands
@@ -297,25 +803,99 @@ Signal2D dwt2s(const Signal2D &x, const Signal2DCompressed &dmat_w,
   return out;
 }
 
+Signal2D dwt2s(const Signal2D &x, const FilterBank &filters,
+               ThreadPool *pool) {
+  assert(x.rows() % 2 == 0);
+  assert(x.columns() % 2 == 0);
+
+  const auto taps = MakeTaps(filters);
+  const size_t split_sz_h = x.rows() / 2;
+
+  const Signal2D intermediate = AnalyzeRows(x, taps, pool);  // split by rows
+  Signal2D out(x.rows(), x.columns());
+
+  /* Split by columns in tiles, the stride is a row of the matrix */
+  internal::ForEachBlock(
+      pool, x.rows() * x.columns(), x.columns(), internal::kColumnTile,
+      nullptr, [&](size_t begin, size_t end, Workspace *) {
+        internal::AnalyzeColumns(
+            {intermediate.data() + begin, intermediate.spacing()}, x.rows(),
+            end - begin, taps, {out.data() + begin, out.spacing()},
+            {out.data(split_sz_h) + begin, out.spacing()});
+      });
+
+  return out;
+}
+
+Signal2D idwt2s(const Signal2D &x, const FilterBank &filters,
+                ThreadPool *pool) {
+  assert(x.rows() % 2 == 0);
+  assert(x.columns() % 2 == 0);
+
+  const auto taps = MakeTaps(filters);
+  const size_t split_sz_w = x.columns() / 2;
+  const size_t split_sz_h = x.rows() / 2;
+  const size_t pixels = x.rows() * x.columns();
+
+  Signal2D intermediate(x.rows(), x.columns());
+  Signal2D out(x.rows(), x.columns());
+
+  internal::ForEachBlock(
+      pool, pixels, x.rows(), 1, nullptr,
+      [&](size_t begin, size_t end, Workspace *) {
+        for (size_t row_idx = begin; row_idx < end; ++row_idx) {  // merge rows
+          internal::SynthesizeLine({x.data(row_idx), 1},
+                                   {x.data(row_idx) + split_sz_w, 1},
+                                   x.columns(), taps,
+                                   {intermediate.data(row_idx), 1});
+        }
+      });
+
+  /* Merge columns in tiles */
+  internal::ForEachBlock(
+      pool, pixels, x.columns(), internal::kColumnTile, nullptr,
+      [&](size_t begin, size_t end, Workspace *) {
+        internal::SynthesizeColumns(
+            {intermediate.data() + begin, intermediate.spacing()},
+            {intermediate.data(split_sz_h) + begin, intermediate.spacing()},
+            x.rows(), end - begin, taps, {out.data() + begin, out.spacing()});
+      });
+
+  return out;
+}
+
+void dwt2s(Signal2D *x, const LiftingScheme &scheme, ThreadPool *pool) {
+  Workspace workspace;
+  const auto view = internal::ViewOf(*x);
+  internal::LiftImage(view, scheme, view, &workspace, pool);
+}
+
+void idwt2s(Signal2D *x, const LiftingScheme &scheme, ThreadPool *pool) {
+  Workspace workspace;
+  internal::UnliftImage(internal::ViewOf(*x), scheme, &workspace, pool);
+}
+
 Signal2D idwt2(const Signal2D &ll, const Signal2D &lh, const Signal2D &hl,
                const Signal2D &hh, const Signal2DCompressed &dmat_w,
                const Signal2DCompressed &dmat_h) {
-  assert(ll.rows() == lh.rows());
-  assert(ll.rows() == hl.rows());
-  assert(ll.rows() == hh.rows());
-  assert(ll.columns() == lh.columns());
-  assert(ll.columns() == hl.columns());
-  assert(ll.columns() == hh.columns());
   assert(dmat_w.rows() == ll.columns() * 2);
   assert(dmat_h.rows() == ll.rows() * 2);
 
-  Signal2D out(dmat_h.rows(), dmat_w.rows());
-  blaze::submatrix(out, 0, 0, ll.rows(), ll.columns()) = ll;
-  blaze::submatrix(out, ll.rows(), 0, lh.rows(), lh.columns()) = lh;
-  blaze::submatrix(out, 0, ll.columns(), hl.rows(), hl.columns()) = hl;
-  blaze::submatrix(out, ll.rows(), ll.columns(), hh.rows(), hh.columns()) = hh;
+  return dwt2s(AssembleSubbands(ll, lh, hl, hh), dmat_w, dmat_h);
+}
 
-  return dwt2s(out, dmat_w, dmat_h);
+Signal2D idwt2(const Signal2D &ll, const Signal2D &lh, const Signal2D &hl,
+               const Signal2D &hh, const FilterBank &filters,
+               ThreadPool *pool) {
+  return internal::Idwt2(ll, lh, hl, hh, MakeTaps(filters), pool);
+}
+
+Signal2D idwt2(const Signal2D &ll, const Signal2D &lh, const Signal2D &hl,
+               const Signal2D &hh, const LiftingScheme &scheme,
+               ThreadPool *pool) {
+  auto out = AssembleSubbands(ll, lh, hl, hh);
+  idwt2s(&out, scheme, pool);
+  return out;
 }
 
 std::tuple<blaze::DynamicVector<DataType>, blaze::DynamicVector<DataType>> dwt(
@@ -326,8 +906,17 @@ std::tuple<blaze::DynamicVector<DataType>, blaze::DynamicVector<DataType>> dwt(
   blaze::DynamicVector<DataType> low_subband(signal.size() / 2);
   blaze::DynamicVector<DataType> high_subband(signal.size() / 2);
 
-  /* Raw convolution */
-  if (dmat.rows() == 2) {
+  /* Raw convolution, the rows are the filters in convolution order */
+  std::array<DataType, internal::kMaxSimdTaps> low_taps;
+  std::array<DataType, internal::kMaxSimdTaps> high_taps;
+  if (dmat.rows() == 2 &&
+      RawConvolutionTaps(dmat, false, low_taps.data(), high_taps.data())) {
+    const internal::FilterTaps taps{low_taps.data(), high_taps.data(),
+                                    dmat.columns()};
+    internal::AnalyzeLine({signal.data(), 1}, signal.size(), taps,
+                          {low_subband.data(), 1}, {high_subband.data(), 1});
+
+  } else if (dmat.rows() == 2) {
     low_subband = 0;
     high_subband = 0;
     for (size_t i = 0; i < signal.size() / 2; ++i) {
@@ -356,6 +945,43 @@ std::tuple<blaze::DynamicVector<DataType>, blaze::DynamicVector<DataType>> dwt(
   return {low_subband, high_subband};
 }
 
+std::tuple<blaze::DynamicVector<DataType>, blaze::DynamicVector<DataType>> dwt(
+    const blaze::DynamicVector<DataType> &signal, const FilterBank &filters) {
+  assert(signal.size() % 2 == 0);
+
+  blaze::DynamicVector<DataType> low_subband;
+  blaze::DynamicVector<DataType> high_subband;
+  internal::Dwt(signal, MakeTaps(filters), &low_subband, &high_subband);
+
+  return {low_subband, high_subband};
+}
+
+std::tuple<blaze::DynamicVector<DataType>, blaze::DynamicVector<DataType>> dwt(
+    const blaze::DynamicVector<DataType> &signal, const LiftingScheme &scheme) {
+  assert(signal.size() % 2 == 0);
+
+  const size_t half = signal.size() / 2;
+  blaze::DynamicVector<DataType> low_subband(half);
+  blaze::DynamicVector<DataType> high_subband(half);
+
+  /* The phases are split out of the signal with the shifts */
+  internal::SplitLine({signal.data(), 1}, signal.size(), scheme.low_parity,
+                      scheme.low_shift, scheme.high_shift,
+                      {low_subband.data(), 1}, {high_subband.data(), 1});
+  LiftPhases({low_subband.data(), 1}, {high_subband.data(), 1}, half, scheme,
+             0);
+
+  return {low_subband, high_subband};
+}
+
+void dwt(blaze::DynamicVector<DataType> *signal, const LiftingScheme &scheme) {
+  assert(signal->size() % 2 == 0);
+
+  Workspace workspace;
+  internal::LiftLine({signal->data(), 1}, signal->size(), scheme,
+                     {workspace.Allocate<DataType>(signal->size() / 2), 1});
+}
+
 blaze::DynamicVector<DataType> idwt(
     const blaze::DynamicVector<DataType> &low_subband,
     const blaze::DynamicVector<DataType> &high_subband,
@@ -364,8 +990,17 @@ blaze::DynamicVector<DataType> idwt(
 
   blaze::DynamicVector<DataType> decoded(low_subband.size() * 2);
   decoded = 0;
-  /* Raw convolution */
-  if (dmat.rows() == 2) {
+  /* Raw convolution, the rows are Lo_D and Hi_D, reversed they are the
+   * filters in convolution order */
+  std::array<DataType, internal::kMaxSimdTaps> low_taps;
+  std::array<DataType, internal::kMaxSimdTaps> high_taps;
+  if (dmat.rows() == 2 &&
+      RawConvolutionTaps(dmat, true, low_taps.data(), high_taps.data())) {
+    const internal::FilterTaps taps{low_taps.data(), high_taps.data(),
+                                    dmat.columns()};
+    internal::SynthesizeLine({low_subband.data(), 1}, {high_subband.data(), 1},
+                             decoded.size(), taps, {decoded.data(), 1});
+  } else if (dmat.rows() == 2) {
     size_t padding_size = dmat.columns() - 2;
     /* Start near end of signal for periodic padding */
     size_t i0 = low_subband.size() - padding_size / 2;
@@ -397,4 +1032,36 @@ blaze::DynamicVector<DataType> idwt(
 
   return decoded;
 }
+
+blaze::DynamicVector<DataType> idwt(
+    const blaze::DynamicVector<DataType> &low_subband,
+    const blaze::DynamicVector<DataType> &high_subband,
+    const FilterBank &filters) {
+  assert(low_subband.size() == high_subband.size());
+
+  return internal::Idwt(low_subband, high_subband, MakeTaps(filters));
+}
+
+blaze::DynamicVector<DataType> idwt(
+    const blaze::DynamicVector<DataType> &low_subband,
+    const blaze::DynamicVector<DataType> &high_subband,
+    const LiftingScheme &scheme) {
+  assert(low_subband.size() == high_subband.size());
+
+  blaze::DynamicVector<DataType> encoded(low_subband.size() * 2);
+  blaze::subvector(encoded, 0, low_subband.size()) = low_subband;
+  blaze::subvector(encoded, low_subband.size(), high_subband.size()) =
+      high_subband;
+  idwt(&encoded, scheme);
+
+  return encoded;
+}
+
+void idwt(blaze::DynamicVector<DataType> *signal, const LiftingScheme &scheme) {
+  assert(signal->size() % 2 == 0);
+
+  Workspace workspace;
+  internal::UnliftLine({signal->data(), 1}, signal->size(), scheme,
+                       {workspace.Allocate<DataType>(signal->size() / 2), 1});
+}
 }  // namespace drift::wavelet
@@ -0,0 +1,103 @@
+// Copyright 2023 PANDA GmbH
+
+#include "wavelet_buffer/wavelet_batch.h"
+
+#include <exception>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+#include "wavelet_buffer/wavelet_plan.h"
+
+namespace drift {
+
+/**
+ * Run a function for every item of a batch, the workspace of the thread is
+ * reset after each item
+ * @param count the number of the items
+ * @param pool threads, nullptr to run in the calling thread
+ * @param func function of the item and the workspace returning false on
+ * error
+ * @return the status of each item
+ */
+template <typename Func>
+static std::vector<BatchStatus> RunBatch(size_t count, ThreadPool* pool,
+                                         Func&& func) {
+  std::vector<BatchStatus> statuses(count, BatchStatus::kFailed);
+  auto run = [&](size_t i, Workspace* workspace) {
+    try {
+      statuses[i] =
+          func(i, workspace) ? BatchStatus::kOk : BatchStatus::kFailed;
+    } catch (std::exception& e) {
+      std::cerr << "Failed batch item " << i << ": " << e.what() << std::endl;
+      statuses[i] = BatchStatus::kException;
+    }
+    workspace->Reset();
+  };
+
+  if (pool) {
+    pool->ParallelFor(count, run);
+  } else {
+    Workspace workspace;
+    for (size_t i = 0; i < count; ++i) {
+      run(i, &workspace);
+    }
+  }
+  return statuses;
+}
+
+std::vector<BatchStatus> BatchDecompose(
+    std::span<WaveletBuffer> buffers, std::span<const SignalN2D> data,
+    const DenoiseAlgorithm<DataType>& denoiser, ThreadPool* pool) {
+  if (buffers.size() != data.size()) {
+    std::cerr << "Different number of buffers and signals" << std::endl;
+    return std::vector<BatchStatus>(buffers.size(), BatchStatus::kFailed);
+  }
+
+  return RunBatch(buffers.size(), pool, [&](size_t i, Workspace* workspace) {
+    auto& buffer = buffers[i];
+    return buffer.plan()->Decompose(data[i], denoiser,
+                                    &buffer.decompositions(), 0,
+                                    buffer.parameters().signal_number,
+                                    workspace);
+  });
+}
+
+std::vector<BatchStatus> BatchSerialize(std::span<const WaveletBuffer> buffers,
+                                        std::span<std::string> blobs,
+                                        uint8_t sf_compression,
+                                        ThreadPool* pool) {
+  if (buffers.size() != blobs.size()) {
+    std::cerr << "Different number of buffers and blobs" << std::endl;
+    return std::vector<BatchStatus>(buffers.size(), BatchStatus::kFailed);
+  }
+
+  return RunBatch(buffers.size(), pool, [&](size_t i, Workspace*) {
+    return buffers[i].Serialize(&blobs[i], sf_compression);
+  });
+}
+
+std::vector<BatchStatus> BatchParse(
+    std::span<const std::string> blobs,
+    std::vector<std::unique_ptr<WaveletBuffer>>* buffers, ThreadPool* pool) {
+  buffers->resize(blobs.size());
+
+  /* The plans of the batch, a plan is prepared once for its parameters */
+  std::map<WaveletParameters, std::shared_ptr<const WaveletPlan>> plans;
+  std::mutex mutex;
+  const WaveletPlanProvider provider = [&](const WaveletParameters& params) {
+    std::lock_guard lock(mutex);
+    auto& plan = plans[params];
+    if (!plan) {
+      plan = std::make_shared<const WaveletPlan>(params);
+    }
+    return plan;
+  };
+
+  return RunBatch(blobs.size(), pool, [&](size_t i, Workspace*) {
+    (*buffers)[i] = WaveletBuffer::Parse(blobs[i], provider);
+    return (*buffers)[i] != nullptr;
+  });
+}
+
+}  // namespace drift
@@ -4,13 +4,17 @@
 
 #include <blaze/Blaze.h>
 
+#include <cmath>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <span>
 #include <string>
 #include <tuple>
 #include <utility>
 #include <vector>
 
+#include "internal/resolution_cache.h"
 #include "wavelet_buffer/wavelet_buffer_serializer.h"
 #include "wavelet_buffer/wavelet_buffer_view.h"
 
@@ -24,8 +28,10 @@ class WaveletBuffer::Impl {
   /**
    * Initialize buffer
    * @param parameters the parameters of the wavelet decomposition
+   * @param plan the transform for the parameters, nullptr to prepare a new one
    */
-  explicit Impl(WaveletParameters parameters)
+  explicit Impl(WaveletParameters parameters,
+                std::shared_ptr<const WaveletPlan> plan = nullptr)
       : parameters_(std::move(parameters)) {
     if (parameters_.dimension() != 2 && parameters_.dimension() != 1) {
       throw std::runtime_error("Only 1D & 2D decomposition is supported");
@@ -56,6 +62,9 @@ class WaveletBuffer::Impl {
             ? parameters_.decomposition_steps
             : 0;
 
+    plan_ = plan ? std::move(plan)
+                 : std::make_shared<const WaveletPlan>(parameters_);
+
     decompositions_.resize(parameters_.signal_number);
     const auto decomposition_size = DecompositionSize(parameters_);
 
@@ -95,8 +104,11 @@ class WaveletBuffer::Impl {
    */
   bool Decompose(const SignalN2D& data,
                  const DenoiseAlgorithm<DataType>& denoiser) {
-    return internal::DecomposeImpl(parameters_, &decompositions_, data,
-                                   denoiser, 0, parameters_.signal_number);
+    resolution_cache_.Clear();
+    return WithWorkspace([&](Workspace* workspace) {
+      return plan_->Decompose(data, denoiser, &decompositions_, 0,
+                              parameters_.signal_number, workspace, pool_);
+    });
   }
 
   /**
@@ -104,13 +116,26 @@ class WaveletBuffer::Impl {
    * @param data the signal
    * @return true if it has no errors
    */
-  bool Decompose(const Signal1D& data,
+  bool Decompose(std::span<const DataType> data,
                  const DenoiseAlgorithm<DataType>& denoiser) {
-    SignalN2D data2d = {Signal2D(data.size(), 1)};
-    blaze::column(data2d[0], 0) = data;
+    resolution_cache_.Clear();
+    return WithWorkspace([&](Workspace* workspace) {
+      return plan_->Decompose(data, denoiser, &decompositions_, 0, workspace);
+    });
+  }
 
-    return internal::DecomposeImpl(parameters_, &decompositions_, data2d,
-                                   denoiser, 0, 1);
+  /**
+   * Decomposes the interleaved channels into the subbands
+   * @param data the signals
+   * @return true if it has no errors
+   */
+  bool DecomposeInterleaved(const Signal2D& data,
+                            const DenoiseAlgorithm<DataType>& denoiser) {
+    resolution_cache_.Clear();
+    return WithWorkspace([&](Workspace* workspace) {
+      return plan_->DecomposeInterleaved(data, denoiser, &decompositions_,
+                                         workspace);
+    });
   }
 
   /**
@@ -119,8 +144,20 @@ class WaveletBuffer::Impl {
    * @return true if it has no errors
    */
   bool Compose(SignalN2D* data, int scale_factor) const {
-    return internal::ComposeImpl(parameters_, data, decompositions_,
-                                 scale_factor, 0, parameters_.signal_number);
+    if (UsesResolutionCache(scale_factor)) {
+      if (data->size() != parameters_.signal_number) {
+        data->resize(parameters_.signal_number, false);
+      }
+      for (size_t ch = 0; ch < parameters_.signal_number; ++ch) {
+        ComposeCached(ch, scale_factor, &(*data)[ch]);
+      }
+      return true;
+    }
+
+    return WithWorkspace([&](Workspace* workspace) {
+      return plan_->Compose(decompositions_, data, scale_factor, 0,
+                            parameters_.signal_number, workspace, pool_);
+    });
   }
 
   /**
@@ -129,25 +166,129 @@ class WaveletBuffer::Impl {
    * @return true if it has no errors
    */
   bool Compose(Signal1D* data, int scale_factor) const {
-    SignalN2D data2d;
-    auto ret =
-        internal::ComposeImpl(parameters_, &data2d, decompositions_,
-                              scale_factor, 0, parameters_.signal_number);
-    if (ret) {
-      *data = blaze::column(data2d[0], 0);
+    if (parameters_.dimension() != 1) {
+      std::cerr << "Invalid 1D signal shape" << std::endl;
+      return false;
+    }
+
+    /* The odd-length levels keep a coefficient for the last sample */
+    const double size =
+        parameters_.signal_shape[0] / std::pow(2, scale_factor);
+    data->resize(static_cast<size_t>(
+                     parameters_.boundary_mode == BoundaryMode::kOddLength
+                         ? std::ceil(size)
+                         : size),
+                 false);
+    return Compose(std::span<DataType>(data->data(), data->size()),
+                   scale_factor);
+  }
+
+  /**
+   * Composes the subbands of the first channel into memory of the caller
+   * @param data the signal
+   * @return true if it has no errors
+   */
+  bool Compose(std::span<DataType> data, int scale_factor) const {
+    if (UsesResolutionCache(scale_factor)) {
+      if (parameters_.dimension() != 1 ||
+          data.size() != static_cast<size_t>(parameters_.signal_shape[0] /
+                                             std::pow(2, scale_factor))) {
+        std::cerr << "Invalid 1D signal shape" << std::endl;
+        return false;
+      }
+
+      Signal2D signal;
+      ComposeCached(0, scale_factor, &signal);
+      std::copy(blaze::column(signal, 0).begin(),
+                blaze::column(signal, 0).end(), data.begin());
+      return true;
+    }
+
+    return WithWorkspace([&](Workspace* workspace) {
+      return plan_->Compose(decompositions_, data, scale_factor, 0, workspace);
+    });
+  }
+
+  /**
+   * Composes the internal subbands into interleaved channels
+   * @param data the signals
+   * @return true if it has no errors
+   */
+  bool ComposeInterleaved(Signal2D* data, int scale_factor) const {
+    return WithWorkspace([&](Workspace* workspace) {
+      return plan_->ComposeInterleaved(decompositions_, data, scale_factor,
+                                       workspace);
+    });
+  }
+
+  /**
+   * Composes a region of the internal subbands into signals
+   * @param region
+   * @param data the composed regions
+   * @return true if it has no errors
+   */
+  bool Compose(const Region& region, SignalN2D* data,
+               int scale_factor) const {
+    return WithWorkspace([&](Workspace* workspace) {
+      return plan_->Compose(decompositions_, region, data, scale_factor, 0,
+                            parameters_.signal_number, workspace, pool_);
+    });
+  }
+
+  /**
+   * Composes a range of the first channel into a signal
+   * @param region
+   * @param data the composed range
+   * @return true if it has no errors
+   */
+  bool Compose(const Region& region, Signal1D* data, int scale_factor) const {
+    if (parameters_.dimension() != 1) {
+      std::cerr << "Invalid 1D signal shape" << std::endl;
+      return false;
+    }
+
+    SignalN2D range;
+    const bool composed = WithWorkspace([&](Workspace* workspace) {
+      return plan_->Compose(decompositions_, region, &range, scale_factor, 0,
+                            1, workspace);
+    });
+    if (!composed) {
+      return false;
     }
+    *data = blaze::column(range[0], 0);
     return true;
   }
 
+  void AttachWorkspace(Workspace* workspace) {
+    workspace_ = workspace;
+    workspace_mutex_ = workspace ? std::make_shared<std::mutex>() : nullptr;
+  }
+
+  void SetResolutionCache(size_t max_bytes) {
+    resolution_cache_.SetBudget(max_bytes);
+  }
+
+  void SetThreadCount(size_t threads) {
+    own_pool_ = threads != 1 ? std::make_shared<ThreadPool>(threads) : nullptr;
+    pool_ = own_pool_.get();
+  }
+
+  void AttachThreadPool(ThreadPool* pool) {
+    own_pool_ = nullptr;
+    pool_ = pool;
+  }
+
   /******** Serializers **************/
 
   /**
    * Parses subbands from a blob of data and creates a new buffer
    * @param blob the blob of subbands
+   * @param plans source of the plan of the buffer, empty to prepare a new
+   * one
    * @return nullptr if it failed to parse the buffer
    */
   [[nodiscard]] static std::unique_ptr<WaveletBuffer> Parse(
-      const std::string& blob) {
+      const std::string& blob, const WaveletPlanProvider& plans) {
     /* Read binary version */
     std::istringstream ss(blob);
     uint8_t version;
@@ -156,7 +297,8 @@ class WaveletBuffer::Impl {
     std::unique_ptr<IWaveletBufferSerializer> serializer;
 
     /* Choose serializer */
-    if (version == kSerializationVersion) {
+    if (version == kSerializationVersion ||
+        version == kPaddedSerializationVersion) {
       serializer = std::make_unique<WaveletBufferSerializer>();
     } else if (version == 2) {
       serializer = std::make_unique<WaveletBufferSerializerLegacy>();
@@ -167,7 +309,7 @@ class WaveletBuffer::Impl {
       return nullptr;
     }
 
-    return serializer->Parse(blob);
+    return serializer->Parse(blob, plans);
   }
   /**
    * Serialize the buffer into the blob for saving in a file or sending via
@@ -191,6 +333,8 @@ class WaveletBuffer::Impl {
    * @return the decomposition as a list of the subbands
    */
   [[nodiscard]] WaveletDecomposition& operator[](int index) {
+    /* The subbands can be changed through the reference */
+    resolution_cache_.Clear();
     return decompositions_[index];
   }
 
@@ -210,7 +354,12 @@ class WaveletBuffer::Impl {
     return parameters_;
   }
 
+  [[nodiscard]] const std::shared_ptr<const WaveletPlan>& plan() const {
+    return plan_;
+  }
+
   [[nodiscard]] blaze::DynamicVector<WaveletDecomposition>& decompositions() {
+    resolution_cache_.Clear();
     return decompositions_;
   }
 
@@ -287,7 +436,72 @@ class WaveletBuffer::Impl {
   }
 
  private:
+  /**
+   * Run a transform with the attached workspace if no other call of the
+   * buffer or of its copies is using it, otherwise with scratch memory of
+   * the call, so const calls from several threads don't share it
+   * @param func function of the workspace, nullptr for memory of the call
+   */
+  template <typename Func>
+  auto WithWorkspace(Func&& func) const {
+    std::unique_lock<std::mutex> lock;
+    if (workspace_mutex_) {
+      lock = std::unique_lock(*workspace_mutex_, std::try_to_lock);
+    }
+    return func(lock.owns_lock() ? workspace_ : nullptr);
+  }
+
+  /**
+   * The cache is used for the levels composed by the steps of the
+   * decomposition
+   */
+  [[nodiscard]] bool UsesResolutionCache(int scale_factor) const {
+    return resolution_cache_.budget() > 0 &&
+           parameters_.boundary_mode != BoundaryMode::kOddLength &&
+           scale_factor >= 0 &&
+           scale_factor < static_cast<int>(parameters_.decomposition_steps);
+  }
+
+  /**
+   * Compose a channel resuming from the nearest cached level, the composed
+   * levels are cached
+   * @param channel
+   * @param level the scale factor
+   * @param data the composed signal
+   */
+  void ComposeCached(size_t channel, size_t level, Signal2D* data) const {
+    const auto& decomposition = decompositions_[channel];
+    auto [from, cached] = resolution_cache_.Find(channel, level);
+    if (!cached) {
+      from = parameters_.decomposition_steps;
+    }
+    const Signal2D& approximation =
+        cached ? *cached : decomposition[decomposition.size() - 1];
+    if (from == level) {
+      plan_->CropApproximation(approximation, level, data);
+      return;
+    }
+
+    Signal2D composed;
+    plan_->ComposeApproximation(
+        decomposition, approximation, from, level, &composed,
+        [this, channel](size_t composed_level, const Signal2D& low) {
+          resolution_cache_.Insert(channel, composed_level, low);
+        },
+        pool_);
+    plan_->CropApproximation(composed, level, data);
+  }
+
   WaveletParameters parameters_;
+  std::shared_ptr<const WaveletPlan> plan_;
+  Workspace* workspace_ = nullptr;
+  /* Taken by the calls using the workspace, copies of the buffer share it */
+  std::shared_ptr<std::mutex> workspace_mutex_;
+  std::shared_ptr<ThreadPool> own_pool_;
+  ThreadPool* pool_ = nullptr;
+  /* Approximations of the levels of Compose, they are dropped when the
+   * subbands change */
+  mutable internal::ResolutionCache resolution_cache_;
 
   /* Channel -> subbands (vector of all details and last approx in the end)
    */
@@ -303,6 +517,9 @@ WaveletBuffer::WaveletBuffer(WaveletBuffer&& buffer) noexcept = default;
 WaveletBuffer::WaveletBuffer(const WaveletParameters& parameters)
     : impl_(std::make_unique<Impl>(parameters)) {}
 
+WaveletBuffer::WaveletBuffer(std::shared_ptr<const WaveletPlan> plan)
+    : impl_(std::make_unique<Impl>(plan->parameters(), plan)) {}
+
 WaveletBuffer::WaveletBuffer(const WaveletParameters& parameters,
                              const NWaveletDecomposition& decompositions)
     : impl_(std::make_unique<Impl>(parameters, decompositions)) {}
@@ -318,9 +535,20 @@ bool WaveletBuffer::Decompose(const SignalN2D& data,
 
 bool WaveletBuffer::Decompose(const Signal1D& data,
                               const DenoiseAlgorithm<DataType>& denoiser) {
+  return impl_->Decompose(std::span<const DataType>(data.data(), data.size()),
+                          denoiser);
+}
+
+bool WaveletBuffer::Decompose(std::span<const DataType> data,
+                              const DenoiseAlgorithm<DataType>& denoiser) {
   return impl_->Decompose(data, denoiser);
 }
 
+bool WaveletBuffer::DecomposeInterleaved(
+    const Signal2D& data, const DenoiseAlgorithm<DataType>& denoiser) {
+  return impl_->DecomposeInterleaved(data, denoiser);
+}
+
 bool WaveletBuffer::Compose(SignalN2D* data, int scale_factor) const {
   return impl_->Compose(data, scale_factor);
 }
@@ -329,11 +557,51 @@ bool WaveletBuffer::Compose(Signal1D* data, int scale_factor) const {
   return impl_->Compose(data, scale_factor);
 }
 
+bool WaveletBuffer::Compose(std::span<DataType> data, int scale_factor) const {
+  return impl_->Compose(data, scale_factor);
+}
+
+bool WaveletBuffer::ComposeInterleaved(Signal2D* data,
+                                       int scale_factor) const {
+  return impl_->ComposeInterleaved(data, scale_factor);
+}
+
+bool WaveletBuffer::Compose(const Region& region, SignalN2D* data,
+                            int scale_factor) const {
+  return impl_->Compose(region, data, scale_factor);
+}
+
+bool WaveletBuffer::Compose(const Region& region, Signal1D* data,
+                            int scale_factor) const {
+  return impl_->Compose(region, data, scale_factor);
+}
+
+void WaveletBuffer::AttachWorkspace(Workspace* workspace) {
+  impl_->AttachWorkspace(workspace);
+}
+
+void WaveletBuffer::SetResolutionCache(size_t max_bytes) {
+  impl_->SetResolutionCache(max_bytes);
+}
+
+void WaveletBuffer::SetThreadCount(size_t threads) {
+  impl_->SetThreadCount(threads);
+}
+
+void WaveletBuffer::AttachThreadPool(ThreadPool* pool) {
+  impl_->AttachThreadPool(pool);
+}
+
 /******** Serializers **************/
 
 [[nodiscard]] std::unique_ptr<WaveletBuffer> WaveletBuffer::Parse(
     const std::string& blob) {
-  return Impl::Parse(blob);
+  return Impl::Parse(blob, {});
+}
+
+[[nodiscard]] std::unique_ptr<WaveletBuffer> WaveletBuffer::Parse(
+    const std::string& blob, const WaveletPlanProvider& plans) {
+  return Impl::Parse(blob, plans);
 }
 
 [[nodiscard]] bool WaveletBuffer::Serialize(std::string* blob,
@@ -356,6 +624,10 @@ const WaveletParameters& WaveletBuffer::parameters() const {
   return impl_->parameters();
 }
 
+std::shared_ptr<const WaveletPlan> WaveletBuffer::plan() const {
+  return impl_->plan();
+}
+
 NWaveletDecomposition& WaveletBuffer::decompositions() {
   return impl_->decompositions();
 }
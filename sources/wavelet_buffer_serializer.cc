@@ -3,6 +3,7 @@
 #include "wavelet_buffer/wavelet_buffer_serializer.h"
 
 #include <iostream>
+#include <utility>
 
 #include "internal/matrix_compressor.h"
 #include "internal/sf_compressor.h"
@@ -27,8 +28,39 @@ static size_t GetMemorySizeForSfCompressor(const SignalShape& signal_shape,
 static bool ParseCompressedSubbands(blaze::Archive<std::istringstream>* archive,
                                     WaveletBuffer* buffer);
 
+/**
+ * Create a buffer for the parsed parameters
+ * @param params
+ * @param plans source of the plan, empty to prepare a new one
+ */
+static std::unique_ptr<WaveletBuffer> MakeBuffer(
+    const WaveletParameters& params, const WaveletPlanProvider& plans) {
+  if (plans) {
+    return std::make_unique<WaveletBuffer>(plans(params));
+  }
+  return std::make_unique<WaveletBuffer>(params);
+}
+
+[[nodiscard]] std::unique_ptr<WaveletBuffer> IWaveletBufferSerializer::Parse(
+    const std::string& blob, const WaveletPlanProvider& plans) {
+  auto buffer = Parse(blob);
+  if (!buffer || !plans) {
+    return buffer;
+  }
+
+  auto planned = std::make_unique<WaveletBuffer>(plans(buffer->parameters()));
+  planned->decompositions() = std::move(buffer->decompositions());
+  return planned;
+}
+
 [[nodiscard]] std::unique_ptr<WaveletBuffer>
 WaveletBufferSerializerLegacy::Parse(const std::string& blob) {
+  return Parse(blob, {});
+}
+
+[[nodiscard]] std::unique_ptr<WaveletBuffer>
+WaveletBufferSerializerLegacy::Parse(const std::string& blob,
+                                     const WaveletPlanProvider& plans) {
   try {
     /* Create archive */
     std::istringstream ss(blob);
@@ -40,7 +72,7 @@ WaveletBufferSerializerLegacy::Parse(const std::string& blob) {
     uint8_t sf_compression;
     archive >> serialization_version >> params >> sf_compression;
 
-    auto buffer = std::make_unique<WaveletBuffer>(params);
+    auto buffer = MakeBuffer(params, plans);
 
     if (sf_compression != 0) {
       if (!ParseCompressedSubbands(&archive, buffer.get())) {
@@ -64,6 +96,11 @@ WaveletBufferSerializerLegacy::Parse(const std::string& blob) {
 
 [[nodiscard]] std::unique_ptr<WaveletBuffer> WaveletBufferSerializer::Parse(
     const std::string& blob) {
+  return Parse(blob, {});
+}
+
+[[nodiscard]] std::unique_ptr<WaveletBuffer> WaveletBufferSerializer::Parse(
+    const std::string& blob, const WaveletPlanProvider& plans) {
   using wavelet::internal::ArchivedMatrix;
   using wavelet::internal::BlazeCompressor;
 
@@ -77,8 +114,20 @@ WaveletBufferSerializerLegacy::Parse(const std::string& blob) {
     WaveletParameters params{};
     uint8_t sf_compression;
     archive >> serialization_version >> params >> sf_compression;
+    if (serialization_version >= kSerializationVersion) {
+      uint8_t boundary_mode;
+      archive >> boundary_mode;
+      /* Padded buffers are written with the older version */
+      if (boundary_mode == static_cast<uint8_t>(BoundaryMode::kPadding) ||
+          boundary_mode > static_cast<uint8_t>(BoundaryMode::kZeroPadding)) {
+        std::cerr << "Wrong boundary mode: "
+                  << static_cast<int>(boundary_mode) << std::endl;
+        return nullptr;
+      }
+      params.boundary_mode = static_cast<BoundaryMode>(boundary_mode);
+    }
 
-    auto buffer = std::make_unique<WaveletBuffer>(params);
+    auto buffer = MakeBuffer(params, plans);
     /* Load subbands */
     for (auto& signal : buffer->decompositions()) {
       for (auto& subband : signal) {
@@ -119,7 +168,13 @@ WaveletBufferSerializerLegacy::Parse(const std::string& blob) {
     }
 
     /* Serialize header */
-    arch << kSerializationVersion << buffer.parameters() << sf_compression;
+    const auto& params = buffer.parameters();
+    if (params.boundary_mode == BoundaryMode::kPadding) {
+      arch << kPaddedSerializationVersion << params << sf_compression;
+    } else {
+      arch << kSerializationVersion << params << sf_compression
+           << static_cast<uint8_t>(params.boundary_mode);
+    }
 
     /* Serialize subbands */
     for (const auto& signal : buffer.decompositions()) {
@@ -25,16 +25,23 @@ class WaveletBufferView::Impl {
   bool Decompose(const SignalN2D& data,
                  const DenoiseAlgorithm<DataType>& denoiser) {
     auto ret = CheckChannelRange();
-    return ret && internal::DecomposeImpl(buffer_->parameters(),
-                                          &buffer_->decompositions(), data,
-                                          denoiser, start_signal_, count_);
+    return ret && buffer_->plan()->Decompose(data, denoiser,
+                                             &buffer_->decompositions(),
+                                             start_signal_, count_);
   }
 
   bool Compose(SignalN2D* data, int scale_factor) const {
     auto ret = CheckChannelRange();
-    return ret && internal::ComposeImpl(const_buffer_->parameters(), data,
-                                        const_buffer_->decompositions(),
-                                        scale_factor, start_signal_, count_);
+    return ret && const_buffer_->plan()->Compose(
+                      const_buffer_->decompositions(), data, scale_factor,
+                      start_signal_, count_);
+  }
+
+  bool Compose(const Region& region, SignalN2D* data, int scale_factor) const {
+    auto ret = CheckChannelRange();
+    return ret && const_buffer_->plan()->Compose(
+                      const_buffer_->decompositions(), region, data,
+                      scale_factor, start_signal_, count_);
   }
 
   NWaveletDecompositionView decompositions() {
@@ -80,6 +87,11 @@ bool WaveletBufferView::Compose(SignalN2D* data, int scale_factor) const {
   return impl_->Compose(data, scale_factor);
 }
 
+bool WaveletBufferView::Compose(const Region& region, SignalN2D* data,
+                                int scale_factor) const {
+  return impl_->Compose(region, data, scale_factor);
+}
+
 WaveletBufferView::NWaveletDecompositionView WaveletBufferView::decompositions()
     const {
   return impl_->decompositions();
@@ -0,0 +1,229 @@
+// Copyright 2023 PANDA GmbH
+
+#include "wavelet_buffer/wavelet_plan.h"
+
+#include <functional>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace drift {
+
+/**
+ * Encapsulate implementation details of WaveletPlan
+ */
+class WaveletPlan::Impl {
+ public:
+  Impl(WaveletParameters parameters, wavelet::Engine engine)
+      : parameters_(std::move(parameters)), engine_(engine) {
+    if (parameters_.dimension() != 2 && parameters_.dimension() != 1) {
+      throw std::runtime_error("Only 1D & 2D decomposition is supported");
+    }
+
+    if (parameters_.wavelet_type == WaveletTypes::kNone) {
+      parameters_.decomposition_steps = 0;
+    }
+
+    const auto max_decomposition_steps =
+        internal::CalculateMaxDecompositionSteps(parameters_.wavelet_type,
+                                                 parameters_.signal_shape);
+    if (parameters_.decomposition_steps > max_decomposition_steps) {
+      throw std::runtime_error(std::string("Too many decomposition steps for "
+                                           "this signal size with that wavelet "
+                                           "type (must be max ") +
+                               std::to_string(max_decomposition_steps) + ").");
+    }
+
+    if (parameters_.boundary_mode == BoundaryMode::kOddLength &&
+        engine_ != wavelet::Engine::kFilterBank) {
+      throw std::runtime_error(
+          "The odd-length boundary mode needs the filter bank engine");
+    }
+
+    padded_shape_ = internal::CalcPaddedSize(parameters_);
+    forward_ = internal::MakeEngineOperators(parameters_, engine_, false);
+    inverse_ = internal::MakeEngineOperators(parameters_, engine_, true);
+  }
+
+  bool Decompose(const SignalN2D& data,
+                 const DenoiseAlgorithm<DataType>& denoiser,
+                 NWaveletDecomposition* decomposition, size_t start_signal,
+                 size_t signal_count, Workspace* workspace,
+                 ThreadPool* pool) const {
+    return internal::DecomposeImpl(parameters_, padded_shape_, *forward_,
+                                   decomposition, data, denoiser,
+                                   start_signal, signal_count, workspace,
+                                   pool);
+  }
+
+  bool Compose(const NWaveletDecomposition& decomposition, SignalN2D* data,
+               int scale_factor, size_t start_signal, size_t count,
+               Workspace* workspace, ThreadPool* pool) const {
+    return internal::ComposeImpl(parameters_, *inverse_, data, decomposition,
+                                 scale_factor, start_signal, count, workspace,
+                                 pool);
+  }
+
+  bool Compose(const NWaveletDecomposition& decomposition,
+               const Region& region, SignalN2D* data, int scale_factor,
+               size_t start_signal, size_t count, Workspace* workspace,
+               ThreadPool* pool) const {
+    return internal::ComposeRegionImpl(parameters_, padded_shape_, region,
+                                       data, decomposition, scale_factor,
+                                       start_signal, count, workspace, pool);
+  }
+
+  bool Decompose(std::span<const DataType> data,
+                 const DenoiseAlgorithm<DataType>& denoiser,
+                 NWaveletDecomposition* decomposition, size_t channel,
+                 Workspace* workspace) const {
+    return internal::DecomposeImpl(parameters_, padded_shape_, *forward_,
+                                   decomposition, channel, data, denoiser,
+                                   workspace);
+  }
+
+  bool Compose(const NWaveletDecomposition& decomposition,
+               std::span<DataType> data, int scale_factor, size_t channel,
+               Workspace* workspace) const {
+    return internal::ComposeImpl(parameters_, *inverse_, data, decomposition,
+                                 scale_factor, channel, workspace);
+  }
+
+  bool DecomposeInterleaved(const Signal2D& data,
+                            const DenoiseAlgorithm<DataType>& denoiser,
+                            NWaveletDecomposition* decomposition,
+                            Workspace* workspace) const {
+    return internal::DecomposeInterleavedImpl(parameters_, padded_shape_,
+                                              *forward_, decomposition, data,
+                                              denoiser, workspace);
+  }
+
+  bool ComposeInterleaved(const NWaveletDecomposition& decomposition,
+                          Signal2D* data, int scale_factor,
+                          Workspace* workspace) const {
+    return internal::ComposeInterleavedImpl(parameters_, *inverse_, data,
+                                            decomposition, scale_factor,
+                                            workspace);
+  }
+
+  void ComposeApproximation(
+      const WaveletDecomposition& decomposition, const Signal2D& approximation,
+      size_t from, size_t to, Signal2D* result,
+      const std::function<void(size_t, const Signal2D&)>& on_level,
+      ThreadPool* pool) const {
+    internal::ComposeApproximationImpl(parameters_, *inverse_, decomposition,
+                                       approximation, from, to, result,
+                                       on_level, pool);
+  }
+
+  void CropApproximation(const Signal2D& approximation, size_t level,
+                         Signal2D* data) const {
+    internal::CropApproximationImpl(parameters_, approximation, level, data);
+  }
+
+  [[nodiscard]] const WaveletParameters& parameters() const {
+    return parameters_;
+  }
+
+  [[nodiscard]] wavelet::Engine engine() const { return engine_; }
+
+  [[nodiscard]] const SignalShape& padded_shape() const {
+    return padded_shape_;
+  }
+
+ private:
+  WaveletParameters parameters_;
+  wavelet::Engine engine_;
+  SignalShape padded_shape_;
+  std::shared_ptr<const internal::EngineOperators> forward_;
+  std::shared_ptr<const internal::EngineOperators> inverse_;
+};
+
+WaveletPlan::WaveletPlan(const WaveletParameters& parameters,
+                         wavelet::Engine engine)
+    : impl_(std::make_unique<Impl>(parameters, engine)) {}
+
+WaveletPlan::WaveletPlan(WaveletPlan&& plan) noexcept = default;
+
+WaveletPlan& WaveletPlan::operator=(WaveletPlan&& plan) noexcept = default;
+
+WaveletPlan::~WaveletPlan() = default;
+
+bool WaveletPlan::Decompose(const SignalN2D& data,
+                            const DenoiseAlgorithm<DataType>& denoiser,
+                            NWaveletDecomposition* decomposition,
+                            size_t start_signal, size_t signal_count,
+                            Workspace* workspace, ThreadPool* pool) const {
+  return impl_->Decompose(data, denoiser, decomposition, start_signal,
+                          signal_count, workspace, pool);
+}
+
+bool WaveletPlan::Compose(const NWaveletDecomposition& decomposition,
+                          SignalN2D* data, int scale_factor,
+                          size_t start_signal, size_t count,
+                          Workspace* workspace, ThreadPool* pool) const {
+  return impl_->Compose(decomposition, data, scale_factor, start_signal, count,
+                        workspace, pool);
+}
+
+bool WaveletPlan::Compose(const NWaveletDecomposition& decomposition,
+                          const Region& region, SignalN2D* data,
+                          int scale_factor, size_t start_signal, size_t count,
+                          Workspace* workspace, ThreadPool* pool) const {
+  return impl_->Compose(decomposition, region, data, scale_factor,
+                        start_signal, count, workspace, pool);
+}
+
+bool WaveletPlan::Decompose(std::span<const DataType> data,
+                            const DenoiseAlgorithm<DataType>& denoiser,
+                            NWaveletDecomposition* decomposition,
+                            size_t channel, Workspace* workspace) const {
+  return impl_->Decompose(data, denoiser, decomposition, channel, workspace);
+}
+
+bool WaveletPlan::Compose(const NWaveletDecomposition& decomposition,
+                          std::span<DataType> data, int scale_factor,
+                          size_t channel, Workspace* workspace) const {
+  return impl_->Compose(decomposition, data, scale_factor, channel, workspace);
+}
+
+bool WaveletPlan::DecomposeInterleaved(
+    const Signal2D& data, const DenoiseAlgorithm<DataType>& denoiser,
+    NWaveletDecomposition* decomposition, Workspace* workspace) const {
+  return impl_->DecomposeInterleaved(data, denoiser, decomposition, workspace);
+}
+
+bool WaveletPlan::ComposeInterleaved(const NWaveletDecomposition& decomposition,
+                                     Signal2D* data, int scale_factor,
+                                     Workspace* workspace) const {
+  return impl_->ComposeInterleaved(decomposition, data, scale_factor,
+                                   workspace);
+}
+
+void WaveletPlan::ComposeApproximation(
+    const WaveletDecomposition& decomposition, const Signal2D& approximation,
+    size_t from, size_t to, Signal2D* result,
+    const std::function<void(size_t, const Signal2D&)>& on_level,
+    ThreadPool* pool) const {
+  impl_->ComposeApproximation(decomposition, approximation, from, to, result,
+                              on_level, pool);
+}
+
+void WaveletPlan::CropApproximation(const Signal2D& approximation,
+                                    size_t level, Signal2D* data) const {
+  impl_->CropApproximation(approximation, level, data);
+}
+
+const WaveletParameters& WaveletPlan::parameters() const {
+  return impl_->parameters();
+}
+
+wavelet::Engine WaveletPlan::engine() const { return impl_->engine(); }
+
+const SignalShape& WaveletPlan::padded_shape() const {
+  return impl_->padded_shape();
+}
+
+}  // namespace drift
@@ -0,0 +1,366 @@
+// Copyright 2023 PANDA GmbH
+
+#include "wavelet_buffer/wavelet_stream.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "internal/dwt_kernels.h"
+#include "wavelet_buffer/wavelet_utils.h"
+
+namespace drift {
+
+/**
+ * Analysis of the complete coefficients of a line, the same sums as the
+ * scalar interior of AnalyzeLine. The order of the additions is fixed, so
+ * a coefficient doesn't depend on where the line was cut
+ * @param src the line
+ * @param count the number of the coefficients
+ * @param filters
+ * @param low the approximation, count elements
+ * @param high the details, count elements
+ */
+static void AnalyzeStream(const DataType *src, size_t count,
+                          const wavelet::FilterBank &filters, DataType *low,
+                          DataType *high) {
+  const size_t length = filters.low_pass.size();
+  for (size_t i = 0; i < count; ++i) {
+    const DataType *x = src + 2 * i;
+    DataType l = 0;
+    DataType h = 0;
+    for (size_t k = 0; k < length; ++k) {
+      l += filters.low_pass[k] * x[k];
+      h += filters.high_pass[k] * x[k];
+    }
+    low[i] = l;
+    high[i] = h;
+  }
+}
+
+/**
+ * Synthesis of the samples from the coefficients which have all their
+ * predecessors under the filters, the same sums as the interior of
+ * SynthesizeLine
+ * @param low the approximation, the first phase - 1 coefficients are the
+ * history
+ * @param high the details
+ * @param count the number of the pairs of the samples to restore
+ * @param filters
+ * @param dst 2 * count samples
+ */
+static void SynthesizeStream(const DataType *low, const DataType *high,
+                             size_t count, const wavelet::FilterBank &filters,
+                             DataType *dst) {
+  const size_t phase_taps = filters.low_pass.size() / 2;
+  for (size_t i = 0; i < count; ++i) {
+    const size_t p = i + phase_taps - 1;
+    DataType even = 0;
+    DataType odd = 0;
+    for (size_t m = 0; m < phase_taps; ++m) {
+      const size_t j = p - m;
+      even += filters.low_pass[2 * m] * low[j] +
+              filters.high_pass[2 * m] * high[j];
+      odd += filters.low_pass[2 * m + 1] * low[j] +
+             filters.high_pass[2 * m + 1] * high[j];
+    }
+    dst[2 * i] = even;
+    dst[2 * i + 1] = odd;
+  }
+}
+
+/**
+ * Filters of the stream
+ * @return empty filters if there are no steps
+ */
+static wavelet::FilterBank StreamFilters(WaveletTypes wavelet_type,
+                                         size_t steps) {
+  if (steps == 0) {
+    return {};
+  }
+  return wavelet::DaubechiesFilters(wavelet_type * 2);
+}
+
+/**
+ * Zeros before the signal of each step. The first coefficient of a step
+ * covers them and the first sample; after an odd delay the step has one
+ * zero more, so its coefficients keep the phase of the periodic transform
+ * @param length the length of the filters
+ * @param steps
+ */
+static std::vector<size_t> StreamPrefixes(size_t length, size_t steps) {
+  std::vector<size_t> prefixes(steps);
+  size_t delay = 0;
+  for (size_t step = 0; step < steps; ++step) {
+    prefixes[step] = length - 2 + delay % 2;
+    delay = (prefixes[step] + delay) / 2;
+  }
+  return prefixes;
+}
+
+StreamDecomposer::StreamDecomposer(WaveletTypes wavelet_type,
+                                   size_t decomposition_steps)
+    : steps_(wavelet_type != kNone ? decomposition_steps : 0),
+      filters_(StreamFilters(wavelet_type, steps_)) {
+  /* A coefficient k of a step reads the samples from 2 * k - prefix of its
+   * input, which is delayed by the previous step */
+  size_t delay = 0;
+  for (const auto prefix :
+       StreamPrefixes(filters_.low_pass.size(), steps_)) {
+    pending_.emplace_back(prefix, 0);
+    delay = (prefix + delay) / 2;
+    delays_.push_back(delay);
+  }
+  delays_.push_back(delay);
+}
+
+void StreamDecomposer::Push(std::span<const DataType> chunk,
+                            StreamSubbands *subbands) {
+  subbands->resize(steps_ + 1);
+
+  const size_t length = filters_.low_pass.size();
+  std::span<const DataType> input = chunk;
+  for (size_t step = 0; step < steps_; ++step) {
+    auto &line = pending_[step];
+    line.insert(line.end(), input.begin(), input.end());
+
+    const size_t count =
+        line.size() >= length ? (line.size() - length) / 2 + 1 : 0;
+    auto &low = scratch_[step % 2];
+    auto &high = (*subbands)[step];
+    const size_t offset = high.size();
+    low.resize(count);
+    high.resize(offset + count);
+    AnalyzeStream(line.data(), count, filters_, low.data(),
+                  high.data() + offset);
+
+    /* Keep the samples under the next coefficients */
+    line.erase(line.begin(), line.begin() + 2 * count);
+    input = low;
+  }
+
+  auto &approximation = (*subbands)[steps_];
+  approximation.insert(approximation.end(), input.begin(), input.end());
+}
+
+size_t StreamDecomposer::decomposition_steps() const { return steps_; }
+
+size_t StreamDecomposer::delay(size_t subband) const {
+  return delays_[subband];
+}
+
+StreamComposer::StreamComposer(WaveletTypes wavelet_type,
+                               size_t decomposition_steps)
+    : steps_(wavelet_type != kNone ? decomposition_steps : 0),
+      filters_(StreamFilters(wavelet_type, steps_)),
+      pending_(steps_) {
+  const auto prefixes = StreamPrefixes(filters_.low_pass.size(), steps_);
+  for (size_t step = 0; step < steps_; ++step) {
+    pending_[step].skip = prefixes[step] - (filters_.low_pass.size() - 2);
+  }
+}
+
+bool StreamComposer::Push(const StreamSubbands &subbands,
+                          std::vector<DataType> *samples) {
+  if (subbands.size() != steps_ + 1) {
+    std::cerr << "Wrong number of subbands in stream. Expected "
+              << steps_ + 1 << " but got " << subbands.size() << std::endl;
+    return false;
+  }
+
+  const size_t phase_taps = filters_.low_pass.size() / 2;
+  std::span<const DataType> input = subbands[steps_];
+  for (size_t step = steps_; step-- > 0;) {
+    auto &pending = pending_[step];
+    pending.low.insert(pending.low.end(), input.begin(), input.end());
+    pending.high.insert(pending.high.end(), subbands[step].begin(),
+                        subbands[step].end());
+
+    /* The first coefficients restore the zeros before the start of the
+     * signal, they are only the history of the filters. A zero more of the
+     * phase is restored and dropped */
+    const size_t pairs = std::min(pending.low.size(), pending.high.size());
+    const size_t count = pairs >= phase_taps ? pairs - (phase_taps - 1) : 0;
+    auto &out = scratch_[step % 2];
+    out.resize(2 * count);
+    SynthesizeStream(pending.low.data(), pending.high.data(), count, filters_,
+                     out.data());
+
+    pending.low.erase(pending.low.begin(), pending.low.begin() + count);
+    pending.high.erase(pending.high.begin(), pending.high.begin() + count);
+    const size_t skipped = std::min(pending.skip, out.size());
+    pending.skip -= skipped;
+    input = std::span<const DataType>(out).subspan(skipped);
+  }
+
+  samples->insert(samples->end(), input.begin(), input.end());
+  return true;
+}
+
+size_t StreamComposer::decomposition_steps() const { return steps_; }
+
+RowStreamDecomposer::RowStreamDecomposer(const WaveletParameters &parameters,
+                                         SubbandRowSink sink)
+    : parameters_(parameters), sink_(std::move(sink)) {
+  if (parameters_.dimension() != 2 || parameters_.signal_number != 1) {
+    throw std::runtime_error("Row stream supports only one 2D signal");
+  }
+  if (parameters_.boundary_mode != BoundaryMode::kPadding) {
+    throw std::runtime_error("Row stream needs the padding boundary mode");
+  }
+
+  if (parameters_.wavelet_type == kNone) {
+    parameters_.decomposition_steps = 0;
+  }
+  const auto max_decomposition_steps = internal::CalculateMaxDecompositionSteps(
+      parameters_.wavelet_type, parameters_.signal_shape);
+  if (static_cast<int>(parameters_.decomposition_steps) >
+      max_decomposition_steps) {
+    throw std::runtime_error(std::string("Too many decomposition steps for "
+                                         "this signal size with that wavelet "
+                                         "type (must be max ") +
+                             std::to_string(max_decomposition_steps) + ").");
+  }
+
+  const size_t steps = parameters_.decomposition_steps;
+  const auto padded = internal::CalcPaddedSize(
+      parameters_.wavelet_type, parameters_.signal_shape, steps);
+  padded_row_.resize(padded[0]);
+  top_ = (padded[1] - parameters_.signal_shape[1]) / 2;
+  if (steps == 0) {
+    return;
+  }
+
+  /* The window has room for the rows under the filters and the first rows
+   * appended at the end of the frame, it is compacted when it is full */
+  filters_ = wavelet::DaubechiesFilters(parameters_.wavelet_type * 2);
+  const size_t length = filters_.low_pass.size();
+  size_t rows = padded[1];
+  size_t columns = padded[0];
+  for (size_t step = 0; step < steps; ++step) {
+    Step level{.rows = rows, .columns = columns};
+    level.window.resize(2 * length * columns);
+    level.head.resize(std::min(length - 2, rows) * columns);
+    level.output.resize(2 * columns);
+    steps_.push_back(std::move(level));
+    rows /= 2;
+    columns /= 2;
+  }
+}
+
+bool RowStreamDecomposer::Push(std::span<const DataType> row) {
+  const size_t columns = parameters_.signal_shape[0];
+  const size_t rows = parameters_.signal_shape[1];
+  if (row.size() != columns) {
+    std::cerr << "Wrong size of row. Expected " << columns << " but got "
+              << row.size() << std::endl;
+    return false;
+  }
+
+  if (steps_.empty()) {
+    sink_(0, received_, row);
+    received_ = (received_ + 1) % rows;
+    return true;
+  }
+
+  /* Zero derivative padding of the row and of the frame */
+  const size_t left = (padded_row_.size() - columns) / 2;
+  std::fill_n(padded_row_.begin(), left, row.front());
+  std::copy(row.begin(), row.end(), padded_row_.begin() + left);
+  std::fill(padded_row_.begin() + left + columns, padded_row_.end(),
+            row.back());
+
+  const size_t copies = received_ == 0 ? top_ + 1 : 1;
+  for (size_t i = 0; i < copies; ++i) {
+    PushRow(0, padded_row_);
+  }
+
+  if (++received_ == rows) {
+    const size_t bottom = steps_[0].rows - rows - top_;
+    for (size_t i = 0; i < bottom; ++i) {
+      PushRow(0, padded_row_);
+    }
+    received_ = 0;
+  }
+  return true;
+}
+
+const WaveletParameters &RowStreamDecomposer::parameters() const {
+  return parameters_;
+}
+
+DataType *RowStreamDecomposer::AppendRow(Step *step) {
+  const size_t capacity = step->window.size() / step->columns;
+  if (step->end == capacity) {
+    std::copy(step->window.begin() + step->begin * step->columns,
+              step->window.end(), step->window.begin());
+    step->end -= step->begin;
+    step->begin = 0;
+  }
+  return step->window.data() + step->end++ * step->columns;
+}
+
+void RowStreamDecomposer::PushRow(size_t level, std::span<const DataType> row) {
+  auto &step = steps_[level];
+  const wavelet::internal::FilterTaps taps{filters_.low_pass.data(),
+                                           filters_.high_pass.data(),
+                                           filters_.low_pass.size()};
+  const size_t half = step.columns / 2;
+  DataType *transformed = AppendRow(&step);
+  wavelet::internal::AnalyzeLine({row.data(), 1}, step.columns, taps,
+                                 {transformed, 1}, {transformed + half, 1});
+
+  const size_t head_rows = step.head.size() / step.columns;
+  if (step.received < head_rows) {
+    std::copy_n(transformed, step.columns,
+                step.head.begin() + step.received * step.columns);
+  }
+  EmitRows(level);
+
+  /* The last rows wrap around to the first ones */
+  if (++step.received == step.rows) {
+    for (size_t k = 0; k < taps.length - 2; ++k) {
+      std::copy_n(step.head.begin() + k % head_rows * step.columns,
+                  step.columns, AppendRow(&step));
+    }
+    EmitRows(level);
+    step.begin = 0;
+    step.end = 0;
+    step.received = 0;
+    step.emitted = 0;
+  }
+}
+
+void RowStreamDecomposer::EmitRows(size_t level) {
+  auto &step = steps_[level];
+  const wavelet::internal::FilterTaps taps{filters_.low_pass.data(),
+                                           filters_.high_pass.data(),
+                                           filters_.low_pass.size()};
+  const size_t half = step.columns / 2;
+  DataType *output = step.output.data();
+  while (step.end - step.begin >= taps.length) {
+    const DataType *src = step.window.data() + step.begin * step.columns;
+    wavelet::internal::AnalyzeColumnSegment({src, step.columns}, 1, half,
+                                            taps, {output, half},
+                                            {output + half, half});
+    wavelet::internal::AnalyzeColumnSegment(
+        {src + half, step.columns}, 1, half, taps, {output + 2 * half, half},
+        {output + 3 * half, half});
+    step.begin += 2;
+
+    const size_t row = step.emitted++;
+    for (size_t i = 1; i < 4; ++i) {
+      sink_(level * 3 + i - 1, row, {output + i * half, half});
+    }
+    if (level + 1 < steps_.size()) {
+      PushRow(level + 1, {output, half});
+    } else {
+      sink_(steps_.size() * 3, row, {output, half});
+    }
+  }
+}
+
+}  // namespace drift
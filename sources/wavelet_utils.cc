@@ -1,13 +1,21 @@
 // Copyright 2021-2022 PANDA GmbH
 
+#include <algorithm>
+#include <cmath>
 #include <functional>
 #include <iostream>
 #include <limits>
 #include <map>
+#include <memory>
+#include <span>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "internal/dwt_kernels.h"
+#include "internal/dwt_transforms.h"
+#include "internal/matrix_cache.h"
 #include "wavelet_buffer/wavelet.h"
 #include "wavelet_buffer/wavelet_buffer.h"
 
@@ -16,96 +24,9 @@ namespace drift {
 namespace internal {
 
 /**
- * build-in cache
+ * Matrices of the matrix engine shared by all plans
  */
-
-class WaveletMatrixCache {
- public:
-  using WaveletMatrixStack =
-      std::vector<std::vector<blaze::CompressedMatrix<DataType>>>;
-
-  using WaveletMatrixStackCache =
-      std::map<WaveletParameters, WaveletMatrixStack>;
-
- public:
-  /**
-   * Lookup for Daubechies matrices in cache and insert new one if not found
-   * @param padded_shape
-   * @param parameters
-   * @return matrices
-   */
-  const WaveletMatrixStack &GenerateMatrices(
-      const SignalShape &padded_shape, const WaveletParameters &parameters) {
-    std::lock_guard lock(mutex_);
-
-    auto it = cache_.find(parameters);
-    if (it != cache_.end()) {
-      return it->second;
-    }
-
-    WaveletMatrixStack stack(parameters.decomposition_steps);
-    for (int step = 0; step < parameters.decomposition_steps; ++step) {
-      stack[step].resize(padded_shape.size());
-      const size_t wavelet_degree = parameters.wavelet_type * 2;
-      for (int dim_index = 0; dim_index < padded_shape.size(); dim_index++) {
-        const auto matrix_size =
-            CalculateDecompositionSizeForStep(padded_shape[dim_index], step);
-        stack[step][dim_index] =
-            wavelet::DaubechiesMat(matrix_size, wavelet_degree);
-      }
-    }
-
-    auto [inserted_it, inserted] = cache_.insert({parameters, stack});
-    return inserted_it->second;
-  }
-
-  /**
-   * Lookup for Daubechies matrices in cache and insert new one if not found
-   * @param padded_shape
-   * @param parameters
-   * @return transposed matrices
-   */
-  const WaveletMatrixStack &GenerateTransMatrices(
-      const SignalShape &padded_shape, const WaveletParameters &parameters) {
-    std::lock_guard lock(trans_mutex_);
-
-    auto it = trans_cache_.find(parameters);
-    if (it != trans_cache_.end()) {
-      return it->second;
-    }
-
-    // create copy
-    WaveletMatrixStack stack = GenerateMatrices(padded_shape, parameters);
-    for (auto &dim_stack : stack) {
-      for (auto &matrix : dim_stack) {
-        blaze::transpose(matrix);
-      }
-    }
-
-    auto [inserted_it, inserted] = trans_cache_.insert({parameters, stack});
-    return inserted_it->second;
-  }
-
- private:
-  /**
-   * @brief Calculate the Decomposition size for a specific step
-   *
-   * @param padded_size size of the input for the step
-   * @param step  the step
-   * @return MatrixSize the size for decomposition
-   */
-  [[nodiscard]] static size_t CalculateDecompositionSizeForStep(
-      size_t padded_size, int step) {
-    return static_cast<size_t>(padded_size / std::pow(2, step));
-  }
-
-  WaveletMatrixStackCache cache_;
-  WaveletMatrixStackCache trans_cache_;
-  std::mutex mutex_;
-  std::mutex trans_mutex_;
-};
-
-static WaveletMatrixCache matrix_cache;
+static MatrixCache matrix_cache;
 
 /**
  * @brief Calculate the maximum possible decomposition steps depending on the
@@ -159,69 +80,884 @@ SignalShape CalcPaddedSize(WaveletTypes wavelet_type,
   }
 }
 
+SignalShape CalcPaddedSize(const WaveletParameters &parameters) {
+  if (parameters.boundary_mode == BoundaryMode::kOddLength) {
+    return parameters.signal_shape;
+  }
+  return CalcPaddedSize(parameters.wavelet_type, parameters.signal_shape,
+                        parameters.decomposition_steps);
+}
+
+/**
+ * Matrices of a step of the matrix engine: for the rows and the columns of
+ * a 2D signal or the filters of a 1D one
+ */
+using WaveletMatrices = std::vector<MatrixCache::Handle>;
+
+/**
+ * Filters of the wavelet for the filter bank engine
+ * @param wavelet_type
+ * @return empty filters for kNone
+ */
+static wavelet::FilterBank MakeFilterBank(WaveletTypes wavelet_type) {
+  if (wavelet_type == kNone) {
+    return {};
+  }
+  return wavelet::DaubechiesFilters(wavelet_type * 2);
+}
+
+/**
+ * Lifting scheme of the wavelet for the lifting engine
+ * @param wavelet_type
+ * @return empty scheme for kNone
+ */
+static wavelet::LiftingScheme MakeLiftingScheme(WaveletTypes wavelet_type) {
+  if (wavelet_type == kNone) {
+    return {};
+  }
+  return wavelet::DaubechiesLifting(wavelet_type * 2);
+}
+
+/**
+ * Call a function with the compile-time taps of a wavelet type, the kernels
+ * are instantiated with constant taps
+ * @return false if there are no such taps for the type
+ */
+template <typename Func>
+static bool VisitStaticTaps(WaveletTypes wavelet_type, Func &&func) {
+  using wavelet::internal::StaticTaps;
+  switch (wavelet_type) {
+    case kDB1:
+      func(StaticTaps<kDB1>{});
+      return true;
+    case kDB2:
+      func(StaticTaps<kDB2>{});
+      return true;
+    case kDB3:
+      func(StaticTaps<kDB3>{});
+      return true;
+    case kDB4:
+      func(StaticTaps<kDB4>{});
+      return true;
+    case kDB5:
+      func(StaticTaps<kDB5>{});
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * Operators of the selected engine for all steps of the transform
+ */
+struct EngineOperators {
+  wavelet::Engine engine;
+  WaveletTypes wavelet_type;
+  size_t dimension;
+  std::vector<WaveletMatrices> matrices; /**< per step, kMatrix only */
+  wavelet::FilterBank filters;           /**< kFilterBank only */
+  wavelet::LiftingScheme lifting;        /**< kLifting only */
+
+  /**
+   * Call a function with the operators of the engine, the engine, the
+   * wavelet type and the dimension are dispatched once per call. The filter
+   * bank engine gets StaticTaps if there are some for the wavelet
+   */
+  template <typename Func>
+  void Visit(Func &&func) const {
+    switch (engine) {
+      case wavelet::Engine::kMatrix:
+        func(matrices);
+        break;
+      case wavelet::Engine::kLifting:
+        func(lifting);
+        break;
+      default:
+        if (!VisitStaticTaps(wavelet_type, func)) {
+          func(filters);
+        }
+    }
+  }
+};
+
+/**
+ * Operator of a step: the matrices are built for every step, other
+ * operators are the same for all steps
+ */
+static const WaveletMatrices &StepOperator(
+    const std::vector<WaveletMatrices> &matrices, int step) {
+  return matrices[step];
+}
+
+template <typename Operator>
+static const Operator &StepOperator(const Operator &wavelet_operator, int) {
+  return wavelet_operator;
+}
+
+/**
+ * Prepare operators of the engine
+ * @param params
+ * @param engine
+ * @param inverse true for composition
+ * @return
+ */
+static EngineOperators MakeOperators(const WaveletParameters &params,
+                                     wavelet::Engine engine, bool inverse) {
+  EngineOperators operators{engine, params.wavelet_type, params.dimension()};
+  switch (engine) {
+    case wavelet::Engine::kMatrix: {
+      if (params.dimension() == 2) {
+        const auto padded_size =
+            CalcPaddedSize(params.wavelet_type, params.signal_shape,
+                           params.decomposition_steps);
+        operators.matrices.resize(params.decomposition_steps);
+        for (size_t step = 0; step < params.decomposition_steps; ++step) {
+          for (const size_t size : padded_size) {
+            operators.matrices[step].push_back(
+                matrix_cache.Get(size >> step, params.wavelet_type, inverse));
+          }
+        }
+      } else {
+        /* Put decompose or compose vectors for 1D */
+        const auto filters = MakeFilterBank(params.wavelet_type);
+        blaze::CompressedMatrix<DataType> dmat(2, filters.low_pass.size());
+        if (inverse) {
+          blaze::row(dmat, 0) = blaze::trans(blaze::reverse(filters.low_pass));
+          blaze::row(dmat, 1) =
+              blaze::trans(blaze::reverse(filters.high_pass));
+        } else {
+          blaze::row(dmat, 0) = blaze::trans(filters.low_pass);
+          blaze::row(dmat, 1) = blaze::trans(filters.high_pass);
+        }
+        operators.matrices.assign(
+            params.decomposition_steps,
+            {std::make_shared<const MatrixCache::Matrix>(std::move(dmat))});
+      }
+      break;
+    }
+    case wavelet::Engine::kLifting:
+      operators.lifting = MakeLiftingScheme(params.wavelet_type);
+      break;
+    default:
+      operators.filters = MakeFilterBank(params.wavelet_type);
+  }
+  return operators;
+}
+
+std::shared_ptr<const EngineOperators> MakeEngineOperators(
+    const WaveletParameters &parameters, wavelet::Engine engine,
+    bool inverse) {
+  return std::make_shared<const EngineOperators>(
+      MakeOperators(parameters, engine, inverse));
+}
+
+/**
+ * Single transform of the matrix engine, the first matrix is for rows
+ * (or 1D signal), the second one is for columns. The products run in the
+ * calling thread, with a pool only the channels and the denoising of the
+ * details are concurrent
+ */
+static auto Dwt1D(const Signal1D &signal, const WaveletMatrices &matrices) {
+  return wavelet::dwt(signal, *matrices[0]);
+}
+
+static auto Dwt2D(const Signal2D &signal, const WaveletMatrices &matrices) {
+  return wavelet::dwt2(signal, *matrices[0], *matrices[1]);
+}
+
+static auto Idwt1D(const Signal1D &low, const Signal1D &high,
+                   const WaveletMatrices &matrices) {
+  return wavelet::idwt(low, high, *matrices[0]);
+}
+
+static auto Idwt2D(const Signal2D &ll, const Signal2D &lh, const Signal2D &hl,
+                   const Signal2D &hh, const WaveletMatrices &matrices) {
+  return wavelet::idwt2(ll, lh, hl, hh, *matrices[0], *matrices[1]);
+}
+
+/**
+ * Single transform of the filter bank engine
+ */
+static auto Dwt1D(const Signal1D &signal, const wavelet::FilterBank &filters) {
+  return wavelet::dwt(signal, filters);
+}
+
+static auto Idwt1D(const Signal1D &low, const Signal1D &high,
+                   const wavelet::FilterBank &filters) {
+  return wavelet::idwt(low, high, filters);
+}
+
+static auto Idwt2D(const Signal2D &ll, const Signal2D &lh, const Signal2D &hl,
+                   const Signal2D &hh, const wavelet::FilterBank &filters,
+                   ThreadPool *pool) {
+  return wavelet::idwt2(ll, lh, hl, hh, filters, pool);
+}
+
+/**
+ * Single inverse transform of the lifting engine
+ */
+static auto Idwt1D(const Signal1D &low, const Signal1D &high,
+                   const wavelet::LiftingScheme &scheme) {
+  return wavelet::idwt(low, high, scheme);
+}
+
+static auto Idwt2D(const Signal2D &ll, const Signal2D &lh, const Signal2D &hl,
+                   const Signal2D &hh, const wavelet::LiftingScheme &scheme,
+                   ThreadPool *pool) {
+  return wavelet::idwt2(ll, lh, hl, hh, scheme, pool);
+}
+
+/**
+ * Denoise the three details of a 2D step, concurrently if they are big
+ * @param dest the first detail
+ * @param denoiser
+ * @param step
+ * @param pool
+ */
+static void DenoiseDetails2D(WaveletDecomposition::Iterator dest,
+                             const DenoiseAlgorithm<DataType> &denoiser,
+                             const size_t step, ThreadPool *pool) {
+  wavelet::internal::ForEachBlock(
+      pool, dest->rows() * dest->columns() * 3, 3, 1, nullptr,
+      [&](size_t begin, size_t end, Workspace *scratch) {
+        for (size_t i = begin; i < end; ++i) {
+          denoiser.DenoiseInPlace(*(dest + i), step, scratch);
+        }
+      });
+}
+
 /**
  * Apply wavelet transformation once on 2D signal
+ * @tparam Operator matrices or filters of the engine
  * @param dest - destination subband iterator
  * @param denoiser
- * @param wavelet_matrix_w
- * @param wavelet_matrix_h
+ * @param wavelet_operator
  * @param signal
+ * @param step
+ * @param pool threads denoising the details of a big image
  */
-static void CalculateOneSideStep2D(
-    WaveletDecomposition::Iterator dest,
-    const DenoiseAlgorithm<DataType> &denoiser,
-    const std::vector<blaze::CompressedMatrix<DataType>> &wavelet_matrix,
-    Signal2D *signal, const size_t step = 0) {
-  auto [cA, cH, cV, cD] =
-      wavelet::dwt2(*signal, wavelet_matrix[0], wavelet_matrix[1]);
-
-  *(dest + 0) = denoiser.Denoise(cH, step);
-  *(dest + 1) = denoiser.Denoise(cV, step);
-  *(dest + 2) = denoiser.Denoise(cD, step);
+template <typename Operator>
+static void CalculateOneSideStep2D(WaveletDecomposition::Iterator dest,
+                                   const DenoiseAlgorithm<DataType> &denoiser,
+                                   const Operator &wavelet_operator,
+                                   Signal2D *signal, const size_t step = 0,
+                                   ThreadPool *pool = nullptr) {
+  auto [cA, cH, cV, cD] = Dwt2D(*signal, wavelet_operator);
+
+  *(dest + 0) = std::move(cH);
+  *(dest + 1) = std::move(cV);
+  *(dest + 2) = std::move(cD);
+  DenoiseDetails2D(dest, denoiser, step, pool);
 
   std::swap(*signal, cA);
 }
 
 /**
  * Apply wavelet transformation once on 1D signal
+ * @tparam Operator matrices or filters of the engine
  * @param dest
  * @param denoiser
- * @param wavelet_matrix
+ * @param wavelet_operator
  * @param signal
  */
-static void CalculateOneSideStep1D(
-    WaveletDecomposition::Iterator dest,
-    const DenoiseAlgorithm<DataType> &denoiser,
-    const std::vector<blaze::CompressedMatrix<DataType>> &wavelet_matrix,
-    Signal2D *signal, const size_t step = 0) {
+template <typename Operator>
+static void CalculateOneSideStep1D(WaveletDecomposition::Iterator dest,
+                                   const DenoiseAlgorithm<DataType> &denoiser,
+                                   const Operator &wavelet_operator,
+                                   Signal2D *signal, const size_t step = 0) {
   auto [low_subband, high_subband] =
-      drift::wavelet::dwt(blaze::column(*signal, 0), wavelet_matrix[0]);
+      Dwt1D(blaze::column(*signal, 0), wavelet_operator);
 
   // copy vector to subband matrix
-  Signal2D data(high_subband.size(), 1);
-  blaze::column(data, 0) = denoiser.Denoise(high_subband, step);
-  *(dest + 0) = data;
+  denoiser.DenoiseInPlace(high_subband, step);
+  dest->resize(high_subband.size(), 1, false);
+  blaze::column(*dest, 0) = high_subband;
 
   signal->resize(low_subband.size(), 1, true);
   blaze::column(*signal, 0) = low_subband;
 }
 
 /**
- * Facade method for different decomposition methods (1d, 2d..)
+ * Apply the filter bank once on 2D signal, the details are written straight
+ * into the decomposition
+ * @param dest - destination subband iterator
+ * @param denoiser
+ * @param filters
+ * @param signal
+ * @param step
+ * @param pool threads for a big image
+ */
+static void CalculateOneSideStep2D(WaveletDecomposition::Iterator dest,
+                                   const DenoiseAlgorithm<DataType> &denoiser,
+                                   const wavelet::FilterBank &filters,
+                                   Signal2D *signal, const size_t step = 0,
+                                   ThreadPool *pool = nullptr) {
+  Signal2D ll;
+  wavelet::dwt2(*signal, filters, &ll, &*(dest + 0), &*(dest + 1),
+                &*(dest + 2), pool);
+  DenoiseDetails2D(dest, denoiser, step, pool);
+
+  std::swap(*signal, ll);
+}
+
+/**
+ * Apply the lifting scheme once on 2D signal in place, only the LL part
+ * remains in the signal
+ * @param dest - destination subband iterator
+ * @param denoiser
+ * @param scheme
+ * @param signal
+ * @param step
+ * @param pool threads for a big image
+ * @param workspace scratch memory of the lines, nullptr to allocate it
+ */
+static void CalculateOneSideStep2D(WaveletDecomposition::Iterator dest,
+                                   const DenoiseAlgorithm<DataType> &denoiser,
+                                   const wavelet::LiftingScheme &scheme,
+                                   Signal2D *signal, const size_t step = 0,
+                                   ThreadPool *pool = nullptr,
+                                   Workspace *workspace = nullptr) {
+  Workspace local;
+  const auto view = wavelet::internal::ViewOf(*signal);
+  wavelet::internal::LiftImage(view, scheme, view,
+                               workspace ? workspace : &local, pool);
+
+  const size_t rows = signal->rows() / 2;
+  const size_t cols = signal->columns() / 2;
+  *(dest + 0) = blaze::submatrix(*signal, rows, 0, rows, cols);
+  *(dest + 1) = blaze::submatrix(*signal, 0, cols, rows, cols);
+  *(dest + 2) = blaze::submatrix(*signal, rows, cols, rows, cols);
+  DenoiseDetails2D(dest, denoiser, step, pool);
+
+  signal->resize(rows, cols, true);
+}
+
+/**
+ * Apply the lifting scheme once on 1D signal in place, only the low half
+ * remains in the signal
+ * @param dest
+ * @param denoiser
+ * @param scheme
+ * @param signal
+ * @param step
+ * @param workspace scratch memory of the line and the details, nullptr to
+ * allocate it
+ */
+static void CalculateOneSideStep1D(WaveletDecomposition::Iterator dest,
+                                   const DenoiseAlgorithm<DataType> &denoiser,
+                                   const wavelet::LiftingScheme &scheme,
+                                   Signal2D *signal, const size_t step = 0,
+                                   Workspace *workspace = nullptr) {
+  Workspace local;
+  auto *scratch = workspace ? workspace : &local;
+
+  /* The column is lifted where it lies */
+  const size_t half = signal->rows() / 2;
+  wavelet::internal::LiftLine({signal->data(), signal->spacing()},
+                              signal->rows(), scheme,
+                              {scratch->Allocate<DataType>(half), 1});
+
+  /* The details are denoised as a vector, the workspace keeps it between
+   * the calls */
+  auto &high = scratch->Object<Signal1D>();
+  high = blaze::subvector(blaze::column(*signal, 0), half, half);
+  denoiser.DenoiseInPlace(high, step, scratch);
+  dest->resize(half, 1, false);
+  blaze::column(*dest, 0) = high;
+
+  signal->resize(half, 1, true);
+}
+
+/**
+ * Apply the filter bank with compile-time taps once
+ * @param dimension
  * @param dest
  * @param denoiser
- * @param wavelet_matrix
+ * @param taps
  * @param signal
  */
+template <WaveletTypes W>
 static void CalculateOneSideStep(
     int dimension, WaveletDecomposition::Iterator dest,
     const DenoiseAlgorithm<DataType> &denoiser,
-    const std::vector<blaze::CompressedMatrix<DataType>> &wavelet_matrix,
-    Signal2D *signal, const size_t step = 0) {
+    const wavelet::internal::StaticTaps<W> &taps, Signal2D *signal,
+    const size_t step = 0, ThreadPool *pool = nullptr) {
   if (dimension == 1) {
-    CalculateOneSideStep1D(dest, denoiser, wavelet_matrix, signal, step);
+    Signal1D low_subband;
+    Signal1D high_subband;
+    wavelet::internal::Dwt(blaze::column(*signal, 0), taps, &low_subband,
+                           &high_subband);
+
+    // copy vector to subband matrix
+    denoiser.DenoiseInPlace(high_subband, step);
+    dest->resize(high_subband.size(), 1, false);
+    blaze::column(*dest, 0) = high_subband;
+
+    signal->resize(low_subband.size(), 1, false);
+    blaze::column(*signal, 0) = low_subband;
+  } else {
+    Signal2D ll;
+    wavelet::internal::Dwt2(*signal, taps, &ll, &*(dest + 0), &*(dest + 1),
+                            &*(dest + 2), pool);
+    DenoiseDetails2D(dest, denoiser, step, pool);
+
+    std::swap(*signal, ll);
+  }
+}
+
+/**
+ * Facade method for different decomposition methods (1d, 2d..)
+ * @param dest
+ * @param denoiser
+ * @param wavelet_operator
+ * @param signal
+ * @param workspace scratch memory of the lifting engine, the other engines
+ * allocate their own
+ */
+template <typename Operator>
+static void CalculateOneSideStep(int dimension,
+                                 WaveletDecomposition::Iterator dest,
+                                 const DenoiseAlgorithm<DataType> &denoiser,
+                                 const Operator &wavelet_operator,
+                                 Signal2D *signal, const size_t step = 0,
+                                 ThreadPool *pool = nullptr,
+                                 Workspace *workspace = nullptr) {
+  if constexpr (std::is_same_v<Operator, wavelet::LiftingScheme>) {
+    if (dimension == 1) {
+      CalculateOneSideStep1D(dest, denoiser, wavelet_operator, signal, step,
+                             workspace);
+    } else {
+      CalculateOneSideStep2D(dest, denoiser, wavelet_operator, signal, step,
+                             pool, workspace);
+    }
+  } else if (dimension == 1) {
+    CalculateOneSideStep1D(dest, denoiser, wavelet_operator, signal, step);
+  } else {
+    CalculateOneSideStep2D(dest, denoiser, wavelet_operator, signal, step,
+                           pool);
+  }
+}
+
+/**
+ * Taps of the filter bank engines for the kernels, other engines have no
+ * taps and don't use the workspace
+ */
+static wavelet::internal::FilterTaps TapsOf(
+    const wavelet::FilterBank &filters) {
+  return {filters.low_pass.data(), filters.high_pass.data(),
+          filters.low_pass.size()};
+}
+
+template <WaveletTypes W>
+static wavelet::internal::StaticTaps<W> TapsOf(
+    const wavelet::internal::StaticTaps<W> &taps) {
+  return taps;
+}
+
+/**
+ * Matrix in the memory of the workspace, its rows follow each other
+ */
+static wavelet::internal::MatrixView<DataType> WorkspaceMatrix(
+    Workspace *workspace, size_t rows, size_t columns) {
+  return {workspace->Allocate<DataType>(rows * columns), rows, columns,
+          columns};
+}
+
+/**
+ * Copy a matrix view into a subband, the memory of the subband is reused if
+ * it has the size
+ */
+static void CopyToSubband(wavelet::internal::MatrixView<const DataType> view,
+                          Subband *subband) {
+  subband->resize(view.rows, view.columns, false);
+  for (size_t i = 0; i < view.rows; ++i) {
+    std::copy_n(view.row(i), view.columns, subband->data(i));
+  }
+}
+
+/**
+ * View with the rows following each other, the matrix is copied into the
+ * workspace if it has a gap between the rows
+ */
+static wavelet::internal::MatrixView<const DataType> Contiguous(
+    wavelet::internal::MatrixView<const DataType> view, Workspace *workspace) {
+  if (view.spacing == view.columns) {
+    return view;
+  }
+
+  const auto copy = WorkspaceMatrix(workspace, view.rows, view.columns);
+  for (size_t i = 0; i < view.rows; ++i) {
+    std::copy_n(view.row(i), view.columns, copy.row(i));
+  }
+  return copy;
+}
+
+/**
+ * Call a function for the channels in [start, start + count), concurrently
+ * on the threads of the pool if it is given
+ * @param func function of the channel and the scratch memory of the thread,
+ * the memory is nullptr if there is neither a pool nor a workspace
+ */
+template <typename Func>
+static void ForEachChannel(ThreadPool *pool, Workspace *workspace,
+                           size_t start, size_t count, Func &&func) {
+  if (pool && pool->size() > 1 && count > 1) {
+    pool->ParallelFor(count, [&](size_t i, Workspace *scratch) {
+      func(start + i, scratch);
+      scratch->Reset();
+    });
+    return;
+  }
+
+  for (size_t ch = start; ch < start + count; ++ch) {
+    func(ch, workspace);
+    if (workspace) {
+      workspace->Reset();
+    }
+  }
+}
+
+/**
+ * Rows and columns of a signal shape as a matrix, 1D signals are columns
+ */
+static std::pair<size_t, size_t> MatrixSize(const SignalShape &shape) {
+  if (shape.size() > 1) {
+    return {shape[1], shape[0]};
+  }
+  return {shape[0], 1};
+}
+
+/**
+ * Padding of a side of the signal to the side of the transform, the filter
+ * bank kernels pad and crop the lines on the fly. The odd-length levels
+ * have no padding, an odd side is extended by its last sample
+ * @param params
+ * @param size the side of the signal
+ * @param padded the side of the transform
+ */
+static wavelet::internal::LinePadding SidePadding(
+    const WaveletParameters &params, size_t size, size_t padded) {
+  return {size, padded + padded % 2, (padded - size) / 2,
+          params.boundary_mode == BoundaryMode::kZeroPadding
+              ? wavelet::internal::Extension::kZero
+              : wavelet::internal::Extension::kEdge};
+}
+
+/**
+ * Check that the engine supports the boundary mode of the parameters, the
+ * odd-length mode has only the kernels of the filter bank
+ */
+static bool SupportsBoundaryMode(const WaveletParameters &parameters,
+                                 const EngineOperators &operators) {
+  bool has_taps = false;
+  operators.Visit([&](const auto &wavelet_operator) {
+    has_taps = requires { TapsOf(wavelet_operator); };
+  });
+  if (parameters.boundary_mode == BoundaryMode::kOddLength && !has_taps) {
+    std::cerr << "The odd-length boundary mode needs the filter bank engine"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Decompose a signal with the filter bank, the scratch memory is taken from
+ * the workspace and the subbands of the decomposition are written in place.
+ * The first step pads the signal on the fly, so no padded copy of it is
+ * made. The odd sides of the levels give ceil(size / 2) coefficients
+ * @param parameters
+ * @param taps
+ * @param signal the signal without padding
+ * @param padded_size the shape of the signal with padding
+ * @param denoiser
+ * @param decomposition the decomposition of the signal
+ * @param workspace
+ * @param pool threads for the levels of a big image
+ */
+template <typename Taps>
+static void DecomposeLevels(
+    const WaveletParameters &parameters, const Taps &taps,
+    wavelet::internal::MatrixView<const DataType> signal,
+    const SignalShape &padded_size,
+    const DenoiseAlgorithm<DataType> &denoiser,
+    WaveletDecomposition *decomposition, Workspace *workspace,
+    ThreadPool *pool = nullptr) {
+  using wavelet::internal::EvenPadding;
+
+  const int steps = parameters.decomposition_steps;
+  const auto padded = MatrixSize(padded_size);
+  const auto row_padding = SidePadding(parameters, signal.rows, padded.first);
+  const auto column_padding =
+      SidePadding(parameters, signal.columns, padded.second);
+
+  wavelet::internal::MatrixView<const DataType> low = signal;
+  if (parameters.dimension() == 1) {
+    /* The details are denoised as a vector, the workspace keeps it between
+     * the calls */
+    auto &high = workspace->Object<Signal1D>();
+    for (int step = 0; step < steps; ++step) {
+      const auto padding = step == 0 ? row_padding : EvenPadding(low.rows);
+      const size_t half = padding.padded / 2;
+      const auto next = WorkspaceMatrix(workspace, half, 1);
+      high.resize(half, false);
+      wavelet::internal::AnalyzePaddedLine({low.data, low.spacing}, padding,
+                                           taps, {next.data, 1},
+                                           {high.data(), 1});
+
+      denoiser.DenoiseInPlace(high, step, workspace);
+      auto &subband = (*decomposition)[step];
+      subband.resize(half, 1, false);
+      blaze::column(subband, 0) = high;
+      low = next;
+    }
+  } else {
+    /* The row pass of the first step is the biggest one, it runs on the
+     * rows of the signal only */
+    const auto scratch = WorkspaceMatrix(
+        workspace, std::max(signal.rows, row_padding.padded / 2),
+        column_padding.padded);
+    for (int step = 0; step < steps; ++step) {
+      const auto rows = step == 0 ? row_padding : EvenPadding(low.rows);
+      const auto columns =
+          step == 0 ? column_padding : EvenPadding(low.columns);
+      const size_t half_rows = rows.padded / 2;
+      const size_t half_columns = columns.padded / 2;
+      const auto next = WorkspaceMatrix(workspace, half_rows, half_columns);
+      auto dest = decomposition->begin() + step * 3;
+      for (int i = 0; i < 3; ++i) {
+        auto &subband = *(dest + i);
+        subband.resize(half_rows, half_columns, false);
+      }
+
+      wavelet::internal::AnalyzePaddedImage(
+          low, rows, columns, taps,
+          {scratch.data, low.rows, 2 * half_columns, 2 * half_columns}, next,
+          wavelet::internal::ViewOf(*(dest + 0)),
+          wavelet::internal::ViewOf(*(dest + 1)),
+          wavelet::internal::ViewOf(*(dest + 2)), pool);
+
+      /* The details are denoised concurrently, each with the workspace of
+       * its thread */
+      wavelet::internal::ForEachBlock(
+          pool, half_rows * half_columns * 3, 3, 1, workspace,
+          [&](size_t begin, size_t end, Workspace *scratch) {
+            for (size_t i = begin; i < end; ++i) {
+              denoiser.DenoiseInPlace(*(dest + i), step, scratch);
+            }
+          });
+      low = next;
+    }
+  }
+
+  CopyToSubband(low, &(*decomposition)[steps * SubbandsPerWaveletTransform(
+                                                   parameters)]);
+}
+
+/**
+ * Decompose one signal with the filter bank, the signal is read in place
+ */
+template <typename Taps>
+static void DecomposeChannel(const WaveletParameters &parameters,
+                             const SignalShape &padded_size, const Taps &taps,
+                             const Signal2D &signal,
+                             const DenoiseAlgorithm<DataType> &denoiser,
+                             WaveletDecomposition *decomposition,
+                             Workspace *workspace, ThreadPool *pool) {
+  /* The column of a 1D signal is copied into a line for the vectorized
+   * kernels */
+  auto view = wavelet::internal::ViewOf(signal);
+  if (parameters.dimension() == 1) {
+    view = Contiguous(view, workspace);
+  }
+
+  DecomposeLevels(parameters, taps, view, padded_size, denoiser,
+                  decomposition, workspace, pool);
+}
+
+/**
+ * Copy the center of a matrix view, the padding of both sides is cropped the
+ * same way as PaddingAlgorithm does
+ */
+static void CropCenter(wavelet::internal::MatrixView<const DataType> padded,
+                       wavelet::internal::MatrixView<DataType> out) {
+  const size_t row_0 = (padded.rows - out.rows) / 2;
+  const size_t column_0 = (padded.columns - out.columns) / 2;
+  for (size_t i = 0; i < out.rows; ++i) {
+    std::copy_n(padded.row(row_0 + i) + column_0, out.columns, out.row(i));
+  }
+}
+
+/**
+ * Compose one signal with the filter bank up to a step, the subbands are
+ * read in place and the scratch memory is taken from the workspace
+ *
+ * The levels write into two buffers in turns and the last level straight
+ * into the output, it computes only the samples of the output. So the peak
+ * memory is a quarter and a sixteenth of the approximation with padding and
+ * one scratch image of the output for the column pass
+ * @param params
+ * @param taps
+ * @param decomposition the decomposition of the signal
+ * @param steps the number of the steps to keep
+ * @param out the approximation without padding and not scaled, see
+ * ComposedSize
+ * @param workspace
+ * @param pool threads for the levels of a big image
+ */
+template <typename Taps>
+static void ComposeLevels(const WaveletParameters &params, const Taps &taps,
+                          const WaveletDecomposition &decomposition,
+                          size_t steps,
+                          wavelet::internal::MatrixView<DataType> out,
+                          Workspace *workspace, ThreadPool *pool = nullptr) {
+  const int subbands_per_wt = SubbandsPerWaveletTransform(params);
+  const bool is_1d = params.dimension() == 1;
+
+  /* The approximation is read from the decomposition on the first step */
+  wavelet::internal::MatrixView<const DataType> low = wavelet::internal::ViewOf(
+      decomposition[params.decomposition_steps * subbands_per_wt]);
+  const int levels = params.decomposition_steps - static_cast<int>(steps);
+  if (levels <= 0) {
+    CropCenter(low, out);
+    return;
+  }
+
+  /* Shape of the input of a step, the odd-length levels round up */
+  const auto coarse = low;
+  const auto signal = MatrixSize(params.signal_shape);
+  auto level_shape = [&](size_t step) -> std::pair<size_t, size_t> {
+    const size_t shift = params.decomposition_steps - step;
+    if (params.boundary_mode == BoundaryMode::kOddLength) {
+      auto side = [step](size_t size) {
+        return (size + (size_t{1} << step) - 1) >> step;
+      };
+      return {side(signal.first), is_1d ? 1 : side(signal.second)};
+    }
+    return {coarse.rows << shift, is_1d ? 1 : coarse.columns << shift};
+  };
+
+  /* The last level is cropped on the fly */
+  const auto [rows, columns] = level_shape(steps);
+  const auto row_padding = SidePadding(params, out.rows, rows);
+  const auto column_padding = SidePadding(params, out.columns, columns);
+
+  const auto [half_rows, half_columns] = level_shape(steps + 1);
+  const auto [quarter_rows, quarter_columns] =
+      levels > 1 ? level_shape(steps + 2) : std::pair<size_t, size_t>{0, 0};
+  DataType *buffers[2] = {
+      workspace->Allocate<DataType>(quarter_rows * quarter_columns),
+      workspace->Allocate<DataType>(half_rows * half_columns)};
+  /* The 1D kernels need lines: the approximation and the details of the
+   * levels are copied, the 2D kernels read the subbands with strides */
+  DataType *scratch = workspace->Allocate<DataType>(
+      is_1d ? row_padding.padded / 2
+            : std::max(out.rows, half_rows) * column_padding.padded);
+  if (is_1d && low.spacing != 1) {
+    DataType *line = buffers[levels % 2];
+    for (size_t i = 0; i < low.rows; ++i) {
+      line[i] = *low.row(i);
+    }
+    low = {line, low.rows, 1, 1};
+  }
+
+  for (int level = levels - 1; level > 0; --level) {
+    auto src = decomposition.begin() +
+               (static_cast<int>(steps) + level + 1) * subbands_per_wt;
+    const auto [next_rows, next_columns] = level_shape(steps + level);
+    const wavelet::internal::MatrixView<DataType> next{
+        buffers[level % 2], next_rows, next_columns, next_columns};
+    if (is_1d) {
+      const auto &high = *(src - 1);
+      for (size_t i = 0; i < high.rows(); ++i) {
+        scratch[i] = high(i, 0);
+      }
+      wavelet::internal::SynthesizeLine({low.data, 1}, {scratch, 1},
+                                        next.rows, taps, {next.data, 1});
+    } else {
+      wavelet::internal::SynthesizeImage(
+          low, wavelet::internal::ViewOf(*(src - 3)),
+          wavelet::internal::ViewOf(*(src - 2)),
+          wavelet::internal::ViewOf(*(src - 1)), taps,
+          {scratch, next.rows, 2 * low.columns, 2 * low.columns}, next,
+          pool);
+    }
+    low = next;
+  }
+
+  auto src = decomposition.begin() + (steps + 1) * subbands_per_wt;
+  if (is_1d) {
+    const auto &high = *(src - 1);
+    for (size_t i = 0; i < high.rows(); ++i) {
+      scratch[i] = high(i, 0);
+    }
+
+    /* A line of the padded length is merged and cropped, so the vectorized
+     * kernels merge the same pairs as for the whole line */
+    if (out.spacing == 1 && row_padding.offset == 0 &&
+        row_padding.size + 1 >= row_padding.padded) {
+      wavelet::internal::SynthesizeLine({low.data, 1}, {scratch, 1},
+                                        out.rows, taps, {out.data, 1});
+      return;
+    }
+    DataType *line = workspace->Allocate<DataType>(row_padding.padded);
+    wavelet::internal::SynthesizeLine({low.data, 1}, {scratch, 1},
+                                      row_padding.padded, taps, {line, 1});
+    for (size_t i = 0; i < out.rows; ++i) {
+      *out.row(i) = line[row_padding.offset + i];
+    }
   } else {
-    CalculateOneSideStep2D(dest, denoiser, wavelet_matrix, signal, step);
+    wavelet::internal::SynthesizeCroppedImage(
+        low, wavelet::internal::ViewOf(*(src - 3)),
+        wavelet::internal::ViewOf(*(src - 2)),
+        wavelet::internal::ViewOf(*(src - 1)), row_padding, column_padding,
+        taps, {scratch, out.rows, 2 * low.columns, 2 * low.columns}, out,
+        workspace, pool);
+  }
+}
+
+/**
+ * Shape of the composed signal as a matrix
+ * @param params
+ * @param steps the number of the steps to keep
+ */
+static std::pair<size_t, size_t> ComposedSize(const WaveletParameters &params,
+                                              size_t steps) {
+  const auto [rows, columns] = MatrixSize(params.signal_shape);
+  if (params.boundary_mode == BoundaryMode::kOddLength) {
+    /* The odd-length levels keep a coefficient for the last sample */
+    const size_t scale = size_t{1} << steps;
+    return {(rows + scale - 1) / scale, (columns + scale - 1) / scale};
+  }
+  if (params.dimension() > 1) {
+    return {static_cast<size_t>(rows / std::pow(2, steps)),
+            static_cast<size_t>(columns / std::pow(2, steps))};
+  }
+  return {static_cast<size_t>(rows / std::pow(2, steps)), 1};
+}
+
+/**
+ * Scale of the approximation after the composition up to a step
+ */
+static double ComposedScale(const WaveletParameters &params, size_t steps) {
+  return std::pow(params.dimension() == 2 ? 2 : std::sqrt(2), steps);
+}
+
+/**
+ * Compose one signal with the filter bank into a matrix without padding
+ * @param data the composed signal, its memory is reused if it has the size
+ */
+template <typename Taps>
+static void ComposeChannel(const WaveletParameters &params, const Taps &taps,
+                           const WaveletDecomposition &decomposition,
+                           size_t steps, Signal2D *data, Workspace *workspace,
+                           ThreadPool *pool) {
+  const auto [rows, columns] = ComposedSize(params, steps);
+  data->resize(rows, columns, false);
+  ComposeLevels(params, taps, decomposition, steps,
+                wavelet::internal::ViewOf(*data), workspace, pool);
+  if (steps > 0) {
+    *data /= ComposedScale(params, steps);
   }
 }
 
@@ -233,7 +969,22 @@ static void CalculateOneSideStep(
 bool DecomposeImpl(const WaveletParameters &parameters,
                    NWaveletDecomposition *decomposition, const SignalN2D &data,
                    const DenoiseAlgorithm<DataType> &denoiser,
-                   size_t start_signal, size_t signal_count) {
+                   size_t start_signal, size_t signal_count,
+                   wavelet::Engine engine) {
+  const auto padded_size = CalcPaddedSize(parameters);
+  const auto operators = MakeOperators(parameters, engine, false);
+
+  return DecomposeImpl(parameters, padded_size, operators, decomposition, data,
+                       denoiser, start_signal, signal_count, nullptr);
+}
+
+bool DecomposeImpl(const WaveletParameters &parameters,
+                   const SignalShape &padded_size,
+                   const EngineOperators &operators,
+                   NWaveletDecomposition *decomposition, const SignalN2D &data,
+                   const DenoiseAlgorithm<DataType> &denoiser,
+                   size_t start_signal, size_t signal_count,
+                   Workspace *workspace, ThreadPool *pool) {
   /* Check shape for 2D */
   if (parameters.dimension() == 2 &&
       (data.size() != signal_count ||
@@ -250,50 +1001,82 @@ bool DecomposeImpl(const WaveletParameters &parameters,
     return false;
   }
 
+  if (!SupportsBoundaryMode(parameters, operators)) {
+    return false;
+  }
+
   const int subbands_per_wt = SubbandsPerWaveletTransform(parameters);
-  const auto padded_size =
-      CalcPaddedSize(parameters.wavelet_type, parameters.signal_shape,
-                     parameters.decomposition_steps);
-
-  /* Get convolution matrix stack if needed */
-  std::vector<std::vector<blaze::CompressedMatrix<DataType>>>
-      wavelet_matrix_stack;
-  if (parameters.dimension() == 2) {
-    wavelet_matrix_stack =
-        matrix_cache.GenerateMatrices(padded_size, parameters);
-  }
-
-  /* Put decompose vectors for 1D */
-  blaze::DynamicVector<DataType> scale_filter;
-  if (parameters.wavelet_type != kNone) {
-    scale_filter = wavelet::dbwavf(parameters.wavelet_type);
-  }
-  const auto [lo_d, hi_d, lo_r, hi_r] = wavelet::Orthfilt(scale_filter);
-  blaze::CompressedMatrix<DataType> dmat(2, lo_d.size());
-  blaze::row(dmat, 0) = blaze::trans(blaze::reverse(lo_d));
-  blaze::row(dmat, 1) = blaze::trans(blaze::reverse(hi_d));
-
-  for (int ch = start_signal; ch < start_signal + signal_count; ++ch) {
-    auto channel = AddPadding(data[ch - start_signal], padded_size);
-
-    for (int step = 0; step < parameters.decomposition_steps; ++step) {
-      if (parameters.dimension() == 1) {
-        CalculateOneSideStep(
-            parameters.dimension(),
-            (*decomposition)[ch].begin() + step * subbands_per_wt, denoiser,
-            {dmat}, &channel, step);
+
+  /* The filter bank takes all scratch memory from the workspace, the
+   * padding included, the lifting engine its lines */
+  Workspace local;
+  if (!workspace) {
+    workspace = &local;
+  }
+
+  operators.Visit([&](const auto &wavelet_operator) {
+    auto decompose = [&](size_t ch, Workspace *scratch) {
+      if constexpr (requires { TapsOf(wavelet_operator); }) {
+        DecomposeChannel(parameters, padded_size, TapsOf(wavelet_operator),
+                         data[ch - start_signal], denoiser,
+                         &(*decomposition)[ch], scratch, pool);
       } else {
-        CalculateOneSideStep(
-            parameters.dimension(),
-            (*decomposition)[ch].begin() + step * subbands_per_wt, denoiser,
-            wavelet_matrix_stack[step], &channel, step);
+        auto channel = AddPadding(data[ch - start_signal], padded_size,
+                                  parameters.boundary_mode);
+        for (int step = 0; step < parameters.decomposition_steps; ++step) {
+          auto dest = (*decomposition)[ch].begin() + step * subbands_per_wt;
+          CalculateOneSideStep(parameters.dimension(), dest, denoiser,
+                               StepOperator(wavelet_operator, step), &channel,
+                               step, pool, scratch);
+        }
+        (*decomposition)[ch][parameters.decomposition_steps *
+                             subbands_per_wt] = channel;
       }
+    };
+    ForEachChannel(pool, workspace, start_signal, signal_count, decompose);
+  });
+
+  return true;
+}
+
+bool DecomposeImpl(const WaveletParameters &parameters,
+                   const SignalShape &padded_size,
+                   const EngineOperators &operators,
+                   NWaveletDecomposition *decomposition, size_t channel,
+                   std::span<const DataType> data,
+                   const DenoiseAlgorithm<DataType> &denoiser,
+                   Workspace *workspace) {
+  if (parameters.dimension() != 1 ||
+      data.size() != parameters.signal_shape[0]) {
+    std::cerr << "Invalid 1D signal shape" << std::endl;
+    return false;
+  }
+
+  bool decomposed = false;
+  operators.Visit([&](const auto &wavelet_operator) {
+    if constexpr (requires { TapsOf(wavelet_operator); }) {
+      Workspace local;
+      auto *scratch = workspace ? workspace : &local;
+
+      /* The signal is read in place */
+      DecomposeLevels(parameters, TapsOf(wavelet_operator),
+                      {data.data(), data.size(), 1, 1}, padded_size, denoiser,
+                      &(*decomposition)[channel], scratch);
+      scratch->Reset();
+      decomposed = true;
     }
-    (*decomposition)[ch][parameters.decomposition_steps * subbands_per_wt] =
-        channel;
+  });
+  if (decomposed) {
+    return true;
   }
 
-  return true;
+  /* Other engines transform matrices */
+  SignalN2D data2d = {Signal2D(data.size(), 1)};
+  for (size_t i = 0; i < data.size(); ++i) {
+    data2d[0](i, 0) = data[i];
+  }
+  return DecomposeImpl(parameters, padded_size, operators, decomposition,
+                       data2d, denoiser, channel, 1, workspace);
 }
 
 /**
@@ -303,139 +1086,679 @@ bool DecomposeImpl(const WaveletParameters &parameters,
  */
 void DecomposeImpl(WaveletParameters params,
                    NWaveletDecomposition *decomposition, int steps,
-                   const DenoiseAlgorithm<DataType> &denoiser) {
-  // setup the calculation matrices
-  auto wavelet_matrix_stack = matrix_cache.GenerateMatrices(
-      CalcPaddedSize(params.wavelet_type, params.signal_shape,
-                     params.decomposition_steps),
-      params);
+                   const DenoiseAlgorithm<DataType> &denoiser,
+                   wavelet::Engine engine) {
+  // setup the calculation matrices or filters
+  const auto operators = MakeOperators(params, engine, false);
 
   const int subbands_per_wt = SubbandsPerWaveletTransform(params);
 
   auto old_step_count = params.decomposition_steps - steps;
 
-  for (int channel = 0; channel < params.signal_number; ++channel) {
-    // grab last subband from original and continue the decomposition
-    Signal2D remainder =
-        (*decomposition)[channel][old_step_count * subbands_per_wt];
-
-    for (int additional_step = 0; additional_step < steps; ++additional_step) {
-      const int step = additional_step + old_step_count;
-      CalculateOneSideStep(
-          params.dimension(),
-          (*decomposition)[channel].begin() + step * subbands_per_wt, denoiser,
-          wavelet_matrix_stack[step], &remainder, step);
+  operators.Visit([&](const auto &wavelet_operator) {
+    for (int channel = 0; channel < params.signal_number; ++channel) {
+      // grab last subband from original and continue the decomposition
+      Signal2D remainder =
+          (*decomposition)[channel][old_step_count * subbands_per_wt];
+
+      for (int additional_step = 0; additional_step < steps;
+           ++additional_step) {
+        const int step = additional_step + old_step_count;
+        auto dest = (*decomposition)[channel].begin() + step * subbands_per_wt;
+        CalculateOneSideStep(params.dimension(), dest, denoiser,
+                             StepOperator(wavelet_operator, step), &remainder,
+                             step);
+      }
+      (*decomposition)[channel][params.decomposition_steps * subbands_per_wt] =
+          remainder;
     }
-    (*decomposition)[channel][params.decomposition_steps * subbands_per_wt] =
-        remainder;
-  }
+  });
 }
 
 /**
  * Single composition step
+ * @tparam Operator matrices or filters of the engine
  * @param low
  * @param src
- * @param wavelet_mat
+ * @param wavelet_operator
+ * @param pool threads for a big image
  * @return
  */
+template <typename Operator>
 blaze::DynamicMatrix<DataType> ComposeStep(
     int dimension, const blaze::DynamicMatrix<DataType> &low,
     typename WaveletDecomposition::ConstIterator src,
-    const std::vector<blaze::CompressedMatrix<DataType>> &wavelet_mat) {
+    const Operator &wavelet_operator, ThreadPool *pool = nullptr) {
+  /* Subbands are dense matrices already, they are read in place */
   if (dimension == 1) {
-    const auto high = static_cast<blaze::DynamicMatrix<DataType>>(*(src - 1));
-    auto result = drift::wavelet::idwt(blaze::column(low, 0),
-                                       blaze::column(high, 0), wavelet_mat[0]);
+    const auto &high = *(src - 1);
+    auto result = Idwt1D(blaze::column(low, 0), blaze::column(high, 0),
+                         wavelet_operator);
     blaze::DynamicMatrix<DataType> data(result.size(), 1);
     blaze::column(data, 0) = result;
     return data;
   }
 
-  return wavelet::idwt2(low,
-                        static_cast<blaze::DynamicMatrix<DataType>>(*(src - 3)),
-                        static_cast<blaze::DynamicMatrix<DataType>>(*(src - 2)),
-                        static_cast<blaze::DynamicMatrix<DataType>>(*(src - 1)),
-                        wavelet_mat[0], wavelet_mat[1]);
+  if constexpr (std::is_same_v<Operator, WaveletMatrices>) {
+    return Idwt2D(low, *(src - 3), *(src - 2), *(src - 1), wavelet_operator);
+  } else {
+    return Idwt2D(low, *(src - 3), *(src - 2), *(src - 1), wavelet_operator,
+                  pool);
+  }
+}
+
+/**
+ * Single composition step of the filter bank with compile-time taps
+ */
+template <WaveletTypes W>
+blaze::DynamicMatrix<DataType> ComposeStep(
+    int dimension, const blaze::DynamicMatrix<DataType> &low,
+    typename WaveletDecomposition::ConstIterator src,
+    const wavelet::internal::StaticTaps<W> &taps, ThreadPool *pool = nullptr) {
+  if (dimension == 1) {
+    const auto &high = *(src - 1);
+    auto result = wavelet::internal::Idwt(blaze::column(low, 0),
+                                          blaze::column(high, 0), taps);
+    blaze::DynamicMatrix<DataType> data(result.size(), 1);
+    blaze::column(data, 0) = result;
+    return data;
+  } else {
+    return wavelet::internal::Idwt2(low, *(src - 3), *(src - 2), *(src - 1),
+                                    taps, pool);
+  }
 }
 
 NWaveletDecomposition ComposeImpl(const WaveletParameters &params,
                                   const NWaveletDecomposition &decomposition,
                                   size_t steps, size_t start_channel,
-                                  size_t count) {
-  NWaveletDecomposition subbands(count);
+                                  size_t count, wavelet::Engine engine) {
+  return ComposeImpl(params, MakeOperators(params, engine, true),
+                     decomposition, steps, start_channel, count);
+}
+
+/**
+ * Compose the padded approximation of one signal up to a step, the subbands
+ * are read in place
+ * @tparam Operator matrices or filters of the engine
+ * @param pool threads for the steps of a big image
+ */
+template <typename Operator>
+static Signal2D ComposeApproximation(const WaveletParameters &params,
+                                     const Operator &wavelet_operator,
+                                     const WaveletDecomposition &decomposition,
+                                     size_t steps,
+                                     ThreadPool *pool = nullptr) {
+  const auto subbands_per_wt = internal::SubbandsPerWaveletTransform(params);
 
-  /* Get convolution matrix stack if needed */
-  std::vector<std::vector<blaze::CompressedMatrix<DataType>>>
-      wavelet_matrix_stack;
-  if (params.dimension() == 2) {
-    wavelet_matrix_stack = matrix_cache.GenerateTransMatrices(
-        CalcPaddedSize(params.wavelet_type, params.signal_shape,
-                       params.decomposition_steps),
-        params);
+  /* Convert sparse matrix with image to dense */
+  auto channel = static_cast<blaze::DynamicMatrix<DataType>>(
+      decomposition[params.decomposition_steps * subbands_per_wt]);
+  for (int i = params.decomposition_steps; i > steps; --i) {
+    auto src = decomposition.begin() + i * subbands_per_wt;
+    channel = ComposeStep(params.dimension(), channel, src,
+                          StepOperator(wavelet_operator, i - 1), pool);
   }
+  return channel;
+}
 
-  /* Put compose vectors for 1D */
-  blaze::DynamicVector<DataType> scale_filter;
-  if (params.wavelet_type != kNone) {
-    scale_filter = wavelet::dbwavf(params.wavelet_type);
+void ComposeApproximationImpl(
+    const WaveletParameters &params, const EngineOperators &operators,
+    const WaveletDecomposition &decomposition, const Signal2D &approximation,
+    size_t from, size_t to, Signal2D *result,
+    const std::function<void(size_t, const Signal2D &)> &on_level,
+    ThreadPool *pool) {
+  if (from <= to) {
+    *result = approximation;
+    return;
   }
-  const auto [lo_d, hi_d, lo_r, hi_r] = wavelet::Orthfilt(scale_filter);
-  blaze::CompressedMatrix<DataType> dmat(2, lo_d.size());
-  blaze::row(dmat, 0) = blaze::trans(blaze::reverse(lo_r));
-  blaze::row(dmat, 1) = blaze::trans(blaze::reverse(hi_r));
 
   const auto subbands_per_wt = internal::SubbandsPerWaveletTransform(params);
-  for (int ch = start_channel; ch < start_channel + count; ++ch) {
-    /* Convert sparse matrix with image to dense */
-    size_t sub_index = ch - start_channel;
-    subbands[sub_index] = decomposition[ch];
-    auto channel = static_cast<blaze::DynamicMatrix<DataType>>(
-        decomposition[ch][params.decomposition_steps * subbands_per_wt]);
-
-    for (int i = params.decomposition_steps; i > steps; --i) {
-      if (params.dimension() == 1) {
-        channel = ComposeStep(params.dimension(), channel,
-                              decomposition[ch].begin() + i * subbands_per_wt,
-                              {dmat});
-      } else {
-        channel = ComposeStep(params.dimension(), channel,
-                              decomposition[ch].begin() + i * subbands_per_wt,
-                              wavelet_matrix_stack[i - 1]);
+  operators.Visit([&](const auto &wavelet_operator) {
+    const Signal2D *low = &approximation;
+    for (size_t level = from; level > to; --level) {
+      auto src = decomposition.begin() + level * subbands_per_wt;
+      *result = ComposeStep(params.dimension(), *low, src,
+                            StepOperator(wavelet_operator, level - 1), pool);
+      low = result;
+      if (on_level) {
+        on_level(level - 1, *result);
       }
     }
+  });
+}
 
-    subbands[sub_index].resize(steps * subbands_per_wt + 1, true);
-    subbands[sub_index][subbands[sub_index].size() - 1] = channel;
+void CropApproximationImpl(const WaveletParameters &params,
+                           const Signal2D &approximation, size_t steps,
+                           Signal2D *data) {
+  const auto [rows, columns] = ComposedSize(params, steps);
+  const ConstSignal2DView view(approximation.data(), approximation.rows(),
+                               approximation.columns(),
+                               approximation.spacing());
+  Padding(rows, columns).Crop(view, data);
+  if (steps > 0) {
+    *data /= ComposedScale(params, steps);
   }
+}
+
+NWaveletDecomposition ComposeImpl(const WaveletParameters &params,
+                                  const EngineOperators &operators,
+                                  const NWaveletDecomposition &decomposition,
+                                  size_t steps, size_t start_channel,
+                                  size_t count) {
+  NWaveletDecomposition subbands(count);
+
+  const auto subbands_per_wt = internal::SubbandsPerWaveletTransform(params);
+  operators.Visit([&](const auto &wavelet_operator) {
+    for (int ch = start_channel; ch < start_channel + count; ++ch) {
+      /* Only the kept details are copied */
+      auto &result = subbands[ch - start_channel];
+      result.resize(steps * subbands_per_wt + 1, false);
+      std::copy_n(decomposition[ch].begin(), steps * subbands_per_wt,
+                  result.begin());
+      result[result.size() - 1] = ComposeApproximation(
+          params, wavelet_operator, decomposition[ch], steps);
+    }
+  });
 
   return subbands;
 }
 
 bool ComposeImpl(const WaveletParameters &params, SignalN2D *data,
                  const NWaveletDecomposition &decomposition, size_t steps,
-                 size_t start_signal, size_t count) {
-  *data = SignalN2D(count, blaze::DynamicMatrix<DataType>());
+                 size_t start_signal, size_t count, wavelet::Engine engine) {
+  return ComposeImpl(params, MakeOperators(params, engine, true), data,
+                     decomposition, steps, start_signal, count, nullptr);
+}
 
-  auto subbands =
-      internal::ComposeImpl(params, decomposition, steps, start_signal, count);
+bool ComposeImpl(const WaveletParameters &params,
+                 const EngineOperators &operators, SignalN2D *data,
+                 const NWaveletDecomposition &decomposition, size_t steps,
+                 size_t start_signal, size_t count, Workspace *workspace,
+                 ThreadPool *pool) {
+  if (!SupportsBoundaryMode(params, operators)) {
+    return false;
+  }
 
-  // crop padding
-  SignalShape scaled_shape(params.signal_shape.size());
-  std::transform(params.signal_shape.begin(), params.signal_shape.end(),
-                 scaled_shape.begin(),
-                 [&steps](auto x) { return x / std::pow(2, steps); });
+  /* The signals of the last call are overwritten in place */
+  if (data->size() != count) {
+    data->resize(count, false);
+  }
+
+  const auto shape = ComposedSize(params, steps);
+  Workspace local;
+  operators.Visit([&](const auto &wavelet_operator) {
+    auto compose = [&](size_t ch, Workspace *scratch) {
+      auto &signal = (*data)[ch - start_signal];
+      if constexpr (requires { TapsOf(wavelet_operator); }) {
+        ComposeChannel(params, TapsOf(wavelet_operator), decomposition[ch],
+                       steps, &signal, scratch, pool);
+      } else {
+        // crop padding
+        signal = Padding(shape.first, shape.second)
+                     .Crop(ComposeApproximation(params, wavelet_operator,
+                                                decomposition[ch], steps,
+                                                pool));
+        if (steps > 0) {
+          signal /= ComposedScale(params, steps);
+        }
+      }
+    };
+    ForEachChannel(pool, workspace ? workspace : &local, start_signal, count,
+                   compose);
+  });
+
+  return true;
+}
+
+bool ComposeImpl(const WaveletParameters &params,
+                 const EngineOperators &operators, std::span<DataType> data,
+                 const NWaveletDecomposition &decomposition, size_t steps,
+                 size_t channel, Workspace *workspace) {
+  const size_t rows = ComposedSize(params, steps).first;
+  if (params.dimension() != 1 || data.size() != rows) {
+    std::cerr << "Invalid 1D signal shape" << std::endl;
+    return false;
+  }
+
+  bool composed = false;
+  operators.Visit([&](const auto &wavelet_operator) {
+    if constexpr (requires { TapsOf(wavelet_operator); }) {
+      Workspace local;
+      auto *scratch = workspace ? workspace : &local;
+
+      /* The signal is composed straight into the memory of the caller */
+      ComposeLevels(params, TapsOf(wavelet_operator), decomposition[channel],
+                    steps, {data.data(), rows, 1, 1}, scratch);
+      if (steps > 0) {
+        Signal2DView signal(data.data(), rows, 1);
+        signal /= ComposedScale(params, steps);
+      }
+      scratch->Reset();
+      composed = true;
+    }
+  });
+  if (composed) {
+    return true;
+  }
+
+  /* Other engines transform matrices */
+  SignalN2D data2d;
+  if (!ComposeImpl(params, operators, &data2d, decomposition, steps, channel,
+                   1)) {
+    return false;
+  }
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = data2d[0](i, 0);
+  }
+  return true;
+}
+
+/**
+ * Decompose the channels of 1D signals interleaved in the rows of a matrix
+ * with the filter bank, the kernels run across the channels like across the
+ * columns of an image
+ * @param signals the signals without padding, a row holds a sample of every
+ * channel
+ * @param padded_size the shape of a signal with padding
+ */
+template <typename Taps>
+static void DecomposeInterleavedLevels(
+    const WaveletParameters &parameters, const Taps &taps,
+    wavelet::internal::MatrixView<const DataType> signals,
+    const SignalShape &padded_size,
+    const DenoiseAlgorithm<DataType> &denoiser,
+    NWaveletDecomposition *decomposition, Workspace *workspace) {
+  const size_t channels = signals.columns;
+  const int steps = parameters.decomposition_steps;
+
+  /* The details are denoised as vectors, the workspace keeps one between
+   * the calls */
+  auto &line = workspace->Object<Signal1D>();
+  wavelet::internal::MatrixView<const DataType> low = signals;
+  for (int step = 0; step < steps; ++step) {
+    /* The first step pads the signals on the fly */
+    const auto padding =
+        step == 0 ? SidePadding(parameters, low.rows, padded_size[0])
+                  : wavelet::internal::EvenPadding(low.rows);
+    const size_t half = padding.padded / 2;
+    const auto next = WorkspaceMatrix(workspace, half, channels);
+    const auto high = WorkspaceMatrix(workspace, half, channels);
+    wavelet::internal::AnalyzePaddedColumns(
+        {low.data, low.spacing}, padding, channels, taps,
+        {next.data, channels}, {high.data, channels});
+
+    line.resize(half, false);
+    for (size_t ch = 0; ch < channels; ++ch) {
+      for (size_t i = 0; i < half; ++i) {
+        line[i] = high.row(i)[ch];
+      }
+      denoiser.DenoiseInPlace(line, step, workspace);
+      auto &subband = (*decomposition)[ch][step];
+      subband.resize(half, 1, false);
+      blaze::column(subband, 0) = line;
+    }
+    low = next;
+  }
+
+  for (size_t ch = 0; ch < channels; ++ch) {
+    auto &subband = (*decomposition)[ch][steps];
+    subband.resize(low.rows, 1, false);
+    for (size_t i = 0; i < low.rows; ++i) {
+      subband(i, 0) = low.row(i)[ch];
+    }
+  }
+}
+
+/**
+ * Compose the channels of 1D signals into the rows of a matrix with the
+ * filter bank, the subbands of the channels are interleaved level by level
+ * and the last level is cropped on the fly
+ * @param out the approximation without padding and not scaled, a row holds
+ * a sample of every channel
+ */
+template <typename Taps>
+static void ComposeInterleavedLevels(
+    const WaveletParameters &params, const Taps &taps,
+    const NWaveletDecomposition &decomposition, size_t steps,
+    wavelet::internal::MatrixView<DataType> out, Workspace *workspace) {
+  const size_t channels = decomposition.size();
+
+  /* Subband i of all channels as a matrix with a column per channel */
+  auto interleave = [&](size_t i) {
+    const size_t rows = decomposition[0][i].rows();
+    const auto matrix = WorkspaceMatrix(workspace, rows, channels);
+    for (size_t ch = 0; ch < channels; ++ch) {
+      const auto &subband = decomposition[ch][i];
+      for (size_t j = 0; j < rows; ++j) {
+        matrix.row(j)[ch] = subband(j, 0);
+      }
+    }
+    return matrix;
+  };
+
+  wavelet::internal::MatrixView<const DataType> low =
+      interleave(params.decomposition_steps);
+  if (params.decomposition_steps <= steps) {
+    CropCenter(low, out);
+    return;
+  }
+
+  for (int level = static_cast<int>(params.decomposition_steps) - 1;
+       level >= static_cast<int>(steps); --level) {
+    const auto high = interleave(level);
+    const size_t rows = params.boundary_mode == BoundaryMode::kOddLength
+                            ? ComposedSize(params, level).first
+                            : low.rows * 2;
+    if (level == static_cast<int>(steps)) {
+      wavelet::internal::SynthesizeCroppedColumns(
+          {low.data, low.spacing}, {high.data, high.spacing},
+          SidePadding(params, out.rows, rows), channels, taps,
+          {out.data, out.spacing});
+      return;
+    }
 
-  const auto factor =
-      std::pow(params.dimension() == 2 ? 2 : std::sqrt(2), steps);
-  for (int ch = 0; ch < count; ++ch) {
-    auto aprox = &subbands[ch][subbands[ch].size() - 1];
-    internal::CropPadding(aprox, scaled_shape);
-    if (steps > 0) {
-      *aprox /= factor;
+    const auto next = WorkspaceMatrix(workspace, rows, channels);
+    wavelet::internal::SynthesizeColumns(
+        {low.data, low.spacing}, {high.data, high.spacing}, next.rows,
+        channels, taps, {next.data, next.spacing});
+    low = next;
+  }
+}
+
+/**
+ * Check the shape of a matrix of interleaved 1D signals
+ */
+static bool IsInterleavedShape(const WaveletParameters &params, size_t rows,
+                               size_t columns) {
+  if (params.dimension() != 1 || rows != params.signal_shape[0] ||
+      columns != params.signal_number) {
+    std::cerr << "Invalid interleaved 1D signal shape" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool DecomposeInterleavedImpl(const WaveletParameters &parameters,
+                              const SignalShape &padded_size,
+                              const EngineOperators &operators,
+                              NWaveletDecomposition *decomposition,
+                              const Signal2D &data,
+                              const DenoiseAlgorithm<DataType> &denoiser,
+                              Workspace *workspace) {
+  if (!IsInterleavedShape(parameters, data.rows(), data.columns())) {
+    return false;
+  }
+
+  bool decomposed = false;
+  operators.Visit([&](const auto &wavelet_operator) {
+    if constexpr (requires { TapsOf(wavelet_operator); }) {
+      Workspace local;
+      auto *scratch = workspace ? workspace : &local;
+
+      /* The signals are read in place */
+      DecomposeInterleavedLevels(parameters, TapsOf(wavelet_operator),
+                                 wavelet::internal::ViewOf(data), padded_size,
+                                 denoiser, decomposition, scratch);
+      scratch->Reset();
+      decomposed = true;
+    }
+  });
+  if (decomposed) {
+    return true;
+  }
+
+  /* Other engines transform the channels one by one */
+  SignalN2D channels(data.columns());
+  for (size_t ch = 0; ch < channels.size(); ++ch) {
+    channels[ch].resize(data.rows(), 1);
+    blaze::column(channels[ch], 0) = blaze::column(data, ch);
+  }
+  return DecomposeImpl(parameters, padded_size, operators, decomposition,
+                       channels, denoiser, 0, channels.size(), workspace);
+}
+
+bool ComposeInterleavedImpl(const WaveletParameters &params,
+                            const EngineOperators &operators, Signal2D *data,
+                            const NWaveletDecomposition &decomposition,
+                            size_t steps, Workspace *workspace) {
+  const size_t rows = ComposedSize(params, steps).first;
+  if (params.dimension() != 1) {
+    std::cerr << "Invalid interleaved 1D signal shape" << std::endl;
+    return false;
+  }
+
+  bool composed = false;
+  operators.Visit([&](const auto &wavelet_operator) {
+    if constexpr (requires { TapsOf(wavelet_operator); }) {
+      Workspace local;
+      auto *scratch = workspace ? workspace : &local;
+
+      data->resize(rows, decomposition.size(), false);
+      ComposeInterleavedLevels(params, TapsOf(wavelet_operator), decomposition,
+                               steps, wavelet::internal::ViewOf(*data),
+                               scratch);
+      if (steps > 0) {
+        *data /= ComposedScale(params, steps);
+      }
+      scratch->Reset();
+      composed = true;
     }
-    (*data)[ch] = *aprox;
+  });
+  if (composed) {
+    return true;
   }
 
+  /* Other engines transform the channels one by one */
+  SignalN2D channels;
+  if (!ComposeImpl(params, operators, &channels, decomposition, steps, 0,
+                   decomposition.size())) {
+    return false;
+  }
+  data->resize(rows, channels.size(), false);
+  for (size_t ch = 0; ch < channels.size(); ++ch) {
+    blaze::column(*data, ch) = blaze::column(channels[ch], 0);
+  }
+  return true;
+}
+
+/**
+ * Samples [begin, begin + size) of a line of a level, the indexes are taken
+ * modulo the length of the line
+ */
+struct Window {
+  std::ptrdiff_t begin;
+  size_t size;
+};
+
+/**
+ * Window of the coefficients of the next level under the synthesis filters
+ */
+static Window CoefficientWindow(Window samples, size_t length) {
+  const auto [begin, size] = wavelet::internal::SynthesisSupport(
+      samples.begin, samples.size, length);
+  return {begin, size};
+}
+
+/**
+ * Copy a window of a subband into a dense matrix, the windows wrap around
+ * the sides of the subband
+ */
+static void CopyWindow(wavelet::internal::MatrixView<const DataType> subband,
+                       Window rows, Window columns, DataType *dst) {
+  auto wrap = [](std::ptrdiff_t index, size_t size) {
+    const auto n = static_cast<std::ptrdiff_t>(size);
+    return static_cast<size_t>(((index % n) + n) % n);
+  };
+
+  for (size_t i = 0; i < rows.size; ++i) {
+    const DataType *row =
+        subband.row(wrap(rows.begin + static_cast<std::ptrdiff_t>(i),
+                         subband.rows));
+    DataType *out = dst + i * columns.size;
+    size_t column = wrap(columns.begin, subband.columns);
+    for (size_t j = 0; j < columns.size; column = 0) {
+      const size_t run = std::min(columns.size - j, subband.columns - column);
+      std::copy_n(row + column, run, out + j);
+      j += run;
+    }
+  }
+}
+
+/**
+ * Compose a region of one signal with the filter bank, the windows of the
+ * levels are halved and grow by the support of the filters
+ * @param rows, columns the region in the approximation with padding at the
+ * level of the steps
+ * @param data the composed region, its memory is reused if it has the size
+ */
+template <typename Taps>
+static void ComposeRegionChannel(const WaveletParameters &params,
+                                 const Taps &taps,
+                                 const WaveletDecomposition &decomposition,
+                                 size_t steps, Window rows, Window columns,
+                                 Signal2D *data, Workspace *workspace) {
+  const int subbands_per_wt = SubbandsPerWaveletTransform(params);
+  const bool is_1d = params.dimension() == 1;
+  const size_t levels = params.decomposition_steps > steps
+                            ? params.decomposition_steps - steps
+                            : 0;
+
+  /* Windows of the levels from the region up to the approximation, a 1D
+   * signal has a single column */
+  std::vector<Window> row_windows = {rows};
+  std::vector<Window> column_windows = {columns};
+  for (size_t level = 0; level < levels; ++level) {
+    row_windows.push_back(CoefficientWindow(row_windows.back(), taps.length));
+    column_windows.push_back(
+        is_1d ? columns
+              : CoefficientWindow(column_windows.back(), taps.length));
+  }
+
+  const auto &approximation =
+      decomposition[params.decomposition_steps * subbands_per_wt];
+  DataType *low = workspace->Allocate<DataType>(row_windows.back().size *
+                                                column_windows.back().size);
+  CopyWindow(wavelet::internal::ViewOf(approximation), row_windows.back(),
+             column_windows.back(), low);
+
+  for (size_t level = levels; level-- > 0;) {
+    const Window in_rows = row_windows[level + 1];
+    const Window in_columns = column_windows[level + 1];
+    const Window out_rows = row_windows[level];
+    const Window out_columns = column_windows[level];
+    auto src = decomposition.begin() + (steps + level + 1) * subbands_per_wt;
+
+    /* The details are copied for the windows wrapping around the sides */
+    const size_t in_size = in_rows.size * in_columns.size;
+    DataType *details[3];
+    for (int i = 0; i < subbands_per_wt; ++i) {
+      details[i] = workspace->Allocate<DataType>(in_size);
+      CopyWindow(wavelet::internal::ViewOf(*(src - subbands_per_wt + i)),
+                 in_rows, in_columns, details[i]);
+    }
+
+    DataType *next =
+        workspace->Allocate<DataType>(out_rows.size * out_columns.size);
+    if (is_1d) {
+      wavelet::internal::SynthesizeSegment({low, 1}, {details[0], 1},
+                                           out_rows.begin, out_rows.size, 1,
+                                           taps, {next, 1});
+    } else {
+      /* Columns of the low and high halves, then the rows */
+      const size_t stride = in_columns.size;
+      DataType *half_low =
+          workspace->Allocate<DataType>(out_rows.size * stride);
+      DataType *half_high =
+          workspace->Allocate<DataType>(out_rows.size * stride);
+      wavelet::internal::SynthesizeSegment(
+          {low, stride}, {details[0], stride}, out_rows.begin, out_rows.size,
+          stride, taps, {half_low, stride});
+      wavelet::internal::SynthesizeSegment(
+          {details[1], stride}, {details[2], stride}, out_rows.begin,
+          out_rows.size, stride, taps, {half_high, stride});
+      for (size_t i = 0; i < out_rows.size; ++i) {
+        wavelet::internal::SynthesizeSegment(
+            {half_low + i * stride, 1}, {half_high + i * stride, 1},
+            out_columns.begin, out_columns.size, 1, taps,
+            {next + i * out_columns.size, 1});
+      }
+    }
+    low = next;
+  }
+
+  data->resize(rows.size, columns.size, false);
+  for (size_t i = 0; i < rows.size; ++i) {
+    std::copy_n(low + i * columns.size, columns.size, data->data(i));
+  }
+  if (steps > 0) {
+    *data /= ComposedScale(params, steps);
+  }
+}
+
+bool ComposeRegionImpl(const WaveletParameters &params,
+                       const SignalShape &padded_size, const Region &region,
+                       SignalN2D *data,
+                       const NWaveletDecomposition &decomposition,
+                       size_t steps, size_t start_signal, size_t count,
+                       Workspace *workspace, ThreadPool *pool) {
+  if (region.offset.size() != params.dimension() ||
+      region.size.size() != params.dimension()) {
+    std::cerr << "Invalid region dimension" << std::endl;
+    return false;
+  }
+  if (params.boundary_mode == BoundaryMode::kOddLength) {
+    std::cerr << "Region compose needs a padding boundary mode" << std::endl;
+    return false;
+  }
+
+  /* The region as a matrix, 1D signals are columns */
+  const bool is_1d = params.dimension() == 1;
+  const auto [rows, columns] = ComposedSize(params, steps);
+  const size_t row_offset = region.offset[is_1d ? 0 : 1];
+  const size_t row_size = region.size[is_1d ? 0 : 1];
+  const size_t column_offset = is_1d ? 0 : region.offset[0];
+  const size_t column_size = is_1d ? 1 : region.size[0];
+  if (row_size == 0 || column_size == 0 || row_offset + row_size > rows ||
+      column_offset + column_size > columns) {
+    std::cerr << "Region out of the signal" << std::endl;
+    return false;
+  }
+
+  /* The composed signal is cropped from the center of the approximation with
+   * padding, see ComposeChannel */
+  const size_t approximation_steps =
+      std::min(steps, params.decomposition_steps);
+  const auto [padded_rows, padded_columns] = MatrixSize(padded_size);
+  const Window row_window = {
+      static_cast<std::ptrdiff_t>(
+          ((padded_rows >> approximation_steps) - rows) / 2 + row_offset),
+      row_size};
+  const Window column_window = {
+      static_cast<std::ptrdiff_t>(
+          is_1d ? 0
+                : ((padded_columns >> approximation_steps) - columns) / 2 +
+                      column_offset),
+      column_size};
+
+  /* The regions of the last call are overwritten in place */
+  if (data->size() != count) {
+    data->resize(count, false);
+  }
+
+  Workspace local;
+  auto compose = [&](size_t ch, Workspace *scratch) {
+    auto &signal = (*data)[ch - start_signal];
+    auto compose_with = [&](const auto &taps) {
+      ComposeRegionChannel(params, taps, decomposition[ch], steps, row_window,
+                           column_window, &signal, scratch);
+    };
+    if (!VisitStaticTaps(params.wavelet_type, compose_with)) {
+      /* kNone has no steps, the region is copied */
+      compose_with(wavelet::internal::FilterTaps{});
+    }
+  };
+  ForEachChannel(pool, workspace ? workspace : &local, start_signal, count,
+                 compose);
   return true;
 }
 
@@ -444,6 +1767,35 @@ int SubbandsPerWaveletTransform(const WaveletParameters &parameters) {
 }
 }  // namespace internal
 
+void SetMatrixCacheLimit(size_t max_bytes) {
+  internal::matrix_cache.SetLimit(max_bytes);
+}
+
+void PrewarmMatrixCache(const WaveletParameters &parameters) {
+  if (parameters.dimension() != 2 ||
+      parameters.wavelet_type == WaveletTypes::kNone) {
+    return;
+  }
+
+  const auto padded_size = internal::CalcPaddedSize(
+      parameters.wavelet_type, parameters.signal_shape,
+      static_cast<int>(parameters.decomposition_steps));
+  for (size_t step = 0; step < parameters.decomposition_steps; ++step) {
+    for (const size_t size : padded_size) {
+      for (const bool transposed : {false, true}) {
+        internal::matrix_cache.Get(size >> step, parameters.wavelet_type,
+                                   transposed);
+      }
+    }
+  }
+}
+
+MatrixCacheStats GetMatrixCacheStats() {
+  const auto stats = internal::matrix_cache.stats();
+  return {stats.hits, stats.misses, stats.evictions, stats.entries,
+          stats.bytes};
+}
+
 DataType Distance(const WaveletBuffer &lhs, const WaveletBuffer &rhs) {
   const auto &lhs_par = lhs.parameters();
   const auto &rhs_par = rhs.parameters();
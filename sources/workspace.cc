@@ -0,0 +1,68 @@
+// Copyright 2023 PANDA GmbH
+
+#include "wavelet_buffer/workspace.h"
+
+#include <algorithm>
+
+namespace drift {
+
+/* Arrays start at a cache line, the rows of the kernels are aligned for the
+ * vectorized loads */
+static constexpr size_t kAlignment = 64;
+
+static size_t AlignUp(size_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+Workspace::Workspace(std::pmr::memory_resource* upstream)
+    : upstream_(upstream) {}
+
+Workspace::~Workspace() { Release(); }
+
+void* Workspace::AllocateBytes(size_t bytes) {
+  bytes = AlignUp(std::max<size_t>(bytes, 1));
+
+  if (blocks_.empty() || blocks_.back().size - used_ < bytes) {
+    /* Grow geometrically, a few blocks are enough for the first call */
+    const size_t last = blocks_.empty() ? 0 : blocks_.back().size;
+    const size_t size = std::max(bytes, 2 * last);
+    auto* data =
+        static_cast<std::byte*>(upstream_->allocate(size, kAlignment));
+    blocks_.push_back({data, size});
+    used_ = 0;
+  }
+
+  void* ptr = blocks_.back().data + used_;
+  used_ += bytes;
+  return ptr;
+}
+
+void Workspace::Reset() {
+  if (blocks_.size() > 1) {
+    /* Merge the blocks, the next call with the same sizes fits in one. The
+     * capacity doesn't shrink, so calls of different sizes fit as well */
+    const size_t size = capacity();
+    Release();
+    blocks_.push_back(
+        {static_cast<std::byte*>(upstream_->allocate(size, kAlignment)),
+         size});
+  }
+  used_ = 0;
+}
+
+size_t Workspace::capacity() const {
+  size_t size = 0;
+  for (const auto& block : blocks_) {
+    size += block.size;
+  }
+  return size;
+}
+
+void Workspace::Release() {
+  for (const auto& block : blocks_) {
+    upstream_->deallocate(block.data, block.size, kAlignment);
+  }
+  blocks_.clear();
+}
+
+}  // namespace drift
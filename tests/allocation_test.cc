@@ -0,0 +1,145 @@
+// Copyright 2023 PANDA GmbH
+
+/* A test binary of its own, it replaces the allocation functions of the C
+ * library for the whole process. The counters see operator new, its aligned
+ * overloads and the posix_memalign storage of Blaze, as they all end up in
+ * them. Only glibc is supported, it exports the functions to forward to.
+ * Memory mapped directly with mmap and the _aligned_malloc of MSVC aren't
+ * counted */
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include "wavelet_buffer/wavelet_plan.h"
+#include "wavelet_buffer/workspace.h"
+#include "signal_generators.h"
+
+using drift::DecompositionSize;
+using drift::DenoiseAlgorithm;
+using drift::NullDenoiseAlgorithm;
+using drift::NWaveletDecomposition;
+using drift::SignalN2D;
+using drift::SimpleDenoiseAlgorithm;
+using drift::ThresholdAbsDenoiseAlgorithm;
+using drift::WaveletDecomposition;
+using drift::WaveletParameters;
+using drift::WaveletPlan;
+using drift::WaveletTypes;
+using drift::Workspace;
+
+/* Allocations of the process */
+static std::atomic<size_t> heap_allocations = 0;
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *p);
+
+void *malloc(size_t size) {
+  ++heap_allocations;
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  ++heap_allocations;
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size) {
+  ++heap_allocations;
+  return __libc_realloc(p, size);
+}
+
+void free(void *p) { __libc_free(p); }
+
+void *memalign(size_t alignment, size_t size) {
+  ++heap_allocations;
+  return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+  ++heap_allocations;
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **p, size_t alignment, size_t size) {
+  ++heap_allocations;
+  if (alignment % sizeof(void *) != 0 ||
+      (alignment & (alignment - 1)) != 0) {
+    return EINVAL;
+  }
+  *p = __libc_memalign(alignment, size);
+  return *p ? 0 : ENOMEM;
+}
+}
+
+TEST_CASE("Heap allocation counters") {
+  struct alignas(128) Line {
+    float values[32];
+  };
+
+  /* A new expression may be elided, the pointers are kept till the check */
+  const size_t heap = heap_allocations;
+  auto object = std::make_unique<int>(0);
+  auto aligned_object = std::make_unique<Line>();
+  blaze::DynamicMatrix<float> matrix(16, 16);
+  const size_t allocations = heap_allocations - heap;
+  REQUIRE(allocations == 3);
+}
+
+TEST_CASE("Transforms with a workspace in the heap") {
+  const auto shape =
+      GENERATE(std::vector<size_t>{300}, std::vector<size_t>{100, 70});
+  const auto wavelet_type = GENERATE(WaveletTypes::kDB1, WaveletTypes::kDB3,
+                                     WaveletTypes::kDB5);
+  CAPTURE(shape, wavelet_type);
+
+  const WaveletParameters params{
+      .signal_shape = shape,
+      .signal_number = 2,
+      .decomposition_steps = 3,
+      .wavelet_type = wavelet_type,
+  };
+  const auto data = GenerateSignals(params.signal_number, shape.back(),
+                                    shape.size() > 1 ? shape[0] : 1);
+
+  const NullDenoiseAlgorithm<float> null_denoiser;
+  const ThresholdAbsDenoiseAlgorithm<float> threshold_denoiser(0.1, 0.5);
+  const SimpleDenoiseAlgorithm<float> simple_denoiser(0.5);
+  const DenoiseAlgorithm<float> *denoiser =
+      GENERATE_COPY(&null_denoiser, &threshold_denoiser, &simple_denoiser);
+
+  const WaveletPlan plan(params);
+  Workspace workspace;
+  NWaveletDecomposition decomposition(
+      params.signal_number, WaveletDecomposition(DecompositionSize(params)));
+  SignalN2D composed;
+  REQUIRE(plan.Decompose(data, *denoiser, &decomposition, 0,
+                         params.signal_number, &workspace));
+  REQUIRE(plan.Compose(decomposition, &composed, 0, 0, params.signal_number,
+                       &workspace));
+
+  SECTION("should not allocate after the first call") {
+    /* Nothing is checked inside the loop, the assertions may allocate */
+    const size_t heap = heap_allocations;
+    bool succeeded = true;
+    for (int i = 0; i < 3; ++i) {
+      succeeded &= plan.Decompose(data, *denoiser, &decomposition, 0,
+                                  params.signal_number, &workspace);
+      succeeded &= plan.Compose(decomposition, &composed, 0, 0,
+                                params.signal_number, &workspace);
+    }
+    const size_t heap_after = heap_allocations;
+
+    REQUIRE(succeeded);
+    REQUIRE(heap_after == heap);
+  }
+}
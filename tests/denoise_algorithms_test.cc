@@ -90,4 +90,50 @@ TEST_CASE("Denoise Algorithms") {
       }
     }
   }
+  SECTION("In place denoising should give the same values") {
+    const drift::NullDenoiseAlgorithm<float> null_denoiser;
+    const drift::SimpleDenoiseAlgorithm<float> simple(0.8);
+    const drift::ThresholdAbsDenoiseAlgorithm<float> threshold(-1.2, 40);
+    for (const drift::DenoiseAlgorithm<float> *denoiser :
+         {static_cast<const drift::DenoiseAlgorithm<float> *>(&null_denoiser),
+          static_cast<const drift::DenoiseAlgorithm<float> *>(&simple),
+          static_cast<const drift::DenoiseAlgorithm<float> *>(&threshold)}) {
+      /* With the scratch memory of a workspace and of the call */
+      drift::Workspace workspace;
+      drift::Workspace *no_workspace = nullptr;
+      for (auto *scratch : {&workspace, no_workspace}) {
+        auto source_2d = kSource2D;
+        denoiser->DenoiseInPlace(source_2d, 3, scratch);
+        REQUIRE(source_2d == denoiser->Denoise(kSource2D, 3));
+
+        auto source_1d = kSource1D;
+        denoiser->DenoiseInPlace(source_1d, 3, scratch);
+        REQUIRE(source_1d == denoiser->Denoise(kSource1D, 3));
+        workspace.Reset();
+      }
+    }
+  }
+  SECTION("In place denoising should fall back to Denoise") {
+    /* Implements only the API returning the signals */
+    class HalfDenoiseAlgorithm : public drift::DenoiseAlgorithm<float> {
+     public:
+      Signal1D Denoise(const Signal1D &data,
+                       const size_t step = 0) const override {
+        return data / 2;
+      }
+      Signal2D Denoise(const Signal2D &data,
+                       const size_t step = 0) const override {
+        return data / 2;
+      }
+    };
+
+    const HalfDenoiseAlgorithm denoiser;
+    auto source_2d = kSource2D;
+    denoiser.DenoiseInPlace(source_2d);
+    REQUIRE(source_2d == kSource2D / 2);
+
+    auto source_1d = kSource1D;
+    denoiser.DenoiseInPlace(source_1d, 1);
+    REQUIRE(source_1d == kSource1D / 2);
+  }
 }
@@ -0,0 +1,312 @@
+// Copyright 2023 PANDA GmbH
+
+#include "internal/dwt_kernels.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_template_test_macros.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include "internal/dwt_simd.h"
+#include "wavelet_buffer/wavelet.h"
+
+using drift::DataType;
+using drift::kDB1;
+using drift::kDB2;
+using drift::kDB3;
+using drift::kDB4;
+using drift::kDB5;
+using drift::Signal1D;
+using drift::wavelet::DaubechiesFilters;
+using drift::wavelet::internal::AnalyzeColumns;
+using drift::wavelet::internal::AnalyzeColumnSegment;
+using drift::wavelet::internal::AnalyzeLine;
+using drift::wavelet::internal::AnalyzePaddedColumns;
+using drift::wavelet::internal::AnalyzePaddedLine;
+using drift::wavelet::internal::AnalyzeSegment;
+using drift::wavelet::internal::Extension;
+using drift::wavelet::internal::FilterTaps;
+using drift::wavelet::internal::kSimdBlock;
+using drift::wavelet::internal::LinePadding;
+using drift::wavelet::internal::StaticTaps;
+using drift::wavelet::internal::SynthesizeColumns;
+using drift::wavelet::internal::SynthesizeCroppedColumns;
+using drift::wavelet::internal::SynthesizeLine;
+
+TEMPLATE_TEST_CASE("Static taps match DaubechiesFilters", "[wavelet]",
+                   StaticTaps<kDB1>, StaticTaps<kDB2>, StaticTaps<kDB3>,
+                   StaticTaps<kDB4>, StaticTaps<kDB5>) {
+  const auto filters = DaubechiesFilters(TestType::length);
+  REQUIRE(filters.low_pass.size() == TestType::length);
+  for (size_t k = 0; k < TestType::length; ++k) {
+    REQUIRE(TestType::low[k] == filters.low_pass[k]);
+    REQUIRE(TestType::high[k] == filters.high_pass[k]);
+  }
+
+  const FilterTaps taps{filters.low_pass.data(), filters.high_pass.data(),
+                        filters.low_pass.size()};
+  const size_t size = GENERATE(2, 10, 64, 1002);
+  CAPTURE(size);
+
+  std::default_random_engine engine;
+  std::normal_distribution<DataType> distribution;
+  std::vector<DataType> x(size);
+  for (auto &v : x) {
+    v = distribution(engine);
+  }
+
+  std::vector<DataType> low(size / 2);
+  std::vector<DataType> high(size / 2);
+  std::vector<DataType> static_low(size / 2);
+  std::vector<DataType> static_high(size / 2);
+  AnalyzeLine({x.data(), 1}, size, taps, {low.data(), 1}, {high.data(), 1});
+  AnalyzeLine({x.data(), 1}, size, TestType{}, {static_low.data(), 1},
+              {static_high.data(), 1});
+  for (size_t i = 0; i < size / 2; ++i) {
+    REQUIRE(static_low[i] == Catch::Approx(low[i]).margin(1e-6));
+    REQUIRE(static_high[i] == Catch::Approx(high[i]).margin(1e-6));
+  }
+
+  std::vector<DataType> y(size);
+  std::vector<DataType> static_y(size);
+  SynthesizeLine({low.data(), 1}, {high.data(), 1}, size, taps,
+                 {y.data(), 1});
+  SynthesizeLine({low.data(), 1}, {high.data(), 1}, size, TestType{},
+                 {static_y.data(), 1});
+  for (size_t i = 0; i < size; ++i) {
+    REQUIRE(static_y[i] == Catch::Approx(y[i]).margin(1e-6));
+  }
+}
+
+TEMPLATE_TEST_CASE("Segments match whole lines and columns", "[wavelet]",
+                   StaticTaps<kDB1>, StaticTaps<kDB3>, StaticTaps<kDB5>) {
+  const TestType taps{};
+  const size_t size = GENERATE(10, 600, 1030, 4100);
+  CAPTURE(size);
+  const size_t half = size / 2;
+  const size_t overlap = taps.length - 2;
+
+  std::default_random_engine engine;
+  std::normal_distribution<DataType> distribution;
+  const size_t width = 37;
+  std::vector<DataType> x(size * width);
+  for (auto &v : x) {
+    v = distribution(engine);
+  }
+
+  SECTION("should analyze a line in segments of vectorized blocks") {
+    std::vector<DataType> low(half);
+    std::vector<DataType> high(half);
+    AnalyzeLine({x.data(), 1}, size, taps, {low.data(), 1}, {high.data(), 1});
+
+    std::vector<DataType> segment_low(half);
+    std::vector<DataType> segment_high(half);
+    for (size_t first = 0; first < half; first += kSimdBlock) {
+      const size_t count = std::min(kSimdBlock, half - first);
+      std::vector<DataType> src(2 * count + overlap);
+      for (size_t j = 0; j < src.size(); ++j) {
+        src[j] = x[(2 * first + j) % size];
+      }
+      AnalyzeSegment(src.data(), size, first, count, taps,
+                     segment_low.data() + first,
+                     segment_high.data() + first);
+    }
+    REQUIRE(segment_low == low);
+    REQUIRE(segment_high == high);
+  }
+
+  SECTION("should analyze columns in segments of any rows") {
+    std::vector<DataType> low(half * width);
+    std::vector<DataType> high(half * width);
+    AnalyzeColumns({x.data(), width}, size, width, taps, {low.data(), width},
+                   {high.data(), width});
+
+    std::vector<DataType> segment_low(half * width);
+    std::vector<DataType> segment_high(half * width);
+    for (size_t first = 0; first < half; first += 7) {
+      const size_t count = std::min<size_t>(7, half - first);
+      std::vector<DataType> src((2 * count + overlap) * width);
+      for (size_t j = 0; j < 2 * count + overlap; ++j) {
+        std::copy_n(&x[(2 * first + j) % size * width], width,
+                    &src[j * width]);
+      }
+      AnalyzeColumnSegment({src.data(), width}, count, width, taps,
+                           {&segment_low[first * width], width},
+                           {&segment_high[first * width], width});
+    }
+    REQUIRE(segment_low == low);
+    REQUIRE(segment_high == high);
+  }
+}
+
+TEMPLATE_TEST_CASE("Odd lines are extended by their last sample", "[wavelet]",
+                   StaticTaps<kDB1>, StaticTaps<kDB2>, StaticTaps<kDB5>) {
+  const TestType taps{};
+  const size_t size = GENERATE(1, 3, 21, 1081);
+  CAPTURE(size);
+  const size_t half = (size + 1) / 2;
+
+  std::default_random_engine engine;
+  std::normal_distribution<DataType> distribution;
+  const size_t width = 37;
+  std::vector<DataType> x(size * width);
+  for (auto &v : x) {
+    v = distribution(engine);
+  }
+
+  SECTION("should analyze a line as the extended one and restore it") {
+    std::vector<DataType> extended(x.begin(), x.begin() + size);
+    extended.push_back(extended.back());
+    std::vector<DataType> low(half);
+    std::vector<DataType> high(half);
+    AnalyzeLine({x.data(), 1}, size, taps, {low.data(), 1}, {high.data(), 1});
+
+    std::vector<DataType> expected_low(half);
+    std::vector<DataType> expected_high(half);
+    AnalyzeLine({extended.data(), 1}, extended.size(), taps,
+                {expected_low.data(), 1}, {expected_high.data(), 1});
+    for (size_t i = 0; i < half; ++i) {
+      REQUIRE(low[i] == Catch::Approx(expected_low[i]).margin(1e-5));
+      REQUIRE(high[i] == Catch::Approx(expected_high[i]).margin(1e-5));
+    }
+
+    /* The extension sample isn't written */
+    std::vector<DataType> y(size + 1, 100);
+    SynthesizeLine({low.data(), 1}, {high.data(), 1}, size, taps,
+                   {y.data(), 1});
+    for (size_t i = 0; i < size; ++i) {
+      REQUIRE(y[i] == Catch::Approx(x[i]).margin(1e-4));
+    }
+    REQUIRE(y[size] == 100);
+  }
+
+  SECTION("should analyze columns as lines and restore them") {
+    std::vector<DataType> low(half * width);
+    std::vector<DataType> high(half * width);
+    AnalyzeColumns({x.data(), width}, size, width, taps, {low.data(), width},
+                   {high.data(), width});
+
+    std::vector<DataType> column(size);
+    std::vector<DataType> column_low(half);
+    std::vector<DataType> column_high(half);
+    for (size_t j = 0; j < width; ++j) {
+      for (size_t i = 0; i < size; ++i) {
+        column[i] = x[i * width + j];
+      }
+      AnalyzeLine({column.data(), 1}, size, taps, {column_low.data(), 1},
+                  {column_high.data(), 1});
+      for (size_t i = 0; i < half; ++i) {
+        REQUIRE(low[i * width + j] ==
+                Catch::Approx(column_low[i]).margin(1e-5));
+        REQUIRE(high[i * width + j] ==
+                Catch::Approx(column_high[i]).margin(1e-5));
+      }
+    }
+
+    std::vector<DataType> y(size * width);
+    SynthesizeColumns({low.data(), width}, {high.data(), width}, size, width,
+                      taps, {y.data(), width});
+    for (size_t i = 0; i < y.size(); ++i) {
+      REQUIRE(y[i] == Catch::Approx(x[i]).margin(1e-4));
+    }
+  }
+}
+
+TEMPLATE_TEST_CASE("Padding on the fly matches the padded lines", "[wavelet]",
+                   StaticTaps<kDB1>, StaticTaps<kDB3>, StaticTaps<kDB5>) {
+  const TestType taps{};
+  /* Sizes padded on both sides, the long ones have vectorized blocks in the
+   * middle and at the padding */
+  const auto sizes = GENERATE(std::pair<size_t, size_t>{3, 4},
+                              std::pair<size_t, size_t>{100, 128},
+                              std::pair<size_t, size_t>{1081, 1088},
+                              std::pair<size_t, size_t>{600, 2048});
+  const auto extension = GENERATE(Extension::kEdge, Extension::kZero);
+  const auto [size, padded] = sizes;
+  CAPTURE(size, padded, extension);
+  const LinePadding padding{size, padded, (padded - size) / 2, extension};
+  const size_t half = padded / 2;
+
+  std::default_random_engine engine;
+  std::normal_distribution<DataType> distribution;
+  const size_t width = 37;
+  std::vector<DataType> x(size * width);
+  for (auto &v : x) {
+    v = distribution(engine);
+  }
+
+  /* The padding the same way as PaddingAlgorithm does */
+  std::vector<DataType> extended(padded * width);
+  for (size_t i = 0; i < padded; ++i) {
+    const bool inside = i >= padding.offset && i - padding.offset < size;
+    size_t row = i < padding.offset ? 0 : size - 1;
+    if (inside) {
+      row = i - padding.offset;
+    }
+    for (size_t j = 0; j < width; ++j) {
+      extended[i * width + j] =
+          inside || extension == Extension::kEdge ? x[row * width + j] : 0;
+    }
+  }
+
+  SECTION("should analyze a line as the padded one") {
+    std::vector<DataType> line(size);
+    std::vector<DataType> padded_line(padded);
+    for (size_t i = 0; i < padded; ++i) {
+      padded_line[i] = extended[i * width];
+    }
+    for (size_t i = 0; i < size; ++i) {
+      line[i] = x[i * width];
+    }
+
+    std::vector<DataType> low(half);
+    std::vector<DataType> high(half);
+    AnalyzePaddedLine({line.data(), 1}, padding, taps, {low.data(), 1},
+                      {high.data(), 1});
+    std::vector<DataType> expected_low(half);
+    std::vector<DataType> expected_high(half);
+    AnalyzeLine({padded_line.data(), 1}, padded, taps,
+                {expected_low.data(), 1}, {expected_high.data(), 1});
+
+    /* The same sums give the same bits */
+    for (size_t i = 0; i < half; ++i) {
+      REQUIRE(low[i] == expected_low[i]);
+      REQUIRE(high[i] == expected_high[i]);
+    }
+  }
+
+  SECTION("should analyze columns as the padded ones and crop them") {
+    std::vector<DataType> low(half * width);
+    std::vector<DataType> high(half * width);
+    AnalyzePaddedColumns({x.data(), width}, padding, width, taps,
+                         {low.data(), width}, {high.data(), width});
+    std::vector<DataType> expected_low(half * width);
+    std::vector<DataType> expected_high(half * width);
+    AnalyzeColumns({extended.data(), width}, padded, width, taps,
+                   {expected_low.data(), width},
+                   {expected_high.data(), width});
+    for (size_t i = 0; i < low.size(); ++i) {
+      REQUIRE(low[i] == Catch::Approx(expected_low[i]).margin(1e-6));
+      REQUIRE(high[i] == Catch::Approx(expected_high[i]).margin(1e-6));
+    }
+
+    /* Only the rows of the line are written */
+    std::vector<DataType> y((size + 1) * width, 100);
+    SynthesizeCroppedColumns({low.data(), width}, {high.data(), width},
+                             padding, width, taps, {y.data(), width});
+    std::vector<DataType> expected(padded * width);
+    SynthesizeColumns({low.data(), width}, {high.data(), width}, padded,
+                      width, taps, {expected.data(), width});
+    for (size_t i = 0; i < size * width; ++i) {
+      REQUIRE(y[i] == expected[padding.offset * width + i]);
+      REQUIRE(y[i] == Catch::Approx(x[i]).margin(1e-4));
+    }
+    for (size_t i = size * width; i < y.size(); ++i) {
+      REQUIRE(y[i] == 100);
+    }
+  }
+}
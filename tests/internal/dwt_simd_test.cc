@@ -0,0 +1,81 @@
+// Copyright 2023 PANDA GmbH
+
+#include "internal/dwt_simd.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+using drift::wavelet::internal::DetectSimdLevel;
+using drift::wavelet::internal::GetSimdKernels;
+using drift::wavelet::internal::SimdLevel;
+
+static std::vector<float> GenerateLine(size_t size,
+                                       std::default_random_engine *engine) {
+  std::normal_distribution<float> distribution;
+  std::vector<float> line(size);
+  for (auto &x : line) {
+    x = distribution(*engine);
+  }
+  return line;
+}
+
+TEST_CASE("Vectorized kernels match scalar convolution", "[wavelet]") {
+  const auto level =
+      GENERATE(SimdLevel::kSse41, SimdLevel::kAvx2, SimdLevel::kAvx512);
+  const auto *kernels = GetSimdKernels(level);
+  if (kernels == nullptr || level > DetectSimdLevel()) {
+    SUCCEED("Instruction set isn't supported");
+    return;
+  }
+
+  const size_t length = GENERATE(2, 4, 6, 8, 10, 20);
+  const size_t size = GENERATE(20, 34, 100, 1001 * 2);
+  CAPTURE(level, length, size);
+
+  std::default_random_engine engine;
+  const auto low_taps = GenerateLine(length, &engine);
+  const auto high_taps = GenerateLine(length, &engine);
+  const auto x = GenerateLine(size, &engine);
+
+  SECTION("Analysis") {
+    const size_t count = (size - length) / 2 + 1;
+    std::vector<float> low(count);
+    std::vector<float> high(count);
+    kernels->analyze(x.data(), count, low_taps.data(), high_taps.data(),
+                     length, low.data(), high.data());
+
+    for (size_t i = 0; i < count; ++i) {
+      float l = 0;
+      float h = 0;
+      for (size_t k = 0; k < length; ++k) {
+        l += low_taps[k] * x[2 * i + k];
+        h += high_taps[k] * x[2 * i + k];
+      }
+      REQUIRE(std::abs(low[i] - l) < 1e-4);
+      REQUIRE(std::abs(high[i] - h) < 1e-4);
+    }
+  }
+
+  SECTION("Synthesis") {
+    const size_t half = size / 2;
+    const size_t phase_taps = length / 2;
+    std::vector<float> y(size);
+    kernels->synthesize(x.data(), x.data() + half, phase_taps - 1, half,
+                        low_taps.data(), high_taps.data(), length, y.data());
+
+    for (size_t p = phase_taps - 1; p < half; ++p) {
+      for (size_t r = 0; r < 2; ++r) {
+        float expected = 0;
+        for (size_t m = 0; m < phase_taps; ++m) {
+          expected += low_taps[2 * m + r] * x[p - m] +
+                      high_taps[2 * m + r] * x[half + p - m];
+        }
+        REQUIRE(std::abs(y[2 * p + r] - expected) < 1e-4);
+      }
+    }
+  }
+}
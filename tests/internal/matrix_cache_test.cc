@@ -0,0 +1,148 @@
+// Copyright 2023 PANDA GmbH
+
+#include "internal/matrix_cache.h"
+
+#include <latch>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "wavelet_buffer/wavelet.h"
+
+using drift::WaveletTypes;
+using drift::internal::MatrixCache;
+
+TEST_CASE("MatrixCache") {
+  MatrixCache cache;
+
+  SECTION("should share the matrices of the same size and type") {
+    const auto matrix = cache.Get(64, WaveletTypes::kDB2, false);
+    REQUIRE(*matrix == drift::wavelet::DaubechiesMat(64, 4));
+    REQUIRE(cache.Get(64, WaveletTypes::kDB2, false) == matrix);
+    REQUIRE(cache.Get(32, WaveletTypes::kDB2, false) != matrix);
+    REQUIRE(cache.Get(64, WaveletTypes::kDB3, false) != matrix);
+
+    const auto stats = cache.stats();
+    REQUIRE(stats.hits == 1);
+    REQUIRE(stats.misses == 3);
+    REQUIRE(stats.entries == 3);
+    REQUIRE(stats.bytes == MatrixCache::MatrixBytes(*matrix) +
+                               MatrixCache::MatrixBytes(
+                                   *cache.Get(32, WaveletTypes::kDB2, false)) +
+                               MatrixCache::MatrixBytes(
+                                   *cache.Get(64, WaveletTypes::kDB3, false)));
+  }
+
+  SECTION("should transpose the forward matrix") {
+    const auto transposed = cache.Get(32, WaveletTypes::kDB4, true);
+    const auto forward = cache.Get(32, WaveletTypes::kDB4, false);
+    REQUIRE(*transposed == blaze::trans(*forward));
+
+    /* The forward matrix is built once for both */
+    REQUIRE(cache.stats().misses == 2);
+    REQUIRE(cache.stats().hits == 1);
+  }
+
+  SECTION("should drop the least recently used matrices") {
+    const auto first = cache.Get(64, WaveletTypes::kDB1, false);
+    const auto second = cache.Get(32, WaveletTypes::kDB1, false);
+    cache.SetLimit(MatrixCache::MatrixBytes(*first) +
+                   MatrixCache::MatrixBytes(*second));
+    cache.Get(16, WaveletTypes::kDB1, false);
+
+    auto stats = cache.stats();
+    REQUIRE(stats.evictions == 1);
+    REQUIRE(stats.entries == 2);
+
+    /* The handles outlive the eviction */
+    REQUIRE(*first == drift::wavelet::DaubechiesMat(64, 2));
+    REQUIRE(cache.Get(32, WaveletTypes::kDB1, false) == second);
+    REQUIRE(cache.Get(64, WaveletTypes::kDB1, false) != first);
+
+    stats = cache.stats();
+    REQUIRE(stats.evictions == 2);
+    REQUIRE(stats.misses == 4);
+  }
+
+  SECTION("should give the same matrices to all threads") {
+    const auto matrix = cache.Get(64, WaveletTypes::kDB3, true);
+    std::vector<MatrixCache::Handle> handles(8);
+    std::vector<std::thread> threads;
+    for (auto& handle : handles) {
+      threads.emplace_back([&cache, &handle] {
+        for (int i = 0; i < 100; ++i) {
+          handle = cache.Get(64, WaveletTypes::kDB3, true);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    for (const auto& handle : handles) {
+      REQUIRE(handle == matrix);
+    }
+    const auto stats = cache.stats();
+    REQUIRE(stats.misses == 2);
+    REQUIRE(stats.hits == 8 * 100);
+  }
+
+  SECTION("should release the evicted matrices of idle threads") {
+    std::weak_ptr<const MatrixCache::Matrix> held;
+    std::latch taken(1);
+    std::latch evicted(1);
+    std::thread thread([&] {
+      held = cache.Get(64, WaveletTypes::kDB2, false);
+      taken.count_down();
+      evicted.wait();
+    });
+
+    taken.wait();
+    REQUIRE_FALSE(held.expired());
+    REQUIRE(cache.stats().thread_handles == 1);
+
+    /* The thread is idle and doesn't call the cache any more */
+    cache.SetLimit(0);
+    REQUIRE(held.expired());
+    REQUIRE(cache.stats().thread_handles == 0);
+    REQUIRE(cache.stats().bytes == 0);
+
+    evicted.count_down();
+    thread.join();
+  }
+
+  SECTION("should refresh the recency on the hits of a thread") {
+    const auto first = cache.Get(64, WaveletTypes::kDB1, false);
+    const auto second = cache.Get(32, WaveletTypes::kDB1, false);
+    cache.SetLimit(MatrixCache::MatrixBytes(*first) +
+                   MatrixCache::MatrixBytes(*second));
+
+    /* The first matrix is hit on the thread after the second one was taken,
+     * the second one is the least recently used */
+    REQUIRE(cache.Get(64, WaveletTypes::kDB1, false) == first);
+    cache.Get(16, WaveletTypes::kDB1, false);
+
+    REQUIRE(cache.stats().evictions == 1);
+    REQUIRE(cache.Get(64, WaveletTypes::kDB1, false) == first);
+    REQUIRE(cache.Get(32, WaveletTypes::kDB1, false) != second);
+  }
+
+  SECTION("should not keep matrices larger than the limit") {
+    cache.SetLimit(0);
+    const auto matrix = cache.Get(16, WaveletTypes::kDB1, false);
+    REQUIRE(*matrix == drift::wavelet::DaubechiesMat(16, 2));
+    REQUIRE(cache.stats().entries == 0);
+    REQUIRE(cache.stats().bytes == 0);
+  }
+
+  SECTION("should reset the counters") {
+    cache.Get(16, WaveletTypes::kDB1, false);
+    cache.Clear();
+    const auto stats = cache.stats();
+    REQUIRE(stats.misses == 0);
+    REQUIRE(stats.entries == 0);
+    REQUIRE(stats.bytes == 0);
+  }
+}
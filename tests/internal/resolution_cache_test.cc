@@ -0,0 +1,65 @@
+// Copyright 2023 PANDA GmbH
+
+#include "internal/resolution_cache.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+using drift::Signal2D;
+using drift::internal::ResolutionCache;
+
+TEST_CASE("ResolutionCache") {
+  /* Room for two levels of 8x8 */
+  const size_t level_bytes = 8 * 8 * sizeof(drift::DataType);
+  ResolutionCache cache(2 * level_bytes);
+  const Signal2D level(8, 8, 1);
+
+  SECTION("should find the finest level not finer than the requested one") {
+    cache.Insert(0, 3, level);
+    cache.Insert(0, 1, level);
+    REQUIRE(cache.bytes() == 2 * level_bytes);
+
+    REQUIRE(cache.Find(0, 0).first == 1);
+    REQUIRE(cache.Find(0, 1).first == 1);
+    REQUIRE(cache.Find(0, 2).first == 3);
+    REQUIRE(*cache.Find(0, 2).second == level);
+    REQUIRE_FALSE(cache.Find(0, 4).second);
+    REQUIRE_FALSE(cache.Find(1, 0).second);
+  }
+
+  SECTION("should drop the least recently used levels") {
+    cache.Insert(0, 3, level);
+    cache.Insert(0, 2, level);
+    REQUIRE(cache.Find(0, 3).second);
+
+    cache.Insert(0, 1, level);
+    REQUIRE(cache.bytes() == 2 * level_bytes);
+    REQUIRE(cache.Find(0, 3).first == 3);
+    REQUIRE(cache.Find(0, 1).first == 1);
+    REQUIRE(cache.Find(0, 2).first == 3);
+
+    cache.SetBudget(level_bytes);
+    REQUIRE(cache.bytes() == level_bytes);
+  }
+
+  SECTION("should keep nothing over the budget") {
+    cache.Insert(0, 0, Signal2D(16, 16));
+    REQUIRE(cache.bytes() == 0);
+    REQUIRE_FALSE(cache.Find(0, 0).second);
+  }
+
+  SECTION("should keep the approximations after clearing") {
+    cache.Insert(0, 1, level);
+    const auto approximation = cache.Find(0, 1).second;
+    cache.Clear();
+    REQUIRE(cache.bytes() == 0);
+    REQUIRE_FALSE(cache.Find(0, 1).second);
+    REQUIRE(*approximation == level);
+  }
+
+  SECTION("should copy the budget only") {
+    cache.Insert(0, 1, level);
+    const ResolutionCache copy = cache;
+    REQUIRE(copy.budget() == cache.budget());
+    REQUIRE(copy.bytes() == 0);
+  }
+}
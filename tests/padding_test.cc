@@ -2,6 +2,8 @@
 
 #include <wavelet_buffer/padding.h>
 
+#include <vector>
+
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/generators/catch_generators.hpp>
 
@@ -185,3 +187,32 @@ TEST_CASE("ZeroDerivativePaddingAlgorithm empty case", "[wavelet]") {
   REQUIRE(result == kEmptyMatrix);
   REQUIRE(padding.Crop(result) == kEmptyMatrix);
 }
+
+TEST_CASE("PaddingAlgorithm into memory of the caller", "[wavelet]") {
+  const blaze::DynamicMatrix<float> kMatrix{{1, 2, 3}, {4, 5, 6}};
+  const auto location =
+      GENERATE(PaddingLocation::kRight, PaddingLocation::kBoth);
+
+  std::vector<float> memory(4 * 5);
+  drift::Signal2DView view(memory.data(), 4, 5);
+
+  SECTION("ZeroPaddingAlgorithm") {
+    ZeroPaddingAlgorithm padding(4, 5, location);
+    padding.Extend(kMatrix, &view);
+    REQUIRE(view == padding.Extend(kMatrix));
+
+    blaze::DynamicMatrix<float> cropped;
+    ZeroPaddingAlgorithm(2, 3, location).Crop(view, &cropped);
+    REQUIRE(cropped == kMatrix);
+  }
+
+  SECTION("ZeroDerivativePaddingAlgorithm") {
+    ZeroDerivativePaddingAlgorithm padding(4, 5, location);
+    padding.Extend(kMatrix, &view);
+    REQUIRE(view == padding.Extend(kMatrix));
+
+    blaze::DynamicMatrix<float> cropped;
+    ZeroDerivativePaddingAlgorithm(2, 3, location).Crop(view, &cropped);
+    REQUIRE(cropped == kMatrix);
+  }
+}
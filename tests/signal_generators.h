@@ -0,0 +1,44 @@
+// Copyright 2023 PANDA GmbH
+
+#ifndef TESTS_SIGNAL_GENERATORS_H_
+#define TESTS_SIGNAL_GENERATORS_H_
+
+#include <random>
+#include <vector>
+
+#include "wavelet_buffer/primitives.h"
+
+/**
+ * Signals of normally distributed values, the same on every call
+ * @param number the number of the signals
+ * @param rows
+ * @param columns
+ */
+inline drift::SignalN2D GenerateSignals(size_t number, size_t rows,
+                                        size_t columns) {
+  std::default_random_engine random_engine;
+  std::normal_distribution<drift::DataType> distribution;
+  drift::SignalN2D signals(number);
+  for (auto &signal : signals) {
+    signal = blaze::generate<blaze::rowMajor>(
+        rows, columns,
+        [&](size_t i, size_t j) { return distribution(random_engine); });
+  }
+  return signals;
+}
+
+/**
+ * Samples of a 1D signal of normally distributed values, the same on every
+ * call
+ */
+inline std::vector<drift::DataType> GenerateSamples(size_t size) {
+  std::default_random_engine random_engine;
+  std::normal_distribution<drift::DataType> distribution;
+  std::vector<drift::DataType> samples(size);
+  for (auto &sample : samples) {
+    sample = distribution(random_engine);
+  }
+  return samples;
+}
+
+#endif  // TESTS_SIGNAL_GENERATORS_H_
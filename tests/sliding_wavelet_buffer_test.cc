@@ -0,0 +1,117 @@
+// Copyright 2023 PANDA GmbH
+
+#include "wavelet_buffer/sliding_wavelet_buffer.h"
+
+#include <string>
+#include <vector>
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include "signal_generators.h"
+
+using drift::DataType;
+using drift::NullDenoiseAlgorithm;
+using drift::Signal1D;
+using drift::SlidingWaveletBuffer;
+using drift::WaveletBuffer;
+using drift::WaveletParameters;
+using drift::WaveletTypes;
+
+TEST_CASE("SlidingWaveletBuffer") {
+  const auto wavelet_type =
+      GENERATE(WaveletTypes::kDB1, WaveletTypes::kDB3, WaveletTypes::kDB5);
+  const int steps = GENERATE(1, 4);
+  /* Aligned pushes shift the coefficients, others decompose the window */
+  const size_t chunk = GENERATE(48, 80, 33);
+  CAPTURE(wavelet_type, steps, chunk);
+
+  const WaveletParameters params = {.signal_shape = {960},
+                                    .signal_number = 1,
+                                    .decomposition_steps = steps,
+                                    .wavelet_type = wavelet_type};
+  const size_t window = params.signal_shape[0];
+  const auto samples = GenerateSamples(3000);
+
+  SlidingWaveletBuffer sliding(params);
+  for (size_t pos = 0; pos + chunk <= samples.size(); pos += chunk) {
+    sliding.Push({samples.data() + pos, chunk});
+  }
+  const size_t end = samples.size() / chunk * chunk;
+  Signal1D signal(window);
+  for (size_t i = 0; i < window; ++i) {
+    signal[i] = samples[end - window + i];
+  }
+
+  SECTION("should decompose the current window") {
+    WaveletBuffer expected(params);
+    REQUIRE(expected.Decompose(signal, NullDenoiseAlgorithm<DataType>()));
+
+    const auto &buffer = sliding.buffer();
+    for (size_t i = 0; i < expected[0].size(); ++i) {
+      const auto &subband = expected[0][i];
+      REQUIRE(buffer[0][i].rows() == subband.rows());
+      for (size_t j = 0; j < subband.rows(); ++j) {
+        REQUIRE(buffer[0][i](j, 0) ==
+                Catch::Approx(subband(j, 0)).margin(1e-4));
+      }
+    }
+  }
+
+  SECTION("should not depend on the pushes") {
+    SlidingWaveletBuffer whole(params);
+    whole.Push({samples.data(), end});
+    REQUIRE(whole.buffer() == sliding.buffer());
+  }
+
+  SECTION("should compose and serialize the current window") {
+    Signal1D restored;
+    REQUIRE(sliding.Compose(&restored));
+    REQUIRE(restored.size() == window);
+    for (size_t i = 0; i < window; ++i) {
+      REQUIRE(restored[i] == Catch::Approx(signal[i]).margin(1e-4));
+    }
+
+    std::string blob;
+    REQUIRE(sliding.Serialize(&blob));
+    const auto parsed = WaveletBuffer::Parse(blob);
+    REQUIRE(parsed);
+    REQUIRE(*parsed == sliding.buffer());
+  }
+}
+
+TEST_CASE("SlidingWaveletBuffer without wavelet") {
+  SlidingWaveletBuffer sliding({.signal_shape = {10},
+                                .signal_number = 1,
+                                .decomposition_steps = 0,
+                                .wavelet_type = WaveletTypes::kNone});
+  const auto samples = GenerateSamples(25);
+  sliding.Push(samples);
+
+  Signal1D restored;
+  REQUIRE(sliding.Compose(&restored));
+  for (size_t i = 0; i < 10; ++i) {
+    REQUIRE(restored[i] == samples[15 + i]);
+  }
+}
+
+TEST_CASE("SlidingWaveletBuffer parameters") {
+  SECTION("should throw for a window with padding") {
+    REQUIRE_THROWS(SlidingWaveletBuffer({.signal_shape = {100},
+                                         .signal_number = 1,
+                                         .decomposition_steps = 3,
+                                         .wavelet_type = WaveletTypes::kDB2}));
+  }
+
+  SECTION("should throw for 2D or many signals") {
+    REQUIRE_THROWS(SlidingWaveletBuffer({.signal_shape = {64, 64},
+                                         .signal_number = 1,
+                                         .decomposition_steps = 2,
+                                         .wavelet_type = WaveletTypes::kDB2}));
+    REQUIRE_THROWS(SlidingWaveletBuffer({.signal_shape = {64},
+                                         .signal_number = 2,
+                                         .decomposition_steps = 2,
+                                         .wavelet_type = WaveletTypes::kDB2}));
+  }
+}
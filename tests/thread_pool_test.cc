@@ -0,0 +1,236 @@
+// Copyright 2023 PANDA GmbH
+
+#include "wavelet_buffer/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include "wavelet_buffer/wavelet.h"
+#include "wavelet_buffer/wavelet_buffer.h"
+#include "wavelet_buffer/wavelet_plan.h"
+#include "signal_generators.h"
+
+using drift::DecompositionSize;
+using drift::NullDenoiseAlgorithm;
+using drift::NWaveletDecomposition;
+using drift::Signal2D;
+using drift::SignalN2D;
+using drift::SimpleDenoiseAlgorithm;
+using drift::ThreadPool;
+using drift::WaveletBuffer;
+using drift::WaveletDecomposition;
+using drift::WaveletParameters;
+using drift::WaveletPlan;
+using drift::WaveletTypes;
+using drift::Workspace;
+using drift::wavelet::Engine;
+
+TEST_CASE("ThreadPool") {
+  const size_t threads = GENERATE(1, 2, 4);
+  ThreadPool pool(threads);
+  REQUIRE(pool.size() == threads);
+
+  SECTION("should run every task once") {
+    std::vector<int> runs(1000);
+    for (int i = 0; i < 10; ++i) {
+      pool.ParallelFor(runs.size(),
+                       [&runs](size_t index, Workspace *) { ++runs[index]; });
+    }
+    REQUIRE(runs == std::vector<int>(runs.size(), 10));
+  }
+
+  SECTION("should give every thread its own workspace") {
+    std::atomic<size_t> failures = 0;
+    pool.ParallelFor(100, [&failures](size_t index, Workspace *workspace) {
+      auto *data = workspace->Allocate<size_t>(100);
+      std::fill_n(data, 100, index);
+      std::this_thread::yield();
+      if (std::count(data, data + 100, index) != 100) {
+        ++failures;
+      }
+      workspace->Reset();
+    });
+    REQUIRE(failures == 0);
+  }
+
+  SECTION("should run nested calls in the calling thread") {
+    std::atomic<size_t> runs = 0;
+    pool.ParallelFor(8, [&](size_t, Workspace *) {
+      pool.ParallelFor(8, [&runs](size_t, Workspace *) { ++runs; });
+    });
+    REQUIRE(runs == 64);
+  }
+
+  SECTION("should pass the exception of a task to the caller") {
+    REQUIRE_THROWS_WITH(pool.ParallelFor(100,
+                                         [](size_t index, Workspace *) {
+                                           if (index == 50) {
+                                             throw std::runtime_error("task");
+                                           }
+                                         }),
+                        "task");
+
+    /* The pool works after the exception */
+    std::atomic<size_t> runs = 0;
+    pool.ParallelFor(10, [&runs](size_t, Workspace *) { ++runs; });
+    REQUIRE(runs == 10);
+  }
+}
+
+TEST_CASE("Transforms on a thread pool") {
+  const auto shape =
+      GENERATE(std::vector<size_t>{300}, std::vector<size_t>{100, 70});
+  const auto engine =
+      GENERATE(Engine::kMatrix, Engine::kFilterBank, Engine::kLifting);
+  CAPTURE(shape, engine);
+
+  const WaveletParameters params{
+      .signal_shape = shape,
+      .signal_number = 16,
+      .decomposition_steps = 3,
+      .wavelet_type = WaveletTypes::kDB3,
+  };
+  const auto data = GenerateSignals(params.signal_number, shape.back(),
+                                    shape.size() > 1 ? shape[0] : 1);
+  const SimpleDenoiseAlgorithm<float> denoiser(0.5);
+  const WaveletPlan plan(params, engine);
+  ThreadPool pool(4);
+
+  SECTION("should decompose and compose as in one thread") {
+    NWaveletDecomposition expected(
+        params.signal_number, WaveletDecomposition(DecompositionSize(params)));
+    REQUIRE(plan.Decompose(data, denoiser, &expected, 0,
+                           params.signal_number));
+
+    NWaveletDecomposition decomposition(
+        params.signal_number, WaveletDecomposition(DecompositionSize(params)));
+    REQUIRE(plan.Decompose(data, denoiser, &decomposition, 0,
+                           params.signal_number, nullptr, &pool));
+    REQUIRE(decomposition == expected);
+
+    for (int scale_factor = 0; scale_factor <= params.decomposition_steps;
+         ++scale_factor) {
+      SignalN2D expected_composed;
+      REQUIRE(plan.Compose(expected, &expected_composed, scale_factor, 0,
+                           params.signal_number));
+
+      SignalN2D composed;
+      REQUIRE(plan.Compose(decomposition, &composed, scale_factor, 0,
+                           params.signal_number, nullptr, &pool));
+      REQUIRE(composed == expected_composed);
+    }
+  }
+}
+
+TEST_CASE("Big image on a thread pool") {
+  /* The image is big enough to split its rows and columns */
+  const auto data = GenerateSignals(1, 1024, 1024);
+  const auto &image = data[0];
+  ThreadPool pool(4);
+
+  SECTION("should transform with filters as in one thread") {
+    const auto filters = drift::wavelet::DaubechiesFilters(6);
+    const Signal2D transformed = drift::wavelet::dwt2s(image, filters);
+    REQUIRE(drift::wavelet::dwt2s(image, filters, &pool) == transformed);
+    REQUIRE(drift::wavelet::idwt2s(transformed, filters, &pool) ==
+            drift::wavelet::idwt2s(transformed, filters));
+
+    Signal2D ll;
+    Signal2D lh;
+    Signal2D hl;
+    Signal2D hh;
+    drift::wavelet::dwt2(image, filters, &ll, &lh, &hl, &hh, &pool);
+    const auto [expected_ll, expected_lh, expected_hl, expected_hh] =
+        drift::wavelet::dwt2(image, filters);
+    REQUIRE(ll == expected_ll);
+    REQUIRE(lh == expected_lh);
+    REQUIRE(hl == expected_hl);
+    REQUIRE(hh == expected_hh);
+    REQUIRE(drift::wavelet::idwt2(ll, lh, hl, hh, filters, &pool) ==
+            drift::wavelet::idwt2(ll, lh, hl, hh, filters));
+  }
+
+  SECTION("should transform with lifting as in one thread") {
+    const auto scheme = drift::wavelet::DaubechiesLifting(6);
+    Signal2D expected = image;
+    drift::wavelet::dwt2s(&expected, scheme);
+    Signal2D transformed = image;
+    drift::wavelet::dwt2s(&transformed, scheme, &pool);
+    REQUIRE(transformed == expected);
+
+    drift::wavelet::idwt2s(&expected, scheme);
+    drift::wavelet::idwt2s(&transformed, scheme, &pool);
+    REQUIRE(transformed == expected);
+  }
+
+  SECTION("should decompose and compose as in one thread") {
+    const auto engine =
+        GENERATE(Engine::kMatrix, Engine::kFilterBank, Engine::kLifting);
+    CAPTURE(engine);
+
+    const WaveletParameters params{
+        .signal_shape = {1024, 1024},
+        .signal_number = 1,
+        .decomposition_steps = 2,
+        .wavelet_type = WaveletTypes::kDB3,
+    };
+    const SimpleDenoiseAlgorithm<float> denoiser(0.5);
+    const WaveletPlan plan(params, engine);
+
+    NWaveletDecomposition expected(
+        1, WaveletDecomposition(DecompositionSize(params)));
+    REQUIRE(plan.Decompose(data, denoiser, &expected, 0, 1));
+    NWaveletDecomposition decomposition(
+        1, WaveletDecomposition(DecompositionSize(params)));
+    REQUIRE(plan.Decompose(data, denoiser, &decomposition, 0, 1, nullptr,
+                           &pool));
+    REQUIRE(decomposition == expected);
+
+    SignalN2D expected_composed;
+    REQUIRE(plan.Compose(expected, &expected_composed, 0, 0, 1));
+    SignalN2D composed;
+    REQUIRE(plan.Compose(decomposition, &composed, 0, 0, 1, nullptr, &pool));
+    REQUIRE(composed == expected_composed);
+  }
+}
+
+TEST_CASE("WaveletBuffer with threads") {
+  const WaveletParameters params{
+      .signal_shape = {100, 100},
+      .signal_number = 3,
+      .decomposition_steps = 2,
+      .wavelet_type = WaveletTypes::kDB2,
+  };
+  const auto data = GenerateSignals(3, 100, 100);
+
+  WaveletBuffer expected(params);
+  REQUIRE(expected.Decompose(data, NullDenoiseAlgorithm<float>()));
+  SignalN2D expected_composed;
+  REQUIRE(expected.Compose(&expected_composed));
+
+  WaveletBuffer buffer(params);
+  ThreadPool pool(2);
+  const auto configure = GENERATE(0, 1, 2);
+  if (configure == 0) {
+    buffer.SetThreadCount(3);
+  } else if (configure == 1) {
+    buffer.SetThreadCount(0);
+  } else {
+    buffer.AttachThreadPool(&pool);
+  }
+
+  REQUIRE(buffer.Decompose(data, NullDenoiseAlgorithm<float>()));
+  REQUIRE(buffer == expected);
+
+  /* Copies share the pool */
+  const WaveletBuffer copy = buffer;
+  SignalN2D composed;
+  REQUIRE(copy.Compose(&composed));
+  REQUIRE(composed == expected_composed);
+}
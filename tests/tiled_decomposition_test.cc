@@ -0,0 +1,122 @@
+// Copyright 2023 PANDA GmbH
+
+#include "wavelet_buffer/tiled_decomposition.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include "wavelet_buffer/wavelet_buffer.h"
+#include "signal_generators.h"
+
+using drift::DataType;
+using drift::DecomposeTiled;
+using drift::NullDenoiseAlgorithm;
+using drift::SignalN2D;
+using drift::TiledLayout;
+using drift::TileOptions;
+using drift::WaveletBuffer;
+using drift::WaveletParameters;
+using drift::WaveletTypes;
+
+static void WriteRawFile(const std::string &path, const SignalN2D &signals) {
+  std::ofstream file(path, std::ios::binary);
+  for (const auto &signal : signals) {
+    for (size_t i = 0; i < signal.rows(); ++i) {
+      file.write(reinterpret_cast<const char *>(signal.data(i)),
+                 signal.columns() * sizeof(DataType));
+    }
+  }
+}
+
+static std::vector<DataType> ReadRawFile(const std::string &path) {
+  std::vector<DataType> data(std::filesystem::file_size(path) /
+                             sizeof(DataType));
+  std::ifstream file(path, std::ios::binary);
+  file.read(reinterpret_cast<char *>(data.data()),
+            data.size() * sizeof(DataType));
+  return data;
+}
+
+TEST_CASE("Tiled decomposition") {
+  const auto directory = std::filesystem::temp_directory_path();
+  const auto input = (directory / "tiled_decomposition_input.raw").string();
+  const auto output = (directory / "tiled_decomposition_output.raw").string();
+
+  SECTION("should give the subbands of WaveletBuffer") {
+    const auto wavelet_type =
+        GENERATE(WaveletTypes::kNone, WaveletTypes::kDB1, WaveletTypes::kDB3,
+                 WaveletTypes::kDB5);
+    /* Tiles of some rows and of all rows, the columns have padding and
+     * don't fill the last tile */
+    const auto options = GENERATE(TileOptions{.rows = 16, .columns = 256},
+                                  TileOptions{.rows = 1000, .columns = 100});
+    CAPTURE(wavelet_type, options.rows, options.columns);
+
+    const WaveletParameters params = {
+        .signal_shape = {1100, 301},
+        .signal_number = 2,
+        .decomposition_steps = wavelet_type != WaveletTypes::kNone ? 3u : 0u,
+        .wavelet_type = wavelet_type};
+    const auto signals = GenerateSignals(2, 301, 1100);
+    WriteRawFile(input, signals);
+
+    WaveletBuffer expected(params);
+    REQUIRE(expected.Decompose(signals, NullDenoiseAlgorithm<DataType>()));
+
+    REQUIRE(DecomposeTiled(params, input, output, options));
+    const auto data = ReadRawFile(output);
+    const auto layout = TiledLayout(params);
+    const size_t subbands = expected[0].size();
+    REQUIRE(layout.size() == 2 * subbands);
+    REQUIRE(data.size() == layout.back().offset +
+                               layout.back().rows * layout.back().columns);
+
+    /* The same kernels give the same bits */
+    for (size_t channel = 0; channel < 2; ++channel) {
+      for (size_t i = 0; i < subbands; ++i) {
+        const auto &subband = expected[channel][i];
+        const auto &place = layout[channel * subbands + i];
+        REQUIRE(place.rows == subband.rows());
+        REQUIRE(place.columns == subband.columns());
+
+        size_t mismatches = 0;
+        for (size_t r = 0; r < place.rows; ++r) {
+          for (size_t c = 0; c < place.columns; ++c) {
+            mismatches +=
+                data[place.offset + r * place.columns + c] != subband(r, c);
+          }
+        }
+        REQUIRE(mismatches == 0);
+      }
+    }
+    REQUIRE_FALSE(std::filesystem::exists(output + ".step0"));
+    REQUIRE_FALSE(std::filesystem::exists(output + ".step1"));
+  }
+
+  SECTION("should fail for wrong inputs") {
+    const WaveletParameters params = {.signal_shape = {64, 32},
+                                      .signal_number = 1,
+                                      .decomposition_steps = 2,
+                                      .wavelet_type = WaveletTypes::kDB2};
+    std::filesystem::remove(input);
+    REQUIRE_FALSE(DecomposeTiled(params, input, output));
+
+    /* One row is missing */
+    WriteRawFile(input, GenerateSignals(1, 31, 64));
+    REQUIRE_FALSE(DecomposeTiled(params, input, output));
+
+    WriteRawFile(input, GenerateSignals(1, 32, 64));
+    auto too_many_steps = params;
+    too_many_steps.decomposition_steps = 10;
+    REQUIRE_FALSE(DecomposeTiled(too_many_steps, input, output));
+    REQUIRE(DecomposeTiled(params, input, output));
+  }
+
+  std::filesystem::remove(input);
+  std::filesystem::remove(output);
+}
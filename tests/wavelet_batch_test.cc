@@ -0,0 +1,111 @@
+// Copyright 2023 PANDA GmbH
+
+#include "wavelet_buffer/wavelet_batch.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include "signal_generators.h"
+
+using drift::BatchDecompose;
+using drift::BatchParse;
+using drift::BatchSerialize;
+using drift::BatchStatus;
+using drift::NullDenoiseAlgorithm;
+using drift::SignalN2D;
+using drift::ThreadPool;
+using drift::WaveletBuffer;
+using drift::WaveletParameters;
+using drift::WaveletTypes;
+
+TEST_CASE("Batch of buffers") {
+  /* Buffers of different sizes */
+  const std::vector<WaveletParameters> params = {
+      {.signal_shape = {300},
+       .signal_number = 2,
+       .decomposition_steps = 3,
+       .wavelet_type = WaveletTypes::kDB3},
+      {.signal_shape = {100, 70},
+       .signal_number = 1,
+       .decomposition_steps = 2,
+       .wavelet_type = WaveletTypes::kDB2},
+      {.signal_shape = {4000},
+       .signal_number = 1,
+       .decomposition_steps = 5,
+       .wavelet_type = WaveletTypes::kDB1},
+  };
+
+  std::vector<WaveletBuffer> buffers;
+  std::vector<SignalN2D> data;
+  for (int i = 0; i < 30; ++i) {
+    const auto &item = params[i % params.size()];
+    buffers.emplace_back(item);
+    data.push_back(GenerateSignals(
+        item.signal_number, item.signal_shape.back(),
+        item.signal_shape.size() > 1 ? item.signal_shape[0] : 1));
+  }
+
+  std::vector<WaveletBuffer> expected = buffers;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    REQUIRE(expected[i].Decompose(data[i], NullDenoiseAlgorithm<float>()));
+  }
+
+  /* 0 runs the batch in the calling thread */
+  const size_t threads = GENERATE(0, 1, 4);
+  std::unique_ptr<ThreadPool> pool =
+      threads ? std::make_unique<ThreadPool>(threads) : nullptr;
+
+  SECTION("should decompose, serialize and parse every buffer") {
+    auto statuses = BatchDecompose(buffers, data,
+                                   NullDenoiseAlgorithm<float>(), pool.get());
+    REQUIRE(statuses ==
+            std::vector<BatchStatus>(buffers.size(), BatchStatus::kOk));
+    REQUIRE(buffers == expected);
+
+    std::vector<std::string> blobs(buffers.size());
+    statuses = BatchSerialize(buffers, blobs, 0, pool.get());
+    REQUIRE(statuses ==
+            std::vector<BatchStatus>(buffers.size(), BatchStatus::kOk));
+
+    std::vector<std::unique_ptr<WaveletBuffer>> parsed;
+    statuses = BatchParse(blobs, &parsed, pool.get());
+    REQUIRE(statuses ==
+            std::vector<BatchStatus>(buffers.size(), BatchStatus::kOk));
+    REQUIRE(parsed.size() == buffers.size());
+    for (size_t i = 0; i < parsed.size(); ++i) {
+      REQUIRE(*parsed[i] == expected[i]);
+    }
+
+    /* The buffers with the same parameters share the plan */
+    REQUIRE(parsed[0]->plan() == parsed[params.size()]->plan());
+    REQUIRE(parsed[0]->plan() != parsed[1]->plan());
+  }
+
+  SECTION("should report the status of each item") {
+    data[1] = GenerateSignals(1, 10, 10);
+    const auto statuses = BatchDecompose(
+        buffers, data, NullDenoiseAlgorithm<float>(), pool.get());
+    REQUIRE(statuses[0] == BatchStatus::kOk);
+    REQUIRE(statuses[1] == BatchStatus::kFailed);
+    REQUIRE(statuses[2] == BatchStatus::kOk);
+
+    std::vector<std::string> blobs = {"GARBAGE", ""};
+    REQUIRE(buffers[0].Serialize(&blobs[1]));
+    std::vector<std::unique_ptr<WaveletBuffer>> parsed;
+    REQUIRE(BatchParse(blobs, &parsed, pool.get()) ==
+            std::vector<BatchStatus>{BatchStatus::kFailed, BatchStatus::kOk});
+    REQUIRE_FALSE(parsed[0]);
+    REQUIRE(parsed[1]);
+  }
+
+  SECTION("should fail for spans of different sizes") {
+    data.pop_back();
+    REQUIRE(BatchDecompose(buffers, data, NullDenoiseAlgorithm<float>(),
+                           pool.get()) ==
+            std::vector<BatchStatus>(buffers.size(), BatchStatus::kFailed));
+  }
+}
@@ -7,7 +7,11 @@
 
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <span>
 #include <sstream>
+#include <utility>
+#include <vector>
 
 #include <catch2/catch_approx.hpp>
 #include <catch2/catch_test_macros.hpp>
@@ -552,6 +556,405 @@ TEST_CASE("Should keep size", "[wavelets]") {
   REQUIRE(signals[buffer_num][0].rows() == output_signal[0].rows());
 }
 
+TEST_CASE("1D signal in memory of the caller", "[wavelets]") {
+  DataGenerator dg;
+  const auto engine = GENERATE(drift::wavelet::Engine::kFilterBank,
+                               drift::wavelet::Engine::kLifting);
+  /* 128 samples need no padding and are read in place */
+  const size_t length = GENERATE(100, 128);
+  CAPTURE(engine, length);
+
+  const auto params = MakeParams({length}, 3, WaveletTypes::kDB3);
+  const Signal1D signal{dg.GenerateMatrix1d(length)};
+  const std::vector<float> samples(signal.begin(), signal.end());
+
+  WaveletBuffer buffer(
+      std::make_shared<const drift::WaveletPlan>(params, engine));
+  WaveletBuffer expected(
+      std::make_shared<const drift::WaveletPlan>(params, engine));
+  REQUIRE(buffer.Decompose(std::span<const float>(samples),
+                           NullDenoiseAlgorithm<float>()));
+
+  SignalN2D signal_2d{Signal2D(signal.size(), 1)};
+  blaze::column(signal_2d[0], 0) = signal;
+  REQUIRE(expected.Decompose(signal_2d, NullDenoiseAlgorithm<float>()));
+  REQUIRE(buffer == expected);
+
+  const auto scale = GENERATE(0, 1, 3);
+  SignalN2D expected_composed;
+  REQUIRE(expected.Compose(&expected_composed, scale));
+
+  std::vector<float> composed(expected_composed[0].rows());
+  REQUIRE(buffer.Compose(std::span<float>(composed), scale));
+  for (size_t i = 0; i < composed.size(); ++i) {
+    REQUIRE(composed[i] == expected_composed[0](i, 0));
+  }
+
+  std::vector<float> wrong_size(composed.size() + 1);
+  REQUIRE_FALSE(buffer.Compose(std::span<float>(wrong_size), scale));
+  REQUIRE_FALSE(buffer.Decompose(std::span<const float>(wrong_size),
+                                 NullDenoiseAlgorithm<float>()));
+}
+
+TEST_CASE("Interleaved 1D channels", "[wavelets]") {
+  DataGenerator dg;
+  const auto engine = GENERATE(drift::wavelet::Engine::kFilterBank,
+                               drift::wavelet::Engine::kMatrix);
+  /* 24 channels fill a tile of the kernels and a part of the next one, 256
+   * samples need no padding and are read in place */
+  const size_t length = GENERATE(250, 256);
+  const size_t channels = 24;
+  CAPTURE(engine, length);
+
+  auto params = MakeParams({length}, 3, WaveletTypes::kDB3);
+  params.signal_number = channels;
+  const Signal2D frames = dg.GenerateMatrix2d(length, channels);
+  SignalN2D signals(channels);
+  for (size_t ch = 0; ch < channels; ++ch) {
+    signals[ch] = Signal2D(length, 1);
+    blaze::column(signals[ch], 0) = blaze::column(frames, ch);
+  }
+
+  const auto plan = std::make_shared<const drift::WaveletPlan>(params, engine);
+  WaveletBuffer buffer(plan);
+  WaveletBuffer expected(plan);
+  REQUIRE(buffer.DecomposeInterleaved(frames, NullDenoiseAlgorithm<float>()));
+  REQUIRE(expected.Decompose(signals, NullDenoiseAlgorithm<float>()));
+  for (size_t ch = 0; ch < channels; ++ch) {
+    CAPTURE(ch);
+    REQUIRE(buffer[ch].size() == expected[ch].size());
+    for (size_t i = 0; i < buffer[ch].size(); ++i) {
+      REQUIRE(buffer[ch][i].rows() == expected[ch][i].rows());
+      REQUIRE(blaze::max(blaze::abs(buffer[ch][i] - expected[ch][i])) < 1e-4f);
+    }
+  }
+
+  const auto scale = GENERATE(0, 1, 3);
+  SignalN2D expected_composed;
+  REQUIRE(expected.Compose(&expected_composed, scale));
+
+  Signal2D composed;
+  REQUIRE(buffer.ComposeInterleaved(&composed, scale));
+  REQUIRE(composed.rows() == expected_composed[0].rows());
+  REQUIRE(composed.columns() == channels);
+  for (size_t ch = 0; ch < channels; ++ch) {
+    REQUIRE(blaze::max(blaze::abs(blaze::column(composed, ch) -
+                                  blaze::column(expected_composed[ch], 0))) <
+            1e-4f);
+  }
+
+  REQUIRE_FALSE(buffer.DecomposeInterleaved(
+      dg.GenerateMatrix2d(length, channels - 1),
+      NullDenoiseAlgorithm<float>()));
+  REQUIRE_FALSE(buffer.DecomposeInterleaved(
+      dg.GenerateMatrix2d(length + 2, channels),
+      NullDenoiseAlgorithm<float>()));
+}
+
+TEST_CASE("Odd sides without padding", "[wavelets]") {
+  DataGenerator dg;
+  const auto shape = GENERATE(std::vector<size_t>{1081},
+                              std::vector<size_t>{1080, 1081});
+  CAPTURE(shape);
+  const bool is_1d = shape.size() == 1;
+  const size_t rows = is_1d ? shape[0] : shape[1];
+  const size_t columns = is_1d ? 1 : shape[0];
+  auto side = [](size_t size, size_t steps) {
+    return (size + (size_t{1} << steps) - 1) >> steps;
+  };
+
+  auto params = MakeParams(shape, 5, WaveletTypes::kDB3);
+  params.boundary_mode = drift::BoundaryMode::kOddLength;
+  const SignalN2D signal = {dg.GenerateMatrix2d(rows, columns)};
+  WaveletBuffer buffer(params);
+  REQUIRE(Decompose(&buffer, signal));
+
+  /* The subbands of a step have half of its input rounded up */
+  const size_t subbands_per_step = is_1d ? 1 : 3;
+  for (size_t i = 0; i < buffer[0].size(); ++i) {
+    const size_t step = std::min<size_t>(i / subbands_per_step + 1, 5);
+    CAPTURE(i);
+    REQUIRE(buffer[0][i].rows() == side(rows, step));
+    REQUIRE(buffer[0][i].columns() == (is_1d ? 1 : side(columns, step)));
+  }
+
+  SECTION("should compose the signal without padding") {
+    SignalN2D composed(1);
+    REQUIRE(Compose(buffer, &composed));
+    REQUIRE(composed[0].rows() == rows);
+    REQUIRE(composed[0].columns() == columns);
+    REQUIRE(blaze::max(blaze::abs(composed[0] - signal[0])) < 1e-4f);
+
+    REQUIRE(Compose(buffer, &composed, 2));
+    REQUIRE(composed[0].rows() == side(rows, 2));
+    REQUIRE(composed[0].columns() == (is_1d ? 1 : side(columns, 2)));
+
+    if (is_1d) {
+      Signal1D line;
+      REQUIRE(buffer.Compose(&line, 2));
+      REQUIRE(line.size() == side(rows, 2));
+    }
+  }
+
+  SECTION("should keep the mode in the blob") {
+    std::string blob;
+    REQUIRE(buffer.Serialize(&blob));
+    REQUIRE(blob[0] == drift::kSerializationVersion);
+    const auto parsed = WaveletBuffer::Parse(blob);
+    REQUIRE(parsed);
+    REQUIRE(parsed->parameters() == params);
+    REQUIRE(*parsed == buffer);
+
+    /* Padded buffers are still readable by the older versions */
+    WaveletBuffer padded(MakeParams(shape, 5, WaveletTypes::kDB3));
+    REQUIRE(Decompose(&padded, signal));
+    REQUIRE(padded.Serialize(&blob));
+    REQUIRE(blob[0] == drift::kPaddedSerializationVersion);
+    const auto parsed_padded = WaveletBuffer::Parse(blob);
+    REQUIRE(parsed_padded);
+    REQUIRE(parsed_padded->parameters() == padded.parameters());
+    REQUIRE(*parsed_padded == padded);
+  }
+
+  SECTION("should reject a wrong mode in the blob") {
+    /* The padded mode is written with the older version, the last one is
+     * kZeroPadding */
+    for (const uint8_t mode : {uint8_t{0}, uint8_t{3}, uint8_t{255}}) {
+      std::stringstream ss;
+      blaze::Archive archive(ss);
+      archive << drift::kSerializationVersion << params << uint8_t{0}
+              << mode;
+      CAPTURE(mode);
+      REQUIRE_FALSE(WaveletBuffer::Parse(ss.str()));
+    }
+  }
+
+  SECTION("should need the filter bank engine") {
+    REQUIRE_THROWS_AS(
+        drift::WaveletPlan(params, drift::wavelet::Engine::kMatrix),
+        std::runtime_error);
+    const drift::Region region = {
+        .offset = drift::SignalShape(shape.size()), .size = shape};
+    SignalN2D composed;
+    REQUIRE_FALSE(buffer.Compose(region, &composed));
+  }
+}
+
+TEST_CASE("Zero padding", "[wavelets]") {
+  DataGenerator dg;
+  const auto shape = GENERATE(std::vector<size_t>{1001},
+                              std::vector<size_t>{300, 203});
+  CAPTURE(shape);
+  const bool is_1d = shape.size() == 1;
+  const size_t rows = is_1d ? shape[0] : shape[1];
+  const size_t columns = is_1d ? 1 : shape[0];
+
+  auto params = MakeParams(shape, 3, WaveletTypes::kDB3);
+  params.boundary_mode = drift::BoundaryMode::kZeroPadding;
+  const SignalN2D signal = {dg.GenerateMatrix2d(rows, columns)};
+
+  /* The filter bank pads on the fly, the matrix engine pads a copy */
+  WaveletBuffer buffer(std::make_shared<const drift::WaveletPlan>(
+      params, drift::wavelet::Engine::kFilterBank));
+  WaveletBuffer expected(std::make_shared<const drift::WaveletPlan>(
+      params, drift::wavelet::Engine::kMatrix));
+  REQUIRE(Decompose(&buffer, signal));
+  REQUIRE(Decompose(&expected, signal));
+  for (size_t i = 0; i < buffer[0].size(); ++i) {
+    CAPTURE(i);
+    REQUIRE(buffer[0][i].rows() == expected[0][i].rows());
+    REQUIRE(buffer[0][i].columns() == expected[0][i].columns());
+    REQUIRE(blaze::max(blaze::abs(buffer[0][i] - expected[0][i])) < 1e-3f);
+  }
+
+  /* The edges aren't repeated */
+  WaveletBuffer edges(MakeParams(shape, 3, WaveletTypes::kDB3));
+  REQUIRE(Decompose(&edges, signal));
+  const size_t last = buffer[0].size() - 1;
+  REQUIRE(blaze::max(blaze::abs(buffer[0][last] - edges[0][last])) > 0.1f);
+
+  SECTION("should crop the padding on compose") {
+    SignalN2D composed(1);
+    REQUIRE(Compose(buffer, &composed));
+    REQUIRE(composed[0].rows() == rows);
+    REQUIRE(composed[0].columns() == columns);
+    REQUIRE(blaze::max(blaze::abs(composed[0] - signal[0])) < 1e-4f);
+
+    SignalN2D expected_composed(1);
+    REQUIRE(Compose(buffer, &composed, 2));
+    REQUIRE(Compose(expected, &expected_composed, 2));
+    REQUIRE(composed[0].rows() == expected_composed[0].rows());
+    REQUIRE(composed[0].columns() == expected_composed[0].columns());
+    REQUIRE(blaze::max(blaze::abs(composed[0] - expected_composed[0])) <
+            1e-3f);
+
+    if (is_1d) {
+      Signal1D line;
+      REQUIRE(buffer.Compose(&line, 2));
+      REQUIRE(blaze::max(blaze::abs(line - blaze::column(composed[0], 0))) <
+              1e-6f);
+    }
+  }
+
+  SECTION("should keep the mode in the blob") {
+    std::string blob;
+    REQUIRE(buffer.Serialize(&blob));
+    REQUIRE(blob[0] == drift::kSerializationVersion);
+    const auto parsed = WaveletBuffer::Parse(blob);
+    REQUIRE(parsed);
+    REQUIRE(parsed->parameters() == params);
+    REQUIRE(*parsed == buffer);
+  }
+}
+
+TEST_CASE("Compose a region of interest", "[wavelets]") {
+  DataGenerator dg;
+  const auto wavelet_type = GENERATE(WaveletTypes::kNone, WaveletTypes::kDB1,
+                                     WaveletTypes::kDB3, WaveletTypes::kDB5);
+  const auto scale = GENERATE(0, 1, 3);
+  CAPTURE(wavelet_type, scale);
+
+  SECTION("rectangles of a 2D signal") {
+    auto params = MakeParams({203, 150}, 3, wavelet_type);
+    params.signal_number = 2;
+    WaveletBuffer buffer(params);
+    REQUIRE(buffer.Decompose(
+        {dg.GenerateMatrix2d(150, 203), dg.GenerateMatrix2d(150, 203)},
+        NullDenoiseAlgorithm<float>()));
+
+    SignalN2D expected;
+    REQUIRE(buffer.Compose(&expected, scale));
+    const size_t rows = expected[0].rows();
+    const size_t columns = expected[0].columns();
+
+    /* The corners need the coefficients wrapped around the sides */
+    const std::vector<drift::Region> regions = {
+        {.offset = {0, 0}, .size = {columns, rows}},
+        {.offset = {0, 0}, .size = {5, 3}},
+        {.offset = {columns - 7, rows - 4}, .size = {7, 4}},
+        {.offset = {columns / 3, rows / 2}, .size = {columns / 4, 1}}};
+    for (const auto &region : regions) {
+      SignalN2D composed;
+      REQUIRE(buffer.Compose(region, &composed, scale));
+      REQUIRE(composed.size() == 2);
+      for (size_t ch = 0; ch < 2; ++ch) {
+        REQUIRE(composed[ch].rows() == region.size[1]);
+        REQUIRE(composed[ch].columns() == region.size[0]);
+        for (size_t i = 0; i < region.size[1]; ++i) {
+          for (size_t j = 0; j < region.size[0]; ++j) {
+            REQUIRE_THAT(
+                composed[ch](i, j),
+                Catch::Matchers::WithinAbs(
+                    expected[ch](region.offset[1] + i, region.offset[0] + j),
+                    1e-4));
+          }
+        }
+      }
+    }
+
+    SignalN2D composed;
+    REQUIRE_FALSE(buffer.Compose({.offset = {0, 0}, .size = {columns + 1, 1}},
+                                 &composed, scale));
+    REQUIRE_FALSE(buffer.Compose({.offset = {0, rows}, .size = {1, 1}},
+                                 &composed, scale));
+    REQUIRE_FALSE(buffer.Compose({.offset = {0}, .size = {1}}, &composed,
+                                 scale));
+  }
+
+  SECTION("ranges of a 1D signal") {
+    WaveletBuffer buffer(MakeParams({1000}, 3, wavelet_type));
+    REQUIRE(buffer.Decompose(Signal1D{dg.GenerateMatrix1d(1000)},
+                             NullDenoiseAlgorithm<float>()));
+
+    Signal1D expected;
+    REQUIRE(buffer.Compose(&expected, scale));
+    const std::vector<std::pair<size_t, size_t>> ranges = {
+        {0, expected.size()},
+        {0, 10},
+        {expected.size() - 9, 9},
+        {expected.size() / 2, 33}};
+    for (const auto &[offset, size] : ranges) {
+      Signal1D composed;
+      REQUIRE(buffer.Compose({.offset = {offset}, .size = {size}}, &composed,
+                             scale));
+      REQUIRE(composed.size() == size);
+      for (size_t i = 0; i < size; ++i) {
+        REQUIRE_THAT(composed[i],
+                     Catch::Matchers::WithinAbs(expected[offset + i], 1e-4));
+      }
+    }
+
+    Signal1D composed;
+    REQUIRE_FALSE(buffer.Compose({.offset = {expected.size()}, .size = {1}},
+                                 &composed, scale));
+  }
+}
+
+TEST_CASE("Compose with a resolution cache", "[wavelets]") {
+  DataGenerator dg;
+  const auto engine = GENERATE(drift::wavelet::Engine::kFilterBank,
+                               drift::wavelet::Engine::kLifting);
+  const auto shape = GENERATE(std::vector<size_t>{203, 150},
+                              std::vector<size_t>{1000});
+  CAPTURE(engine, shape.size());
+
+  auto params = MakeParams(shape, 4, WaveletTypes::kDB3);
+  params.signal_number = 2;
+  SignalN2D signals(2);
+  for (auto &signal : signals) {
+    signal = shape.size() == 2 ? dg.GenerateMatrix2d(150, 203)
+                               : dg.GenerateMatrix2d(1000, 1);
+  }
+
+  const auto plan = std::make_shared<const drift::WaveletPlan>(params, engine);
+  WaveletBuffer expected(plan);
+  WaveletBuffer buffer(plan);
+  buffer.SetResolutionCache(16 << 20);
+  REQUIRE(expected.Decompose(signals, NullDenoiseAlgorithm<float>()));
+  REQUIRE(buffer.Decompose(signals, NullDenoiseAlgorithm<float>()));
+
+  /* Zoom in, out and in again */
+  for (const int scale : {4, 3, 2, 1, 0, 2, 3, 0}) {
+    CAPTURE(scale);
+    SignalN2D expected_composed;
+    SignalN2D composed;
+    REQUIRE(expected.Compose(&expected_composed, scale));
+    REQUIRE(buffer.Compose(&composed, scale));
+    REQUIRE(composed == expected_composed);
+  }
+
+  SECTION("should drop the levels when the subbands change") {
+    expected[1][0] *= 2;
+    buffer[1][0] *= 2;
+    SignalN2D expected_composed;
+    SignalN2D composed;
+    REQUIRE(expected.Compose(&expected_composed, 0));
+    REQUIRE(buffer.Compose(&composed, 0));
+    REQUIRE(composed == expected_composed);
+
+    for (auto *decompositions :
+         {&expected.decompositions(), &buffer.decompositions()}) {
+      auto &channel = (*decompositions)[0];
+      channel[channel.size() - 1] = 0;
+    }
+    REQUIRE(expected.Compose(&expected_composed, 2));
+    REQUIRE(buffer.Compose(&composed, 2));
+    REQUIRE(composed == expected_composed);
+  }
+
+  SECTION("should compose into memory of the caller") {
+    if (shape.size() == 1) {
+      SignalN2D expected_composed;
+      REQUIRE(expected.Compose(&expected_composed, 1));
+      std::vector<float> composed(expected_composed[0].rows());
+      REQUIRE(buffer.Compose(std::span<float>(composed), 1));
+      for (size_t i = 0; i < composed.size(); ++i) {
+        REQUIRE(composed[i] == expected_composed[0](i, 0));
+      }
+    }
+  }
+}
+
 // TODO(victor1234): for future wavelet work
 /*
 TEST_CASE("sinus", "[wavelets]") {
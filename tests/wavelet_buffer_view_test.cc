@@ -82,6 +82,13 @@ TEST_CASE("Wavelet Buffer View 2D", "[generators]") {
       REQUIRE(data.size() == 1);
       REQUIRE(data[0] == (kChannel + 1));
     }
+
+    SECTION("region") {
+      REQUIRE(view.Compose({.offset = {1, 2}, .size = {3, 2}}, &data));
+      REQUIRE(data.size() == 1);
+      const Signal2D expected = blaze::submatrix(kChannel + 1, 2, 1, 2, 3);
+      REQUIRE(blaze::max(blaze::abs(data[0] - expected)) < 1e-4f);
+    }
   }
 
   SECTION("should cast to buffer with copping") {
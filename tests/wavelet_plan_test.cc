@@ -0,0 +1,177 @@
+// Copyright 2023 PANDA GmbH
+
+#include "wavelet_buffer/wavelet_plan.h"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include "wavelet_buffer/wavelet_buffer.h"
+#include "signal_generators.h"
+
+using drift::DecompositionSize;
+using drift::NullDenoiseAlgorithm;
+using drift::NWaveletDecomposition;
+using drift::Signal2D;
+using drift::SignalN2D;
+using drift::WaveletBuffer;
+using drift::WaveletDecomposition;
+using drift::WaveletParameters;
+using drift::WaveletPlan;
+using drift::WaveletTypes;
+using drift::wavelet::Engine;
+
+TEST_CASE("WaveletPlan") {
+  const auto shape =
+      GENERATE(std::vector<size_t>{300}, std::vector<size_t>{100, 70});
+  const auto engine =
+      GENERATE(Engine::kMatrix, Engine::kFilterBank, Engine::kLifting);
+  CAPTURE(shape, engine);
+
+  const WaveletParameters params{
+      .signal_shape = shape,
+      .signal_number = 2,
+      .decomposition_steps = 3,
+      .wavelet_type = WaveletTypes::kDB3,
+  };
+  const auto data = GenerateSignals(params.signal_number, shape.back(),
+                                    shape.size() > 1 ? shape[0] : 1);
+
+  const WaveletPlan plan(params, engine);
+  REQUIRE(plan.engine() == engine);
+  REQUIRE(plan.parameters() == params);
+  REQUIRE(plan.padded_shape() ==
+          drift::internal::CalcPaddedSize(params.wavelet_type,
+                                          params.signal_shape,
+                                          params.decomposition_steps));
+
+  SECTION("should decompose as the transform without plan") {
+    NWaveletDecomposition expected(
+        params.signal_number, WaveletDecomposition(DecompositionSize(params)));
+    REQUIRE(drift::internal::DecomposeImpl(params, &expected, data,
+                                           NullDenoiseAlgorithm<float>(), 0,
+                                           params.signal_number, engine));
+
+    NWaveletDecomposition decomposition(
+        params.signal_number, WaveletDecomposition(DecompositionSize(params)));
+    /* The plan is reused, every call gives the same result */
+    for (int i = 0; i < 2; ++i) {
+      REQUIRE(plan.Decompose(data, NullDenoiseAlgorithm<float>(),
+                             &decomposition, 0, params.signal_number));
+      REQUIRE(decomposition == expected);
+    }
+
+    SignalN2D composed;
+    REQUIRE(plan.Compose(decomposition, &composed, 0, 0,
+                         params.signal_number));
+    SignalN2D expected_composed;
+    REQUIRE(drift::internal::ComposeImpl(params, &expected_composed, expected,
+                                         0, 0, params.signal_number, engine));
+    REQUIRE(composed == expected_composed);
+  }
+
+  SECTION("should compose partially as the composition of signals") {
+    NWaveletDecomposition decomposition(
+        params.signal_number, WaveletDecomposition(DecompositionSize(params)));
+    REQUIRE(plan.Decompose(data, NullDenoiseAlgorithm<float>(),
+                           &decomposition, 0, params.signal_number));
+
+    const int subbands_per_wt =
+        drift::internal::SubbandsPerWaveletTransform(params);
+    for (int steps = 0; steps <= params.decomposition_steps; ++steps) {
+      CAPTURE(steps);
+      const auto partial = drift::internal::ComposeImpl(
+          params, decomposition, steps, 1, 1, engine);
+      REQUIRE(partial.size() == 1);
+      REQUIRE(partial[0].size() == steps * subbands_per_wt + 1);
+      for (int i = 0; i < steps * subbands_per_wt; ++i) {
+        REQUIRE(partial[0][i] == decomposition[1][i]);
+      }
+
+      SignalN2D composed;
+      REQUIRE(plan.Compose(decomposition, &composed, steps, 1, 1));
+
+      /* The approximation keeps the padding and the scale */
+      drift::SignalShape scaled_shape;
+      for (auto size : shape) {
+        scaled_shape.push_back(size >> steps);
+      }
+      Signal2D approximation = partial[0][partial[0].size() - 1];
+      drift::internal::CropPadding(&approximation, scaled_shape);
+      if (steps > 0) {
+        approximation /= std::pow(shape.size() == 2 ? 2 : std::sqrt(2), steps);
+      }
+      REQUIRE(approximation == composed[0]);
+    }
+  }
+}
+
+TEST_CASE("WaveletPlan shared by buffers") {
+  const WaveletParameters params{
+      .signal_shape = {100, 100},
+      .signal_number = 1,
+      .decomposition_steps = 2,
+      .wavelet_type = WaveletTypes::kDB2,
+  };
+  const auto data = GenerateSignals(1, 100, 100);
+
+  const auto plan = std::make_shared<const WaveletPlan>(params);
+  WaveletBuffer shared(plan);
+  WaveletBuffer own(params);
+
+  REQUIRE(shared.plan() == plan);
+  REQUIRE(shared.parameters() == own.parameters());
+
+  REQUIRE(shared.Decompose(data, NullDenoiseAlgorithm<float>()));
+  REQUIRE(own.Decompose(data, NullDenoiseAlgorithm<float>()));
+  REQUIRE(shared == own);
+
+  /* Copies share the plan */
+  const WaveletBuffer copy = shared;
+  REQUIRE(copy.plan() == plan);
+}
+
+TEST_CASE("WaveletPlan validates parameters") {
+  WaveletParameters params{
+      .signal_shape = {100, 100, 1},
+      .signal_number = 1,
+      .decomposition_steps = 1,
+      .wavelet_type = WaveletTypes::kDB2,
+  };
+  REQUIRE_THROWS_WITH(WaveletPlan(params),
+                      "Only 1D & 2D decomposition is supported");
+
+  params.signal_shape = {100, 100};
+  params.decomposition_steps = 10;
+  REQUIRE_THROWS_WITH(WaveletPlan(params),
+                      "Too many decomposition steps for this signal size "
+                      "with that wavelet type (must be max 5).");
+
+  params.wavelet_type = WaveletTypes::kNone;
+  REQUIRE(WaveletPlan(params).parameters().decomposition_steps == 0);
+}
+
+TEST_CASE("WaveletPlan with a prewarmed matrix cache") {
+  /* A shape no other test uses, so the matrices are built here */
+  const WaveletParameters params{
+      .signal_shape = {222, 134},
+      .signal_number = 3,
+      .decomposition_steps = 2,
+      .wavelet_type = WaveletTypes::kDB4,
+  };
+  drift::PrewarmMatrixCache(params);
+  const auto prewarmed = drift::GetMatrixCacheStats();
+
+  /* The plans of any channel number find all matrices */
+  const WaveletPlan plan(params, Engine::kMatrix);
+  auto other_params = params;
+  other_params.signal_number = 1;
+  const WaveletPlan other_plan(other_params, Engine::kMatrix);
+
+  const auto stats = drift::GetMatrixCacheStats();
+  REQUIRE(stats.misses == prewarmed.misses);
+  REQUIRE(stats.hits == prewarmed.hits + 16);
+}
@@ -0,0 +1,235 @@
+// Copyright 2023 PANDA GmbH
+
+#include "wavelet_buffer/wavelet_stream.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include "internal/dwt_kernels.h"
+#include "wavelet_buffer/wavelet_buffer.h"
+#include "signal_generators.h"
+
+using drift::DataType;
+using drift::NullDenoiseAlgorithm;
+using drift::RowStreamDecomposer;
+using drift::Signal1D;
+using drift::SignalN2D;
+using drift::StreamComposer;
+using drift::StreamDecomposer;
+using drift::StreamSubbands;
+using drift::WaveletBuffer;
+using drift::WaveletDecomposition;
+using drift::WaveletParameters;
+using drift::WaveletTypes;
+
+/**
+ * Push the samples in chunks of random size and collect the coefficients
+ */
+static StreamSubbands DecomposeInChunks(StreamDecomposer *decomposer,
+                                        const std::vector<DataType> &samples,
+                                        size_t max_chunk) {
+  std::default_random_engine random_engine;
+  std::uniform_int_distribution<size_t> chunk_size(0, max_chunk);
+  StreamSubbands subbands;
+  for (size_t pos = 0; pos < samples.size();) {
+    const size_t size = std::min(chunk_size(random_engine),
+                                 samples.size() - pos);
+    decomposer->Push({samples.data() + pos, size}, &subbands);
+    pos += size;
+  }
+  return subbands;
+}
+
+TEST_CASE("StreamDecomposer") {
+  const auto wavelet_type =
+      GENERATE(WaveletTypes::kDB1, WaveletTypes::kDB3, WaveletTypes::kDB5);
+  const size_t steps = GENERATE(1, 3, 5);
+  CAPTURE(wavelet_type, steps);
+
+  const auto samples = GenerateSamples(5000);
+  StreamDecomposer decomposer(wavelet_type, steps);
+  StreamSubbands expected;
+  decomposer.Push(samples, &expected);
+  REQUIRE(expected.size() == steps + 1);
+
+  SECTION("should not depend on the chunks") {
+    const size_t max_chunk = GENERATE(1, 7, 300);
+    StreamDecomposer chunked(wavelet_type, steps);
+    REQUIRE(DecomposeInChunks(&chunked, samples, max_chunk) == expected);
+  }
+
+  SECTION("should give the coefficients of the filter bank") {
+    /* The periodic transform of the signal after the zeros, its
+     * coefficients before the wrap around; the line is strided to run the
+     * scalar kernel with the same order of the additions */
+    const auto filters = drift::wavelet::DaubechiesFilters(wavelet_type * 2);
+    const size_t length = filters.low_pass.size();
+    const size_t size = samples.size() + length - 2;
+    std::vector<DataType> line(2 * size, 0);
+    for (size_t i = 0; i < samples.size(); ++i) {
+      line[2 * (i + length - 2)] = samples[i];
+    }
+
+    std::vector<DataType> low(size / 2);
+    std::vector<DataType> high(size / 2);
+    drift::wavelet::internal::AnalyzeLine(
+        {line.data(), 2}, size,
+        drift::wavelet::internal::FilterTaps{
+            filters.low_pass.data(), filters.high_pass.data(), length},
+        {low.data(), 1}, {high.data(), 1});
+
+    REQUIRE(expected[0].size() == (size - length) / 2 + 1);
+    for (size_t i = 0; i < expected[0].size(); ++i) {
+      REQUIRE(expected[0][i] == high[i]);
+    }
+  }
+
+  SECTION("should give the coefficients of WaveletBuffer after the delay") {
+    /* A signal without padding, the last coefficients of the buffer wrap
+     * around to its start and the stream has no samples for them yet */
+    const size_t size = 4096;
+    WaveletBuffer buffer({.signal_shape = {size},
+                          .signal_number = 1,
+                          .decomposition_steps = steps,
+                          .wavelet_type = wavelet_type});
+    REQUIRE(buffer.Decompose(Signal1D(size, samples.data()),
+                             NullDenoiseAlgorithm<DataType>()));
+
+    StreamDecomposer head(wavelet_type, steps);
+    StreamSubbands subbands;
+    head.Push({samples.data(), size}, &subbands);
+
+    const size_t length = wavelet_type * 2;
+    for (size_t i = 0; i < subbands.size(); ++i) {
+      CAPTURE(i);
+      const auto &subband = buffer.decompositions()[0][i];
+      const size_t delay = head.delay(i);
+      REQUIRE(delay <= length);
+      REQUIRE(subbands[i].size() >= delay);
+
+      const size_t count = subbands[i].size() - delay;
+      REQUIRE(count <= subband.rows());
+      REQUIRE(count + length >= subband.rows());
+      for (size_t k = 0; k < count; ++k) {
+        REQUIRE(subbands[i][delay + k] ==
+                Catch::Approx(subband(k, 0)).margin(1e-4));
+      }
+    }
+  }
+
+  SECTION("should compose the samples") {
+    StreamComposer composer(wavelet_type, steps);
+    std::vector<DataType> restored;
+    REQUIRE(composer.Push(expected, &restored));
+
+    /* The last samples wait for the coefficients of the next ones */
+    REQUIRE(restored.size() <= samples.size());
+    REQUIRE(restored.size() + (size_t{1} << steps) * wavelet_type * 2 >=
+            samples.size());
+    for (size_t i = 0; i < restored.size(); ++i) {
+      REQUIRE(restored[i] == Catch::Approx(samples[i]).margin(1e-4));
+    }
+
+    /* Composing in chunks gives the same samples */
+    StreamDecomposer chunked_decomposer(wavelet_type, steps);
+    StreamComposer chunked_composer(wavelet_type, steps);
+    std::vector<DataType> chunked_restored;
+    for (size_t pos = 0; pos < samples.size(); pos += 100) {
+      StreamSubbands chunk;
+      chunked_decomposer.Push(
+          {samples.data() + pos, std::min<size_t>(100, samples.size() - pos)},
+          &chunk);
+      REQUIRE(chunked_composer.Push(chunk, &chunked_restored));
+    }
+    REQUIRE(chunked_restored == restored);
+
+    REQUIRE_FALSE(composer.Push(StreamSubbands(steps), &restored));
+  }
+}
+
+TEST_CASE("Stream without wavelet") {
+  const auto samples = GenerateSamples(100);
+  StreamDecomposer decomposer(WaveletTypes::kNone, 3);
+  REQUIRE(decomposer.decomposition_steps() == 0);
+
+  StreamSubbands subbands;
+  decomposer.Push(samples, &subbands);
+  REQUIRE(subbands == StreamSubbands{samples});
+
+  StreamComposer composer(WaveletTypes::kNone, 3);
+  std::vector<DataType> restored;
+  REQUIRE(composer.Push(subbands, &restored));
+  REQUIRE(restored == samples);
+}
+
+TEST_CASE("RowStreamDecomposer") {
+  const auto wavelet_type =
+      GENERATE(WaveletTypes::kNone, WaveletTypes::kDB1, WaveletTypes::kDB3,
+               WaveletTypes::kDB5);
+  CAPTURE(wavelet_type);
+
+  /* The frame needs padding in both directions */
+  const WaveletParameters params = {
+      .signal_shape = {203, 150},
+      .signal_number = 1,
+      .decomposition_steps = wavelet_type != WaveletTypes::kNone ? 3u : 0u,
+      .wavelet_type = wavelet_type};
+  WaveletBuffer expected(params);
+
+  /* The rows of the subbands are collected into a decomposition */
+  WaveletDecomposition decomposition(expected[0].size());
+  size_t sunk_rows = 0;
+  RowStreamDecomposer decomposer(
+      params, [&](size_t subband, size_t row, std::span<const DataType> data) {
+        auto &matrix = decomposition[subband];
+        if (matrix.columns() != data.size()) {
+          matrix.resize(0, data.size());
+        }
+        if (matrix.rows() <= row) {
+          matrix.resize(row + 1, data.size(), true);
+        }
+        std::copy(data.begin(), data.end(), matrix.begin(row));
+        ++sunk_rows;
+      });
+
+  /* Two frames one after another */
+  for (int frame = 0; frame < 2; ++frame) {
+    const auto samples = GenerateSamples(203 * 150 * (frame + 1));
+    SignalN2D signal = {blaze::DynamicMatrix<DataType>(150, 203)};
+    for (size_t i = 0; i < 150; ++i) {
+      for (size_t j = 0; j < 203; ++j) {
+        signal[0](i, j) = samples[samples.size() - 203 * 150 + i * 203 + j];
+      }
+    }
+    REQUIRE(expected.Decompose(signal, NullDenoiseAlgorithm<DataType>()));
+
+    sunk_rows = 0;
+    for (size_t i = 0; i < 150; ++i) {
+      REQUIRE(decomposer.Push({signal[0].data(i), 203}));
+    }
+
+    /* Every row of the subbands once with the same bits */
+    size_t rows = 0;
+    for (size_t i = 0; i < decomposition.size(); ++i) {
+      const auto &subband = expected[0][i];
+      rows += subband.rows();
+      REQUIRE(decomposition[i].rows() == subband.rows());
+      REQUIRE(decomposition[i].columns() == subband.columns());
+      size_t mismatches = 0;
+      for (size_t r = 0; r < subband.rows(); ++r) {
+        for (size_t c = 0; c < subband.columns(); ++c) {
+          mismatches += decomposition[i](r, c) != subband(r, c);
+        }
+      }
+      REQUIRE(mismatches == 0);
+    }
+    REQUIRE(sunk_rows == rows);
+  }
+
+  REQUIRE_FALSE(decomposer.Push(std::vector<DataType>(202)));
+}
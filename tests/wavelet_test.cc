@@ -2,6 +2,8 @@
 
 #include "wavelet_buffer/wavelet.h"
 
+#include <random>
+
 #include <catch2/catch_approx.hpp>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/generators/catch_generators.hpp>
@@ -10,11 +12,22 @@
 
 using drift::DataType;
 using drift::Signal1D;
+using drift::Signal2D;
 using drift::ZeroDerivativePaddingAlgorithm;
+using drift::wavelet::DaubechiesFilters;
+using drift::wavelet::DaubechiesLifting;
 using drift::wavelet::DaubechiesMat;
 using drift::wavelet::dbwavf;
 using drift::wavelet::Orthfilt;
 
+static Signal2D GenerateImage(size_t rows, size_t columns) {
+  std::default_random_engine random_engine;
+  std::normal_distribution<DataType> distribution;
+  return blaze::generate<blaze::rowMajor>(
+      rows, columns,
+      [&](size_t i, size_t j) { return distribution(random_engine); });
+}
+
 TEST_CASE("DaubechiesMat", "[wavelet]") {
   auto wnum = GENERATE(1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
   const auto w = dbwavf(wnum);
@@ -100,3 +113,147 @@ TEST_CASE("dbwavf", "[wavelet]") {
     REQUIRE(Catch::Approx(r[i]) == coeffs[wnum][i]);
   }
 }
+
+TEST_CASE("DaubechiesFilters", "[wavelet]") {
+  const int wnum = GENERATE(1, 2, 3, 4, 5);
+  const auto filters = DaubechiesFilters(wnum * 2);
+  const auto dmat = DaubechiesMat(24, wnum * 2);
+
+  const size_t fl = wnum * 2;
+  REQUIRE(filters.low_pass.size() == fl);
+  REQUIRE(filters.high_pass.size() == fl);
+  REQUIRE(blaze::subvector(blaze::row(dmat, 0), 0, fl) ==
+          blaze::trans(filters.low_pass));
+  REQUIRE(blaze::subvector(blaze::row(dmat, dmat.rows() / 2), 0, fl) ==
+          blaze::trans(filters.high_pass));
+}
+
+TEST_CASE("Filter bank transform matches matrix transform", "[wavelet]") {
+  const int wnum = GENERATE(1, 2, 3, 4, 5);
+  CAPTURE(wnum);
+
+  const auto filters = DaubechiesFilters(wnum * 2);
+
+  SECTION("2D signal") {
+    const size_t rows = 32;
+    const size_t columns = 48;
+    const auto x = GenerateImage(rows, columns);
+
+    const auto dmat_w = DaubechiesMat(columns, wnum * 2);
+    const auto dmat_h = DaubechiesMat(rows, wnum * 2);
+
+    const Signal2D expected = drift::wavelet::dwt2s(x, dmat_w, dmat_h);
+    const Signal2D result = drift::wavelet::dwt2s(x, filters);
+    REQUIRE(blaze::max(blaze::abs(result - expected)) < 1e-5);
+
+    const auto [ll, lh, hl, hh] = drift::wavelet::dwt2(x, filters);
+    const Signal2D restored = drift::wavelet::idwt2(ll, lh, hl, hh, filters);
+    const Signal2D expected_restored = drift::wavelet::idwt2(
+        ll, lh, hl, hh, blaze::CompressedMatrix<DataType>(blaze::trans(dmat_w)),
+        blaze::CompressedMatrix<DataType>(blaze::trans(dmat_h)));
+    REQUIRE(blaze::max(blaze::abs(restored - expected_restored)) < 1e-5);
+    REQUIRE(blaze::max(blaze::abs(restored - x)) < 1e-5);
+  }
+
+  SECTION("1D signal") {
+    const Signal1D x = blaze::column(GenerateImage(64, 1), 0);
+
+    blaze::CompressedMatrix<DataType> dmat(2, filters.low_pass.size());
+    blaze::row(dmat, 0) = blaze::trans(filters.low_pass);
+    blaze::row(dmat, 1) = blaze::trans(filters.high_pass);
+
+    const auto [expected_low, expected_high] = drift::wavelet::dwt(x, dmat);
+    const auto [low, high] = drift::wavelet::dwt(x, filters);
+    REQUIRE(blaze::max(blaze::abs(low - expected_low)) < 1e-5);
+    REQUIRE(blaze::max(blaze::abs(high - expected_high)) < 1e-5);
+
+    const Signal1D restored = drift::wavelet::idwt(low, high, filters);
+    REQUIRE(blaze::max(blaze::abs(restored - x)) < 1e-5);
+  }
+}
+
+TEST_CASE("Fused dwt2 writes subbands directly", "[wavelet]") {
+  const int wnum = GENERATE(1, 3, 5);
+  CAPTURE(wnum);
+
+  const auto filters = DaubechiesFilters(wnum * 2);
+  const size_t rows = 40;
+  const size_t columns = 24;
+  const auto x = GenerateImage(rows, columns);
+
+  /* Outputs of a wrong size are resized */
+  Signal2D ll(1, 1);
+  Signal2D lh;
+  Signal2D hl(rows, columns);
+  Signal2D hh(3, 100);
+  drift::wavelet::dwt2(x, filters, &ll, &lh, &hl, &hh);
+
+  const Signal2D whole = drift::wavelet::dwt2s(x, filters);
+  const size_t h = rows / 2;
+  const size_t w = columns / 2;
+  REQUIRE(ll == blaze::submatrix(whole, 0, 0, h, w));
+  REQUIRE(lh == blaze::submatrix(whole, h, 0, h, w));
+  REQUIRE(hl == blaze::submatrix(whole, 0, w, h, w));
+  REQUIRE(hh == blaze::submatrix(whole, h, w, h, w));
+
+  const Signal2D restored = drift::wavelet::idwt2(ll, lh, hl, hh, filters);
+  const Signal2D expected = drift::wavelet::idwt2s(whole, filters);
+  REQUIRE(blaze::max(blaze::abs(restored - expected)) < 1e-5);
+}
+
+TEST_CASE("Lifting scheme matches filter bank transform", "[wavelet]") {
+  const int wnum = GENERATE(1, 2, 3, 4, 5);
+  /* Subbands of even and odd length */
+  const size_t half = GENERATE(16, 17);
+  CAPTURE(wnum, half);
+
+  const auto filters = DaubechiesFilters(wnum * 2);
+  const auto scheme = DaubechiesLifting(wnum * 2);
+
+  SECTION("2D signal") {
+    const size_t rows = 2 * half;
+    const size_t columns = 2 * half + 16;
+    const auto x = GenerateImage(rows, columns);
+
+    const Signal2D expected = drift::wavelet::dwt2s(x, filters);
+    Signal2D result = x;
+    drift::wavelet::dwt2s(&result, scheme);
+    REQUIRE(blaze::max(blaze::abs(result - expected)) < 1e-4);
+
+    drift::wavelet::idwt2s(&result, scheme);
+    REQUIRE(blaze::max(blaze::abs(result - x)) < 1e-4);
+
+    const auto [ll, lh, hl, hh] = drift::wavelet::dwt2(x, scheme);
+    const auto [expected_ll, expected_lh, expected_hl, expected_hh] =
+        drift::wavelet::dwt2(x, filters);
+    REQUIRE(blaze::max(blaze::abs(ll - expected_ll)) < 1e-4);
+    REQUIRE(blaze::max(blaze::abs(lh - expected_lh)) < 1e-4);
+    REQUIRE(blaze::max(blaze::abs(hl - expected_hl)) < 1e-4);
+    REQUIRE(blaze::max(blaze::abs(hh - expected_hh)) < 1e-4);
+
+    const Signal2D restored = drift::wavelet::idwt2(ll, lh, hl, hh, scheme);
+    REQUIRE(blaze::max(blaze::abs(restored - x)) < 1e-4);
+  }
+
+  SECTION("1D signal") {
+    const Signal1D x = blaze::column(GenerateImage(2 * half, 1), 0);
+
+    const auto [expected_low, expected_high] = drift::wavelet::dwt(x, filters);
+    const auto [low, high] = drift::wavelet::dwt(x, scheme);
+    REQUIRE(blaze::max(blaze::abs(low - expected_low)) < 1e-4);
+    REQUIRE(blaze::max(blaze::abs(high - expected_high)) < 1e-4);
+
+    const Signal1D restored = drift::wavelet::idwt(low, high, scheme);
+    REQUIRE(blaze::max(blaze::abs(restored - x)) < 1e-4);
+
+    Signal1D line = x;
+    drift::wavelet::dwt(&line, scheme);
+    REQUIRE(blaze::max(blaze::abs(blaze::subvector(line, 0, half) - low)) <
+            1e-4);
+    REQUIRE(blaze::max(blaze::abs(blaze::subvector(line, half, half) -
+                                  high)) < 1e-4);
+
+    drift::wavelet::idwt(&line, scheme);
+    REQUIRE(blaze::max(blaze::abs(line - x)) < 1e-4);
+  }
+}
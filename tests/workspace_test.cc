@@ -0,0 +1,246 @@
+// Copyright 2023 PANDA GmbH
+
+#include "wavelet_buffer/workspace.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include "wavelet_buffer/wavelet_buffer.h"
+#include "wavelet_buffer/wavelet_plan.h"
+#include "signal_generators.h"
+
+using drift::DecompositionSize;
+using drift::DenoiseAlgorithm;
+using drift::NullDenoiseAlgorithm;
+using drift::NWaveletDecomposition;
+using drift::SignalN2D;
+using drift::SimpleDenoiseAlgorithm;
+using drift::ThresholdAbsDenoiseAlgorithm;
+using drift::WaveletBuffer;
+using drift::WaveletDecomposition;
+using drift::WaveletParameters;
+using drift::WaveletPlan;
+using drift::WaveletTypes;
+using drift::Workspace;
+
+/**
+ * Memory resource counting the allocations
+ */
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  size_t allocations = 0;
+  size_t deallocations = 0;
+
+ private:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    ++allocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    ++deallocations;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(
+      const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+/**
+ * Pointers to the memory of all subbands
+ */
+static std::vector<const float *> SubbandData(
+    const NWaveletDecomposition &decomposition) {
+  std::vector<const float *> pointers;
+  for (const auto &subbands : decomposition) {
+    for (const auto &subband : subbands) {
+      pointers.push_back(subband.data());
+    }
+  }
+  return pointers;
+}
+
+TEST_CASE("Workspace") {
+  CountingResource resource;
+
+  {
+    Workspace workspace(&resource);
+    REQUIRE(workspace.capacity() == 0);
+
+    SECTION("should align arrays to a cache line") {
+      for (size_t count : {1, 3, 17, 100}) {
+        const auto *data = workspace.Allocate<float>(count);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(data) % 64 == 0);
+      }
+    }
+
+    SECTION("should keep the objects after reset") {
+      auto &line = workspace.Object<std::vector<float>>();
+      line.resize(100);
+      workspace.Reset();
+      REQUIRE(&workspace.Object<std::vector<float>>() == &line);
+      REQUIRE(workspace.Object<std::vector<float>>().size() == 100);
+      REQUIRE(&workspace.Object<std::vector<double>>() !=
+              static_cast<void *>(&line));
+    }
+
+    SECTION("should merge the blocks on reset") {
+      auto allocate = [&workspace] {
+        for (size_t count = 1; count < 100000; count *= 2) {
+          workspace.Allocate<double>(count);
+        }
+      };
+
+      allocate();
+      REQUIRE(resource.allocations > 1);
+      workspace.Reset();
+
+      const auto allocations = resource.allocations;
+      const auto capacity = workspace.capacity();
+      for (int i = 0; i < 3; ++i) {
+        allocate();
+        workspace.Reset();
+      }
+      REQUIRE(resource.allocations == allocations);
+      REQUIRE(workspace.capacity() == capacity);
+    }
+  }
+
+  REQUIRE(resource.allocations == resource.deallocations);
+}
+
+TEST_CASE("Transforms with a workspace") {
+  const auto shape =
+      GENERATE(std::vector<size_t>{300}, std::vector<size_t>{100, 70});
+  const auto wavelet_type = GENERATE(WaveletTypes::kDB1, WaveletTypes::kDB3,
+                                     WaveletTypes::kDB5);
+  CAPTURE(shape, wavelet_type);
+
+  const WaveletParameters params{
+      .signal_shape = shape,
+      .signal_number = 2,
+      .decomposition_steps = 3,
+      .wavelet_type = wavelet_type,
+  };
+  const auto data = GenerateSignals(params.signal_number, shape.back(),
+                                    shape.size() > 1 ? shape[0] : 1);
+
+  const NullDenoiseAlgorithm<float> null_denoiser;
+  const ThresholdAbsDenoiseAlgorithm<float> threshold_denoiser(0.1, 0.5);
+  const SimpleDenoiseAlgorithm<float> simple_denoiser(0.5);
+  const DenoiseAlgorithm<float> *denoiser =
+      GENERATE_COPY(&null_denoiser, &threshold_denoiser, &simple_denoiser);
+
+  const WaveletPlan plan(params);
+  CountingResource resource;
+  Workspace workspace(&resource);
+
+  SECTION("should decompose and compose as without workspace") {
+    NWaveletDecomposition expected(
+        params.signal_number, WaveletDecomposition(DecompositionSize(params)));
+    REQUIRE(plan.Decompose(data, *denoiser, &expected, 0,
+                           params.signal_number));
+
+    NWaveletDecomposition decomposition(
+        params.signal_number, WaveletDecomposition(DecompositionSize(params)));
+    REQUIRE(plan.Decompose(data, *denoiser, &decomposition, 0,
+                           params.signal_number, &workspace));
+    REQUIRE(decomposition == expected);
+
+    for (int scale_factor = 0; scale_factor <= params.decomposition_steps;
+         ++scale_factor) {
+      SignalN2D expected_composed;
+      REQUIRE(plan.Compose(expected, &expected_composed, scale_factor, 0,
+                           params.signal_number));
+
+      SignalN2D composed;
+      REQUIRE(plan.Compose(decomposition, &composed, scale_factor, 0,
+                           params.signal_number, &workspace));
+      REQUIRE(composed == expected_composed);
+    }
+  }
+
+  SECTION("should not allocate after the first call") {
+    NWaveletDecomposition decomposition(
+        params.signal_number, WaveletDecomposition(DecompositionSize(params)));
+    SignalN2D composed;
+    REQUIRE(plan.Decompose(data, *denoiser, &decomposition, 0,
+                           params.signal_number, &workspace));
+    REQUIRE(plan.Compose(decomposition, &composed, 0, 0, params.signal_number,
+                         &workspace));
+
+    const auto allocations = resource.allocations;
+    const auto subbands = SubbandData(decomposition);
+    const auto signal = composed[0].data();
+
+    bool succeeded = true;
+    for (int i = 0; i < 3; ++i) {
+      succeeded &= plan.Decompose(data, *denoiser, &decomposition, 0,
+                                  params.signal_number, &workspace);
+      succeeded &= plan.Compose(decomposition, &composed, 0, 0,
+                                params.signal_number, &workspace);
+    }
+
+    REQUIRE(succeeded);
+    REQUIRE(resource.allocations == allocations);
+    /* The subbands and the signals are overwritten in place */
+    REQUIRE(SubbandData(decomposition) == subbands);
+    REQUIRE(composed[0].data() == signal);
+  }
+}
+
+TEST_CASE("WaveletBuffer with a workspace") {
+  const WaveletParameters params{
+      .signal_shape = {100, 100},
+      .signal_number = 1,
+      .decomposition_steps = 2,
+      .wavelet_type = WaveletTypes::kDB2,
+  };
+  const auto data = GenerateSignals(1, 100, 100);
+
+  Workspace workspace;
+  WaveletBuffer buffer(params);
+  WaveletBuffer expected(params);
+  buffer.AttachWorkspace(&workspace);
+
+  REQUIRE(buffer.Decompose(data, NullDenoiseAlgorithm<float>()));
+  REQUIRE(expected.Decompose(data, NullDenoiseAlgorithm<float>()));
+  REQUIRE(buffer == expected);
+
+  SignalN2D composed;
+  SignalN2D expected_composed;
+  REQUIRE(buffer.Compose(&composed));
+  REQUIRE(expected.Compose(&expected_composed));
+  REQUIRE(composed == expected_composed);
+  REQUIRE(workspace.capacity() > 0);
+
+  SECTION("should compose concurrently") {
+    /* The assertions aren't thread-safe, the threads only compose */
+    std::vector<SignalN2D> results(4);
+    std::vector<std::thread> threads;
+    std::atomic<size_t> failures = 0;
+    for (auto &result : results) {
+      threads.emplace_back([&buffer, &result, &failures] {
+        for (int i = 0; i < 10; ++i) {
+          failures += !buffer.Compose(&result);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    REQUIRE(failures == 0);
+    for (const auto &result : results) {
+      REQUIRE(result == expected_composed);
+    }
+  }
+}
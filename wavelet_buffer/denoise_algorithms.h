@@ -5,8 +5,11 @@
 #include <blaze/Blaze.h>
 
 #include <algorithm>
+#include <memory>
 #include <tuple>
 
+#include "wavelet_buffer/workspace.h"
+
 namespace drift {
 /**
  * Interface for different algorithms to reduce the noise in subbands
@@ -29,6 +32,22 @@ class DenoiseAlgorithm {
                            const size_t step = 0) const = 0;
   virtual Signal2D Denoise(const Signal2D &data,
                            const size_t step = 0) const = 0;
+
+  /**
+   * Remove noise from the signal in place, the default implementation calls
+   * Denoise()
+   * @param data the signal, replaced with the "clean" one
+   * @param step denoise step number
+   * @param workspace scratch memory, it may be nullptr
+   */
+  virtual void DenoiseInPlace(Signal1D &data, size_t step = 0,
+                              Workspace *workspace = nullptr) const {
+    data = Denoise(data, step);
+  }
+  virtual void DenoiseInPlace(Signal2D &data, size_t step = 0,
+                              Workspace *workspace = nullptr) const {
+    data = Denoise(data, step);
+  }
 };
 
 /**
@@ -47,6 +66,11 @@ class NullDenoiseAlgorithm : public DenoiseAlgorithm<T> {
   Signal2D Denoise(const Signal2D &data, const size_t step = 0) const override {
     return data;
   }
+
+  void DenoiseInPlace(Signal1D &data, size_t step = 0,
+                      Workspace *workspace = nullptr) const override {}
+  void DenoiseInPlace(Signal2D &data, size_t step = 0,
+                      Workspace *workspace = nullptr) const override {}
 };
 
 /**
@@ -108,6 +132,28 @@ class ThresholdAbsDenoiseAlgorithm : public DenoiseAlgorithm<T> {
     return result;
   }
 
+  void DenoiseInPlace(Signal1D &data, size_t step = 0,
+                      Workspace *workspace = nullptr) const override {
+    const T threshold = GetThreshold(step);
+    for (auto &x : data) {
+      if (!(std::abs(x) > threshold)) {
+        x = 0;
+      }
+    }
+  }
+
+  void DenoiseInPlace(Signal2D &data, size_t step = 0,
+                      Workspace *workspace = nullptr) const override {
+    const T threshold = GetThreshold(step);
+    for (size_t i = 0UL; i < data.rows(); ++i) {
+      for (auto &x : blaze::row(data, i)) {
+        if (!(std::abs(x) > threshold)) {
+          x = 0;
+        }
+      }
+    }
+  }
+
  private:
   T GetThreshold(const size_t step) const { return a_ * step + b_; }
 
@@ -201,7 +247,64 @@ class SimpleDenoiseAlgorithm : public DenoiseAlgorithm<T> {
     return result;
   }
 
+  /**
+   * The same as Denoise(), the sorted values are taken from the workspace or
+   * from a workspace of the call if it is nullptr
+   */
+  void DenoiseInPlace(Signal2D &data, size_t step = 0,
+                      Workspace *workspace = nullptr) const override {
+    using Value = std::tuple<T, size_t, size_t>;
+    const size_t size = blaze::size(data);
+    Workspace local;
+    Value *values = (workspace ? workspace : &local)->Allocate<Value>(size);
+    for (size_t i = 0; i < data.rows(); ++i) {
+      for (size_t j = 0; j < data.columns(); ++j) {
+        std::construct_at(values + i + j * data.rows(), std::fabs(data(i, j)),
+                          i, j);
+      }
+    }
+
+    const size_t slice_index = SliceIndex(size);
+    std::nth_element(
+        values, values + slice_index, values + size,
+        [](auto a, auto b) { return std::get<0>(a) > std::get<0>(b); });
+
+    // Zero the values behind the slice, the biggest ones stay
+    for (size_t c = slice_index; c < size; ++c) {
+      auto [tr, i, j] = values[c];
+      data(i, j) = 0;
+    }
+  }
+
+  void DenoiseInPlace(Signal1D &data, size_t step = 0,
+                      Workspace *workspace = nullptr) const override {
+    using Value = std::tuple<T, size_t>;
+    const size_t size = data.size();
+    Workspace local;
+    Value *values = (workspace ? workspace : &local)->Allocate<Value>(size);
+    for (size_t i = 0; i < size; ++i) {
+      std::construct_at(values + i, std::fabs(data[i]), i);
+    }
+
+    const size_t slice_index = SliceIndex(size);
+    std::nth_element(
+        values, values + slice_index, values + size,
+        [](auto a, auto b) { return std::get<0>(a) > std::get<0>(b); });
+
+    for (size_t c = slice_index; c < size; ++c) {
+      data[std::get<1>(values[c])] = 0;
+    }
+  }
+
  private:
+  /**
+   * Number of the biggest values to keep, subtracted from the size to ensure
+   * the same split as Denoise()
+   */
+  size_t SliceIndex(size_t size) const {
+    return size - std::min<size_t>(size * compression_level_, size - 1);
+  }
+
   T compression_level_;
 };
 
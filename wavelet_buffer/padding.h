@@ -35,6 +35,16 @@ class PaddingAlgorithm {
   virtual blaze::DynamicMatrix<DataType> Extend(
       const blaze::DynamicMatrix<DataType>& source) const = 0;
 
+  /**
+   * Pad signal into memory of the caller, the default implementation copies
+   * the result of Extend(source)
+   * @param source input signal
+   * @param result padded signal, it must have the padded size
+   */
+  virtual void Extend(const blaze::DynamicMatrix<DataType>& source,
+                      Signal2DView* result) const;
+  virtual void Extend(const Signal2DView& source, Signal2DView* result) const;
+
   /**
    * Crop signal
    * @param source input signal
@@ -43,6 +53,21 @@ class PaddingAlgorithm {
   blaze::DynamicMatrix<DataType> Crop(
       const blaze::DynamicMatrix<DataType>& padded) const;
 
+  /**
+   * Crop signal into a matrix, its memory is reused if it has the size
+   * @param padded input signal
+   * @param result cropped signal
+   */
+  void Crop(const ConstSignal2DView& padded,
+            blaze::DynamicMatrix<DataType>* result) const;
+
+  /**
+   * Crop signal into memory of the caller
+   * @param padded input signal
+   * @param result cropped signal, it must have the cropped size
+   */
+  void Crop(const ConstSignal2DView& padded, Signal2DView* result) const;
+
  protected:
   size_t rows_, columns_;
   PaddingLocation location_;
@@ -56,6 +81,9 @@ class ZeroPaddingAlgorithm : public PaddingAlgorithm {
   using PaddingAlgorithm::PaddingAlgorithm;
   blaze::DynamicMatrix<DataType> Extend(
       const blaze::DynamicMatrix<DataType>& source) const override;
+  void Extend(const blaze::DynamicMatrix<DataType>& source,
+              Signal2DView* result) const override;
+  void Extend(const Signal2DView& source, Signal2DView* result) const override;
 };
 
 /**
@@ -67,6 +95,9 @@ class ZeroDerivativePaddingAlgorithm : public PaddingAlgorithm {
   using PaddingAlgorithm::PaddingAlgorithm;
   blaze::DynamicMatrix<DataType> Extend(
       const blaze::DynamicMatrix<DataType>& source) const override;
+  void Extend(const blaze::DynamicMatrix<DataType>& source,
+              Signal2DView* result) const override;
+  void Extend(const Signal2DView& source, Signal2DView* result) const override;
 };
 
 }  // namespace drift
@@ -15,6 +15,19 @@ using Signal1D = blaze::DynamicVector<DataType>;
 using Signal2D = blaze::DynamicMatrix<DataType>;
 using SignalN2D = blaze::DynamicVector<Signal2D>;
 
+/**
+ * 2D signal in memory owned by someone else, e.g. a Workspace
+ */
+using Signal2DView = blaze::CustomMatrix<DataType, blaze::unaligned,
+                                         blaze::unpadded, blaze::rowMajor>;
+
+/**
+ * Read-only 2D signal in memory owned by someone else
+ */
+using ConstSignal2DView =
+    blaze::CustomMatrix<const DataType, blaze::unaligned, blaze::unpadded,
+                        blaze::rowMajor>;
+
 struct Size {
   int width;
   int height;
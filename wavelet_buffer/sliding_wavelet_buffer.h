@@ -0,0 +1,96 @@
+// Copyright 2023 PANDA GmbH
+
+#ifndef WAVELET_BUFFER_SLIDING_WAVELET_BUFFER_H_
+#define WAVELET_BUFFER_SLIDING_WAVELET_BUFFER_H_
+
+#include <span>
+#include <string>
+#include <vector>
+
+#include "wavelet_buffer/primitives.h"
+#include "wavelet_buffer/wavelet.h"
+#include "wavelet_buffer/wavelet_buffer.h"
+#include "wavelet_buffer/wavelet_parameters.h"
+
+namespace drift {
+
+/**
+ * @class SlidingWaveletBuffer
+ *
+ * 1D decomposition of a window sliding over a signal. Pushing N samples
+ * drops the N oldest ones and updates only the coefficients whose filters
+ * cover the new samples or wrap around the end of the window, the cost is
+ * about N + filter length * steps instead of the window length.
+ *
+ * The coefficients are those of the periodic transform of WaveletBuffer
+ * without denoising. They are computed by a scalar kernel with a fixed
+ * order of the additions, so they don't depend on how the samples were
+ * pushed, but they can differ from the SIMD kernels of WaveletBuffer in the
+ * last bits. The window starts with zeros
+ */
+class SlidingWaveletBuffer {
+ public:
+  /**
+   * @param parameters a 1D decomposition of one signal, the signal size is
+   * the window, it must be divisible by 2^decomposition_steps to have no
+   * padding
+   * @throw std::runtime_error if the parameters are not supported
+   */
+  explicit SlidingWaveletBuffer(const WaveletParameters& parameters);
+
+  /**
+   * Slide the window over the next samples. If the number of the samples is
+   * not divisible by 2^decomposition_steps the coefficients of the steps
+   * don't shift and the window is decomposed again
+   * @param samples the samples following the previous ones, only the last
+   * window of them is used if there are more
+   */
+  void Push(std::span<const DataType> samples);
+
+  /**
+   * Decomposition of the current window, the coefficients are copied into
+   * the buffer if they changed since the previous call
+   */
+  [[nodiscard]] const WaveletBuffer& buffer();
+
+  /**
+   * Compose the current window
+   * @param data the signal
+   * @param scale_factor wavelet scale factor, see WaveletBuffer::Compose
+   * @return true if it has no errors
+   */
+  bool Compose(Signal1D* data, int scale_factor = 0);
+
+  /**
+   * Serialize the decomposition of the current window
+   * @param blob the blob to serialize
+   * @param sf_compression - 0 - switch off, 16 - max compression(bfloat).
+   * @return return true if it has no error
+   */
+  [[nodiscard]] bool Serialize(std::string* blob, uint8_t sf_compression = 0);
+
+  /**
+   * Parameters of the decomposition
+   */
+  [[nodiscard]] const WaveletParameters& parameters() const;
+
+ private:
+  /**
+   * Coefficients of a step kept periodically, the logical index i is at
+   * (offset + i) % size. The level 0 keeps the samples of the window
+   */
+  struct Level {
+    std::vector<DataType> low;
+    std::vector<DataType> high;
+    size_t offset = 0;
+  };
+
+  WaveletBuffer buffer_;
+  wavelet::FilterBank filters_;
+  std::vector<Level> levels_;
+  bool synced_ = true; /**< the buffer has the coefficients of the levels */
+};
+
+}  // namespace drift
+
+#endif  // WAVELET_BUFFER_SLIDING_WAVELET_BUFFER_H_
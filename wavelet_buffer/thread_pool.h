@@ -0,0 +1,117 @@
+// Copyright 2023 PANDA GmbH
+
+#ifndef WAVELET_BUFFER_THREAD_POOL_H_
+#define WAVELET_BUFFER_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "wavelet_buffer/workspace.h"
+
+namespace drift {
+
+/**
+ * @class ThreadPool
+ *
+ * Threads running the independent parts of the transforms, e.g. the channels
+ * of a decomposition. The calling thread takes part in the work, so a pool of
+ * N threads starts N - 1 workers. Every thread has its own workspace for the
+ * scratch memory.
+ *
+ * The tasks are scheduled by work stealing: every thread starts with an
+ * equal range of the indices and a thread that runs out of them takes the
+ * back half of the range of another one, so tasks of different duration
+ * balance out without a shared queue.
+ *
+ * The pool runs one ParallelFor at a time, concurrent calls wait for each
+ * other. A ParallelFor called from a task runs in the calling thread with a
+ * workspace of its own
+ */
+class ThreadPool {
+ public:
+  /**
+   * Start the workers
+   * @param threads the number of threads with the caller, 0 for the number
+   * of the hardware threads
+   */
+  explicit ThreadPool(size_t threads = 0);
+
+  ThreadPool(const ThreadPool&) = delete;
+
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * Stop and join the workers
+   */
+  ~ThreadPool();
+
+  /**
+   * Call a function for every index in [0, count), each thread runs the
+   * indices of its range in order and steals from the others at the end
+   * @param count the number of the tasks, less than 2^32
+   * @param func function of the index and the workspace of the thread
+   * running the task
+   * @throw the first exception thrown by the tasks, after all tasks finished
+   */
+  void ParallelFor(size_t count,
+                   const std::function<void(size_t, Workspace*)>& func);
+
+  /**
+   * Number of threads with the caller
+   */
+  [[nodiscard]] size_t size() const;
+
+ private:
+  void WorkerLoop(size_t thread);
+
+  void RunTasks(size_t thread);
+
+  /**
+   * Take the next index of the range of a thread
+   */
+  bool TakeTask(size_t thread, size_t* index);
+
+  /**
+   * Move the back half of the range of another thread to the range of a
+   * thread and take its first index
+   */
+  bool StealTask(size_t thread, size_t* index);
+
+  /**
+   * Indices [begin, end) left to a thread as begin << 32 | end, the owner
+   * takes them from the front and the thieves from the back
+   */
+  struct alignas(64) TaskRange {
+    std::atomic<uint64_t> range = 0;
+  };
+
+  std::vector<std::thread> workers_;
+  std::vector<std::unique_ptr<Workspace>> workspaces_;
+  std::unique_ptr<TaskRange[]> ranges_;
+
+  std::mutex call_mutex_; /**< serializes the calls of ParallelFor */
+
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable finish_;
+  size_t generation_ = 0; /**< number of the started calls */
+  size_t running_ = 0;    /**< workers not finished with the call */
+  bool stop_ = false;
+
+  /* The current call */
+  const std::function<void(size_t, Workspace*)>* func_ = nullptr;
+  std::atomic<bool> failed_ = false; /**< a task threw, the rest is skipped */
+  std::exception_ptr error_;
+};
+
+}  // namespace drift
+
+#endif  // WAVELET_BUFFER_THREAD_POOL_H_
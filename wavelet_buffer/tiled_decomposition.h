@@ -0,0 +1,64 @@
+// Copyright 2023 PANDA GmbH
+
+#ifndef WAVELET_BUFFER_TILED_DECOMPOSITION_H_
+#define WAVELET_BUFFER_TILED_DECOMPOSITION_H_
+
+#include <string>
+#include <vector>
+
+#include "wavelet_buffer/primitives.h"
+#include "wavelet_buffer/wavelet_parameters.h"
+
+namespace drift {
+
+/**
+ * Size of the tiles of a tiled decomposition in the coefficients of a step,
+ * a tile reads the samples under the filters of its coefficients
+ */
+struct TileOptions {
+  size_t rows = 256;
+  size_t columns = 512; /**< rounded up to a multiple of 256 */
+};
+
+/**
+ * Place of a subband in the file of a tiled decomposition, the rows follow
+ * each other without gaps
+ */
+struct TiledSubband {
+  size_t offset; /**< the first element */
+  size_t rows;
+  size_t columns;
+};
+
+/**
+ * Layout of the file of a tiled decomposition: the subbands of every
+ * channel in the order of WaveletDecomposition, the channels follow each
+ * other
+ * @param parameters the parameters of a 2D decomposition
+ * @return the subbands of all channels
+ */
+std::vector<TiledSubband> TiledLayout(const WaveletParameters& parameters);
+
+/**
+ * Decompose 2D signals larger than the memory tile by tile. The input file
+ * is mapped into memory, every step reads the tiles of its input with the
+ * overlap the filters need and writes their subbands into the output file,
+ * the approximations between the steps go to temporary files next to it.
+ * The memory holds only the tiles of one step.
+ *
+ * The subbands are the same as of WaveletBuffer with the filter bank engine
+ * and without denoising
+ * @param parameters the parameters of a 2D decomposition
+ * @param input raw file of the channels one after another, each channel has
+ * signal_shape[1] rows of signal_shape[0] values of DataType
+ * @param output raw file of the subbands, see TiledLayout
+ * @param options
+ * @return true if it has no errors
+ */
+bool DecomposeTiled(const WaveletParameters& parameters,
+                    const std::string& input, const std::string& output,
+                    const TileOptions& options = {});
+
+}  // namespace drift
+
+#endif  // WAVELET_BUFFER_TILED_DECOMPOSITION_H_
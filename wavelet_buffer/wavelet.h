@@ -6,8 +6,10 @@
 #include <blaze/Blaze.h>
 
 #include <tuple>
+#include <vector>
 
 #include "wavelet_buffer/primitives.h"
+#include "wavelet_buffer/thread_pool.h"
 
 namespace drift::wavelet {
 
@@ -18,6 +20,53 @@ using Signal2DCompressed = blaze::CompressedMatrix<DataType>;
  */
 enum class Padding { ZeroDerivative, Periodized };
 
+/**
+ * Implementation of the wavelet transform used by the decomposition and
+ * composition
+ */
+enum class Engine {
+  kMatrix,      // products with sparse convolution matrices (DaubechiesMat)
+  kFilterBank,  // direct periodic convolution with the filters
+  kLifting,     // lifting steps in place on a single buffer
+};
+
+/**
+ * Low-pass and high-pass analysis filters in convolution order:
+ *   low[i] = sum_k low_pass[k] * x[(2i + k) mod N]
+ * The same filters are used for the synthesis, which is the adjoint of the
+ * analysis
+ */
+struct FilterBank {
+  Signal1D low_pass;
+  Signal1D high_pass;
+};
+
+/**
+ * Factorization of a filter bank into lifting steps (Daubechies & Sweldens).
+ * The line is split into two phases, the phases update each other in turns
+ * and are scaled at the end:
+ *   low[i]  = x[(2 * (i + low_shift) + low_parity) mod N]
+ *   high[i] = x[(2 * (i + high_shift) + 1 - low_parity) mod N]
+ *   low[i] += sum_j coefficients[j] * high[(i + offset + j) mod N/2]
+ *     (or high by low for prediction steps)
+ *   low *= low_scale, high *= high_scale
+ * The inverse undoes the steps in reverse order
+ */
+struct LiftingScheme {
+  struct Step {
+    bool update_low;  // low is updated by high if true, otherwise vice versa
+    int offset;       // index offset of the first coefficient
+    Signal1D coefficients;
+  };
+
+  std::vector<Step> steps;
+  size_t low_parity;
+  int low_shift;
+  int high_shift;
+  DataType low_scale;
+  DataType high_scale;
+};
+
 /**
  * Construct convolutional matrix for wavelet transform
  * @param size
@@ -28,17 +77,105 @@ enum class Padding { ZeroDerivative, Periodized };
 blaze::CompressedMatrix<DataType> DaubechiesMat(
     size_t size, int order = 4, Padding padding = Padding::Periodized);
 
+/**
+ * Construct the filter bank for wavelet transform, the filters are the same
+ * as the non-zero elements of a row of DaubechiesMat
+ * @param order
+ * @return
+ */
+FilterBank DaubechiesFilters(int order = 4);
+
+/**
+ * Construct the lifting scheme for wavelet transform, it gives the same
+ * result as DaubechiesFilters. The schemes are factorized from the filters
+ * on the first call
+ * @param order 2, 4, 6, 8 or 10 (DB1-DB5)
+ * @return
+ */
+LiftingScheme DaubechiesLifting(int order = 4);
+
 Signal2D dwt2s(Signal2D const &x, Signal2DCompressed const &dmat_w,
                Signal2DCompressed const &dmat_h);
 
+/**
+ * Whole image transform with the filters applied directly to the rows and
+ * the columns, no dividing by subbands
+ * @param x image with even number of rows and columns
+ * @param filters
+ * @param pool threads to split the rows and the columns of a big image
+ * @return image with LL, HL (top) and LH, HH (bottom) parts
+ */
+Signal2D dwt2s(Signal2D const &x, FilterBank const &filters,
+               ThreadPool *pool = nullptr);
+
+/**
+ * Inverse of dwt2s
+ * @param x image with LL, HL (top) and LH, HH (bottom) parts
+ * @param filters filters used for the decomposition
+ * @param pool threads to split the rows and the columns of a big image
+ * @return
+ */
+Signal2D idwt2s(Signal2D const &x, FilterBank const &filters,
+                ThreadPool *pool = nullptr);
+
+/**
+ * Whole image transform in place with the lifting scheme, it needs scratch
+ * memory only for half of a row or of a narrow tile of columns
+ * @param x image with even number of rows and columns, it is replaced with
+ * LL, HL (top) and LH, HH (bottom) parts
+ * @param scheme
+ * @param pool threads to split the rows and the columns of a big image, each
+ * of them takes its scratch memory from its workspace
+ */
+void dwt2s(Signal2D *x, LiftingScheme const &scheme,
+           ThreadPool *pool = nullptr);
+
+/**
+ * Inverse of dwt2s in place
+ * @param x image with LL, HL (top) and LH, HH (bottom) parts
+ * @param scheme lifting scheme used for the decomposition
+ * @param pool threads to split the rows and the columns of a big image
+ */
+void idwt2s(Signal2D *x, LiftingScheme const &scheme,
+            ThreadPool *pool = nullptr);
+
 std::tuple<Signal2D, Signal2D, Signal2D, Signal2D> dwt2(
     Signal2D const &x, Signal2DCompressed const &dmat_w,
     Signal2DCompressed const &dmat_h);
 
+std::tuple<Signal2D, Signal2D, Signal2D, Signal2D> dwt2(
+    Signal2D const &x, FilterBank const &filters);
+
+/**
+ * Single level transform writing the subbands directly to the outputs, no
+ * whole image result is assembled or divided
+ * @param x image with even number of rows and columns
+ * @param filters
+ * @param ll approximation, resized to the half of the image
+ * @param lh horizontal details
+ * @param hl vertical details
+ * @param hh diagonal details
+ * @param pool threads to split the rows and the columns of a big image
+ */
+void dwt2(Signal2D const &x, FilterBank const &filters, Signal2D *ll,
+          Signal2D *lh, Signal2D *hl, Signal2D *hh,
+          ThreadPool *pool = nullptr);
+
+std::tuple<Signal2D, Signal2D, Signal2D, Signal2D> dwt2(
+    Signal2D const &x, LiftingScheme const &scheme);
+
 Signal2D idwt2(const Signal2D &ll, const Signal2D &lh, const Signal2D &hl,
                const Signal2D &hh, const Signal2DCompressed &dmat_w,
                const Signal2DCompressed &dmat_h);
 
+Signal2D idwt2(const Signal2D &ll, const Signal2D &lh, const Signal2D &hl,
+               const Signal2D &hh, const FilterBank &filters,
+               ThreadPool *pool = nullptr);
+
+Signal2D idwt2(const Signal2D &ll, const Signal2D &lh, const Signal2D &hl,
+               const Signal2D &hh, const LiftingScheme &scheme,
+               ThreadPool *pool = nullptr);
+
 /**
  * Construct the scaling filter associated with the Daubechies wavelet
  * @param wnum Daubechies wavelet vanishing moments, positive integer in the
@@ -66,6 +203,32 @@ std::tuple<blaze::DynamicVector<DataType>, blaze::DynamicVector<DataType>> dwt(
     const blaze::DynamicVector<DataType> &signal,
     const blaze::CompressedMatrix<DataType> &dmat);
 
+/**
+ * Wavelet decomposition using the filters directly
+ * @param signal signal of even size
+ * @param filters
+ * @return
+ */
+std::tuple<blaze::DynamicVector<DataType>, blaze::DynamicVector<DataType>> dwt(
+    const blaze::DynamicVector<DataType> &signal, const FilterBank &filters);
+
+/**
+ * Wavelet decomposition using the lifting scheme
+ * @param signal signal of even size
+ * @param scheme
+ * @return
+ */
+std::tuple<blaze::DynamicVector<DataType>, blaze::DynamicVector<DataType>> dwt(
+    const blaze::DynamicVector<DataType> &signal, const LiftingScheme &scheme);
+
+/**
+ * Wavelet decomposition in place using the lifting scheme
+ * @param signal signal of even size, it is replaced with the low subband
+ * followed by the high one
+ * @param scheme
+ */
+void dwt(blaze::DynamicVector<DataType> *signal, const LiftingScheme &scheme);
+
 /**
  * Wavelet composition using Daubechies matrix
  * @param low_subband
@@ -77,5 +240,37 @@ blaze::DynamicVector<DataType> idwt(
     const blaze::DynamicVector<DataType> &low_subband,
     const blaze::DynamicVector<DataType> &high_subband,
     const blaze::CompressedMatrix<DataType> &dmat);
+
+/**
+ * Wavelet composition using the filters directly
+ * @param low_subband
+ * @param high_subband
+ * @param filters filters used for the decomposition
+ * @return
+ */
+blaze::DynamicVector<DataType> idwt(
+    const blaze::DynamicVector<DataType> &low_subband,
+    const blaze::DynamicVector<DataType> &high_subband,
+    const FilterBank &filters);
+
+/**
+ * Wavelet composition using the lifting scheme
+ * @param low_subband
+ * @param high_subband
+ * @param scheme lifting scheme used for the decomposition
+ * @return
+ */
+blaze::DynamicVector<DataType> idwt(
+    const blaze::DynamicVector<DataType> &low_subband,
+    const blaze::DynamicVector<DataType> &high_subband,
+    const LiftingScheme &scheme);
+
+/**
+ * Wavelet composition in place using the lifting scheme
+ * @param signal the low subband followed by the high one, it is replaced
+ * with the composed signal
+ * @param scheme lifting scheme used for the decomposition
+ */
+void idwt(blaze::DynamicVector<DataType> *signal, const LiftingScheme &scheme);
 }  // namespace drift::wavelet
 #endif  // WAVELET_BUFFER_WAVELET_H_
@@ -0,0 +1,75 @@
+// Copyright 2023 PANDA GmbH
+
+#ifndef WAVELET_BUFFER_WAVELET_BATCH_H_
+#define WAVELET_BUFFER_WAVELET_BATCH_H_
+
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "wavelet_buffer/denoise_algorithms.h"
+#include "wavelet_buffer/primitives.h"
+#include "wavelet_buffer/thread_pool.h"
+#include "wavelet_buffer/wavelet_buffer.h"
+
+/* Batches of independent buffers. The items of a batch are the tasks of the
+ * pool, its work stealing balances out the items of different size. Every
+ * item reports its own status */
+
+namespace drift {
+
+/**
+ * Result of one item of a batch
+ */
+enum class BatchStatus {
+  kOk,        /**< the item is done */
+  kFailed,    /**< the call reported an error, e.g. a wrong signal shape */
+  kException, /**< the call threw, the message is printed to std::cerr */
+};
+
+/**
+ * Decompose the signals of many buffers. The transform of an item runs in
+ * one thread with the workspace of the thread, so the batch reuses the
+ * scratch memory and the plans of the buffers
+ * @param buffers the buffers to write
+ * @param data the signals of each buffer
+ * @param denoiser algorithm to clean the small values in Hi-freq subbands
+ * @param pool threads, nullptr to run in the calling thread
+ * @return the status of each buffer, kFailed for all if the spans have
+ * different sizes
+ */
+std::vector<BatchStatus> BatchDecompose(
+    std::span<WaveletBuffer> buffers, std::span<const SignalN2D> data,
+    const DenoiseAlgorithm<DataType>& denoiser, ThreadPool* pool = nullptr);
+
+/**
+ * Serialize many buffers
+ * @param buffers the buffers to serialize
+ * @param blobs the blob of each buffer
+ * @param sf_compression - 0 - switch off, 16 - max compression(bfloat).
+ * @param pool threads, nullptr to run in the calling thread
+ * @return the status of each buffer, kFailed for all if the spans have
+ * different sizes
+ */
+std::vector<BatchStatus> BatchSerialize(std::span<const WaveletBuffer> buffers,
+                                        std::span<std::string> blobs,
+                                        uint8_t sf_compression = 0,
+                                        ThreadPool* pool = nullptr);
+
+/**
+ * Parse many buffers, the buffers with the same parameters share one plan
+ * @param blobs the blobs of subbands
+ * @param buffers the parsed buffers, resized to the number of the blobs and
+ * nullptr for the blobs failed to parse
+ * @param pool threads, nullptr to run in the calling thread
+ * @return the status of each blob
+ */
+std::vector<BatchStatus> BatchParse(
+    std::span<const std::string> blobs,
+    std::vector<std::unique_ptr<WaveletBuffer>>* buffers,
+    ThreadPool* pool = nullptr);
+
+}  // namespace drift
+
+#endif  // WAVELET_BUFFER_WAVELET_BATCH_H_
@@ -7,6 +7,7 @@
 #include <cmath>
 #include <map>
 #include <memory>
+#include <span>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -14,13 +15,22 @@
 
 #include "wavelet_buffer/denoise_algorithms.h"
 #include "wavelet_buffer/primitives.h"
+#include "wavelet_buffer/thread_pool.h"
 #include "wavelet_buffer/wavelet_parameters.h"
+#include "wavelet_buffer/wavelet_plan.h"
+#include "wavelet_buffer/workspace.h"
 #include "wavelet_buffer/wavelet_utils.h"
 
 namespace drift {
 
 constexpr uint8_t kSerializationVersion =
-    3;  // Increase if we brake compatibility
+    4;  // Increase if we brake compatibility
+
+/**
+ * Version of the blobs of padded buffers, they have no boundary mode and
+ * older readers can parse them
+ */
+constexpr uint8_t kPaddedSerializationVersion = 3;
 
 class WaveletBufferView;
 /**
@@ -34,6 +44,14 @@ class WaveletBuffer {
    */
   explicit WaveletBuffer(const WaveletParameters& parameters);
 
+  /**
+   * Initialize buffer sharing a prepared transform, buffers with the same
+   * parameters don't repeat the setup
+   * @param plan the plan of the transform, its parameters are the parameters
+   * of the buffer
+   */
+  explicit WaveletBuffer(std::shared_ptr<const WaveletPlan> plan);
+
   /**
    * Initialize buffer with decompositions
    * @param parameters the parameters of the wavelet decomposition
@@ -81,6 +99,29 @@ class WaveletBuffer {
   bool Decompose(const Signal1D& data,
                  const DenoiseAlgorithm<DataType>& denoiser);
 
+  /**
+   * Decomposes a 1D signal from memory of the caller into the subbands of
+   * the first channel, the signal isn't copied if it needs no padding
+   * @param data the signal
+   * @param denoiser algorithm to clean the small values in Hi-freq
+   * subbands
+   * @return true if it has no errors
+   */
+  bool Decompose(std::span<const DataType> data,
+                 const DenoiseAlgorithm<DataType>& denoiser);
+
+  /**
+   * Decomposes the channels of 1D signals interleaved in the rows of a
+   * matrix, the filter bank engine transforms all channels at once
+   * @param data signal_shape[0] rows of signal_number channels, e.g. frames
+   * of a multi-axis sensor
+   * @param denoiser algorithm to clean the small values in Hi-freq
+   * subbands
+   * @return true if it has no errors
+   */
+  bool DecomposeInterleaved(const Signal2D& data,
+                            const DenoiseAlgorithm<DataType>& denoiser);
+
   /**
    * Composes the intrnal subbands into a signal
    * @param data the signal
@@ -103,6 +144,89 @@ class WaveletBuffer {
    */
   bool Compose(Signal1D* data, int scale_factor = 0) const;
 
+  /**
+   * Composes the subbands of the first channel into memory of the caller
+   * @param data the signal, its size must be the size of the original signal
+   * divided by 2^scale_factor
+   * @param scale_factor wavelet scale factor
+   * @return true if it has no errors
+   */
+  bool Compose(std::span<DataType> data, int scale_factor = 0) const;
+
+  /**
+   * Composes the channels of 1D signals interleaved in the rows of a matrix
+   * @param data the signals, a row holds a sample of every channel
+   * @param scale_factor the number of the steps not recomposed, the output
+   * has 2^N times less rows
+   * @return true if it has no errors
+   */
+  bool ComposeInterleaved(Signal2D* data, int scale_factor = 0) const;
+
+  /**
+   * Composes a region of the signals, only the coefficients under the
+   * synthesis filters of the region are transformed, so the cost depends on
+   * the size of the region and not of the signals
+   * @param region a rectangle of the composed signals, e.g. a zoomed part
+   * of an image
+   * @param data the composed regions
+   * @param scale_factor wavelet scale factor, the region is in the signals
+   * 2^N smaller
+   * @return false if the region is out of the composed signals
+   */
+  bool Compose(const Region& region, SignalN2D* data,
+               int scale_factor = 0) const;
+
+  /**
+   * Composes a range of the samples of the first channel, only the
+   * coefficients under the synthesis filters of the range are transformed
+   * @param region a range of the composed 1D signal
+   * @param data the composed range
+   * @param scale_factor wavelet scale factor, the range is in the signal 2^N
+   * smaller
+   * @return false if the range is out of the composed signal
+   */
+  bool Compose(const Region& region, Signal1D* data,
+               int scale_factor = 0) const;
+
+  /**
+   * Use scratch memory of a workspace for Decompose and Compose, the
+   * subbands and the signals are overwritten in place, so the calls don't
+   * allocate after the first one with the same shape
+   * @param workspace owned by the caller, it must outlive the buffer and its
+   * copies, nullptr to detach it. Concurrent calls of the buffer and of its
+   * copies don't share it, a call finding it in use takes scratch memory of
+   * its own
+   */
+  void AttachWorkspace(Workspace* workspace);
+
+  /**
+   * Keep the approximations of the levels composed by Compose within a
+   * memory budget, a finer composition resumes from the nearest kept level
+   * instead of the approximation of the decomposition, e.g. when a user
+   * zooms in. The levels are dropped by Decompose and when the non-const
+   * operator[] or decompositions() are called, so a reference from them
+   * must be taken again for every change of the subbands after a Compose
+   * @param max_bytes memory budget of the approximations, 0 to switch the
+   * cache off
+   */
+  void SetResolutionCache(size_t max_bytes);
+
+  /**
+   * Decompose and compose the channels concurrently on a pool owned by the
+   * buffer, copies of the buffer share it. The result doesn't depend on the
+   * number of threads
+   * @param threads the number of threads, 0 for the number of the hardware
+   * threads, 1 to run in the calling thread
+   */
+  void SetThreadCount(size_t threads);
+
+  /**
+   * Decompose and compose the channels concurrently on a pool of the caller
+   * @param pool owned by the caller, it must outlive the buffer and its
+   * copies, nullptr to run in the calling thread
+   */
+  void AttachThreadPool(ThreadPool* pool);
+
   /******** Serializers **************/
 
   /**
@@ -113,6 +237,17 @@ class WaveletBuffer {
   [[nodiscard]] static std::unique_ptr<WaveletBuffer> Parse(
       const std::string& blob);
 
+  /**
+   * Parses subbands from a blob of data and creates a new buffer with a plan
+   * from the provider, the buffers parsed with a cache share their plans
+   * @param blob the blob of subbands
+   * @param plans source of the plan for the parsed parameters, it throws if
+   * the parameters aren't supported
+   * @return nullptr if it failed to parse the buffer
+   */
+  [[nodiscard]] static std::unique_ptr<WaveletBuffer> Parse(
+      const std::string& blob, const WaveletPlanProvider& plans);
+
   /**
    * Serialize the buffer into the blob for saving in a file or sending via
    * network
@@ -128,6 +263,9 @@ class WaveletBuffer {
   /**
    * Access to the decomposition by channels
    * NOTE: the last element is always an abstraction
+   * NOTE: the call drops the levels of the resolution cache, a reference
+   * kept over a Compose must be taken again before the subbands are changed
+   * through it
    * @param index the index of the channel
    * @return the decomposition as a list of the subbands
    */
@@ -161,6 +299,17 @@ class WaveletBuffer {
    */
   [[nodiscard]] const WaveletParameters& parameters() const;
 
+  /**
+   * Transform of the buffer, it can be shared with other buffers
+   */
+  [[nodiscard]] std::shared_ptr<const WaveletPlan> plan() const;
+
+  /**
+   * Access to the decompositions of all channels
+   * NOTE: the call drops the levels of the resolution cache, a reference
+   * kept over a Compose must be taken again before the subbands are changed
+   * through it
+   */
   [[nodiscard]] NWaveletDecomposition& decompositions();
   [[nodiscard]] const NWaveletDecomposition& decompositions() const;
 
@@ -7,6 +7,7 @@
 #include <string>
 
 #include "wavelet_buffer/wavelet_buffer.h"
+#include "wavelet_buffer/wavelet_plan.h"
 
 namespace drift {
 class IWaveletBufferSerializer {
@@ -19,6 +20,17 @@ class IWaveletBufferSerializer {
    */
   [[nodiscard]] virtual std::unique_ptr<WaveletBuffer> Parse(
       const std::string& blob) = 0;
+  /**
+   * Parses subbands from a blob of data and creates a new buffer with a plan
+   * of the provider, the default implementation moves the subbands of
+   * Parse(blob) into it
+   * @param blob the blob of subbands
+   * @param plans source of the plan of the buffer, empty to prepare a new
+   * one
+   * @return nullptr if it failed to parse the buffer
+   */
+  [[nodiscard]] virtual std::unique_ptr<WaveletBuffer> Parse(
+      const std::string& blob, const WaveletPlanProvider& plans);
   /**
    * Serialize the buffer into the blob for saving in a file or sending via
    * network
@@ -40,6 +52,15 @@ class WaveletBufferSerializerLegacy : public IWaveletBufferSerializer {
    */
   [[nodiscard]] std::unique_ptr<WaveletBuffer> Parse(
       const std::string& blob) override;
+  /**
+   * Parses subbands from a blob of data and creates a new buffer
+   * @param blob the blob of subbands
+   * @param plans source of the plan of the buffer, empty to prepare a new
+   * one
+   * @return nullptr if it failed to parse the buffer
+   */
+  [[nodiscard]] std::unique_ptr<WaveletBuffer> Parse(
+      const std::string& blob, const WaveletPlanProvider& plans) override;
   /**
    * Serialize the buffer into the blob for saving in a file or sending via
    * network
@@ -60,6 +81,15 @@ class WaveletBufferSerializer : public IWaveletBufferSerializer {
    */
   [[nodiscard]] std::unique_ptr<WaveletBuffer> Parse(
       const std::string& blob) override;
+  /**
+   * Parses subbands from a blob of data and creates a new buffer
+   * @param blob the blob of subbands
+   * @param plans source of the plan of the buffer, empty to prepare a new
+   * one
+   * @return nullptr if it failed to parse the buffer
+   */
+  [[nodiscard]] std::unique_ptr<WaveletBuffer> Parse(
+      const std::string& blob, const WaveletPlanProvider& plans) override;
   /**
    * Serialize the buffer into the blob for saving in a file or sending via
    * network
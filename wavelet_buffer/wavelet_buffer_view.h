@@ -42,6 +42,18 @@ class WaveletBufferView {
    */
   bool Compose(SignalN2D* data, int scale_factor = 0) const;
 
+  /**
+   * Composes a region of the signals of the view, only the coefficients
+   * under the synthesis filters of the region are transformed
+   * @param region a rectangle of the composed signals
+   * @param data the composed regions
+   * @param scale_factor wavelet scale factor, the region is in the signals
+   * 2^N smaller
+   * @return false if the region is out of the composed signals
+   */
+  bool Compose(const Region& region, SignalN2D* data,
+               int scale_factor = 0) const;
+
   [[nodiscard]] NWaveletDecompositionView decompositions() const;
 
   /**
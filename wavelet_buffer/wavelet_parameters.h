@@ -23,11 +23,36 @@ enum WaveletTypes {
   kDB5 = 5,
 };
 
+/**
+ * How the transform handles the boundaries of a signal
+ */
+enum class BoundaryMode {
+  /** The signal is padded to a multiple of 2^steps in every dimension */
+  kPadding = 0,
+  /** No padding, an odd side is extended by its last sample inside the
+   * filters and its subbands have ceil(size / 2) coefficients. Only the
+   * filter bank engine supports it */
+  kOddLength = 1,
+  /** The signal is padded like kPadding but with zeros instead of its edge
+   * samples */
+  kZeroPadding = 2,
+};
+
 /**
  * Signal shape, order from low to high (width, height, color, etc)
  */
 using SignalShape = std::vector<size_t>;
 
+/**
+ * Region of interest of a signal: a range of samples of a 1D signal or a
+ * rectangle of a 2D one, the order of the dimensions is the same as in
+ * SignalShape (width, height)
+ */
+struct Region {
+  SignalShape offset; /**< the first sample in every dimension */
+  SignalShape size;   /**< the number of samples in every dimension */
+};
+
 /**
  * Parameters of wavelet decomposition
  */
@@ -36,12 +61,14 @@ struct WaveletParameters {
   size_t signal_number;        // Channels in the signal (RGB=3)
   size_t decomposition_steps;  // Steps fo the decompositions
   WaveletTypes wavelet_type;
+  BoundaryMode boundary_mode = BoundaryMode::kPadding;
 
   bool operator==(const WaveletParameters& rhs) const {
     return signal_shape == rhs.signal_shape &&
            signal_number == rhs.signal_number &&
            decomposition_steps == rhs.decomposition_steps &&
-           wavelet_type == rhs.wavelet_type;
+           wavelet_type == rhs.wavelet_type &&
+           boundary_mode == rhs.boundary_mode;
   }
 
   bool operator!=(const WaveletParameters& rhs) const {
@@ -50,9 +77,10 @@ struct WaveletParameters {
 
   bool operator<(const WaveletParameters& rhs) const {
     return std::tie(signal_shape, signal_number, decomposition_steps,
-                    wavelet_type) <
+                    wavelet_type, boundary_mode) <
            std::tie(rhs.signal_shape, rhs.signal_number,
-                    rhs.decomposition_steps, rhs.wavelet_type);
+                    rhs.decomposition_steps, rhs.wavelet_type,
+                    rhs.boundary_mode);
   }
 
   bool operator>(const WaveletParameters& rhs) const { return rhs < *this; }
@@ -75,6 +103,8 @@ struct WaveletParameters {
        << "  decomposition_steps: " << parameters.decomposition_steps
        << std::endl
        << "  wavelet_type: " << parameters.wavelet_type << std::endl
+       << "  boundary_mode: "
+       << static_cast<int>(parameters.boundary_mode) << std::endl
        << "}";
     return os;
   }
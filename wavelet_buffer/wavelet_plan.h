@@ -0,0 +1,228 @@
+// Copyright 2023 PANDA GmbH
+
+#ifndef WAVELET_BUFFER_WAVELET_PLAN_H_
+#define WAVELET_BUFFER_WAVELET_PLAN_H_
+
+#include <functional>
+#include <memory>
+#include <span>
+
+#include "wavelet_buffer/denoise_algorithms.h"
+#include "wavelet_buffer/primitives.h"
+#include "wavelet_buffer/thread_pool.h"
+#include "wavelet_buffer/wavelet.h"
+#include "wavelet_buffer/wavelet_parameters.h"
+#include "wavelet_buffer/wavelet_utils.h"
+#include "wavelet_buffer/workspace.h"
+
+namespace drift {
+
+/**
+ * @class WaveletPlan
+ *
+ * Transform prepared once for the wavelet parameters: the padded shape and
+ * the filters or matrices of the engine for both directions. Decompose and
+ * Compose only run the transform. The plan doesn't change after
+ * construction, so buffers and threads can share it
+ */
+class WaveletPlan {
+ public:
+  /**
+   * Prepare the transform
+   * @param parameters the parameters of the wavelet decomposition
+   * @param engine implementation of the transform
+   * @throw std::runtime_error if the parameters aren't supported
+   */
+  explicit WaveletPlan(
+      const WaveletParameters& parameters,
+      wavelet::Engine engine = wavelet::Engine::kFilterBank);
+
+  WaveletPlan(WaveletPlan&& plan) noexcept;
+
+  WaveletPlan& operator=(WaveletPlan&& plan) noexcept;
+
+  WaveletPlan(const WaveletPlan&) = delete;
+
+  WaveletPlan& operator=(const WaveletPlan&) = delete;
+
+  /**
+   * Destructor, required by std::unique_ptr and PImpl
+   */
+  ~WaveletPlan();
+
+  /**
+   * Decompose signals into the subbands
+   * @param data the signals
+   * @param denoiser algorithm to clean the small values in Hi-freq subbands
+   * @param decomposition the decomposition to write, it must have the size of
+   * the parameters
+   * @param start_signal the first channel of the decomposition to write
+   * @param signal_count the number of signals
+   * @param workspace scratch memory, if it is given the filter bank engine
+   * writes the subbands in place and doesn't allocate after the first call
+   * @param pool threads to decompose the channels concurrently, the result
+   * is the same as without it
+   * @return true if it has no errors
+   */
+  bool Decompose(const SignalN2D& data,
+                 const DenoiseAlgorithm<DataType>& denoiser,
+                 NWaveletDecomposition* decomposition, size_t start_signal,
+                 size_t signal_count, Workspace* workspace = nullptr,
+                 ThreadPool* pool = nullptr) const;
+
+  /**
+   * Decompose a 1D signal from memory of the caller, the filter bank engine
+   * doesn't copy it if it needs no padding
+   * @param data the signal of the size of the parameters
+   * @param denoiser algorithm to clean the small values in Hi-freq subbands
+   * @param decomposition the decomposition to write, it must have the size of
+   * the parameters
+   * @param channel the channel of the decomposition to write
+   * @param workspace scratch memory, nullptr to allocate it for the call
+   * @return false if the signal isn't 1D or has a wrong size
+   */
+  bool Decompose(std::span<const DataType> data,
+                 const DenoiseAlgorithm<DataType>& denoiser,
+                 NWaveletDecomposition* decomposition, size_t channel,
+                 Workspace* workspace = nullptr) const;
+
+  /**
+   * Decompose the channels of 1D signals interleaved in the rows of a
+   * matrix, the filter bank engine transforms all channels at once
+   * @param data signal_shape[0] rows of signal_number channels, e.g. frames
+   * of a multi-axis sensor
+   * @param denoiser algorithm to clean the small values in Hi-freq subbands
+   * @param decomposition the decomposition to write, it must have the size of
+   * the parameters
+   * @param workspace scratch memory, nullptr to allocate it for the call
+   * @return false if the signals aren't 1D or have a wrong shape
+   */
+  bool DecomposeInterleaved(const Signal2D& data,
+                            const DenoiseAlgorithm<DataType>& denoiser,
+                            NWaveletDecomposition* decomposition,
+                            Workspace* workspace = nullptr) const;
+
+  /**
+   * Compose signals from the subbands
+   * @param decomposition the wavelet subbands
+   * @param data the composed signals
+   * @param scale_factor 0 - all the steps of the decomposition recomposed,
+   * N - all the steps but N and the output is 2^N smaller
+   * @param start_signal the first channel of the decomposition to read
+   * @param count the number of signals
+   * @param workspace scratch memory, if it is given the filter bank engine
+   * overwrites the signals in place and doesn't allocate after the first call
+   * @param pool threads to compose the channels concurrently, the result is
+   * the same as without it
+   * @return true if it has no errors
+   */
+  bool Compose(const NWaveletDecomposition& decomposition, SignalN2D* data,
+               int scale_factor, size_t start_signal, size_t count,
+               Workspace* workspace = nullptr,
+               ThreadPool* pool = nullptr) const;
+
+  /**
+   * Compose a region of signals, only the coefficients under the synthesis
+   * filters of the region are transformed
+   * @param decomposition the wavelet subbands
+   * @param region a range of a 1D signal or a rectangle of a 2D one in the
+   * composed signals
+   * @param data the composed regions, 1D regions are columns
+   * @param scale_factor the number of the steps not recomposed
+   * @param start_signal the first channel of the decomposition to read
+   * @param count the number of signals
+   * @param workspace scratch memory, nullptr to allocate it for the call
+   * @param pool threads to compose the channels concurrently
+   * @return false if the region is out of the composed signals
+   */
+  bool Compose(const NWaveletDecomposition& decomposition,
+               const Region& region, SignalN2D* data, int scale_factor,
+               size_t start_signal, size_t count,
+               Workspace* workspace = nullptr,
+               ThreadPool* pool = nullptr) const;
+
+  /**
+   * Compose a 1D signal into memory of the caller
+   * @param decomposition the wavelet subbands
+   * @param data the signal, its size must be the size of the parameters
+   * divided by 2^scale_factor
+   * @param scale_factor the number of the steps not recomposed
+   * @param channel the channel of the decomposition to read
+   * @param workspace scratch memory, nullptr to allocate it for the call
+   * @return false if the signal isn't 1D or has a wrong size
+   */
+  bool Compose(const NWaveletDecomposition& decomposition,
+               std::span<DataType> data, int scale_factor, size_t channel,
+               Workspace* workspace = nullptr) const;
+
+  /**
+   * Compose the channels of 1D signals interleaved in the rows of a matrix
+   * @param decomposition the wavelet subbands of all channels
+   * @param data the composed signals, a row holds a sample of every channel
+   * @param scale_factor the number of the steps not recomposed
+   * @param workspace scratch memory, nullptr to allocate it for the call
+   * @return false if the signals aren't 1D
+   */
+  bool ComposeInterleaved(const NWaveletDecomposition& decomposition,
+                          Signal2D* data, int scale_factor,
+                          Workspace* workspace = nullptr) const;
+
+  /**
+   * Compose the approximation with padding of one channel level by level, a
+   * composition can resume from an approximation kept before
+   * @param decomposition the subbands of the channel
+   * @param approximation the approximation with padding at level `from`,
+   * the last subband of the decomposition for decomposition_steps
+   * @param from the level of the approximation
+   * @param to the level to compose, not coarser than `from`
+   * @param result the approximation with padding at level `to`
+   * @param on_level function called with every composed level and its
+   * approximation, it can be empty
+   * @param pool threads for the steps of a big image
+   */
+  void ComposeApproximation(
+      const WaveletDecomposition& decomposition, const Signal2D& approximation,
+      size_t from, size_t to, Signal2D* result,
+      const std::function<void(size_t, const Signal2D&)>& on_level = {},
+      ThreadPool* pool = nullptr) const;
+
+  /**
+   * Crop an approximation with padding into the composed signal
+   * @param approximation the approximation with padding at a level
+   * @param level the level, it is the scale factor of the composed signal
+   * @param data the composed signal, its memory is reused if it has the size
+   */
+  void CropApproximation(const Signal2D& approximation, size_t level,
+                         Signal2D* data) const;
+
+  /**
+   * Parameters of the decomposition, the number of steps is 0 for kNone
+   */
+  [[nodiscard]] const WaveletParameters& parameters() const;
+
+  /**
+   * Implementation of the transform
+   */
+  [[nodiscard]] wavelet::Engine engine() const;
+
+  /**
+   * Shape of the signal with padding for all steps
+   */
+  [[nodiscard]] const SignalShape& padded_shape() const;
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * Source of plans for parameters, e.g. a cache sharing one plan between
+ * the buffers with the same parameters
+ */
+using WaveletPlanProvider = std::function<std::shared_ptr<const WaveletPlan>(
+    const WaveletParameters&)>;
+
+}  // namespace drift
+
+#endif  // WAVELET_BUFFER_WAVELET_PLAN_H_
@@ -0,0 +1,199 @@
+// Copyright 2023 PANDA GmbH
+
+#ifndef WAVELET_BUFFER_WAVELET_STREAM_H_
+#define WAVELET_BUFFER_WAVELET_STREAM_H_
+
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "wavelet_buffer/primitives.h"
+#include "wavelet_buffer/wavelet.h"
+#include "wavelet_buffer/wavelet_parameters.h"
+
+namespace drift {
+
+/**
+ * Coefficients of a stream in the order of the subbands of a 1D
+ * decomposition: the details of each step and the approximation of the last
+ * one
+ */
+using StreamSubbands = std::vector<std::vector<DataType>>;
+
+/**
+ * @class StreamDecomposer
+ *
+ * 1D decomposition of an unbounded signal pushed in chunks of any size. A
+ * coefficient is emitted as soon as all samples under the filters have
+ * arrived, every step keeps only the samples overlapped by the next
+ * coefficients. The coefficients don't depend on the chunks, they are the
+ * same as for the whole signal pushed at once.
+ *
+ * A stream has no end to wrap around as the periodic transform of
+ * WaveletBuffer does, it starts with zeros instead, so StreamComposer
+ * restores every sample. The zeros keep the phase of the periodic
+ * transform: from delay() on, the coefficient k of a subband is the
+ * coefficient k - delay() of WaveletBuffer for a signal without padding,
+ * only the first delay() coefficients cover the zeros
+ */
+class StreamDecomposer {
+ public:
+  /**
+   * @param wavelet_type
+   * @param decomposition_steps the number of the steps, 0 for kNone
+   */
+  StreamDecomposer(WaveletTypes wavelet_type, size_t decomposition_steps);
+
+  /**
+   * Decompose the next chunk of the signal
+   * @param chunk the samples following the previous chunk
+   * @param subbands the coefficients completed by the chunk are appended to
+   * them, it is resized to the number of the subbands
+   */
+  void Push(std::span<const DataType> chunk, StreamSubbands* subbands);
+
+  /**
+   * The number of the steps
+   */
+  [[nodiscard]] size_t decomposition_steps() const;
+
+  /**
+   * The number of the coefficients of a subband covering the zeros before
+   * the stream, the following ones are those of WaveletBuffer
+   * @param subband the index of the subband in StreamSubbands
+   */
+  [[nodiscard]] size_t delay(size_t subband) const;
+
+ private:
+  size_t steps_;
+  wavelet::FilterBank filters_;
+  std::vector<std::vector<DataType>> pending_; /**< samples of each step */
+  std::vector<size_t> delays_;                 /**< of each subband */
+  std::vector<DataType> scratch_[2]; /**< approximations passed to the steps */
+};
+
+/**
+ * @class StreamComposer
+ *
+ * Inverse of StreamDecomposer, it restores the samples as soon as the
+ * coefficients under the filters have arrived. The restored samples start
+ * with the first sample of the stream and don't depend on the chunks
+ */
+class StreamComposer {
+ public:
+  /**
+   * @param wavelet_type the wavelet of the decomposer
+   * @param decomposition_steps the number of the steps of the decomposer
+   */
+  StreamComposer(WaveletTypes wavelet_type, size_t decomposition_steps);
+
+  /**
+   * Compose the next coefficients
+   * @param subbands the coefficients following the previous ones, e.g. the
+   * output of StreamDecomposer::Push
+   * @param samples the restored samples are appended to it
+   * @return false if the number of the subbands doesn't match the steps
+   */
+  bool Push(const StreamSubbands& subbands, std::vector<DataType>* samples);
+
+  /**
+   * The number of the steps
+   */
+  [[nodiscard]] size_t decomposition_steps() const;
+
+ private:
+  /**
+   * Coefficients of a step waiting for their pairs or kept for the filters
+   */
+  struct Step {
+    std::vector<DataType> low;
+    std::vector<DataType> high;
+    size_t skip = 0; /**< restored zeros to drop before the signal */
+  };
+
+  size_t steps_;
+  wavelet::FilterBank filters_;
+  std::vector<Step> pending_;
+  std::vector<DataType> scratch_[2]; /**< approximations restored by steps */
+};
+
+/**
+ * Receiver of the rows of the subbands of a 2D decomposition
+ * @param subband the index of the subband in WaveletDecomposition
+ * @param row the index of the row in the subband
+ * @param data the values of the row
+ */
+using SubbandRowSink = std::function<void(size_t subband, size_t row,
+                                          std::span<const DataType> data)>;
+
+/**
+ * @class RowStreamDecomposer
+ *
+ * Line-based 2D decomposition of frames pushed row by row. Every step
+ * transforms a row as soon as it arrives and keeps a window of the filter
+ * length of the transformed rows, a row of the subbands goes to the sink
+ * when all rows under the filters have arrived. The memory is
+ * O(width * filter length * steps).
+ *
+ * The first rows of every step are kept for the periodic wrap at the end of
+ * the frame, so the subbands are the same as of WaveletBuffer with the
+ * filter bank engine and without denoising
+ */
+class RowStreamDecomposer {
+ public:
+  /**
+   * @param parameters a 2D decomposition of one signal, the signal shape is
+   * the width and the height of a frame
+   * @param sink receiver of the rows of the subbands
+   * @throw std::runtime_error if the parameters are not supported
+   */
+  RowStreamDecomposer(const WaveletParameters& parameters,
+                      SubbandRowSink sink);
+
+  /**
+   * Decompose the next row of the frame. After the last row of a frame all
+   * rows of its subbands have gone to the sink and the next row starts a
+   * new frame
+   * @param row signal_shape[0] values
+   * @return false if the row has a wrong size
+   */
+  bool Push(std::span<const DataType> row);
+
+  /**
+   * Parameters of the decomposition, the number of steps is 0 for kNone
+   */
+  [[nodiscard]] const WaveletParameters& parameters() const;
+
+ private:
+  /**
+   * Rows of a step transformed in the row direction, [low | high] as the
+   * row pass of the 2D transform
+   */
+  struct Step {
+    size_t rows;    /**< rows of the input of the step */
+    size_t columns; /**< columns of the input of the step */
+    std::vector<DataType> window; /**< rows waiting for the column pass */
+    size_t begin = 0;             /**< the first row under the filters */
+    size_t end = 0;               /**< the end of the rows in the window */
+    std::vector<DataType> head;   /**< the first rows for the wrap */
+    size_t received = 0;
+    size_t emitted = 0;
+    std::vector<DataType> output; /**< a row of LL, LH, HL and HH */
+  };
+
+  void PushRow(size_t level, std::span<const DataType> row);
+  static DataType* AppendRow(Step* step);
+  void EmitRows(size_t level);
+
+  WaveletParameters parameters_;
+  SubbandRowSink sink_;
+  wavelet::FilterBank filters_;
+  std::vector<Step> steps_;
+  std::vector<DataType> padded_row_;
+  size_t top_ = 0; /**< rows of the padding before the frame */
+  size_t received_ = 0;
+};
+
+}  // namespace drift
+
+#endif  // WAVELET_BUFFER_WAVELET_STREAM_H_
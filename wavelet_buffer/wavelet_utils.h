@@ -4,13 +4,19 @@
 
 #include <blaze/Blaze.h>
 
+#include <functional>
+#include <memory>
+#include <span>
 #include <tuple>
 #include <vector>
 
 #include "wavelet_buffer/denoise_algorithms.h"
 #include "wavelet_buffer/padding.h"
 #include "wavelet_buffer/primitives.h"
+#include "wavelet_buffer/thread_pool.h"
+#include "wavelet_buffer/wavelet.h"
 #include "wavelet_buffer/wavelet_parameters.h"
+#include "wavelet_buffer/workspace.h"
 
 namespace drift {
 
@@ -31,16 +37,34 @@ namespace internal {
 int CalculateMaxDecompositionSteps(WaveletTypes wavelet_type,
                                    const std::vector<size_t>& signal_shape);
 
+/**
+ * Matrices or filters of a transform engine prepared for all steps, defined
+ * in wavelet_utils.cc
+ */
+struct EngineOperators;
+
+/**
+ * Prepare operators of the engine once to run many transforms
+ * @param parameters wavelet parameters
+ * @param engine implementation of the transform
+ * @param inverse true for composition
+ * @return
+ */
+std::shared_ptr<const EngineOperators> MakeEngineOperators(
+    const WaveletParameters& parameters, wavelet::Engine engine, bool inverse);
+
 /**
  * Partial decompose
  * @param parameters wavelet parameters
  * @param decomposition the initial decomposition to decompose
  * @param steps
  * @param denoiser
+ * @param engine implementation of the transform
  */
 void DecomposeImpl(WaveletParameters parameters,
                    NWaveletDecomposition* decomposition, int steps,
-                   const DenoiseAlgorithm<DataType>& denoiser);
+                   const DenoiseAlgorithm<DataType>& denoiser,
+                   wavelet::Engine engine = wavelet::Engine::kFilterBank);
 
 /**
  * Decompose signal
@@ -50,12 +74,80 @@ void DecomposeImpl(WaveletParameters parameters,
  * @param denoiser
  * @param start_signal
  * @param signal_count
+ * @param engine implementation of the transform
  * @return
  */
 bool DecomposeImpl(const WaveletParameters& parameters,
                    NWaveletDecomposition* decomposition, const SignalN2D& data,
                    const DenoiseAlgorithm<DataType>& denoiser,
-                   size_t start_signal, size_t signal_count);
+                   size_t start_signal, size_t signal_count,
+                   wavelet::Engine engine = wavelet::Engine::kFilterBank);
+
+/**
+ * Decompose signal with prepared operators, no setup work
+ * @param parameters
+ * @param padded_size shape of the signal with padding, see CalcPaddedSize
+ * @param operators forward operators of the engine
+ * @param decomposition
+ * @param data
+ * @param denoiser
+ * @param start_signal
+ * @param signal_count
+ * @param workspace scratch memory, the subbands of the decomposition are
+ * written in place if it isn't nullptr (filter bank engine only)
+ * @param pool threads to decompose the channels concurrently, the workspaces
+ * of its threads are used instead of the given one
+ * @return
+ */
+bool DecomposeImpl(const WaveletParameters& parameters,
+                   const SignalShape& padded_size,
+                   const EngineOperators& operators,
+                   NWaveletDecomposition* decomposition, const SignalN2D& data,
+                   const DenoiseAlgorithm<DataType>& denoiser,
+                   size_t start_signal, size_t signal_count,
+                   Workspace* workspace = nullptr, ThreadPool* pool = nullptr);
+
+/**
+ * Decompose one 1D signal from memory of the caller, the filter bank engine
+ * reads it in place if it needs no padding
+ * @param parameters
+ * @param padded_size shape of the signal with padding, see CalcPaddedSize
+ * @param operators forward operators of the engine
+ * @param decomposition
+ * @param channel the channel of the decomposition to write
+ * @param data the signal
+ * @param denoiser
+ * @param workspace scratch memory, nullptr to allocate it for the call
+ * @return false if the signal has a wrong size
+ */
+bool DecomposeImpl(const WaveletParameters& parameters,
+                   const SignalShape& padded_size,
+                   const EngineOperators& operators,
+                   NWaveletDecomposition* decomposition, size_t channel,
+                   std::span<const DataType> data,
+                   const DenoiseAlgorithm<DataType>& denoiser,
+                   Workspace* workspace = nullptr);
+
+/**
+ * Decompose the channels of 1D signals interleaved in the rows of a matrix,
+ * the filter bank engine transforms all channels at once with the samples of
+ * a row in the lanes of the kernels
+ * @param parameters
+ * @param padded_size shape of the signal with padding, see CalcPaddedSize
+ * @param operators forward operators of the engine
+ * @param decomposition
+ * @param data signal_shape[0] rows of signal_number channels
+ * @param denoiser
+ * @param workspace scratch memory, nullptr to allocate it for the call
+ * @return false if the signals have a wrong shape
+ */
+bool DecomposeInterleavedImpl(const WaveletParameters& parameters,
+                              const SignalShape& padded_size,
+                              const EngineOperators& operators,
+                              NWaveletDecomposition* decomposition,
+                              const Signal2D& data,
+                              const DenoiseAlgorithm<DataType>& denoiser,
+                              Workspace* workspace = nullptr);
 
 /**
  * Partial compose
@@ -63,13 +155,118 @@ bool DecomposeImpl(const WaveletParameters& parameters,
  * @param decomposition the wavelet subband
  * @param start_signal the first signal in the vector
  * @param count the number of signals to decompose
+ * @param engine implementation of the transform
  * @return new decomposition
  */
+NWaveletDecomposition ComposeImpl(
+    const WaveletParameters& params, const NWaveletDecomposition& decomposition,
+    size_t steps, size_t start_channel, size_t count,
+    wavelet::Engine engine = wavelet::Engine::kFilterBank);
+
+/**
+ * Partial compose with prepared operators
+ * @param operators inverse operators of the engine
+ */
 NWaveletDecomposition ComposeImpl(const WaveletParameters& params,
+                                  const EngineOperators& operators,
                                   const NWaveletDecomposition& decomposition,
                                   size_t steps, size_t start_channel,
                                   size_t count);
 
+/**
+ * Compose signals from decomposition with prepared operators
+ * @param operators inverse operators of the engine
+ * @param data the composed signals, their memory is reused if they have the
+ * size
+ * @param workspace scratch memory of the filter bank engine, nullptr to
+ * allocate it for the call
+ * @param pool threads to compose the channels concurrently
+ */
+bool ComposeImpl(const WaveletParameters& params,
+                 const EngineOperators& operators, SignalN2D* data,
+                 const NWaveletDecomposition& decomposition, size_t steps,
+                 size_t start_signal, size_t count,
+                 Workspace* workspace = nullptr, ThreadPool* pool = nullptr);
+
+/**
+ * Compose one 1D signal into memory of the caller
+ * @param operators inverse operators of the engine
+ * @param data the signal, it must have the size of the composed signal
+ * @param channel the channel of the decomposition to read
+ * @param workspace scratch memory, nullptr to allocate it for the call
+ * @return false if the signal has a wrong size
+ */
+bool ComposeImpl(const WaveletParameters& params,
+                 const EngineOperators& operators, std::span<DataType> data,
+                 const NWaveletDecomposition& decomposition, size_t steps,
+                 size_t channel, Workspace* workspace = nullptr);
+
+/**
+ * Compose the channels of 1D signals interleaved in the rows of a matrix
+ * @param operators inverse operators of the engine
+ * @param data the composed signals, a row holds a sample of every channel,
+ * the memory is reused if it has the size
+ * @param workspace scratch memory, nullptr to allocate it for the call
+ * @return false if the signals aren't 1D
+ */
+bool ComposeInterleavedImpl(const WaveletParameters& params,
+                            const EngineOperators& operators, Signal2D* data,
+                            const NWaveletDecomposition& decomposition,
+                            size_t steps, Workspace* workspace = nullptr);
+
+/**
+ * Compose a region of signals from decomposition, every step transforms only
+ * the coefficients under the synthesis filters of the region, so the cost
+ * depends on the size of the region and not of the signals. The filter bank
+ * is used for all engines, they give the same transform
+ * @param padded_size shape of the signal with padding, see CalcPaddedSize
+ * @param region the region of the composed signals, they are 2^steps smaller
+ * than the original ones
+ * @param data the composed regions, 1D regions are columns, their memory is
+ * reused if they have the size
+ * @param workspace scratch memory, nullptr to allocate it for the call
+ * @param pool threads to compose the channels concurrently
+ * @return false if the region is out of the composed signals
+ */
+bool ComposeRegionImpl(const WaveletParameters& params,
+                       const SignalShape& padded_size, const Region& region,
+                       SignalN2D* data,
+                       const NWaveletDecomposition& decomposition,
+                       size_t steps, size_t start_signal, size_t count,
+                       Workspace* workspace = nullptr,
+                       ThreadPool* pool = nullptr);
+
+/**
+ * Compose the approximation with padding of one signal level by level from
+ * an approximation at a coarser level
+ * @param operators inverse operators of the engine
+ * @param decomposition the subbands of the signal
+ * @param approximation the approximation with padding at level `from`
+ * @param from the level of the approximation
+ * @param to the level to compose, not coarser than `from`
+ * @param result the approximation with padding at level `to`
+ * @param on_level function called with every composed level and its
+ * approximation, it can be empty
+ * @param pool threads for the steps of a big image
+ */
+void ComposeApproximationImpl(
+    const WaveletParameters& params, const EngineOperators& operators,
+    const WaveletDecomposition& decomposition, const Signal2D& approximation,
+    size_t from, size_t to, Signal2D* result,
+    const std::function<void(size_t, const Signal2D&)>& on_level,
+    ThreadPool* pool = nullptr);
+
+/**
+ * Crop the approximation with padding at a level into the composed signal,
+ * the same as composing the signal with the level as the scale factor
+ * @param approximation the approximation with padding
+ * @param steps the level of the approximation
+ * @param data the composed signal, its memory is reused if it has the size
+ */
+void CropApproximationImpl(const WaveletParameters& params,
+                           const Signal2D& approximation, size_t steps,
+                           Signal2D* data);
+
 /**
  * Compose signals from decomposition
  * @param params wavelet parameters of the decomposition
@@ -77,11 +274,13 @@ NWaveletDecomposition ComposeImpl(const WaveletParameters& params,
  * @param decomposition the wavelet subband
  * @param start_signal the first signal in the vector
  * @param count the number of signals to decompose
+ * @param engine implementation of the transform
  * @return false if there is an error
  */
 bool ComposeImpl(const WaveletParameters& params, SignalN2D* data,
                  const NWaveletDecomposition& decomposition, size_t steps,
-                 size_t start_signal, size_t count);
+                 size_t start_signal, size_t count,
+                 wavelet::Engine engine = wavelet::Engine::kFilterBank);
 
 /**
  * Remove padding depending on signal shape and dimension
@@ -110,11 +309,14 @@ void CropPadding(Container* data, const SignalShape& signal_shape) {
  * @tparam Container type of Matrix
  * @param data
  * @param padded_size
+ * @param mode BoundaryMode::kZeroPadding pads with zeros, the other modes
+ * repeat the edges
  * @return
  */
 template <typename Container>
 static Container AddPadding(const Container& data,
-                            const SignalShape& padded_size) {
+                            const SignalShape& padded_size,
+                            BoundaryMode mode = BoundaryMode::kPadding) {
   size_t rows, columns;
   if (padded_size.size() > 1) {
     rows = padded_size[1];
@@ -124,6 +326,9 @@ static Container AddPadding(const Container& data,
     columns = 1;
   }
 
+  if (mode == BoundaryMode::kZeroPadding) {
+    return ZeroPaddingAlgorithm(rows, columns).Extend(data);
+  }
   Padding padding(rows, columns);
   return padding.Extend(data);
 }
@@ -139,6 +344,14 @@ SignalShape CalcPaddedSize(WaveletTypes wavelet_type,
                            const SignalShape& signal_shape,
                            const int decomposition_steps);
 
+/**
+ * Shape of the signal the transform runs on, it is the signal shape itself
+ * for BoundaryMode::kOddLength
+ * @param parameters
+ * @return
+ */
+SignalShape CalcPaddedSize(const WaveletParameters& parameters);
+
 /**
  * Number of subbands that will be added on each wavelet decomposition
  * @param parameters
@@ -154,6 +367,37 @@ int SubbandsPerWaveletTransform(const WaveletParameters& parameters);
  */
 size_t DecompositionSize(const WaveletParameters& parameters);
 
+/**
+ * Counters of the cache of the matrices of the matrix engine, the matrices
+ * are shared by all plans with the same sizes of the steps
+ */
+struct MatrixCacheStats {
+  size_t hits;
+  size_t misses;
+  size_t evictions;
+  size_t entries;
+  size_t bytes;
+};
+
+/**
+ * Bound the memory of the matrix cache, the least recently used matrices are
+ * dropped first, plans holding them keep them alive
+ * @param max_bytes the bound, 256 MB by default
+ */
+void SetMatrixCacheLimit(size_t max_bytes);
+
+/**
+ * Build the matrices of the matrix engine for the parameters ahead of the
+ * first plan, e.g. at startup. Other engines and 1D signals need none
+ * @param parameters
+ */
+void PrewarmMatrixCache(const WaveletParameters& parameters);
+
+/**
+ * Counters of the matrix cache since the start of the process
+ */
+MatrixCacheStats GetMatrixCacheStats();
+
 /**
  * Compare the buffer to another one.
  * @note The buffers must have the same number of decomposition steps
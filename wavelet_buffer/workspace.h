@@ -0,0 +1,103 @@
+// Copyright 2023 PANDA GmbH
+
+#ifndef WAVELET_BUFFER_WORKSPACE_H_
+#define WAVELET_BUFFER_WORKSPACE_H_
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace drift {
+
+/**
+ * @class Workspace
+ *
+ * Arena for the scratch memory of the transforms. Memory is taken by bumping
+ * a pointer and released all at once by Reset(), which also merges the
+ * blocks into one big enough for the whole call. After the first call with a
+ * given shape the transforms don't allocate any more.
+ *
+ * A workspace isn't thread safe, use one per thread
+ */
+class Workspace {
+ public:
+  /**
+   * Create an empty workspace
+   * @param upstream the resource to allocate blocks from
+   */
+  explicit Workspace(
+      std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+  Workspace(const Workspace&) = delete;
+
+  Workspace& operator=(const Workspace&) = delete;
+
+  ~Workspace();
+
+  /**
+   * Uninitialized memory for an array, valid until Reset()
+   * @tparam T trivially destructible type
+   * @param count number of elements
+   * @return memory aligned to a cache line
+   */
+  template <typename T>
+  T* Allocate(size_t count) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "the arena doesn't call destructors");
+    return static_cast<T*>(AllocateBytes(count * sizeof(T)));
+  }
+
+  /**
+   * Object kept by the workspace between the calls, e.g. a vector the
+   * denoisers work on. It is created by the first call, survives Reset() and
+   * is destroyed with the workspace. There is one object of a type, its
+   * users mustn't hold it at the same time
+   * @tparam T default constructible type
+   */
+  template <typename T>
+  T& Object() {
+    for (const auto& [type, object] : objects_) {
+      if (type == typeid(T)) {
+        return *static_cast<T*>(object.get());
+      }
+    }
+    auto object = std::make_shared<T>();
+    objects_.emplace_back(typeid(T), object);
+    return *object;
+  }
+
+  /**
+   * Release the memory of all arrays, the blocks are merged into one of the
+   * whole capacity
+   */
+  void Reset();
+
+  /**
+   * Total size of the blocks in bytes
+   */
+  [[nodiscard]] size_t capacity() const;
+
+ private:
+  struct Block {
+    std::byte* data;
+    size_t size;
+  };
+
+  void* AllocateBytes(size_t bytes);
+
+  void Release();
+
+  std::pmr::memory_resource* upstream_;
+  std::vector<Block> blocks_;
+  size_t used_ = 0; /**< bytes used in the last block */
+  std::vector<std::pair<std::type_index, std::shared_ptr<void>>> objects_;
+};
+
+}  // namespace drift
+
+#endif  // WAVELET_BUFFER_WORKSPACE_H_